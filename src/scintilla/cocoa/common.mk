@@ -20,6 +20,9 @@ CCO=$(CO) $(gDEFs) $(INCS)
 
 # include directories and global #define
 gDEFs=-DSCI_NAMESPACE -DSCI_LEXER
+ifdef BLOCK_STORAGE
+gDEFs+=-DSCI_BLOCK_STORAGE
+endif
 
 # source directories
 SRC_DIRS=../src ./ScintillaFramework ./ScintillaTest ./ \
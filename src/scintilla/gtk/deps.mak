@@ -33,7 +33,8 @@ Document.o: ../src/Document.cxx ../include/Platform.h ../include/ILexer.h \
  ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
  ../src/RunStyles.h ../src/CellBuffer.h ../src/PerLine.h \
  ../src/CharClassify.h ../lexlib/CharacterSet.h ../src/Decoration.h \
- ../src/Document.h ../src/RESearch.h ../src/UniConversion.h
+ ../src/Document.h ../src/RESearch.h ../src/LinearRegex.h \
+ ../src/UniConversion.h
 Editor.o: ../src/Editor.cxx ../include/Platform.h ../include/ILexer.h \
  ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
  ../src/RunStyles.h ../src/ContractionState.h ../src/CellBuffer.h \
@@ -48,6 +49,7 @@ Indicator.o: ../src/Indicator.cxx ../include/Platform.h \
  ../include/Scintilla.h ../src/XPM.h ../src/Indicator.h
 KeyMap.o: ../src/KeyMap.cxx ../include/Platform.h ../include/Scintilla.h \
  ../src/KeyMap.h
+LinearRegex.o: ../src/LinearRegex.cxx ../src/LinearRegex.h
 LineMarker.o: ../src/LineMarker.cxx ../include/Platform.h \
  ../include/Scintilla.h ../src/XPM.h ../src/LineMarker.h
 PerLine.o: ../src/PerLine.cxx ../include/Platform.h \
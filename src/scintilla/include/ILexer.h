@@ -8,6 +8,8 @@
 #ifndef ILEXER_H
 #define ILEXER_H
 
+#include "Sci_Position.h"
+
 #ifdef SCI_NAMESPACE
 namespace Scintilla {
 #endif
@@ -18,27 +20,27 @@ namespace Scintilla {
 	#define SCI_METHOD
 #endif
 
-enum { dvOriginal=0, dvLineEnd=1 };
+enum { dvOriginal=0, dvLineEnd=1, dvContiguousRange=2, dvCheckpoints=3 };
 
 class IDocument {
 public:
 	virtual int SCI_METHOD Version() const = 0;
 	virtual void SCI_METHOD SetErrorStatus(int status) = 0;
-	virtual int SCI_METHOD Length() const = 0;
-	virtual void SCI_METHOD GetCharRange(char *buffer, int position, int lengthRetrieve) const = 0;
-	virtual char SCI_METHOD StyleAt(int position) const = 0;
-	virtual int SCI_METHOD LineFromPosition(int position) const = 0;
-	virtual int SCI_METHOD LineStart(int line) const = 0;
+	virtual Sci_Position SCI_METHOD Length() const = 0;
+	virtual void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const = 0;
+	virtual char SCI_METHOD StyleAt(Sci_Position position) const = 0;
+	virtual int SCI_METHOD LineFromPosition(Sci_Position position) const = 0;
+	virtual Sci_Position SCI_METHOD LineStart(int line) const = 0;
 	virtual int SCI_METHOD GetLevel(int line) const = 0;
 	virtual int SCI_METHOD SetLevel(int line, int level) = 0;
 	virtual int SCI_METHOD GetLineState(int line) const = 0;
 	virtual int SCI_METHOD SetLineState(int line, int state) = 0;
-	virtual void SCI_METHOD StartStyling(int position, char mask) = 0;
-	virtual bool SCI_METHOD SetStyleFor(int length, char style) = 0;
-	virtual bool SCI_METHOD SetStyles(int length, const char *styles) = 0;
+	virtual void SCI_METHOD StartStyling(Sci_Position position, char mask) = 0;
+	virtual bool SCI_METHOD SetStyleFor(Sci_Position length, char style) = 0;
+	virtual bool SCI_METHOD SetStyles(Sci_Position length, const char *styles) = 0;
 	virtual void SCI_METHOD DecorationSetCurrentIndicator(int indicator) = 0;
-	virtual void SCI_METHOD DecorationFillRange(int position, int value, int fillLength) = 0;
-	virtual void SCI_METHOD ChangeLexerState(int start, int end) = 0;
+	virtual void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) = 0;
+	virtual void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) = 0;
 	virtual int SCI_METHOD CodePage() const = 0;
 	virtual bool SCI_METHOD IsDBCSLeadByte(char ch) const = 0;
 	virtual const char * SCI_METHOD BufferPointer() = 0;
@@ -47,7 +49,28 @@ public:
 
 class IDocumentWithLineEnd : public IDocument {
 public:
-	virtual int SCI_METHOD LineEnd(int line) const = 0;
+	virtual Sci_Position SCI_METHOD LineEnd(int line) const = 0;
+};
+
+class IDocumentWithContiguousRange : public IDocumentWithLineEnd {
+public:
+	// The text stored contiguously around position, such as one side of the gap, so
+	// lexers can read it without copying. Its start and length are returned and it is
+	// valid until the text is modified. Returns null when position is not in the document.
+	virtual const char * SCI_METHOD ContiguousRange(Sci_Position position, Sci_Position *start, Sci_Position *length) const = 0;
+};
+
+class IDocumentWithCheckpoints : public IDocumentWithContiguousRange {
+public:
+	// Lexer state saved at the start of a line. It moves with the line as text is edited.
+	virtual void SCI_METHOD SetLineCheckpoint(int line, const char *state, int length) = 0;
+	// Copies up to length bytes of the saved state and returns its full length or -1 if none.
+	virtual int SCI_METHOD GetLineCheckpoint(int line, char *state, int length) const = 0;
+	// Called by a lexer at the start of line when its state equals the checkpoint there.
+	// Returns true when the text from position, at or before the start of line, has not
+	// changed since the styles, fold levels and line states that follow were set, so the
+	// lexer can stop and the styles kept, up to the next change after the range being lexed.
+	virtual bool SCI_METHOD StylesConverged(int line, Sci_Position position) = 0;
 };
 
 enum { lvOriginal=0, lvSubStyles=1 };
@@ -87,6 +110,23 @@ public:
 	virtual void * SCI_METHOD ConvertToDocument() = 0;
 };
 
+/// Read only memory such as a mapped file that a document may refer to instead of copying.
+class IMemoryView {
+public:
+	virtual const char * SCI_METHOD Data() = 0;
+	virtual Sci_Position SCI_METHOD Length() = 0;
+	virtual void SCI_METHOD Release() = 0;
+};
+
+class ILoaderWithView : public ILoader {
+public:
+	// Appends the view which is released by the document when no longer needed.
+	// Returns a status code from SC_STATUS_*
+	virtual int SCI_METHOD AddView(IMemoryView *view) = 0;
+	// Whether the document refers to views instead of copying them
+	virtual bool SCI_METHOD KeepsViews() = 0;
+};
+
 #ifdef SCI_NAMESPACE
 }
 #endif
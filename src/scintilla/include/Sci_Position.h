@@ -0,0 +1,22 @@
+// Scintilla source code edit control
+/** @file Sci_Position.h
+ ** Define the Sci_Position type used in Scintilla's internal data structures.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef SCI_POSITION_H
+#define SCI_POSITION_H
+
+// Document positions and lengths.
+// Defining SCI_LARGE_FILE_SUPPORT widens positions to the size of a pointer so that
+// documents larger than 2 gigabytes can be held on 64-bit builds.
+// The default is int which keeps the data structures as small and fast as before.
+#ifdef SCI_LARGE_FILE_SUPPORT
+#include <stddef.h>
+typedef ptrdiff_t Sci_Position;
+#else
+typedef int Sci_Position;
+#endif
+
+#endif
@@ -362,6 +362,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCFIND_WORDSTART 0x00100000
 #define SCFIND_REGEXP 0x00200000
 #define SCFIND_POSIX 0x00400000
+#define SCFIND_LINEARREGEX 0x01000000
 #define SCI_FINDTEXT 2150
 #define SCI_FORMATRANGE 2151
 #define SCI_GETFIRSTVISIBLELINE 2152
@@ -427,6 +428,25 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_CALLTIPSETWORDWRAP 4030
 #define SCI_SETMOUSECAPTURE 4031
 #define SCI_SETFOLDHIGHLIGHTCOLOUR 4032
+#define SCI_GETPOSITIONCACHEHITS 4033
+#define SCI_GETPOSITIONCACHEMISSES 4034
+#define SCI_SETLINEIMAGECACHE 4035
+#define SCI_GETLINEIMAGECACHE 4036
+#define SCI_SETUNDOMEMORYLIMIT 4037
+#define SCI_GETUNDOMEMORYLIMIT 4038
+#define SC_IDLESTYLING_NONE 0
+#define SC_IDLESTYLING_TOVISIBLE 1
+#define SC_IDLESTYLING_AFTERVISIBLE 2
+#define SC_IDLESTYLING_ALL 3
+#define SCI_SETIDLESTYLING 4039
+#define SCI_GETIDLESTYLING 4040
+#define SCI_SEARCHALLINTARGET 4041
+#define SCI_GETMATCHSTART 4042
+#define SCI_GETMATCHEND 4043
+#define SCI_INDICATORFILLMATCHES 4044
+#define SCI_INDICATORFILLALLINTARGET 4045
+#define SCI_REPLACEMATCHES 4046
+#define SCI_REPLACEMATCHESRE 4047
 #define SCI_VISIBLEFROMDOCLINE 2220
 #define SCI_DOCLINEFROMVISIBLE 2221
 #define SCI_WRAPCOUNT 2235
@@ -971,6 +991,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCN_CLICK 2061
 #define SCN_MOUSEBUTTONUP 2062
 #define SCN_AUTOCUPDATED 2038
+#define SCN_WRAPPROGRESS 2063
 #ifndef SCI_DISABLE_PROVISIONAL
 #define SC_LINE_END_TYPE_DEFAULT 0
 #define SC_LINE_END_TYPE_UNICODE 1
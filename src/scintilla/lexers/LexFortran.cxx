@@ -424,7 +424,7 @@ static void FoldFortranDoc(unsigned int startPos, int length, int initStyle,
 						break;
 				}
 				Label[j] = '\0';
-				while (doLabels[posLabel] == atoi(Label) && posLabel > -1) {
+				while (posLabel > -1 && doLabels[posLabel] == atoi(Label)) {
 					levelCurrent--;
 					posLabel--;
 				}
@@ -12,6 +12,8 @@
 #include <assert.h>
 #include <ctype.h>
 
+#include <string>
+
 #include "ILexer.h"
 #include "Scintilla.h"
 #include "SciLexer.h"
@@ -22,6 +24,7 @@
 #include "StyleContext.h"
 #include "CharacterSet.h"
 #include "LexerModule.h"
+#include "CheckpointState.h"
 
 #ifdef SCI_NAMESPACE
 using namespace Scintilla;
@@ -710,9 +713,46 @@ static void ColouriseHyperTextDoc(unsigned int startPos, int length, int initSty
 		}
 	}
 
+	// Every few lines save the state so lexing after an edit can stop where it is as before
+	CheckpointState checkpoint(styler.CheckpointsSupported());
+	int lineCheckpoint = lineCurrent;
+
 	styler.StartSegment(startPos);
 	const int lengthDoc = startPos + length;
 	for (int i = startPos; i < lengthDoc; i++) {
+		// Only while lineCurrent is in step as it falls behind when a line end is skipped
+		if (lineCurrent != lineCheckpoint) {
+			lineCheckpoint = lineCurrent;
+			if (checkpoint.Due(lineCurrent) && (i == styler.LineStart(lineCurrent))) {
+				checkpoint.Begin();
+				checkpoint.Add(state);
+				checkpoint.Add(i - static_cast<int>(styler.GetStartSegment()));
+				checkpoint.Add(inScriptType);
+				checkpoint.Add(tagOpened);
+				checkpoint.Add(tagClosing);
+				checkpoint.Add(tagDontFold);
+				checkpoint.Add(aspScript);
+				checkpoint.Add(clientScript);
+				checkpoint.Add(beforePreProc);
+				checkpoint.Add(scriptLanguage);
+				checkpoint.Add(beforeLanguage);
+				checkpoint.Add(levelPrev);
+				checkpoint.Add(levelCurrent);
+				checkpoint.Add(visibleChars);
+				checkpoint.Add(lineStartVisibleChars);
+				checkpoint.Add(chPrev);
+				checkpoint.Add(ch);
+				checkpoint.Add(chPrevNonWhite);
+				checkpoint.Add(makoComment);
+				checkpoint.Add(prevWord);
+				checkpoint.Add(phpStringDelimiter);
+				checkpoint.Add(makoBlockType);
+				checkpoint.Add(djangoBlockType);
+				// The current segment is styled when it ends so its text must be unchanged too
+				if (checkpoint.Converged(styler, lineCurrent, styler.GetStartSegment()))
+					return;
+			}
+		}
 		const int chPrev2 = chPrev;
 		chPrev = ch;
 		if (!IsASpace(ch) && state != SCE_HJ_COMMENT &&
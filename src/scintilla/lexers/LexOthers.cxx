@@ -1018,8 +1018,8 @@ static void ColourisePropsDoc(unsigned int startPos, int length, int, WordList *
 			style = ColourisePropsLine(lineBuffer, linePos, startLine, i, keywordlists, styler, allowInitialSpaces);
 			// test: is next a continuation of line
 			continuation = (linePos >= sizeof(lineBuffer) - 1) ||
-				(style != SCE_PROPS_COMMENT &&  ((lineBuffer[linePos-2] == '\\')
-				|| (lineBuffer[linePos-3] == '\\' && lineBuffer[linePos-2] == '\r')));
+				(style != SCE_PROPS_COMMENT && linePos >= 2 && ((lineBuffer[linePos-2] == '\\')
+				|| (linePos >= 3 && lineBuffer[linePos-3] == '\\' && lineBuffer[linePos-2] == '\r')));
 //!-end-[PropsKeysSets]
 			linePos = 0;
 			startLine = i + 1;
@@ -0,0 +1,65 @@
+// Scintilla source code edit control
+/** @file CheckpointState.h
+ ** Save the complete state of a lexer every few lines so lexing after an edit can stop
+ ** once it reaches a line where the state is the same as before.
+ ** The state is built by adding each variable carried from line to line.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef CHECKPOINTSTATE_H
+#define CHECKPOINTSTATE_H
+
+#include <assert.h>
+#include <string.h>
+
+#include <string>
+
+#include "ILexer.h"
+#include "LexAccessor.h"
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+class CheckpointState {
+	bool enabled;
+	int interval;
+	std::string state;
+	std::string saved;
+
+public:
+	explicit CheckpointState(bool enabled_, int interval_=8) : enabled(enabled_), interval(interval_) {
+	}
+	bool Due(int line) const {
+		return enabled && (line > 0) && ((line % interval) == 0);
+	}
+	void Begin() {
+		state.clear();
+	}
+	void Add(int value) {
+		state.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	void Add(const char *s) {
+		state.append(s, strlen(s) + 1);
+	}
+	// Call at the start of line with the state built by Begin and Add. Returns true when
+	// the state equals that saved for line and the styles that follow can be kept, so the
+	// lexer should stop. Otherwise saves the state for line.
+	// The lexer must not depend on text before position other than through the state.
+	bool Converged(LexAccessor &styler, int line, int position) {
+		saved.resize(state.length());
+		if (!state.empty() &&
+			(styler.GetLineCheckpoint(line, &saved[0], static_cast<int>(saved.length())) ==
+				static_cast<int>(state.length())) &&
+			(saved == state) && styler.StylesConverged(line, position))
+			return true;
+		styler.SetLineCheckpoint(line, state.c_str(), static_cast<int>(state.length()));
+		return false;
+	}
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+#endif
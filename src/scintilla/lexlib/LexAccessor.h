@@ -17,6 +17,8 @@ enum EncodingType { enc8bit, encUnicode, encDBCS };
 class LexAccessor {
 private:
 	IDocument *pAccess;
+	/// Set when the document can be read in place
+	IDocumentWithContiguousRange *pRange;
 	enum {extremePosition=0x7FFFFFFF};
 	/** @a bufferSize is a trade off between time taken to copy the characters
 	 * and retrieval overhead.
@@ -24,6 +26,8 @@ private:
 	 * in case there is some backtracking. */
 	enum {bufferSize=4000, slopSize=bufferSize/8};
 	char buf[bufferSize+1];
+	/// The characters from startPos to endPos, either buf or the document's own storage
+	const char *text;
 	int startPos;
 	int endPos;
 	int codePage;
@@ -48,19 +52,34 @@ private:
 		if (endPos > lenDoc)
 			endPos = lenDoc;
 
+		if (pRange && (position >= 0) && (position < lenDoc)) {
+			Sci_Position rangeStart = 0;
+			Sci_Position rangeLength = 0;
+			const char *range = pRange->ContiguousRange(position, &rangeStart, &rangeLength);
+			// Only copy when the buffer would cross the end of the range, such as near the gap
+			if (range && (startPos >= rangeStart) && (endPos <= rangeStart + rangeLength)) {
+				text = range;
+				startPos = static_cast<int>(rangeStart);
+				endPos = static_cast<int>(rangeStart + rangeLength);
+				return;
+			}
+		}
 		pAccess->GetCharRange(buf, startPos, endPos-startPos);
 		buf[endPos-startPos] = '\0';
+		text = buf;
 	}
 
 public:
 	LexAccessor(IDocument *pAccess_) :
-		pAccess(pAccess_), startPos(extremePosition), endPos(0),
+		pAccess(pAccess_), pRange(0), text(buf), startPos(extremePosition), endPos(0),
 		codePage(pAccess->CodePage()), 
 		encodingType(enc8bit),
 		lenDoc(pAccess->Length()),
 		mask(127), validLen(0), chFlags(0), chWhile(0),
 		startSeg(0), startPosStyling(0), 
 		documentVersion(pAccess->Version()) {
+		if (documentVersion >= dvContiguousRange)
+			pRange = static_cast<IDocumentWithContiguousRange *>(pAccess);
 		switch (codePage) {
 		case 65001:
 			encodingType = encUnicode;
@@ -77,7 +96,7 @@ public:
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
-		return buf[position - startPos];
+		return text[position - startPos];
 	}
 	/** Safe version of operator[], returning a defined value for invalid position. */
 	char SafeGetCharAt(int position, char chDefault=' ') {
@@ -88,7 +107,7 @@ public:
 				return chDefault;
 			}
 		}
-		return buf[position - startPos];
+		return text[position - startPos];
 	}
 	bool IsLeadByte(char ch) {
 		return pAccess->IsDBCSLeadByte(ch);
@@ -199,6 +218,26 @@ public:
 	void ChangeLexerState(int start, int end) {
 		pAccess->ChangeLexerState(start, end);
 	}
+	// Checkpoints of lexer state are only stored by documents that support them
+	bool CheckpointsSupported() const {
+		return documentVersion >= dvCheckpoints;
+	}
+	void SetLineCheckpoint(int line, const char *state, int length) {
+		if (documentVersion >= dvCheckpoints)
+			static_cast<IDocumentWithCheckpoints *>(pAccess)->SetLineCheckpoint(line, state, length);
+	}
+	int GetLineCheckpoint(int line, char *state, int length) const {
+		if (documentVersion >= dvCheckpoints)
+			return static_cast<IDocumentWithCheckpoints *>(pAccess)->GetLineCheckpoint(line, state, length);
+		return -1;
+	}
+	bool StylesConverged(int line, int position) {
+		if (documentVersion < dvCheckpoints)
+			return false;
+		// Styles must be written before the document takes over the rest
+		Flush();
+		return static_cast<IDocumentWithCheckpoints *>(pAccess)->StylesConverged(line, position);
+	}
 };
 
 #ifdef SCI_NAMESPACE
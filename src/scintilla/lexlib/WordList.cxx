@@ -83,9 +83,37 @@ void WordList::Clear() {
 		delete []list;
 		delete []words;
 	}
+	delete []table;
+	delete []punctuated;
 	words = 0;
 	list = 0;
 	len = 0;
+	table = 0;
+	tableMask = 0;
+	prefixMin = 0;
+	prefixMax = -1;
+	punctuated = 0;
+}
+
+// FNV-1a which is quick for short strings and can be extended a character at a time
+static const unsigned int hashStart = 2166136261U;
+
+static inline unsigned int HashStep(unsigned int hash, char ch) {
+	return (hash ^ static_cast<unsigned char>(ch)) * 16777619U;
+}
+
+// Markers are punctuation so words of letters, digits and '_' need not be scanned for them
+static inline bool IsPunctuation(char ch) {
+	const unsigned char uch = static_cast<unsigned char>(ch);
+	return (uch < 0x80) && ispunct(uch) && (uch != '_');
+}
+
+static bool HasPunctuation(const char *s) {
+	for (; *s; s++) {
+		if (IsPunctuation(*s))
+			return true;
+	}
+	return false;
 }
 
 #ifdef _MSC_VER
@@ -122,6 +150,82 @@ void WordList::Set(const char *s) {
 		unsigned char indexChar = words[l][0];
 		starts[indexChar] = l;
 	}
+
+	int punctuatedCount = 0;
+	for (int p = 0; p < len; p++) {
+		if (HasPunctuation(words[p]))
+			punctuatedCount++;
+	}
+	punctuated = new int[punctuatedCount + 1];
+	punctuatedCount = 0;
+	for (int p = 0; p < len; p++) {
+		if (HasPunctuation(words[p]))
+			punctuated[punctuatedCount++] = p;
+	}
+	punctuated[punctuatedCount] = -1;
+	for (unsigned int k = 0; k < (sizeof(punctuatedStarts) / sizeof(punctuatedStarts[0])); k++)
+		punctuatedStarts[k] = -1;
+	for (int m = punctuatedCount - 1; m >= 0; m--) {
+		unsigned char indexChar = words[punctuated[m]][0];
+		punctuatedStarts[indexChar] = m;
+	}
+
+	// Keep the table at most half full so probe sequences stay short
+	unsigned int tableSize = 16;
+	while (tableSize < static_cast<unsigned int>(len) * 2)
+		tableSize *= 2;
+	table = new int[tableSize];
+	tableMask = tableSize - 1;
+	for (unsigned int t = 0; t < tableSize; t++)
+		table[t] = -1;
+	for (int w = 0; w < len; w++) {
+		unsigned int hash = hashStart;
+		int length = 0;
+		for (; words[w][length]; length++)
+			hash = HashStep(hash, words[w][length]);
+		unsigned int slot = hash & tableMask;
+		while (table[slot] >= 0)
+			slot = (slot + 1) & tableMask;
+		table[slot] = w;
+		if (words[w][0] == '^') {
+			if ((prefixMax < 0) || (length - 1 < prefixMin))
+				prefixMin = length - 1;
+			if (length - 1 > prefixMax)
+				prefixMax = length - 1;
+		}
+	}
+}
+
+/** Check whether the first length characters of s are a word in the list.
+ * When prefix is true look for the prefix element made from them instead.
+ */
+bool WordList::InTable(unsigned int hash, const char *s, int length, bool prefix) const {
+	const int offset = prefix ? 1 : 0;
+	for (unsigned int slot = hash & tableMask; table[slot] >= 0; slot = (slot + 1) & tableMask) {
+		const char *word = words[table[slot]];
+		if ((!prefix || (word[0] == '^')) && (strncmp(word + offset, s, length) == 0) &&
+			!word[offset + length])
+			return true;
+	}
+	return false;
+}
+
+/** Check whether s starts with any of the prefix elements, hashing each of its
+ * prefixes that is as long as a prefix element.
+ */
+bool WordList::InPrefixes(const char *s) const {
+	if (prefixMax < 0)
+		return false;
+	if (prefixMin == 0)
+		return true;
+	unsigned int hash = HashStep(hashStart, '^');
+	for (int length = 0; (length < prefixMax) && s[length];) {
+		hash = HashStep(hash, s[length]);
+		length++;
+		if ((length >= prefixMin) && InTable(hash, s, length, true))
+			return true;
+	}
+	return false;
 }
 
 /** Check whether a string is in the list.
@@ -132,36 +236,35 @@ void WordList::Set(const char *s) {
 bool WordList::InList(const char *s) const {
 	if (0 == words)
 		return false;
-	unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (static_cast<unsigned char>(words[j][0]) == firstChar) {
-			if (s[1] == words[j][1]) {
-				const char *a = words[j] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b)
-					return true;
-			}
-			j++;
-		}
+	unsigned int hash = hashStart;
+	int length = 0;
+	for (; s[length]; length++)
+		hash = HashStep(hash, s[length]);
+	return InTable(hash, s, length, false) || InPrefixes(s);
+}
+
+/** Check whether s is word or an abbreviation of it.
+ */
+static bool IsAbbreviation(const char *word, const char *s, const char marker) {
+	bool isSubword = false;
+	int start = 1;
+	if (word[1] == marker) {
+		isSubword = true;
+		start++;
 	}
-	j = starts['^'];
-	if (j >= 0) {
-		while (words[j][0] == '^') {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			while (*a && *a == *b) {
+	if (s[1] == word[start]) {
+		const char *a = word + start;
+		const char *b = s + 1;
+		while (*a && *a == *b) {
+			a++;
+			if (*a == marker) {
+				isSubword = true;
 				a++;
-				b++;
 			}
-			if (!*a)
-				return true;
-			j++;
+			b++;
 		}
+		if ((!*a || isSubword) && !*b)
+			return true;
 	}
 	return false;
 }
@@ -174,45 +277,36 @@ bool WordList::InList(const char *s) const {
 bool WordList::InListAbbreviated(const char *s, const char marker) const {
 	if (0 == words)
 		return false;
+	// A word without the marker only matches itself so try the table first and
+	// only scan the words with the same first character that may hold the marker.
+	unsigned int hash = hashStart;
+	bool hasMarker = false;
+	int length = 0;
+	for (; s[length]; length++) {
+		hash = HashStep(hash, s[length]);
+		if (s[length] == marker)
+			hasMarker = true;
+	}
+	if (!hasMarker && InTable(hash, s, length, false))
+		return true;
+	if (InPrefixes(s))
+		return true;
 	unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (static_cast<unsigned char>(words[j][0]) == firstChar) {
-			bool isSubword = false;
-			int start = 1;
-			if (words[j][1] == marker) {
-				isSubword = true;
-				start++;
-			}
-			if (s[1] == words[j][start]) {
-				const char *a = words[j] + start;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					if (*a == marker) {
-						isSubword = true;
-						a++;
-					}
-					b++;
-				}
-				if ((!*a || isSubword) && !*b)
+	if (IsPunctuation(marker)) {
+		int m = punctuatedStarts[firstChar];
+		if (m >= 0) {
+			for (; (punctuated[m] >= 0) && (static_cast<unsigned char>(words[punctuated[m]][0]) == firstChar); m++) {
+				if (IsAbbreviation(words[punctuated[m]], s, marker))
 					return true;
 			}
-			j++;
 		}
+		return false;
 	}
-	j = starts['^'];
+	int j = starts[firstChar];
 	if (j >= 0) {
-		while (words[j][0] == '^') {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			while (*a && *a == *b) {
-				a++;
-				b++;
-			}
-			if (!*a)
+		for (; static_cast<unsigned char>(words[j][0]) == firstChar; j++) {
+			if (IsAbbreviation(words[j], s, marker))
 				return true;
-			j++;
 		}
 	}
 	return false;
@@ -22,8 +22,20 @@ public:
 	int len;
 	bool onlyLineEnds;	///< Delimited by any white space or only line ends
 	int starts[256];
+	// Open addressed hash table of indices into words with -1 for empty slots so a word is
+	// found in time proportional to its length however many words share its first character.
+	// Prefix elements are hashed including their '^'.
+	int *table;
+	unsigned int tableMask;
+	int prefixMin;	///< Length of the shortest prefix element without its '^'
+	int prefixMax;	///< Length of the longest prefix element or -1 when there are none
+	// Indices into words of the words containing ASCII punctuation, ended by -1 and indexed by
+	// first character like starts. Only these can hold an abbreviation marker.
+	int *punctuated;
+	int punctuatedStarts[256];
 	WordList(bool onlyLineEnds_ = false) :
-		words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_)
+		words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_),
+		table(0), tableMask(0), prefixMin(0), prefixMax(-1), punctuated(0)
 		{}
 	~WordList() { Clear(); }
 	operator bool() const { return len ? true : false; }
@@ -32,6 +44,9 @@ public:
 	void Set(const char *s);
 	bool InList(const char *s) const;
 	bool InListAbbreviated(const char *s, const char marker) const;
+private:
+	bool InTable(unsigned int hash, const char *s, int length, bool prefix) const;
+	bool InPrefixes(const char *s) const;
 };
 
 #ifdef SCI_NAMESPACE
@@ -26,6 +26,7 @@ SOURCES += \
     ../../src/ScintillaBase.cxx \
     ../../src/RunStyles.cxx \
     ../../src/RESearch.cxx \
+    ../../src/LinearRegex.cxx \
     ../../src/PositionCache.cxx \
     ../../src/PerLine.cxx \
     ../../src/LineMarker.cxx \
@@ -63,6 +64,7 @@ OTHER_FILES +=
 INCLUDEPATH += ../ScintillaEditBase ../../include ../../src ../../lexlib
 
 DEFINES += SCINTILLA_QT=1 MAKING_LIBRARY=1 SCI_LEXER=1 _CRT_SECURE_NO_DEPRECATE=1
+block_storage:DEFINES += SCI_BLOCK_STORAGE=1
 
 DESTDIR = ../../bin
 DLLDESTDIR = ../../bin
@@ -24,6 +24,7 @@ SOURCES += \
     ../../src/ScintillaBase.cxx \
     ../../src/RunStyles.cxx \
     ../../src/RESearch.cxx \
+    ../../src/LinearRegex.cxx \
     ../../src/PositionCache.cxx \
     ../../src/PerLine.cxx \
     ../../src/LineMarker.cxx \
@@ -64,6 +65,7 @@ HEADERS  += \
     ../../src/ScintillaBase.h \
     ../../src/RunStyles.h \
     ../../src/RESearch.h \
+    ../../src/LinearRegex.h \
     ../../src/PositionCache.h \
     ../../src/PerLine.h \
     ../../src/Partitioning.h \
@@ -80,6 +82,7 @@ HEADERS  += \
     ../../src/CellBuffer.h \
     ../../src/Catalogue.h \
     ../../src/CallTip.h \
+    ../../src/BlockVector.h \
     ../../src/AutoComplete.h \
     ../../include/Scintilla.h \
     ../../include/SciLexer.h \
@@ -103,6 +106,7 @@ OTHER_FILES +=
 INCLUDEPATH += ../../include ../../src ../../lexlib
 
 DEFINES += SCINTILLA_QT=1 MAKING_LIBRARY=1 SCI_LEXER=1 _CRT_SECURE_NO_DEPRECATE=1
+block_storage:DEFINES += SCI_BLOCK_STORAGE=1
 
 DESTDIR = ../../bin
 
@@ -0,0 +1,434 @@
+// Scintilla source code edit control
+/** @file BlockVector.h
+ ** Array of elements stored as a sequence of small gap buffers so that
+ ** insertions and deletions only move data within one block.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BLOCKVECTOR_H
+#define BLOCKVECTOR_H
+
+/// Provides the same interface as SplitVector but divides the elements into blocks
+/// each of which is a SplitVector of around blockSize elements.
+/// The cost of an edit depends on the block size rather than on the length of the array
+/// so edits that alternate between distant positions do not move the whole array.
+/// The start position of each block is held in a Partitioning.
+/// Only the empty array has an empty block.
+/// Blocks may also refer to elements owned elsewhere, such as a mapped file,
+/// which are copied into the block the first time the block is modified.
+
+template <typename T>
+class BlockVector {
+	/// A block either owns its elements in a SplitVector or refers to shared read only elements.
+	/// A shared block without data holds zeros.
+	class Block {
+		SplitVector<T> body;
+		const T *shared;
+		Sci_Position lengthShared;
+		bool isShared;
+
+		// Private so Block objects can not be copied
+		Block(const Block &);
+	public:
+		Block() : shared(0), lengthShared(0), isShared(false) {
+		}
+		Block(const T *shared_, Sci_Position lengthShared_) :
+			shared(shared_), lengthShared(lengthShared_), isShared(true) {
+		}
+		bool IsShared() const {
+			return isShared;
+		}
+		Sci_Position Length() const {
+			return isShared ? lengthShared : body.Length();
+		}
+		T ValueAt(Sci_Position position) const {
+			if (!isShared)
+				return body.ValueAt(position);
+			if (!shared || (position < 0) || (position >= lengthShared))
+				return 0;
+			return shared[position];
+		}
+		void GetRange(T *buffer, Sci_Position position, Sci_Position retrieveLength) const {
+			if (!isShared) {
+				body.GetRange(buffer, position, retrieveLength);
+			} else if (shared) {
+				for (Sci_Position i = 0; i < retrieveLength; i++)
+					buffer[i] = shared[position + i];
+			} else {
+				for (Sci_Position i = 0; i < retrieveLength; i++)
+					buffer[i] = 0;
+			}
+		}
+		/// The storage of the block, first copying any shared elements so it can be modified.
+		SplitVector<T> &Owned() {
+			if (isShared) {
+				body.ReAllocate(lengthShared + 1);
+				if (shared)
+					body.InsertFromArray(0, shared, 0, lengthShared);
+				else
+					body.InsertValue(0, lengthShared, 0);
+				shared = 0;
+				lengthShared = 0;
+				isShared = false;
+			}
+			return body;
+		}
+		const T *ContiguousRange(Sci_Position position, Sci_Position &start, Sci_Position &length) const {
+			if (!isShared)
+				return body.ContiguousRange(position, start, length);
+			start = 0;
+			length = shared ? lengthShared : 0;
+			return shared;
+		}
+		/// Shared data is returned directly without copying.
+		const T *RangePointer(Sci_Position position, Sci_Position rangeLength) {
+			if (isShared && shared)
+				return shared + position;
+			return Owned().RangePointer(position, rangeLength);
+		}
+	};
+
+	SplitVector<Block *> blocks;
+	Partitioning starts;
+	Sci_Position lengthBody;
+	Sci_Position blockSize;
+	/// Most recently used block, so that sequential access does not search.
+	mutable int blockCurrent;
+
+	// Private so BlockVector objects can not be copied
+	BlockVector(const BlockVector &);
+
+	void Init() {
+		blocks.Insert(0, new Block());
+		lengthBody = 0;
+		blockCurrent = 0;
+	}
+
+	void Free() {
+		for (Sci_Position b = 0; b < blocks.Length(); b++) {
+			delete blocks.ValueAt(b);
+		}
+		blocks.DeleteAll();
+		starts.DeleteAll();
+	}
+
+	Sci_Position BlockStart(int block) const {
+		return starts.PositionFromPartition(block);
+	}
+
+	Block *BlockAt(int block) const {
+		return blocks.ValueAt(block);
+	}
+
+	/// Block containing position with the end of the array in the last block.
+	int BlockFromPosition(Sci_Position position) const {
+		if ((blockCurrent < starts.Partitions()) &&
+			(BlockStart(blockCurrent) <= position) &&
+			(position < BlockStart(blockCurrent + 1))) {
+			return blockCurrent;
+		}
+		blockCurrent = starts.PartitionFromPosition(position);
+		return blockCurrent;
+	}
+
+	/// Break an oversized block into blocks of blockSize elements.
+	void SplitBlock(int block) {
+		Block *pb = BlockAt(block);
+		Sci_Position position = BlockStart(block);
+		while (pb->Length() > 2 * blockSize) {
+			Block *pbFront = new Block();
+			pbFront->Owned().ReAllocate(blockSize + 1);
+			pbFront->Owned().InsertFromArray(0, pb->RangePointer(0, blockSize), 0, blockSize);
+			pb->Owned().DeleteRange(0, blockSize);
+			blocks.Insert(block, pbFront);
+			block++;
+			position += blockSize;
+			starts.InsertPartition(block, position);
+		}
+		blockCurrent = block;
+	}
+
+	/// Append the contents of the following block to block and remove the following block.
+	void MergeWithNext(int block) {
+		Block *pb = BlockAt(block);
+		Block *pbNext = BlockAt(block + 1);
+		const Sci_Position lengthNext = pbNext->Length();
+		if (lengthNext > 0) {
+			pb->Owned().InsertFromArray(pb->Length(), pbNext->RangePointer(0, lengthNext), 0, lengthNext);
+		}
+		delete pbNext;
+		blocks.Delete(block + 1);
+		starts.RemovePartition(block + 1);
+		blockCurrent = block;
+	}
+
+	/// After a deletion, merge neighbouring blocks that have become small.
+	void MergeIfSmall(int block) {
+		if ((block < 0) || (block + 1 >= blocks.Length()))
+			return;
+		const Sci_Position lengthBlock = BlockAt(block)->Length();
+		const Sci_Position lengthNext = BlockAt(block + 1)->Length();
+		if (((lengthBlock < blockSize / 2) || (lengthNext < blockSize / 2)) &&
+			(lengthBlock + lengthNext <= 2 * blockSize)) {
+			MergeWithNext(block);
+		}
+	}
+
+	void InsertRange(Sci_Position position, const T *s, T v, Sci_Position insertLength) {
+		PLATFORM_ASSERT((position >= 0) && (position <= lengthBody));
+		if (insertLength > 0) {
+			if ((position < 0) || (position > lengthBody)) {
+				return;
+			}
+			const int block = BlockFromPosition(position);
+			Block *pb = BlockAt(block);
+			const Sci_Position offset = position - BlockStart(block);
+			if (s) {
+				pb->Owned().InsertFromArray(offset, s, 0, insertLength);
+			} else {
+				pb->Owned().InsertValue(offset, insertLength, v);
+			}
+			starts.InsertText(block, insertLength);
+			lengthBody += insertLength;
+			if (pb->Length() > 2 * blockSize) {
+				SplitBlock(block);
+			}
+		}
+	}
+
+public:
+	/// Construct a block vector.
+	explicit BlockVector(Sci_Position blockSize_=0x10000) : starts(64), blockSize(blockSize_) {
+		Init();
+	}
+
+	~BlockVector() {
+		Free();
+	}
+
+	Sci_Position GetBlockSize() const {
+		return blockSize;
+	}
+
+	/// Blocks allocate as they are needed so there is nothing to reserve.
+	void ReAllocate(Sci_Position) {
+	}
+
+	/// Retrieve the element at a particular position.
+	/// Retrieving positions outside the range of the array returns 0.
+	T ValueAt(Sci_Position position) const {
+		if ((position < 0) || (position >= lengthBody)) {
+			return 0;
+		}
+		const int block = BlockFromPosition(position);
+		return BlockAt(block)->ValueAt(position - BlockStart(block));
+	}
+
+	void SetValueAt(Sci_Position position, T v) {
+		PLATFORM_ASSERT((position >= 0) && (position < lengthBody));
+		if ((position < 0) || (position >= lengthBody)) {
+			return;
+		}
+		const int block = BlockFromPosition(position);
+		BlockAt(block)->Owned().SetValueAt(position - BlockStart(block), v);
+	}
+
+	/// Retrieve the length of the array.
+	Sci_Position Length() const {
+		return lengthBody;
+	}
+
+	/// Number of blocks currently used.
+	int Blocks() const {
+		return starts.Partitions();
+	}
+
+	/// Insert a single value into the array.
+	void Insert(Sci_Position position, T v) {
+		InsertRange(position, 0, v, 1);
+	}
+
+	/// Insert a number of elements into the array setting their value.
+	/// Inserting at positions outside the current range fails.
+	void InsertValue(Sci_Position position, Sci_Position insertLength, T v) {
+		InsertRange(position, 0, v, insertLength);
+	}
+
+	/// Ensure at least length elements allocated,
+	/// appending zero valued elements if needed.
+	void EnsureLength(Sci_Position wantedLength) {
+		if (Length() < wantedLength) {
+			InsertValue(Length(), wantedLength - Length(), 0);
+		}
+	}
+
+	/// Insert elements into the array from an array.
+	void InsertFromArray(Sci_Position positionToInsert, const T s[], Sci_Position positionFrom, Sci_Position insertLength) {
+		InsertRange(positionToInsert, s + positionFrom, 0, insertLength);
+	}
+
+	/// Delete one element from the array.
+	void Delete(Sci_Position position) {
+		PLATFORM_ASSERT((position >= 0) && (position < lengthBody));
+		if ((position < 0) || (position >= lengthBody)) {
+			return;
+		}
+		DeleteRange(position, 1);
+	}
+
+	/// Delete a range from the array.
+	/// Deleting positions outside the current range fails.
+	void DeleteRange(Sci_Position position, Sci_Position deleteLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + deleteLength <= lengthBody));
+		if ((position < 0) || ((position + deleteLength) > lengthBody)) {
+			return;
+		}
+		if ((position == 0) && (deleteLength == lengthBody)) {
+			// Full deallocation returns storage and is faster
+			DeleteAll();
+			return;
+		}
+		int block = BlockFromPosition(position);
+		if (BlockAt(block)->Length() > 2 * blockSize) {
+			// May be left as one large block by BufferPointer
+			SplitBlock(block);
+			block = BlockFromPosition(position);
+		}
+		const int blockFirst = block;
+		while (deleteLength > 0) {
+			Block *pb = BlockAt(block);
+			const Sci_Position offset = position - BlockStart(block);
+			const Sci_Position lengthBlock = pb->Length();
+			Sci_Position lengthInBlock = lengthBlock - offset;
+			if (lengthInBlock > deleteLength)
+				lengthInBlock = deleteLength;
+			starts.InsertText(block, -lengthInBlock);
+			if (lengthInBlock == lengthBlock) {
+				// Whole block deleted so remove it. Its start now equals the start of the
+				// following block and the first partition always stays at 0.
+				delete pb;
+				blocks.Delete(block);
+				starts.RemovePartition((block > 0) ? block : block + 1);
+			} else {
+				pb->Owned().DeleteRange(offset, lengthInBlock);
+				block++;
+			}
+			deleteLength -= lengthInBlock;
+			lengthBody -= lengthInBlock;
+		}
+		blockCurrent = 0;
+		MergeIfSmall(blockFirst);
+		MergeIfSmall(blockFirst - 1);
+	}
+
+	/// Delete all the array contents.
+	void DeleteAll() {
+		Free();
+		Init();
+	}
+
+	/// Retrieve a range of elements into an array
+	void GetRange(T *buffer, Sci_Position position, Sci_Position retrieveLength) const {
+		int block = BlockFromPosition(position);
+		while (retrieveLength > 0) {
+			const Block *pb = BlockAt(block);
+			const Sci_Position offset = position - BlockStart(block);
+			Sci_Position lengthInBlock = pb->Length() - offset;
+			if (lengthInBlock > retrieveLength)
+				lengthInBlock = retrieveLength;
+			pb->GetRange(buffer, offset, lengthInBlock);
+			buffer += lengthInBlock;
+			position += lengthInBlock;
+			retrieveLength -= lengthInBlock;
+			block++;
+		}
+	}
+
+	/// Overwrite a range of elements from an array.
+	void SetRange(const T *buffer, Sci_Position position, Sci_Position setLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + setLength <= lengthBody));
+		int block = BlockFromPosition(position);
+		while (setLength > 0) {
+			Block *pb = BlockAt(block);
+			const Sci_Position offset = position - BlockStart(block);
+			Sci_Position lengthInBlock = pb->Length() - offset;
+			if (lengthInBlock > setLength)
+				lengthInBlock = setLength;
+			pb->Owned().SetRange(buffer, offset, lengthInBlock);
+			buffer += lengthInBlock;
+			position += lengthInBlock;
+			setLength -= lengthInBlock;
+			block++;
+		}
+	}
+
+	/// Append elements owned elsewhere as shared blocks without copying them.
+	/// The elements must stay valid and unchanged until HoldsShared returns false.
+	/// A null data pointer appends zeros.
+	void AppendShared(const T *data, Sci_Position appendLength) {
+		while (appendLength > 0) {
+			const Sci_Position lengthBlock = (appendLength < blockSize) ? appendLength : blockSize;
+			Block *pb = new Block(data, lengthBlock);
+			if (lengthBody == 0) {
+				// Replace the empty block
+				delete BlockAt(0);
+				blocks.SetValueAt(0, pb);
+			} else {
+				blocks.Insert(blocks.Length(), pb);
+				starts.InsertPartition(blocks.Length() - 1, lengthBody);
+			}
+			starts.InsertText(blocks.Length() - 1, lengthBlock);
+			lengthBody += lengthBlock;
+			if (data)
+				data += lengthBlock;
+			appendLength -= lengthBlock;
+		}
+	}
+
+	/// Whether any block still refers to shared elements.
+	bool HoldsShared() const {
+		for (Sci_Position b = 0; b < blocks.Length(); b++) {
+			if (BlockAt(static_cast<int>(b))->IsShared())
+				return true;
+		}
+		return false;
+	}
+
+	/// Gather all elements into one owned block and return a pointer to them followed by a 0.
+	/// The next edit will divide the array into blocks again.
+	const T *BufferPointer() {
+		while (blocks.Length() > 1) {
+			MergeWithNext(0);
+		}
+		return BlockAt(0)->Owned().BufferPointer();
+	}
+
+	/// Return a pointer to a contiguous range, merging blocks if the range crosses blocks.
+	const T *RangePointer(Sci_Position position, Sci_Position rangeLength) {
+		const int block = BlockFromPosition(position);
+		const Sci_Position offset = position - BlockStart(block);
+		while (((offset + rangeLength) > BlockAt(block)->Length()) && (block + 1 < blocks.Length())) {
+			MergeWithNext(block);
+		}
+		return BlockAt(block)->RangePointer(offset, rangeLength);
+	}
+
+	/// Retrieve the contiguous storage that contains position without merging blocks.
+	/// The start position and length of that storage are returned.
+	const T *ContiguousRange(Sci_Position position, Sci_Position &start, Sci_Position &length) const {
+		const int block = BlockFromPosition(position);
+		const Sci_Position blockStart = BlockStart(block);
+		const T *range = BlockAt(block)->ContiguousRange(position - blockStart, start, length);
+		start += blockStart;
+		return range;
+	}
+
+	/// There is no single gap so report the end which makes callers treat
+	/// the whole array as one range.
+	Sci_Position GapPosition() const {
+		return lengthBody;
+	}
+};
+
+#endif
@@ -10,11 +10,20 @@
 #include <stdlib.h>
 #include <stdarg.h>
 
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CELLBUFFER_SSE2
+#endif
+
 #include "Platform.h"
 
 #include "Scintilla.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "CellBuffer.h"
 #include "UniConversion.h"
 
@@ -41,11 +50,11 @@ void LineVector::SetPerLine(PerLine *pl) {
 	perLine = pl;
 }
 
-void LineVector::InsertText(int line, int delta) {
+void LineVector::InsertText(int line, Sci_Position delta) {
 	starts.InsertText(line, delta);
 }
 
-void LineVector::InsertLine(int line, int position, bool lineStart) {
+void LineVector::InsertLine(int line, Sci_Position position, bool lineStart) {
 	starts.InsertPartition(line, position);
 	if (perLine) {
 		if ((line > 0) && lineStart)
@@ -54,7 +63,7 @@ void LineVector::InsertLine(int line, int position, bool lineStart) {
 	}
 }
 
-void LineVector::SetLineStart(int line, int position) {
+void LineVector::SetLineStart(int line, Sci_Position position) {
 	starts.SetPartitionStartPosition(line, position);
 }
 
@@ -65,7 +74,7 @@ void LineVector::RemoveLine(int line) {
 	}
 }
 
-int LineVector::LineFromPosition(int pos) const {
+int LineVector::LineFromPosition(Sci_Position pos) const {
 	return starts.PartitionFromPosition(pos);
 }
 
@@ -81,8 +90,8 @@ Action::~Action() {
 	Destroy();
 }
 
-void Action::Create(actionType at_, int position_, char *data_, int lenData_, bool mayCoalesce_) {
-	delete []data;
+// The text of actions is owned by the UndoArena of the history so actions only refer to it.
+void Action::Create(actionType at_, Sci_Position position_, char *data_, Sci_Position lenData_, bool mayCoalesce_) {
 	position = position_;
 	at = at_;
 	data = data_;
@@ -91,20 +100,16 @@ void Action::Create(actionType at_, int position_, char *data_, int lenData_, bo
 }
 
 void Action::Destroy() {
-	delete []data;
 	data = 0;
 }
 
 void Action::Grab(Action *source) {
-	delete []data;
-
 	position = source->position;
 	at = source->at;
 	data = source->data;
 	lenData = source->lenData;
 	mayCoalesce = source->mayCoalesce;
 
-	// Ownership of source data transferred to this
 	source->position = 0;
 	source->at = startAction;
 	source->data = 0;
@@ -129,6 +134,81 @@ void Action::Grab(Action *source) {
 // operation. If there is no outstanding BeginUndoAction call then a new operation is started
 // unless it looks as if the new action is caused by the user typing or deleting a stream of text.
 // Sequences that look like typing or deletion are coalesced into a single user operation.
+// Where coalesced actions are contiguous insertions or forward deletions, they are merged
+// into a single action so typing a line of text costs one action rather than one per character.
+// The text of all actions is stored in an UndoArena in the same order as the actions.
+// A memory limit may be set, in which case the oldest user operations are discarded
+// when the history grows beyond the limit.
+
+UndoArena::UndoArena() : first(0), last(0), memory(0) {
+}
+
+UndoArena::~UndoArena() {
+	Clear();
+}
+
+void UndoArena::Free(Block *block) {
+	if (block->previous)
+		block->previous->next = block->next;
+	else
+		first = block->next;
+	if (block->next)
+		block->next->previous = block->previous;
+	else
+		last = block->previous;
+	memory -= sizeof(Block) + block->size;
+	delete []block->text;
+	delete block;
+}
+
+void UndoArena::Clear() {
+	while (last)
+		Free(last);
+}
+
+char *UndoArena::Allocate(Sci_Position length) {
+	if (length <= 0)
+		return 0;
+	if (!last || (last->size - last->used < length)) {
+		Block *block = new Block;
+		block->size = (length > blockSize) ? length : static_cast<Sci_Position>(blockSize);
+		block->text = new char[block->size];
+		block->used = 0;
+		block->previous = last;
+		block->next = 0;
+		if (last)
+			last->next = block;
+		else
+			first = block;
+		last = block;
+		memory += sizeof(Block) + block->size;
+	}
+	char *text = last->text + last->used;
+	last->used += length;
+	return text;
+}
+
+// Discard all text after end which must be inside a block or 0 to discard everything.
+void UndoArena::TruncateAfter(const char *end) {
+	if (!end) {
+		Clear();
+		return;
+	}
+	while (last && !last->Contains(end))
+		Free(last);
+	if (last)
+		last->used = end - last->text;
+}
+
+// Discard all blocks before the block containing start or everything when start is 0.
+void UndoArena::ReleaseBefore(const char *start) {
+	if (!start) {
+		Clear();
+		return;
+	}
+	while (first && !first->Contains(start))
+		Free(first);
+}
 
 UndoHistory::UndoHistory() {
 
@@ -138,6 +218,8 @@ UndoHistory::UndoHistory() {
 	currentAction = 0;
 	undoSequenceDepth = 0;
 	savePoint = 0;
+	memoryLimit = 0;
+	memoryNextCheck = 0;
 
 	actions[currentAction].Create(startAction);
 }
@@ -162,7 +244,25 @@ void UndoHistory::EnsureUndoRoom() {
 	}
 }
 
-void UndoHistory::AppendAction(actionType at, int position, char *data, int lengthData,
+// The end of the text of the last action before actionEnd that has text.
+const char *UndoHistory::TextEnd(int actionEnd) const {
+	for (int act = actionEnd - 1; act >= 0; act--) {
+		if (actions[act].data)
+			return actions[act].data + actions[act].lenData;
+	}
+	return 0;
+}
+
+// The start of the text of the first action at or after actionStart that has text.
+const char *UndoHistory::TextStart(int actionStart) const {
+	for (int act = actionStart; act <= maxAction; act++) {
+		if (actions[act].data)
+			return actions[act].data;
+	}
+	return 0;
+}
+
+char *UndoHistory::AppendAction(actionType at, Sci_Position position, Sci_Position lengthData,
 	bool &startSequence, bool mayCoalesce) {
 	EnsureUndoRoom();
 	//Platform::DebugPrintf("%% %d action %d %d %d\n", at, position, lengthData, currentAction);
@@ -226,10 +326,75 @@ void UndoHistory::AppendAction(actionType at, int position, char *data, int leng
 		currentAction++;
 	}
 	startSequence = oldCurrentAction != currentAction;
-	actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
-	currentAction++;
-	actions[currentAction].Create(startAction);
+	if (maxAction > oldCurrentAction) {
+		// Discard the text of actions that could have been redone
+		arena.TruncateAfter(TextEnd(oldCurrentAction));
+	}
+	char *data = arena.Allocate(lengthData);
+	Action *actPrevious = (currentAction >= 1) ? &actions[currentAction - 1] : 0;
+	// Merging is not possible at the save point as that would hide the modification
+	if (!startSequence && data && actPrevious && (currentAction != savePoint) && (actPrevious->at == at) &&
+		actPrevious->mayCoalesce && mayCoalesce &&
+		(actPrevious->data + actPrevious->lenData == data) &&
+		(((at == insertAction) && (position == actPrevious->position + actPrevious->lenData)) ||
+		((at == removeAction) && (position == actPrevious->position)))) {
+		// Contiguous with previous action so extend it
+		actPrevious->lenData += lengthData;
+		actions[currentAction].Create(startAction);
+	} else {
+		actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
+		currentAction++;
+		actions[currentAction].Create(startAction);
+	}
 	maxAction = currentAction;
+	if (startSequence) {
+		// A new user operation means an older one may now be dropped
+		memoryNextCheck = 0;
+	}
+	EnforceMemoryLimit();
+	return data;
+}
+
+void UndoHistory::DropActions(int actionsDrop) {
+	arena.ReleaseBefore(TextStart(actionsDrop));
+	for (int act = actionsDrop; act <= maxAction; act++)
+		actions[act - actionsDrop].Grab(&actions[act]);
+	maxAction -= actionsDrop;
+	currentAction -= actionsDrop;
+	if (savePoint >= 0)
+		savePoint = (savePoint < actionsDrop) ? -1 : savePoint - actionsDrop;
+}
+
+void UndoHistory::EnforceMemoryLimit() {
+	if ((memoryLimit == 0) || (Memory() <= memoryLimit) || (Memory() <= memoryNextCheck))
+		return;
+	// Find the earliest boundary between user operations that brings memory down to
+	// three quarters of the limit so that dropping is not needed for each action.
+	// The current user operation is never dropped.
+	const size_t target = memoryLimit / 4 * 3;
+	const size_t memoryArena = arena.Memory();
+	const UndoArena::Block *block = arena.First();
+	size_t freed = 0;
+	int actionsDrop = 0;
+	for (int act = 1; act < currentAction; act++) {
+		if (actions[act].data) {
+			while (block && !block->Contains(actions[act].data)) {
+				freed += sizeof(UndoArena::Block) + block->size;
+				block = block->next;
+			}
+		}
+		if (actions[act].at == startAction) {
+			actionsDrop = act;
+			const size_t memoryActions = (maxAction + 1 - act) * sizeof(Action);
+			if (memoryArena - freed + memoryActions <= target)
+				break;
+		}
+	}
+	if (actionsDrop > 0)
+		DropActions(actionsDrop);
+	// When the current user operation is too large to fit, wait for it to grow by a quarter
+	// of the limit before trying again.
+	memoryNextCheck = (Memory() > memoryLimit) ? Memory() + memoryLimit / 4 : 0;
 }
 
 void UndoHistory::BeginUndoAction() {
@@ -266,10 +431,26 @@ void UndoHistory::DropUndoSequence() {
 void UndoHistory::DeleteUndoHistory() {
 	for (int i = 1; i < maxAction; i++)
 		actions[i].Destroy();
+	arena.Clear();
 	maxAction = 0;
 	currentAction = 0;
 	actions[currentAction].Create(startAction);
 	savePoint = 0;
+	memoryNextCheck = 0;
+}
+
+void UndoHistory::SetMemoryLimit(size_t limit) {
+	memoryLimit = limit;
+	memoryNextCheck = 0;
+	EnforceMemoryLimit();
+}
+
+size_t UndoHistory::GetMemoryLimit() const {
+	return memoryLimit;
+}
+
+size_t UndoHistory::Memory() const {
+	return arena.Memory() + (maxAction + 1) * sizeof(Action);
 }
 
 void UndoHistory::SetSavePoint() {
@@ -339,35 +520,35 @@ CellBuffer::CellBuffer() {
 CellBuffer::~CellBuffer() {
 }
 
-char CellBuffer::CharAt(int position) const {
+char CellBuffer::CharAt(Sci_Position position) const {
 	return substance.ValueAt(position);
 }
 
-void CellBuffer::GetCharRange(char *buffer, int position, int lengthRetrieve) const {
+void CellBuffer::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
 	if (lengthRetrieve < 0)
 		return;
 	if (position < 0)
 		return;
 	if ((position + lengthRetrieve) > substance.Length()) {
-		Platform::DebugPrintf("Bad GetCharRange %d for %d of %d\n", position,
-		                      lengthRetrieve, substance.Length());
+		Platform::DebugPrintf("Bad GetCharRange %d for %d of %d\n", static_cast<int>(position),
+		                      static_cast<int>(lengthRetrieve), static_cast<int>(substance.Length()));
 		return;
 	}
 	substance.GetRange(buffer, position, lengthRetrieve);
 }
 
-char CellBuffer::StyleAt(int position) const {
+char CellBuffer::StyleAt(Sci_Position position) const {
 	return style.ValueAt(position);
 }
 
-void CellBuffer::GetStyleRange(unsigned char *buffer, int position, int lengthRetrieve) const {
+void CellBuffer::GetStyleRange(unsigned char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
 	if (lengthRetrieve < 0)
 		return;
 	if (position < 0)
 		return;
 	if ((position + lengthRetrieve) > style.Length()) {
-		Platform::DebugPrintf("Bad GetStyleRange %d for %d of %d\n", position,
-		                      lengthRetrieve, style.Length());
+		Platform::DebugPrintf("Bad GetStyleRange %d for %d of %d\n", static_cast<int>(position),
+		                      static_cast<int>(lengthRetrieve), static_cast<int>(style.Length()));
 		return;
 	}
 	style.GetRange(reinterpret_cast<char *>(buffer), position, lengthRetrieve);
@@ -377,27 +558,225 @@ const char *CellBuffer::BufferPointer() {
 	return substance.BufferPointer();
 }
 
-const char *CellBuffer::RangePointer(int position, int rangeLength) {
+const char *CellBuffer::RangePointer(Sci_Position position, Sci_Position rangeLength) {
 	return substance.RangePointer(position, rangeLength);
 }
 
-int CellBuffer::GapPosition() const {
+Sci_Position CellBuffer::GapPosition() const {
 	return substance.GapPosition();
 }
 
+const char *CellBuffer::ContiguousRangePointer(Sci_Position position, Sci_Position rangeLength) const {
+	Sci_Position start = 0;
+	Sci_Position lengthRange = 0;
+	const char *range = substance.ContiguousRange(position, start, lengthRange);
+	if (range && (position + rangeLength <= start + lengthRange))
+		return range + (position - start);
+	return 0;
+}
+
+const char *CellBuffer::ContiguousRange(Sci_Position position, Sci_Position &start, Sci_Position &length) const {
+	start = 0;
+	length = 0;
+	if ((position < 0) || (position >= Length()))
+		return 0;
+	return substance.ContiguousRange(position, start, length);
+}
+
+static inline bool ByteMatches(char ch, char target, const char *fold) {
+	return (fold ? fold[static_cast<unsigned char>(ch)] : ch) == target;
+}
+
+static bool BytesMatch(const char *text, const char *s, Sci_Position length, const char *fold) {
+	if (!fold)
+		return memcmp(text, s, length) == 0;
+	for (Sci_Position i = 0; i < length; i++) {
+		if (fold[static_cast<unsigned char>(text[i])] != s[i])
+			return false;
+	}
+	return true;
+}
+
+#ifdef CELLBUFFER_SSE2
+
+// Find the bytes that fold to target. Only the first two are stored as that is all
+// the vector filter can check. Returns how many there are.
+static int FoldEquivalents(char target, const char *fold, char *equivalents) {
+	if (!fold) {
+		equivalents[0] = target;
+		equivalents[1] = target;
+		return 1;
+	}
+	int count = 0;
+	for (int ch = 0; ch < 0x100; ch++) {
+		if (fold[ch] == target) {
+			if (count < 2)
+				equivalents[count] = static_cast<char>(ch);
+			count++;
+		}
+	}
+	if (count == 1)
+		equivalents[1] = equivalents[0];
+	return count;
+}
+
+// For 16 candidate positions, mark those where both the first and last bytes match.
+static inline int CandidateMask(const char *text, Sci_Position length,
+	__m128i first0, __m128i first1, __m128i last0, __m128i last1) {
+	const __m128i chunkFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+	const __m128i chunkLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + length - 1));
+	const __m128i matchFirst = _mm_or_si128(_mm_cmpeq_epi8(chunkFirst, first0), _mm_cmpeq_epi8(chunkFirst, first1));
+	const __m128i matchLast = _mm_or_si128(_mm_cmpeq_epi8(chunkLast, last0), _mm_cmpeq_epi8(chunkLast, last1));
+	return _mm_movemask_epi8(_mm_and_si128(matchFirst, matchLast));
+}
+
+#endif
+
+// Matches that straddle the gap or a block boundary are checked a byte at a time.
+bool CellBuffer::MatchesAt(Sci_Position position, const char *s, Sci_Position length, const char *fold) const {
+	for (Sci_Position i = 0; i < length; i++) {
+		if (!ByteMatches(substance.ValueAt(position + i), s[i], fold))
+			return false;
+	}
+	return true;
+}
+
+// Searches each contiguous part of the storage directly rather than through CharAt.
+// Candidates are filtered on their first and last bytes, 16 at a time with SSE2,
+// or by memchr on the first byte otherwise, before the whole match is compared.
+Sci_Position CellBuffer::FindBytes(Sci_Position rangeStart, Sci_Position rangeEnd, const char *s, Sci_Position length,
+	const char *fold, bool forward) const {
+	if (rangeStart < 0)
+		rangeStart = 0;
+	if (rangeEnd > Length())
+		rangeEnd = Length();
+	const Sci_Position lastStart = rangeEnd - length;
+	if ((length <= 0) || (lastStart < rangeStart))
+		return -1;
+	const char first = s[0];
+#ifdef CELLBUFFER_SSE2
+	char equivalentsFirst[2];
+	char equivalentsLast[2];
+	const int countFirst = FoldEquivalents(first, fold, equivalentsFirst);
+	const int countLast = FoldEquivalents(s[length - 1], fold, equivalentsLast);
+	if ((countFirst == 0) || (countLast == 0))
+		return -1;
+	const bool useVector = (countFirst <= 2) && (countLast <= 2);
+	const __m128i first0 = _mm_set1_epi8(equivalentsFirst[0]);
+	const __m128i first1 = _mm_set1_epi8(equivalentsFirst[1]);
+	const __m128i last0 = _mm_set1_epi8(equivalentsLast[0]);
+	const __m128i last1 = _mm_set1_epi8(equivalentsLast[1]);
+#endif
+	if (forward) {
+		Sci_Position pos = rangeStart;
+		while (pos <= lastStart) {
+			Sci_Position start = 0;
+			Sci_Position lengthRange = 0;
+			const char *range = substance.ContiguousRange(pos, start, lengthRange);
+			const Sci_Position end = start + lengthRange;
+			if (!range || (end <= pos)) {
+				// Not expected but ensure progress
+				if (MatchesAt(pos, s, length, fold))
+					return pos;
+				pos++;
+				continue;
+			}
+			// Candidates before endWhole are followed by the whole match length in this range
+			const Sci_Position endCandidates = (end < lastStart + 1) ? end : lastStart + 1;
+			const Sci_Position endWhole = (endCandidates < end - length + 1) ? endCandidates : end - length + 1;
+#ifdef CELLBUFFER_SSE2
+			if (useVector) {
+				while (pos + 16 <= endWhole) {
+					const char *text = range + (pos - start);
+					int mask = CandidateMask(text, length, first0, first1, last0, last1);
+					while (mask) {
+						int offset = 0;
+						while (!(mask & (1 << offset)))
+							offset++;
+						if (BytesMatch(text + offset, s, length, fold))
+							return pos + offset;
+						mask &= mask - 1;
+					}
+					pos += 16;
+				}
+			}
+#endif
+			while (pos < endCandidates) {
+				const char *text = range + (pos - start);
+				if (!fold && (pos < endWhole)) {
+					// Jump to the next occurrence of the first byte
+					const char *hit = static_cast<const char *>(memchr(text, first, endWhole - pos));
+					if (!hit) {
+						pos = endWhole;
+						continue;
+					}
+					pos += hit - text;
+					text = hit;
+				}
+				if (ByteMatches(*text, first, fold) &&
+					((pos < endWhole) ? BytesMatch(text, s, length, fold) : MatchesAt(pos, s, length, fold)))
+					return pos;
+				pos++;
+			}
+		}
+	} else {
+		Sci_Position pos = lastStart;
+		while (pos >= rangeStart) {
+			Sci_Position start = 0;
+			Sci_Position lengthRange = 0;
+			const char *range = substance.ContiguousRange(pos, start, lengthRange);
+			const Sci_Position end = start + lengthRange;
+			if (!range || (end <= pos)) {
+				if (MatchesAt(pos, s, length, fold))
+					return pos;
+				pos--;
+				continue;
+			}
+			const Sci_Position startCandidates = (start > rangeStart) ? start : rangeStart;
+			const Sci_Position endWhole = end - length + 1;
+			// Matches that straddle the end of this range
+			for (; (pos >= startCandidates) && (pos >= endWhole); pos--) {
+				if (MatchesAt(pos, s, length, fold))
+					return pos;
+			}
+#ifdef CELLBUFFER_SSE2
+			if (useVector) {
+				while (pos - 15 >= startCandidates) {
+					const char *text = range + (pos - 15 - start);
+					int mask = CandidateMask(text, length, first0, first1, last0, last1);
+					while (mask) {
+						int offset = 15;
+						while (!(mask & (1 << offset)))
+							offset--;
+						if (BytesMatch(text + offset, s, length, fold))
+							return pos - 15 + offset;
+						mask &= ~(1 << offset);
+					}
+					pos -= 16;
+				}
+			}
+#endif
+			for (; pos >= startCandidates; pos--) {
+				const char *text = range + (pos - start);
+				if (ByteMatches(*text, first, fold) && BytesMatch(text, s, length, fold))
+					return pos;
+			}
+		}
+	}
+	return -1;
+}
+
 // The char* returned is to an allocation owned by the undo history
-const char *CellBuffer::InsertString(int position, const char *s, int insertLength, bool &startSequence) {
+const char *CellBuffer::InsertString(Sci_Position position, const char *s, Sci_Position insertLength, bool &startSequence) {
 	char *data = 0;
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
 	if (!readOnly) {
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
 			// This takes up about half load time
-			data = new char[insertLength];
-			for (int i = 0; i < insertLength; i++) {
-				data[i] = s[i];
-			}
-			uh.AppendAction(insertAction, position, data, insertLength, startSequence);
+			data = uh.AppendAction(insertAction, position, insertLength, startSequence);
+			if (data)
+				memcpy(data, s, insertLength);
 		}
 
 		BasicInsertString(position, s, insertLength);
@@ -405,7 +784,33 @@ const char *CellBuffer::InsertString(int position, const char *s, int insertLeng
 	return data;
 }
 
-bool CellBuffer::SetStyleAt(int position, char styleValue, char mask) {
+bool CellBuffer::AppendShared(const char *s, Sci_Position insertLength) {
+#ifdef SCI_BLOCK_STORAGE
+	BasicInsertString(Length(), s, insertLength, true);
+	return true;
+#else
+	BasicInsertString(Length(), s, insertLength);
+	return false;
+#endif
+}
+
+bool CellBuffer::HoldsShared() const {
+#ifdef SCI_BLOCK_STORAGE
+	return substance.HoldsShared();
+#else
+	return false;
+#endif
+}
+
+bool CellBuffer::CanHoldShared() {
+#ifdef SCI_BLOCK_STORAGE
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool CellBuffer::SetStyleAt(Sci_Position position, char styleValue, char mask) {
 	styleValue &= mask;
 	char curVal = style.ValueAt(position);
 	if ((curVal & mask) != styleValue) {
@@ -416,34 +821,73 @@ bool CellBuffer::SetStyleAt(int position, char styleValue, char mask) {
 	}
 }
 
-bool CellBuffer::SetStyleFor(int position, int lengthStyle, char styleValue, char mask) {
+// Enough to cover the styles a lexer sends at once without a large stack frame
+static const Sci_Position styleBlockSize = 4096;
+
+bool CellBuffer::SetStyleFor(Sci_Position position, Sci_Position lengthStyle, char styleValue, char mask,
+	Sci_Position &changeStart, Sci_Position &changeEnd) {
+	char styles[styleBlockSize];
+	memset(styles, styleValue, (lengthStyle < styleBlockSize) ? lengthStyle : styleBlockSize);
 	bool changed = false;
-	PLATFORM_ASSERT(lengthStyle == 0 ||
-		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
-	while (lengthStyle--) {
-		char curVal = style.ValueAt(position);
-		if ((curVal & mask) != styleValue) {
-			style.SetValueAt(position, static_cast<char>((curVal & ~mask) | styleValue));
+	while (lengthStyle > 0) {
+		const Sci_Position lengthBlock = (lengthStyle < styleBlockSize) ? lengthStyle : styleBlockSize;
+		Sci_Position startBlock = 0;
+		if (SetStyles(position, lengthBlock, styles, mask, startBlock, changeEnd)) {
+			if (!changed)
+				changeStart = startBlock;
 			changed = true;
 		}
-		position++;
+		position += lengthBlock;
+		lengthStyle -= lengthBlock;
+	}
+	return changed;
+}
+
+bool CellBuffer::SetStyles(Sci_Position position, Sci_Position lengthStyle, const char *styles, char mask,
+	Sci_Position &changeStart, Sci_Position &changeEnd) {
+	PLATFORM_ASSERT(lengthStyle >= 0 && position >= 0);
+	// Styles past the end are dropped as a lexer may overrun by a character
+	if (position + lengthStyle > style.Length())
+		lengthStyle = style.Length() - position;
+	bool changed = false;
+	char current[styleBlockSize];
+	for (Sci_Position offset = 0; offset < lengthStyle; offset += styleBlockSize) {
+		const Sci_Position lengthBlock = (lengthStyle - offset < styleBlockSize) ?
+			lengthStyle - offset : styleBlockSize;
+		const char *wanted = styles + offset;
+		style.GetRange(current, position + offset, lengthBlock);
+		if ((mask == '\377') && (memcmp(current, wanted, lengthBlock) == 0))
+			continue;
+		Sci_Position first = 0;
+		while ((first < lengthBlock) && (((current[first] ^ wanted[first]) & mask) == 0))
+			first++;
+		if (first == lengthBlock)
+			continue;
+		Sci_Position last = lengthBlock - 1;
+		while (((current[last] ^ wanted[last]) & mask) == 0)
+			last--;
+		for (Sci_Position i = first; i <= last; i++)
+			current[i] = static_cast<char>((current[i] & ~mask) | (wanted[i] & mask));
+		style.SetRange(current + first, position + offset + first, last - first + 1);
+		if (!changed)
+			changeStart = position + offset + first;
+		changeEnd = position + offset + last + 1;
+		changed = true;
 	}
 	return changed;
 }
 
 // The char* returned is to an allocation owned by the undo history
-const char *CellBuffer::DeleteChars(int position, int deleteLength, bool &startSequence) {
+const char *CellBuffer::DeleteChars(Sci_Position position, Sci_Position deleteLength, bool &startSequence) {
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
 	PLATFORM_ASSERT(deleteLength > 0);
 	char *data = 0;
 	if (!readOnly) {
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
-			data = new char[deleteLength];
-			for (int i = 0; i < deleteLength; i++) {
-				data[i] = substance.ValueAt(position + i);
-			}
-			uh.AppendAction(removeAction, position, data, deleteLength, startSequence);
+			data = uh.AppendAction(removeAction, position, deleteLength, startSequence);
+			if (data)
+				substance.GetRange(data, position, deleteLength);
 		}
 
 		BasicDeleteChars(position, deleteLength);
@@ -451,11 +895,105 @@ const char *CellBuffer::DeleteChars(int position, int deleteLength, bool &startS
 	return data;
 }
 
-int CellBuffer::Length() const {
+// The text of a replaceAction starts with this header followed by the ranges then the removed
+// and inserted text of each range in turn.
+struct ReplaceHeader {
+	int count;
+	int linesRemoved;
+	int linesInserted;
+};
+
+static const Sci_Position replaceRangesOffset = sizeof(ReplaceHeader);
+
+static Sci_Position ReplaceTextOffset(int count) {
+	return replaceRangesOffset + count * static_cast<Sci_Position>(sizeof(ReplacedRange));
+}
+
+int CellBuffer::ReplaceSpan(Sci_Position position, Sci_Position lengthOld, const char *spanNew, Sci_Position lengthNew,
+	const ReplacedRange *ranges, int count, bool &startSequence) {
+	int linesRemoved = 0;
+	if (!readOnly) {
+		char *data = 0;
+		if (collectingUndo) {
+			// Only the text of the ranges is saved as the text between them is unchanged
+			Sci_Position lengthData = ReplaceTextOffset(count);
+			for (int r = 0; r < count; r++)
+				lengthData += ranges[r].lengthRemoved + ranges[r].lengthInserted;
+			data = uh.AppendAction(replaceAction, position, lengthData, startSequence, false);
+			memcpy(data + replaceRangesOffset, ranges, count * sizeof(ReplacedRange));
+			char *text = data + ReplaceTextOffset(count);
+			Sci_Position delta = 0;
+			for (int r = 0; r < count; r++) {
+				substance.GetRange(text, position + ranges[r].offset, ranges[r].lengthRemoved);
+				text += ranges[r].lengthRemoved;
+				memcpy(text, spanNew + ranges[r].offset + delta, ranges[r].lengthInserted);
+				text += ranges[r].lengthInserted;
+				delta += ranges[r].lengthInserted - ranges[r].lengthRemoved;
+			}
+		}
+
+		const int linesBefore = lv.Lines();
+		linesRemoved = BasicReplaceSpan(position, lengthOld, spanNew, lengthNew, ranges, count);
+		if (data) {
+			const ReplaceHeader header = { count, linesRemoved, lv.Lines() - linesBefore + linesRemoved };
+			memcpy(data, &header, sizeof(header));
+		}
+	}
+	return linesRemoved;
+}
+
+int CellBuffer::ReplaceStepRanges(const Action &action, bool undo, ReplacedRange *ranges,
+	int &linesRemoved, int &linesInserted) {
+	ReplaceHeader header;
+	memcpy(&header, action.data, sizeof(header));
+	linesRemoved = undo ? header.linesInserted : header.linesRemoved;
+	linesInserted = undo ? header.linesRemoved : header.linesInserted;
+	if (ranges) {
+		memcpy(ranges, action.data + replaceRangesOffset, header.count * sizeof(ReplacedRange));
+		if (undo) {
+			// Undoing replaces the inserted text, found where it is after the earlier ranges changed
+			Sci_Position delta = 0;
+			for (int r = 0; r < header.count; r++) {
+				const Sci_Position lengthRemoved = ranges[r].lengthRemoved;
+				ranges[r].offset += delta;
+				ranges[r].lengthRemoved = ranges[r].lengthInserted;
+				ranges[r].lengthInserted = lengthRemoved;
+				delta += ranges[r].lengthRemoved - lengthRemoved;
+			}
+		}
+	}
+	return header.count;
+}
+
+Sci_Position CellBuffer::ReplaceStepText(const Action &action, bool undo, char *spanNew) const {
+	int linesRemoved = 0;
+	int linesInserted = 0;
+	const int count = ReplaceStepRanges(action, undo, 0, linesRemoved, linesInserted);
+	std::vector<ReplacedRange> ranges(count);
+	ReplaceStepRanges(action, undo, &ranges[0], linesRemoved, linesInserted);
+	const char *text = action.data + ReplaceTextOffset(count);
+	Sci_Position offsetOld = 0;
+	Sci_Position offsetNew = 0;
+	for (int r = 0; r < count; r++) {
+		const Sci_Position lengthKept = ranges[r].offset - offsetOld;
+		// Undo restores the removed text which is before the inserted text of each range
+		const char *textRange = undo ? text : text + ranges[r].lengthRemoved;
+		if (spanNew) {
+			substance.GetRange(spanNew + offsetNew, action.position + offsetOld, lengthKept);
+			memcpy(spanNew + offsetNew + lengthKept, textRange, ranges[r].lengthInserted);
+		}
+		offsetNew += lengthKept + ranges[r].lengthInserted;
+		offsetOld = ranges[r].offset + ranges[r].lengthRemoved;
+		text += ranges[r].lengthRemoved + ranges[r].lengthInserted;
+	}
+	return offsetNew;
+}
+
+Sci_Position CellBuffer::Length() const {
 	return substance.Length();
 }
 
-void CellBuffer::Allocate(int newSize) {
+void CellBuffer::Allocate(Sci_Position newSize) {
 	substance.ReAllocate(newSize);
 	style.ReAllocate(newSize);
 }
@@ -475,7 +1013,7 @@ int CellBuffer::Lines() const {
 	return lv.Lines();
 }
 
-int CellBuffer::LineStart(int line) const {
+Sci_Position CellBuffer::LineStart(int line) const {
 	if (line < 0)
 		return 0;
 	else if (line >= Lines())
@@ -502,7 +1040,7 @@ bool CellBuffer::IsSavePoint() {
 
 // Without undo
 
-void CellBuffer::InsertLine(int line, int position, bool lineStart) {
+void CellBuffer::InsertLine(int line, Sci_Position position, bool lineStart) {
 	lv.InsertLine(line, position, lineStart);
 }
 
@@ -510,7 +1048,7 @@ void CellBuffer::RemoveLine(int line) {
 	lv.RemoveLine(line);
 }
 
-bool CellBuffer::UTF8LineEndOverlaps(int position) const {
+bool CellBuffer::UTF8LineEndOverlaps(Sci_Position position) const {
 	unsigned char bytes[] = {
 		static_cast<unsigned char>(substance.ValueAt(position-2)),
 		static_cast<unsigned char>(substance.ValueAt(position-1)),
@@ -524,14 +1062,14 @@ void CellBuffer::ResetLineEnds() {
 	// Reinitialize line data -- too much work to preserve
 	lv.Init();
 
-	int position = 0;
-	int length = Length();
+	Sci_Position position = 0;
+	Sci_Position length = Length();
 	int lineInsert = 1;
 	bool atLineStart = true;
 	lv.InsertText(lineInsert-1, length);
 	unsigned char chBeforePrev = 0;
 	unsigned char chPrev = 0;
-	for (int i = 0; i < length; i++) {
+	for (Sci_Position i = 0; i < length; i++) {
 		unsigned char ch = substance.ValueAt(position + i);
 		if (ch == '\r') {
 			InsertLine(lineInsert, (position + i) + 1, atLineStart);
@@ -556,7 +1094,38 @@ void CellBuffer::ResetLineEnds() {
 	}
 }
 
-void CellBuffer::BasicInsertString(int position, const char *s, int insertLength) {
+/// Position of the first CR or LF in s from start up to end, or end when there are none.
+static Sci_Position NextLineEnd(const char *s, Sci_Position start, Sci_Position end) {
+	Sci_Position i = start;
+#ifdef CELLBUFFER_SSE2
+	// Compare 16 bytes at a time
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	while (i + 16 <= end) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+		const int mask = _mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)));
+		if (mask) {
+			// The lowest set bit is the first line end
+			int offset = 0;
+			while (!(mask & (1 << offset)))
+				offset++;
+			return i + offset;
+		}
+		i += 16;
+	}
+#endif
+	while ((i < end) && (s[i] != '\r') && (s[i] != '\n'))
+		i++;
+	return i;
+}
+
+#ifdef SCI_BLOCK_STORAGE
+void CellBuffer::BasicInsertString(Sci_Position position, const char *s, Sci_Position insertLength, bool shared) {
+#else
+// The gap buffer can not share text so always copies
+void CellBuffer::BasicInsertString(Sci_Position position, const char *s, Sci_Position insertLength, bool) {
+#endif
 	if (insertLength == 0)
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
@@ -567,8 +1136,17 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 		breakingUTF8LineEnd = UTF8LineEndOverlaps(position);
 	}
 
-	substance.InsertFromArray(position, s, 0, insertLength);
-	style.InsertValue(position, insertLength, 0);
+#ifdef SCI_BLOCK_STORAGE
+	if (shared) {
+		// Only appends may share so the text can not split an existing block
+		substance.AppendShared(s, insertLength);
+		style.AppendShared(0, insertLength);
+	} else
+#endif
+	{
+		substance.InsertFromArray(position, s, 0, insertLength);
+		style.InsertValue(position, insertLength, 0);
+	}
 
 	int lineInsert = lv.LineFromPosition(position) + 1;
 	bool atLineStart = lv.LineStart(lineInsert-1) == position;
@@ -585,7 +1163,19 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 		RemoveLine(lineInsert);
 	}
 	unsigned char ch = ' ';
-	for (int i = 0; i < insertLength; i++) {
+	for (Sci_Position i = 0; i < insertLength; i++) {
+		if (!utf8LineEnds) {
+			// Only CR and LF end lines so skip over other characters
+			const Sci_Position iLineEnd = NextLineEnd(s, i, insertLength);
+			if (iLineEnd > i) {
+				chBeforePrev = (iLineEnd - i > 1) ? s[iLineEnd - 2] : chPrev;
+				chPrev = s[iLineEnd - 1];
+				ch = chPrev;
+				i = iLineEnd;
+				if (i == insertLength)
+					break;
+			}
+		}
 		ch = s[i];
 		if (ch == '\r') {
 			InsertLine(lineInsert, (position + i) + 1, atLineStart);
@@ -633,7 +1223,7 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 	}
 }
 
-void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
+void CellBuffer::BasicDeleteChars(Sci_Position position, Sci_Position deleteLength) {
 	if (deleteLength == 0)
 		return;
 
@@ -664,7 +1254,7 @@ void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 		}
 
 		unsigned char ch = chNext;
-		for (int i = 0; i < deleteLength; i++) {
+		for (Sci_Position i = 0; i < deleteLength; i++) {
 			chNext = substance.ValueAt(position + i + 1);
 			if (ch == '\r') {
 				if (chNext != '\n') {
@@ -701,6 +1291,120 @@ void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 	style.DeleteRange(position, deleteLength);
 }
 
+bool CellBuffer::IsLineStartAt(Sci_Position position) const {
+	const unsigned char chPrev = substance.ValueAt(position - 1);
+	if (chPrev == '\n') {
+		return true;
+	} else if (chPrev == '\r') {
+		// The start of a crlf pair ends its line after the lf
+		return substance.ValueAt(position) != '\n';
+	} else if (utf8LineEnds && !UTF8IsAscii(chPrev)) {
+		const unsigned char back3[3] = {
+			static_cast<unsigned char>(substance.ValueAt(position - 3)),
+			static_cast<unsigned char>(substance.ValueAt(position - 2)),
+			chPrev,
+		};
+		return UTF8IsSeparator(back3) || UTF8IsNEL(back3+1);
+	}
+	return false;
+}
+
+// Replace the span at position with spanNew in one step, returning the number of lines removed.
+// Which bytes end lines is only known from the whole text so the line starts in and just after
+// the span are found again in the new text. Old starts outside the ranges move with their text and
+// keep their lines, and so the lines' markers and other data, when the new text still starts a line
+// there. Other old lines are removed, merging their data into the line before, and lines for the
+// remaining new starts are inserted.
+int CellBuffer::BasicReplaceSpan(Sci_Position position, Sci_Position lengthOld, const char *spanNew, Sci_Position lengthNew,
+	const ReplacedRange *ranges, int count) {
+	// Whether a line starts depends on the bytes before it, up to a UTF-8 separator, and on a
+	// following lf, so starts this far after the span may change
+	const Sci_Position lookAhead = UTF8SeparatorLength;
+
+	// Where the old starts are in the new text or -1 when inside a range
+	std::vector<Sci_Position> startsOld;
+	const int lineFirst = lv.LineFromPosition((position > 0) ? position - 1 : 0) + 1;
+	const Sci_Position endOld = std::min(position + lengthOld + lookAhead, Length());
+	Sci_Position delta = 0;
+	int range = 0;
+	for (int line = lineFirst; (line < lv.Lines()) && (lv.LineStart(line) <= endOld); line++) {
+		const Sci_Position start = lv.LineStart(line);
+		while ((range < count) && (position + ranges[range].offset + ranges[range].lengthRemoved <= start)) {
+			delta += ranges[range].lengthInserted - ranges[range].lengthRemoved;
+			range++;
+		}
+		const bool insideRange = (range < count) && (position + ranges[range].offset < start);
+		startsOld.push_back(insideRange ? -1 : start + delta);
+	}
+
+	// Styles of the text kept between the ranges are kept and inserted text is unstyled
+	std::vector<char> styles(lengthNew + 1);
+	Sci_Position offsetOld = 0;
+	Sci_Position offsetNew = 0;
+	for (int r = 0; r < count; r++) {
+		const Sci_Position lengthKept = ranges[r].offset - offsetOld;
+		style.GetRange(&styles[offsetNew], position + offsetOld, lengthKept);
+		offsetNew += lengthKept;
+		memset(&styles[offsetNew], 0, ranges[r].lengthInserted);
+		offsetNew += ranges[r].lengthInserted;
+		offsetOld = ranges[r].offset + ranges[r].lengthRemoved;
+	}
+	PLATFORM_ASSERT((offsetOld == lengthOld) && (offsetNew == lengthNew));
+
+	if (lengthOld > 0) {
+		substance.DeleteRange(position, lengthOld);
+		style.DeleteRange(position, lengthOld);
+	}
+	if (lengthNew > 0) {
+		substance.InsertFromArray(position, spanNew, 0, lengthNew);
+		style.InsertFromArray(position, &styles[0], 0, lengthNew);
+	}
+
+	// Point all the lines after those that may change further along in the buffer
+	lv.InsertText(lineFirst - 1 + static_cast<int>(startsOld.size()), lengthNew - lengthOld);
+
+	std::vector<Sci_Position> startsNew;
+	const Sci_Position endNew = std::min(position + lengthNew + lookAhead, Length());
+	Sci_Position pos = (position > 0) ? position : 1;
+	while (pos <= endNew) {
+		if (!utf8LineEnds && (pos > position) && (pos <= position + lengthNew)) {
+			// Only CR and LF end lines so skip over other characters of the new text
+			pos = position + NextLineEnd(spanNew, pos - 1 - position, lengthNew) + 1;
+			if (pos > endNew)
+				break;
+		}
+		if (IsLineStartAt(pos))
+			startsNew.push_back(pos);
+		pos++;
+	}
+
+	int linesRemoved = 0;
+	int line = lineFirst;
+	size_t next = 0;
+	for (size_t i = 0; i < startsOld.size(); i++) {
+		if (startsOld[i] >= 0) {
+			while ((next < startsNew.size()) && (startsNew[next] < startsOld[i])) {
+				InsertLine(line, startsNew[next], false);
+				line++;
+				next++;
+			}
+			if ((next < startsNew.size()) && (startsNew[next] == startsOld[i])) {
+				lv.SetLineStart(line, startsOld[i]);
+				line++;
+				next++;
+				continue;
+			}
+		}
+		RemoveLine(line);
+		linesRemoved++;
+	}
+	for (; next < startsNew.size(); next++) {
+		InsertLine(line, startsNew[next], false);
+		line++;
+	}
+	return linesRemoved;
+}
+
 bool CellBuffer::SetUndoCollection(bool collectUndo) {
 	collectingUndo = collectUndo;
 	uh.DropUndoSequence();
@@ -721,13 +1425,21 @@ void CellBuffer::EndUndoAction() {
 
 void CellBuffer::AddUndoAction(int token, bool mayCoalesce) {
 	bool startSequence;
-	uh.AppendAction(containerAction, token, 0, 0, startSequence, mayCoalesce);
+	uh.AppendAction(containerAction, token, 0, startSequence, mayCoalesce);
 }
 
 void CellBuffer::DeleteUndoHistory() {
 	uh.DeleteUndoHistory();
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) {
+	uh.SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::GetUndoMemoryLimit() const {
+	return uh.GetMemoryLimit();
+}
+
 bool CellBuffer::CanUndo() {
 	return uh.CanUndo();
 }
@@ -740,12 +1452,27 @@ const Action &CellBuffer::GetUndoStep() const {
 	return uh.GetUndoStep();
 }
 
+void CellBuffer::PerformReplaceStep(const Action &actionStep, bool undo) {
+	int linesRemoved = 0;
+	int linesInserted = 0;
+	const int count = ReplaceStepRanges(actionStep, undo, 0, linesRemoved, linesInserted);
+	std::vector<ReplacedRange> ranges(count);
+	ReplaceStepRanges(actionStep, undo, &ranges[0], linesRemoved, linesInserted);
+	const Sci_Position lengthOld = ranges[count - 1].offset + ranges[count - 1].lengthRemoved;
+	const Sci_Position lengthNew = ReplaceStepText(actionStep, undo, 0);
+	std::vector<char> spanNew(lengthNew + 1);
+	ReplaceStepText(actionStep, undo, &spanNew[0]);
+	BasicReplaceSpan(actionStep.position, lengthOld, &spanNew[0], lengthNew, &ranges[0], count);
+}
+
 void CellBuffer::PerformUndoStep() {
 	const Action &actionStep = uh.GetUndoStep();
 	if (actionStep.at == insertAction) {
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
 		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
+	} else if (actionStep.at == replaceAction) {
+		PerformReplaceStep(actionStep, true);
 	}
 	uh.CompletedUndoStep();
 }
@@ -768,6 +1495,8 @@ void CellBuffer::PerformRedoStep() {
 		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
+	} else if (actionStep.at == replaceAction) {
+		PerformReplaceStep(actionStep, false);
 	}
 	uh.CompletedRedoStep();
 }
@@ -21,12 +21,21 @@ public:
 	virtual void RemoveLine(int)=0;
 };
 
+/// Line starts are held in one Partitioning by default.
+/// Defining SCI_BLOCK_STORAGE holds them in blocks so that edits far from the
+/// previous edit do not update the start of every line in between.
+#ifdef SCI_BLOCK_STORAGE
+typedef BlockPartitioning LineStarts;
+#else
+typedef Partitioning LineStarts;
+#endif
+
 /**
  * The line vector contains information about each of the lines in a cell buffer.
  */
 class LineVector {
 
-	Partitioning starts;
+	LineStarts starts;
 	PerLine *perLine;
 
 public:
@@ -36,15 +45,15 @@ public:
 	void Init();
 	void SetPerLine(PerLine *pl);
 
-	void InsertText(int line, int delta);
-	void InsertLine(int line, int position, bool lineStart);
-	void SetLineStart(int line, int position);
+	void InsertText(int line, Sci_Position delta);
+	void InsertLine(int line, Sci_Position position, bool lineStart);
+	void SetLineStart(int line, Sci_Position position);
 	void RemoveLine(int line);
 	int Lines() const {
 		return starts.Partitions();
 	}
-	int LineFromPosition(int pos) const;
-	int LineStart(int line) const {
+	int LineFromPosition(Sci_Position pos) const;
+	Sci_Position LineStart(int line) const {
 		return starts.PositionFromPartition(line);
 	}
 
@@ -65,7 +74,17 @@ public:
 
 };
 
-enum actionType { insertAction, removeAction, startAction, containerAction };
+enum actionType { insertAction, removeAction, startAction, containerAction, replaceAction };
+
+/**
+ * One of the ranges changed by replacing a span of text in a single step.
+ * The offset is from the start of the span in the text before the replacement.
+ */
+struct ReplacedRange {
+	Sci_Position offset;
+	Sci_Position lengthRemoved;
+	Sci_Position lengthInserted;
+};
 
 /**
  * Actions are used to store all the information required to perform one undo/redo step.
@@ -73,18 +92,55 @@ enum actionType { insertAction, removeAction, startAction, containerAction };
 class Action {
 public:
 	actionType at;
-	int position;
+	Sci_Position position;
 	char *data;
-	int lenData;
+	Sci_Position lenData;
 	bool mayCoalesce;
 
 	Action();
 	~Action();
-	void Create(actionType at_, int position_=0, char *data_=0, int lenData_=0, bool mayCoalesce_=true);
+	void Create(actionType at_, Sci_Position position_=0, char *data_=0, Sci_Position lenData_=0, bool mayCoalesce_=true);
 	void Destroy();
 	void Grab(Action *source);
 };
 
+/**
+ * Append only storage for the text of actions.
+ * Text is held in large blocks so each action does not need its own allocation.
+ * As text is appended in the same order as actions, discarding the oldest actions
+ * frees blocks from the start and discarding redo actions frees text from the end.
+ */
+class UndoArena {
+public:
+	struct Block {
+		Block *previous;
+		Block *next;
+		char *text;
+		Sci_Position size;
+		Sci_Position used;
+		bool Contains(const char *position) const {
+			return (position >= text) && (position <= text + used);
+		}
+	};
+private:
+	Block *first;
+	Block *last;
+	size_t memory;
+	void Free(Block *block);
+	// Private so UndoArena objects can not be copied
+	UndoArena(const UndoArena &);
+public:
+	enum { blockSize = 0x10000 };
+	UndoArena();
+	~UndoArena();
+	void Clear();
+	char *Allocate(Sci_Position length);
+	void TruncateAfter(const char *end);
+	void ReleaseBefore(const char *start);
+	const Block *First() const { return first; }
+	size_t Memory() const { return memory; }
+};
+
 /**
  *
  */
@@ -95,8 +151,15 @@ class UndoHistory {
 	int currentAction;
 	int undoSequenceDepth;
 	int savePoint;
+	UndoArena arena;
+	size_t memoryLimit;
+	size_t memoryNextCheck;
 
 	void EnsureUndoRoom();
+	const char *TextEnd(int actionEnd) const;
+	const char *TextStart(int actionStart) const;
+	void DropActions(int actionsDrop);
+	void EnforceMemoryLimit();
 
 	// Private so UndoHistory objects can not be copied
 	UndoHistory(const UndoHistory &);
@@ -105,13 +168,20 @@ public:
 	UndoHistory();
 	~UndoHistory();
 
-	void AppendAction(actionType at, int position, char *data, int length, bool &startSequence, bool mayCoalesce=true);
+	/// Returns storage for length bytes of the action's text that the caller fills in.
+	char *AppendAction(actionType at, Sci_Position position, Sci_Position length, bool &startSequence, bool mayCoalesce=true);
 
 	void BeginUndoAction();
 	void EndUndoAction();
 	void DropUndoSequence();
 	void DeleteUndoHistory();
 
+	/// When the memory used exceeds the limit, the oldest user operations are discarded.
+	/// A limit of 0 is unlimited.
+	void SetMemoryLimit(size_t limit);
+	size_t GetMemoryLimit() const;
+	size_t Memory() const;
+
 	/// The save point is a marker in the undo stack where the container has stated that
 	/// the buffer was saved. Undo and redo can move over the save point.
 	void SetSavePoint();
@@ -129,6 +199,15 @@ public:
 	void CompletedRedoStep();
 };
 
+/// Text and styles are held in one gap buffer by default.
+/// Defining SCI_BLOCK_STORAGE holds them in blocks so that edits far apart
+/// from each other do not move most of the document.
+#ifdef SCI_BLOCK_STORAGE
+typedef BlockVector<char> CellStorage;
+#else
+typedef SplitVector<char> CellStorage;
+#endif
+
 /**
  * Holder for an expandable array of characters that supports undo and line markers.
  * Based on article "Data Structures in a Bit-Mapped Text Editor"
@@ -136,8 +215,8 @@ public:
  */
 class CellBuffer {
 private:
-	SplitVector<char> substance;
-	SplitVector<char> style;
+	CellStorage substance;
+	CellStorage style;
 	bool readOnly;
 	int utf8LineEnds;
 
@@ -146,11 +225,16 @@ private:
 
 	LineVector lv;
 
-	bool UTF8LineEndOverlaps(int position) const;
+	bool UTF8LineEndOverlaps(Sci_Position position) const;
 	void ResetLineEnds();
 	/// Actions without undo
-	void BasicInsertString(int position, const char *s, int insertLength);
-	void BasicDeleteChars(int position, int deleteLength);
+	void BasicInsertString(Sci_Position position, const char *s, Sci_Position insertLength, bool shared=false);
+	void BasicDeleteChars(Sci_Position position, Sci_Position deleteLength);
+	bool IsLineStartAt(Sci_Position position) const;
+	int BasicReplaceSpan(Sci_Position position, Sci_Position lengthOld, const char *spanNew, Sci_Position lengthNew,
+		const ReplacedRange *ranges, int count);
+	void PerformReplaceStep(const Action &actionStep, bool undo);
+	bool MatchesAt(Sci_Position position, const char *s, Sci_Position length, const char *fold) const;
 
 public:
 
@@ -158,32 +242,67 @@ public:
 	~CellBuffer();
 
 	/// Retrieving positions outside the range of the buffer works and returns 0
-	char CharAt(int position) const;
-	void GetCharRange(char *buffer, int position, int lengthRetrieve) const;
-	char StyleAt(int position) const;
-	void GetStyleRange(unsigned char *buffer, int position, int lengthRetrieve) const;
+	char CharAt(Sci_Position position) const;
+	void GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const;
+	char StyleAt(Sci_Position position) const;
+	void GetStyleRange(unsigned char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const;
 	const char *BufferPointer();
-	const char *RangePointer(int position, int rangeLength);
-	int GapPosition() const;
-
-	int Length() const;
-	void Allocate(int newSize);
+	const char *RangePointer(Sci_Position position, Sci_Position rangeLength);
+	Sci_Position GapPosition() const;
+	/// The text from position if the range is stored contiguously, otherwise null.
+	/// Unlike RangePointer, the gap is never moved.
+	const char *ContiguousRangePointer(Sci_Position position, Sci_Position rangeLength) const;
+	/// The contiguously stored part of the text containing position and its extent.
+	const char *ContiguousRange(Sci_Position position, Sci_Position &start, Sci_Position &length) const;
+	/// Find the first, or the last when searching backwards, occurrence of s lying entirely
+	/// within [rangeStart, rangeEnd). When fold is not null, each byte of the buffer is mapped
+	/// through it before being compared with s which must already be folded.
+	/// Returns -1 if not found.
+	Sci_Position FindBytes(Sci_Position rangeStart, Sci_Position rangeEnd, const char *s, Sci_Position length,
+		const char *fold, bool forward) const;
+
+	Sci_Position Length() const;
+	void Allocate(Sci_Position newSize);
 	int GetLineEndTypes() const { return utf8LineEnds; }
 	void SetLineEndTypes(int utf8LineEnds_);
 	void SetPerLine(PerLine *pl);
 	int Lines() const;
-	int LineStart(int line) const;
-	int LineFromPosition(int pos) const { return lv.LineFromPosition(pos); }
-	void InsertLine(int line, int position, bool lineStart);
+	Sci_Position LineStart(int line) const;
+	int LineFromPosition(Sci_Position pos) const { return lv.LineFromPosition(pos); }
+	void InsertLine(int line, Sci_Position position, bool lineStart);
 	void RemoveLine(int line);
-	const char *InsertString(int position, const char *s, int insertLength, bool &startSequence);
+	const char *InsertString(Sci_Position position, const char *s, Sci_Position insertLength, bool &startSequence);
+	/// Append text without undo while loading. With block storage the buffer refers to the text
+	/// which must stay valid and unchanged until HoldsShared returns false.
+	/// @return true if the buffer refers to the text and false if it was copied.
+	bool AppendShared(const char *s, Sci_Position insertLength);
+	bool HoldsShared() const;
+	static bool CanHoldShared();
 
 	/// Setting styles for positions outside the range of the buffer is safe and has no effect.
 	/// @return true if the style of a character is changed.
-	bool SetStyleAt(int position, char styleValue, char mask='\377');
-	bool SetStyleFor(int position, int length, char styleValue, char mask);
-
-	const char *DeleteChars(int position, int deleteLength, bool &startSequence);
+	bool SetStyleAt(Sci_Position position, char styleValue, char mask='\377');
+	/// Set styles a block at a time, writing only the stretch of each block that changes.
+	/// When they change, the first changed position and the position after the last are returned.
+	bool SetStyleFor(Sci_Position position, Sci_Position length, char styleValue, char mask,
+		Sci_Position &changeStart, Sci_Position &changeEnd);
+	/// Styles for positions past the end of the buffer are dropped.
+	bool SetStyles(Sci_Position position, Sci_Position length, const char *styles, char mask,
+		Sci_Position &changeStart, Sci_Position &changeEnd);
+
+	const char *DeleteChars(Sci_Position position, Sci_Position deleteLength, bool &startSequence);
+	/// Replace the ranges of the span at position, whose text becomes spanNew, as one undo action.
+	/// Lines whose starts are outside the ranges keep their markers and other per-line data.
+	/// @return the number of lines removed; the lines inserted follow from the change in Lines().
+	int ReplaceSpan(Sci_Position position, Sci_Position lengthOld, const char *spanNew, Sci_Position lengthNew,
+		const ReplacedRange *ranges, int count, bool &startSequence);
+	/// The ranges of a replaceAction as they are changed by undoing or redoing it, with the
+	/// lines that step removes and inserts. Call with ranges null to find the count.
+	static int ReplaceStepRanges(const Action &action, bool undo, ReplacedRange *ranges,
+		int &linesRemoved, int &linesInserted);
+	/// Fill spanNew, when not null, with the text a replaceAction gives its span when undone or
+	/// redone and return its length.
+	Sci_Position ReplaceStepText(const Action &action, bool undo, char *spanNew) const;
 
 	bool IsReadOnly() const;
 	void SetReadOnly(bool set);
@@ -199,6 +318,8 @@ public:
 	void EndUndoAction();
 	void AddUndoAction(int token, bool mayCoalesce);
 	void DeleteUndoHistory();
+	void SetUndoMemoryLimit(size_t limit);
+	size_t GetUndoMemoryLimit() const;
 
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
@@ -55,7 +55,7 @@ Decoration *DecorationList::DecorationFromIndicator(int indicator) {
 	return 0;
 }
 
-Decoration *DecorationList::Create(int indicator, int length) {
+Decoration *DecorationList::Create(int indicator, Sci_Position length) {
 	currentIndicator = indicator;
 	Decoration *decoNew = new Decoration(indicator);
 	decoNew->rs.InsertSpace(0, length);
@@ -111,7 +111,7 @@ void DecorationList::SetCurrentValue(int value) {
 	currentValue = value ? value : 1;
 }
 
-bool DecorationList::FillRange(int &position, int value, int &fillLength) {
+bool DecorationList::FillRange(Sci_Position &position, int value, Sci_Position &fillLength) {
 	if (!current) {
 		current = DecorationFromIndicator(currentIndicator);
 		if (!current) {
@@ -125,7 +125,27 @@ bool DecorationList::FillRange(int &position, int value, int &fillLength) {
 	return changed;
 }
 
-void DecorationList::InsertSpace(int position, int insertLength) {
+bool DecorationList::FillRanges(const int *starts, const int *ends, int count, int value) {
+	if (!current) {
+		current = DecorationFromIndicator(currentIndicator);
+		if (!current) {
+			current = Create(currentIndicator, lengthDocument);
+		}
+	}
+	bool changed = false;
+	for (int i = 0; i < count; i++) {
+		Sci_Position position = starts[i];
+		Sci_Position fillLength = ends[i] - starts[i];
+		if (current->rs.FillRange(position, value, fillLength))
+			changed = true;
+	}
+	if (current->Empty()) {
+		Delete(currentIndicator);
+	}
+	return changed;
+}
+
+void DecorationList::InsertSpace(Sci_Position position, Sci_Position insertLength) {
 	const bool atEnd = position == lengthDocument;
 	lengthDocument += insertLength;
 	for (Decoration *deco=root; deco; deco = deco->next) {
@@ -136,7 +156,7 @@ void DecorationList::InsertSpace(int position, int insertLength) {
 	}
 }
 
-void DecorationList::DeleteRange(int position, int deleteLength) {
+void DecorationList::DeleteRange(Sci_Position position, Sci_Position deleteLength) {
 	lengthDocument -= deleteLength;
 	Decoration *deco;
 	for (deco=root; deco; deco = deco->next) {
@@ -145,6 +165,35 @@ void DecorationList::DeleteRange(int position, int deleteLength) {
 	DeleteAnyEmpty();
 }
 
+void DecorationList::ReplaceRanges(const int *starts, const int *ends, const int *lengthsInserted, int count) {
+	for (Decoration *deco=root; deco; deco = deco->next) {
+		// Each range is where the earlier ranges have moved it
+		Sci_Position lengthReplaced = lengthDocument;
+		Sci_Position delta = 0;
+		for (int i = 0; i < count; i++) {
+			const Sci_Position position = starts[i] + delta;
+			const Sci_Position lengthRemoved = ends[i] - starts[i];
+			if (lengthRemoved > 0) {
+				deco->rs.DeleteRange(position, lengthRemoved);
+				lengthReplaced -= lengthRemoved;
+			}
+			Sci_Position lengthInserted = lengthsInserted[i];
+			if (lengthInserted > 0) {
+				deco->rs.InsertSpace(position, lengthInserted);
+				if (position == lengthReplaced) {
+					Sci_Position positionFill = position;
+					deco->rs.FillRange(positionFill, 0, lengthInserted);
+				}
+				lengthReplaced += lengthsInserted[i];
+			}
+			delta += lengthsInserted[i] - lengthRemoved;
+		}
+	}
+	for (int i = 0; i < count; i++)
+		lengthDocument += lengthsInserted[i] - (ends[i] - starts[i]);
+	DeleteAnyEmpty();
+}
+
 void DecorationList::DeleteAnyEmpty() {
 	Decoration *deco = root;
 	while (deco) {
@@ -157,7 +206,7 @@ void DecorationList::DeleteAnyEmpty() {
 	}
 }
 
-int DecorationList::AllOnFor(int position) {
+int DecorationList::AllOnFor(Sci_Position position) {
 	int mask = 0;
 	for (Decoration *deco=root; deco; deco = deco->next) {
 		if (deco->rs.ValueAt(position)) {
@@ -167,7 +216,7 @@ int DecorationList::AllOnFor(int position) {
 	return mask;
 }
 
-int DecorationList::ValueAt(int indicator, int position) {
+int DecorationList::ValueAt(int indicator, Sci_Position position) {
 	Decoration *deco = DecorationFromIndicator(indicator);
 	if (deco) {
 		return deco->rs.ValueAt(position);
@@ -175,7 +224,7 @@ int DecorationList::ValueAt(int indicator, int position) {
 	return 0;
 }
 
-int DecorationList::Start(int indicator, int position) {
+Sci_Position DecorationList::Start(int indicator, Sci_Position position) {
 	Decoration *deco = DecorationFromIndicator(indicator);
 	if (deco) {
 		return deco->rs.StartRun(position);
@@ -183,7 +232,7 @@ int DecorationList::Start(int indicator, int position) {
 	return 0;
 }
 
-int DecorationList::End(int indicator, int position) {
+Sci_Position DecorationList::End(int indicator, Sci_Position position) {
 	Decoration *deco = DecorationFromIndicator(indicator);
 	if (deco) {
 		return deco->rs.EndRun(position);
@@ -27,9 +27,9 @@ class DecorationList {
 	int currentIndicator;
 	int currentValue;
 	Decoration *current;
-	int lengthDocument;
+	Sci_Position lengthDocument;
 	Decoration *DecorationFromIndicator(int indicator);
-	Decoration *Create(int indicator, int length);
+	Decoration *Create(int indicator, Sci_Position length);
 	void Delete(int indicator);
 	void DeleteAnyEmpty();
 public:
@@ -46,15 +46,20 @@ public:
 	int GetCurrentValue() const { return currentValue; }
 
 	// Returns true if some values may have changed
-	bool FillRange(int &position, int value, int &fillLength);
+	bool FillRange(Sci_Position &position, int value, Sci_Position &fillLength);
+	// Fill many ranges in ascending order with one value
+	bool FillRanges(const int *starts, const int *ends, int count, int value);
 
-	void InsertSpace(int position, int insertLength);
-	void DeleteRange(int position, int deleteLength);
+	void InsertSpace(Sci_Position position, Sci_Position insertLength);
+	void DeleteRange(Sci_Position position, Sci_Position deleteLength);
+	// Replace many ranges, in ascending order and positioned as before any are replaced,
+	// moving each decoration once
+	void ReplaceRanges(const int *starts, const int *ends, const int *lengthsInserted, int count);
 
-	int AllOnFor(int position);
-	int ValueAt(int indicator, int position);
-	int Start(int indicator, int position);
-	int End(int indicator, int position);
+	int AllOnFor(Sci_Position position);
+	int ValueAt(int indicator, Sci_Position position);
+	Sci_Position Start(int indicator, Sci_Position position);
+	Sci_Position End(int indicator, Sci_Position position);
 };
 
 #ifdef SCI_NAMESPACE
@@ -13,6 +13,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "Platform.h"
 
@@ -21,6 +22,7 @@
 
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "RunStyles.h"
 #include "CellBuffer.h"
 #include "PerLine.h"
@@ -29,6 +31,7 @@
 #include "Decoration.h"
 #include "Document.h"
 #include "RESearch.h"
+#include "LinearRegex.h"
 #include "UniConversion.h"
 
 #ifdef SCI_NAMESPACE
@@ -59,8 +62,12 @@ void LexInterface::Colourise(int start, int end) {
 			styleStart = pdoc->StyleAt(start - 1) & pdoc->stylingBitsMask;
 
 		if (len > 0) {
+			pdoc->BeginStyleBatch();
+			pdoc->LexStarting(start, end);
 			instance->Lex(start, len, styleStart, pdoc);
 			instance->Fold(start, len, styleStart, pdoc);
+			pdoc->LexFinished();
+			pdoc->EndStyleBatch();
 		}
 
 		performingStyle = false;
@@ -78,9 +85,10 @@ int LexInterface::LineEndTypesSupported() {
 	return 0;
 }
 
-Document::Document() {
+Document::Document() : durationStyleOneLine(0.00001, 0.000001, 0.0001) {
 	refCount = 0;
 	pcf = NULL;
+	foldTableState = foldTableNone;
 #ifdef _WIN32
 	eolMode = SC_EOL_CRLF;
 #else
@@ -93,9 +101,18 @@ Document::Document() {
 	stylingMask = 0;
 	endStyled = 0;
 	styleClock = 0;
+	textClock = 0;
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
+	styleBatchDepth = 0;
+	styleBatchStart = 0;
+	styleBatchEnd = 0;
+	stylesKeptEnd = 0;
+	lexStart = 0;
+	lexEnd = -1;
+	lexCheckpointLine = 0;
+	lexConverged = false;
 	tabInChars = 8;
 	indentInChars = 0;
 	actualIndentInChars = 8;
@@ -107,6 +124,7 @@ Document::Document() {
 
 	matchesValid = false;
 	regex = 0;
+	regexLinear = false;
 
 	UTF8BytesOfLeadInitialise();
 
@@ -115,6 +133,7 @@ Document::Document() {
 	perLineData[ldState] = new LineState();
 	perLineData[ldMargin] = new LineAnnotation();
 	perLineData[ldAnnotation] = new LineAnnotation();
+	perLineData[ldCheckpoints] = new LineCheckpoints();
 
 	cb.SetPerLine(this);
 
@@ -138,6 +157,7 @@ Document::~Document() {
 	pli = 0;
 	delete pcf;
 	pcf = 0;
+	ReleaseViews();
 }
 
 void Document::Init() {
@@ -277,15 +297,15 @@ int Document::LineFromHandle(int markerHandle) {
 	return static_cast<LineMarkers *>(perLineData[ldMarkers])->LineFromHandle(markerHandle);
 }
 
-int SCI_METHOD Document::LineStart(int line) const {
+Sci_Position SCI_METHOD Document::LineStart(int line) const {
 	return cb.LineStart(line);
 }
 
-int SCI_METHOD Document::LineEnd(int line) const {
+Sci_Position SCI_METHOD Document::LineEnd(int line) const {
 	if (line == LinesTotal() - 1) {
 		return LineStart(line + 1);
 	} else {
-		int position = LineStart(line + 1);
+		Sci_Position position = LineStart(line + 1);
 		if (SC_CP_UTF8 == dbcsCodePage) {
 			unsigned char bytes[] = {
 				static_cast<unsigned char>(cb.CharAt(position-3)),
@@ -315,7 +335,7 @@ void SCI_METHOD Document::SetErrorStatus(int status) {
 	}
 }
 
-int SCI_METHOD Document::LineFromPosition(int pos) const {
+int SCI_METHOD Document::LineFromPosition(Sci_Position pos) const {
 	return cb.LineFromPosition(pos);
 }
 
@@ -487,7 +507,7 @@ int Document::ClampPositionIntoDocument(int pos) {
 	return Platform::Clamp(pos, 0, Length());
 }
 
-bool Document::IsCrLf(int pos) {
+bool Document::IsCrLf(Sci_Position pos) {
 	if (pos < 0)
 		return false;
 	if (pos >= (Length() - 1))
@@ -515,8 +535,8 @@ int Document::LenChar(int pos) {
 	}
 }
 
-bool Document::InGoodUTF8(int pos, int &start, int &end) const {
-	int trail = pos;
+bool Document::InGoodUTF8(Sci_Position pos, Sci_Position &start, Sci_Position &end) const {
+	Sci_Position trail = pos;
 	while ((trail>0) && (pos-trail < UTF8MaxBytes) && UTF8IsTrailByte(static_cast<unsigned char>(cb.CharAt(trail-1))))
 		trail--;
 	start = (trail > 0) ? trail-1 : trail;
@@ -527,13 +547,13 @@ bool Document::InGoodUTF8(int pos, int &start, int &end) const {
 		return false;
 	} else {
 		int trailBytes = widthCharBytes - 1;
-		int len = pos - start;
+		Sci_Position len = pos - start;
 		if (len > trailBytes)
 			// pos too far from lead
 			return false;
 		char charBytes[UTF8MaxBytes] = {static_cast<char>(leadByte),0,0,0};
 		for (int b=1; b<widthCharBytes && ((start+b) < Length()); b++)
-			charBytes[b] = cb.CharAt(static_cast<int>(start+b));
+			charBytes[b] = cb.CharAt(start+b);
 		int utf8status = UTF8Classify(reinterpret_cast<const unsigned char *>(charBytes), widthCharBytes);
 		if (utf8status & UTF8MaskInvalid)
 			return false;
@@ -547,7 +567,7 @@ bool Document::InGoodUTF8(int pos, int &start, int &end) const {
 // When lines are terminated with \r\n pairs which should be treated as one character.
 // When displaying DBCS text such as Japanese.
 // If moving, move the position in the indicated direction.
-int Document::MovePositionOutsideChar(int pos, int moveDir, bool checkLineEnd) {
+Sci_Position Document::MovePositionOutsideChar(Sci_Position pos, int moveDir, bool checkLineEnd) {
 	//Platform::DebugPrintf("NoCRLF %d %d\n", pos, moveDir);
 	// If out of range, just return minimum/maximum value.
 	if (pos <= 0)
@@ -568,8 +588,8 @@ int Document::MovePositionOutsideChar(int pos, int moveDir, bool checkLineEnd) {
 			unsigned char ch = static_cast<unsigned char>(cb.CharAt(pos));
 			// If ch is not a trail byte then pos is valid intercharacter position
 			if (UTF8IsTrailByte(ch)) {
-				int startUTF = pos;
-				int endUTF = pos;
+				Sci_Position startUTF = pos;
+				Sci_Position endUTF = pos;
 				if (InGoodUTF8(pos, startUTF, endUTF)) {
 					// ch is a trail byte within a UTF-8 character
 					if (moveDir > 0)
@@ -582,12 +602,12 @@ int Document::MovePositionOutsideChar(int pos, int moveDir, bool checkLineEnd) {
 		} else {
 			// Anchor DBCS calculations at start of line because start of line can
 			// not be a DBCS trail byte.
-			int posStartLine = LineStart(LineFromPosition(pos));
+			Sci_Position posStartLine = LineStart(LineFromPosition(pos));
 			if (pos == posStartLine)
 				return pos;
 
 			// Step back until a non-lead-byte is found.
-			int posCheck = pos;
+			Sci_Position posCheck = pos;
 			while ((posCheck > posStartLine) && IsDBCSLeadByte(cb.CharAt(posCheck-1)))
 				posCheck--;
 
@@ -614,7 +634,7 @@ int Document::MovePositionOutsideChar(int pos, int moveDir, bool checkLineEnd) {
 // NextPosition moves between valid positions - it can not handle a position in the middle of a
 // multi-byte character. It is used to iterate through text more efficiently than MovePositionOutsideChar.
 // A \r\n pair is treated as two characters.
-int Document::NextPosition(int pos, int moveDir) const {
+Sci_Position Document::NextPosition(Sci_Position pos, int moveDir) const {
 	// If out of range, just return minimum/maximum value.
 	int increment = (moveDir > 0) ? 1 : -1;
 	if (pos + increment <= 0)
@@ -634,7 +654,7 @@ int Document::NextPosition(int pos, int moveDir) const {
 					const int widthCharBytes = UTF8BytesOfLead[leadByte];
 					char charBytes[UTF8MaxBytes] = {static_cast<char>(leadByte),0,0,0};
 					for (int b=1; b<widthCharBytes; b++)
-						charBytes[b] = cb.CharAt(static_cast<int>(pos+b));
+						charBytes[b] = cb.CharAt(pos+b);
 					int utf8status = UTF8Classify(reinterpret_cast<const unsigned char *>(charBytes), widthCharBytes);
 					if (utf8status & UTF8MaskInvalid)
 						pos++;
@@ -648,8 +668,8 @@ int Document::NextPosition(int pos, int moveDir) const {
 				// If ch is not a trail byte then pos is valid intercharacter position
 				if (UTF8IsTrailByte(ch)) {
 					// If ch is a trail byte in a valid UTF-8 character then return start of character
-					int startUTF = pos;
-					int endUTF = pos;
+					Sci_Position startUTF = pos;
+					Sci_Position endUTF = pos;
 					if (InGoodUTF8(pos, startUTF, endUTF)) {
 						pos = startUTF;
 					}
@@ -665,7 +685,7 @@ int Document::NextPosition(int pos, int moveDir) const {
 			} else {
 				// Anchor DBCS calculations at start of line because start of line can
 				// not be a DBCS trail byte.
-				int posStartLine = LineStart(LineFromPosition(pos));
+				Sci_Position posStartLine = LineStart(LineFromPosition(pos));
 				// See http://msdn.microsoft.com/en-us/library/cc194792%28v=MSDN.10%29.aspx
 				// http://msdn.microsoft.com/en-us/library/cc194790.aspx
 				if ((pos - 1) <= posStartLine) {
@@ -675,7 +695,7 @@ int Document::NextPosition(int pos, int moveDir) const {
 					return pos - 2;
 				} else {
 					// Otherwise, step back until a non-lead-byte is found.
-					int posTemp = pos - 1;
+					Sci_Position posTemp = pos - 1;
 					while (posStartLine <= --posTemp && IsDBCSLeadByte(cb.CharAt(posTemp)))
 						;
 					// Now posTemp+1 must point to the beginning of a character,
@@ -692,9 +712,9 @@ int Document::NextPosition(int pos, int moveDir) const {
 	return pos;
 }
 
-bool Document::NextCharacter(int &pos, int moveDir) {
+bool Document::NextCharacter(Sci_Position &pos, int moveDir) {
 	// Returns true if pos changed
-	int posNext = NextPosition(pos, moveDir);
+	Sci_Position posNext = NextPosition(pos, moveDir);
 	if (posNext == pos) {
 		return false;
 	} else {
@@ -787,6 +807,10 @@ int Document::SafeSegment(const char *text, int length, int lengthSegment) {
 void Document::ModifiedAt(int pos) {
 	if (endStyled > pos)
 		endStyled = pos;
+	// Outside text modification this is a change to keywords, properties or line ends
+	// that may alter the styles after pos without changing the text
+	if (enteredModification == 0)
+		StylesInvalidFrom(pos);
 }
 
 void Document::CheckReadOnly() {
@@ -797,7 +821,7 @@ void Document::CheckReadOnly() {
 	}
 }
 
-// Document only modified by gateways DeleteChars, InsertString, Undo, Redo, and SetStyleAt.
+// Document only modified by gateways DeleteChars, InsertString, ReplaceRanges, Undo, Redo, and SetStyleAt.
 // SetStyleAt does not change the persistent state of a document
 
 bool Document::DeleteChars(int pos, int len) {
@@ -889,6 +913,44 @@ void * SCI_METHOD Document::ConvertToDocument() {
 	return this;
 }
 
+int SCI_METHOD Document::AddView(IMemoryView *view) {
+	try {
+		int position = Length();
+		views.push_back(view);
+		if (!cb.AppendShared(view->Data(), view->Length())) {
+			views.pop_back();
+			view->Release();
+		}
+		textClock = (textClock + 1) % 0x40000000;
+		ModifiedAt(position);
+	} catch (std::bad_alloc &) {
+		return SC_STATUS_BADALLOC;
+	} catch (...) {
+		return SC_STATUS_FAILURE;
+	}
+	return 0;
+}
+
+bool SCI_METHOD Document::KeepsViews() {
+	return CellBuffer::CanHoldShared();
+}
+
+void Document::ReleaseViews() {
+	for (size_t i = 0; i < views.size(); i++) {
+		views[i]->Release();
+	}
+	views.clear();
+}
+
+const char * SCI_METHOD Document::BufferPointer() {
+	const char *text = cb.BufferPointer();
+	if (!views.empty() && !cb.HoldsShared()) {
+		// The text has been copied so the file may now be written
+		ReleaseViews();
+	}
+	return text;
+}
+
 int Document::Undo() {
 	int newPos = -1;
 	CheckReadOnly();
@@ -906,6 +968,15 @@ int Document::Undo() {
 			for (int step = 0; step < steps; step++) {
 				const int prevLinesTotal = LinesTotal();
 				const Action &action = cb.GetUndoStep();
+				if (action.at == replaceAction) {
+					newPos = ReplaceStep(action, true,
+						SC_PERFORMED_UNDO | ((steps > 1) ? SC_MULTISTEPUNDOREDO : 0), step == steps - 1, multiLine);
+					coalescedRemovePos = -1;
+					coalescedRemoveLen = 0;
+					prevRemoveActionPos = -1;
+					prevRemoveActionLen = 0;
+					continue;
+				}
 				if (action.at == removeAction) {
 					NotifyModified(DocModification(
 									SC_MOD_BEFOREINSERT | SC_PERFORMED_UNDO, action));
@@ -986,6 +1057,11 @@ int Document::Redo() {
 			for (int step = 0; step < steps; step++) {
 				const int prevLinesTotal = LinesTotal();
 				const Action &action = cb.GetRedoStep();
+				if (action.at == replaceAction) {
+					newPos = ReplaceStep(action, false,
+						SC_PERFORMED_REDO | ((steps > 1) ? SC_MULTISTEPUNDOREDO : 0), step == steps - 1, multiLine);
+					continue;
+				}
 				if (action.at == insertAction) {
 					NotifyModified(DocModification(
 									SC_MOD_BEFOREINSERT | SC_PERFORMED_REDO, action));
@@ -1446,6 +1522,32 @@ static inline char MakeLowerCase(char ch) {
 		return static_cast<char>(ch - 'A' + 'a');
 }
 
+ActionDuration::ActionDuration(double duration_, double minDuration_, double maxDuration_) :
+	duration(duration_), minDuration(minDuration_), maxDuration(maxDuration_) {
+}
+
+void ActionDuration::AddSample(int numberActions, double durationOfActions) {
+	// Only adjust for multiple actions to avoid instability
+	if (numberActions < 8)
+		return;
+	// Exponential smoothing with the most recent sample contributing a quarter
+	const double alpha = 0.25;
+	const double durationOne = durationOfActions / numberActions;
+	duration = alpha * durationOne + (1.0 - alpha) * duration;
+	if (duration < minDuration)
+		duration = minDuration;
+	if (duration > maxDuration)
+		duration = maxDuration;
+}
+
+double ActionDuration::Duration() const {
+	return duration;
+}
+
+int ActionDuration::ActionsInAllowedTime(double secondsAllowed) const {
+	return static_cast<int>(secondsAllowed / duration);
+}
+
 CaseFolderTable::CaseFolderTable() {
 	for (size_t iChar=0; iChar<sizeof(mapping); iChar++) {
 		mapping[iChar] = static_cast<char>(iChar);
@@ -1480,7 +1582,7 @@ void CaseFolderTable::StandardASCII() {
 	}
 }
 
-bool Document::MatchesWordOptions(bool word, bool wordStart, int pos, int length) {
+bool Document::MatchesWordOptions(bool word, bool wordStart, Sci_Position pos, Sci_Position length) {
 	return (!word && !wordStart) ||
 			(word && IsWordAt(pos, pos + length)) ||
 			(wordStart && IsWordStartAt(pos));
@@ -1493,6 +1595,44 @@ bool Document::HasCaseFolder(void) const {
 void Document::SetCaseFolder(CaseFolder *pcf_) {
 	delete pcf;
 	pcf = pcf_;
+	foldTableState = foldTableNone;
+}
+
+// A table folding each byte when the case folder folds single bytes to single bytes,
+// otherwise null. For UTF-8 only the ASCII entries are used.
+const char *Document::FoldTable() {
+	if (foldTableState == foldTableNone) {
+		foldTableState = foldTableValid;
+		const int bytesFolded = (SC_CP_UTF8 == dbcsCodePage) ? 0x80 : 0x100;
+		for (int ch = 0; ch < 0x100; ch++) {
+			foldTable[ch] = static_cast<char>(ch);
+			if (ch < bytesFolded) {
+				const char chMixed = static_cast<char>(ch);
+				char folded[UTF8MaxBytes * 4 + 1];
+				if (pcf->Fold(folded, sizeof(folded), &chMixed, 1) != 1)
+					foldTableState = foldTableInvalid;
+				foldTable[ch] = folded[0];
+			}
+		}
+	}
+	return (foldTableState == foldTableValid) ? foldTable : 0;
+}
+
+// Find bytes, optionally folded, skipping matches that do not satisfy the word options.
+Sci_Position Document::FindLiteral(Sci_Position rangeStart, Sci_Position rangeEnd, const char *s, int length,
+	const char *fold, bool forward, bool word, bool wordStart) {
+	while (rangeStart < rangeEnd) {
+		const Sci_Position pos = cb.FindBytes(rangeStart, rangeEnd, s, length, fold, forward);
+		if (pos < 0)
+			break;
+		if (MatchesWordOptions(word, wordStart, pos, length))
+			return pos;
+		if (forward)
+			rangeStart = pos + 1;
+		else
+			rangeEnd = pos + length - 1;
+	}
+	return -1;
 }
 
 /**
@@ -1500,15 +1640,22 @@ void Document::SetCaseFolder(CaseFolder *pcf_) {
  * searches (just pass minPos > maxPos to do a backward search)
  * Has not been tested with backwards DBCS searches yet.
  */
-long Document::FindText(int minPos, int maxPos, const char *search,
+Sci_Position Document::FindText(Sci_Position minPos, Sci_Position maxPos, const char *search,
                         bool caseSensitive, bool word, bool wordStart, bool regExp, int flags,
                         int *length) {
 	if ((minPos == maxPos) && (minPos == Length())) return -1; //!-add-[FixFind]
 	if (*length <= 0)
 		return minPos;
 	if (regExp) {
-		if (!regex)
-			regex = CreateRegexSearch(&charClass);
+		const bool linear = (flags & SCFIND_LINEARREGEX) != 0;
+		if (regex && (linear != regexLinear)) {
+			delete regex;
+			regex = 0;
+		}
+		if (!regex) {
+			regex = linear ? CreateLinearRegexSearch(&charClass) : CreateRegexSearch(&charClass);
+			regexLinear = linear;
+		}
 		return regex->FindText(this, minPos, maxPos, search, caseSensitive, word, wordStart, flags, length);
 	} else {
 
@@ -1516,21 +1663,29 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 		const int increment = forward ? 1 : -1;
 
 		// Range endpoints should not be inside DBCS characters, but just in case, move them.
-		const int startPos = MovePositionOutsideChar(minPos, increment, false);
-		const int endPos = MovePositionOutsideChar(maxPos, increment, false);
+		const Sci_Position startPos = MovePositionOutsideChar(minPos, increment, false);
+		const Sci_Position endPos = MovePositionOutsideChar(maxPos, increment, false);
 
 		// Compute actual search ranges needed
 		const int lengthFind = *length;
 
 		//Platform::DebugPrintf("Find %d %d %s %d\n", startPos, endPos, ft->lpstrText, lengthFind);
-		const int limitPos = Platform::Maximum(startPos, endPos);
-		int pos = startPos;
+		const Sci_Position limitPos = (startPos > endPos) ? startPos : endPos;
+		Sci_Position pos = startPos;
 		if (!forward) {
 			// Back all of a character
 			pos = NextPosition(pos, increment);
 		}
-		if (caseSensitive) {
-			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+		// Single byte text and UTF-8 text where the search does not start with a trail
+		// byte can be searched as bytes as no match can start inside a character.
+		const bool searchBytes = !dbcsCodePage ||
+			((SC_CP_UTF8 == dbcsCodePage) && !UTF8IsTrailByte(static_cast<unsigned char>(search[0])));
+		const Sci_Position rangeStart = forward ? startPos : endPos;
+		const Sci_Position rangeEnd = forward ? endPos : startPos;
+		if (caseSensitive && searchBytes) {
+			return FindLiteral(rangeStart, rangeEnd, search, lengthFind, 0, forward, word, wordStart);
+		} else if (caseSensitive) {
+			const Sci_Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
 				if (CharAt(pos) == charStartSearch) {
@@ -1552,9 +1707,10 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 				pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind));
 			char bytes[UTF8MaxBytes + 1];
 			char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
+			const char *foldAscii = FoldTable();
 			while (forward ? (pos < endPos) : (pos >= endPos)) {
 				int widthFirstCharacter = 0;
-				int posIndexDocument = pos;
+				Sci_Position posIndexDocument = pos;
 				int indexSearch = 0;
 				bool characterMatches = true;
 				for (;;) {
@@ -1572,7 +1728,12 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 						widthFirstCharacter = widthChar;
 					if ((posIndexDocument + widthChar) > limitPos)
 						break;
-					const int lenFlat = static_cast<int>(pcf->Fold(folded, sizeof(folded), bytes, widthChar));
+					int lenFlat = 1;
+					if (foldAscii && UTF8IsAscii(leadByte)) {
+						folded[0] = foldAscii[leadByte];
+					} else {
+						lenFlat = static_cast<int>(pcf->Fold(folded, sizeof(folded), bytes, widthChar));
+					}
 					folded[lenFlat] = 0;
 					// Does folded match the buffer
 					characterMatches = 0 == memcmp(folded, &searchThing[0] + indexSearch, lenFlat);
@@ -1585,7 +1746,7 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 				}
 				if (characterMatches && (indexSearch == static_cast<int>(lenSearch))) {
 					if (MatchesWordOptions(word, wordStart, pos, posIndexDocument - pos)) {
-						*length = posIndexDocument - pos;
+						*length = static_cast<int>(posIndexDocument - pos);
 						return pos;
 					}
 				}
@@ -1633,8 +1794,14 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 				if (!NextCharacter(pos, increment))
 					break;
 			}
+		} else if (FoldTable()) {
+			const char *fold = FoldTable();
+			std::vector<char> searchThing(lengthFind + 1);
+			for (int i = 0; i < lengthFind; i++)
+				searchThing[i] = fold[static_cast<unsigned char>(search[i])];
+			return FindLiteral(rangeStart, rangeEnd, &searchThing[0], lengthFind, fold, forward, word, wordStart);
 		} else {
-			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+			const Sci_Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			std::vector<char> searchThing(lengthFind + 1);
 			pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
@@ -1689,10 +1856,15 @@ void Document::ChangeCase(Range r, bool makeUpperCase) {
 
 void Document::SetDefaultCharClasses(bool includeWordClass) {
     charClass.SetDefaultCharClasses(includeWordClass);
+    // Word characters are compiled into patterns so discard any cached pattern
+    delete regex;
+    regex = 0;
 }
 
 void Document::SetCharClasses(const unsigned char *chars, CharClassify::cc newCharClass) {
     charClass.SetCharClasses(chars, newCharClass);
+    delete regex;
+    regex = 0;
 }
 
 int Document::GetCharsOfClass(CharClassify::cc characterClass, unsigned char *buffer) {
@@ -1704,57 +1876,161 @@ void Document::SetStylingBits(int bits) {
 	stylingBitsMask = (1 << stylingBits) - 1;
 }
 
-void SCI_METHOD Document::StartStyling(int position, char mask) {
+void SCI_METHOD Document::StartStyling(Sci_Position position, char mask) {
 	stylingMask = mask;
 	endStyled = position;
+	if ((lexEnd >= 0) && (position < lexStart)) {
+		lexStart = position;
+		lexCheckpointLine = Platform::Minimum(lexCheckpointLine, LineFromPosition(position) - 1);
+	}
 }
 
-bool SCI_METHOD Document::SetStyleFor(int length, char style) {
+bool SCI_METHOD Document::SetStyleFor(Sci_Position length, char style) {
 	if (enteredStyling != 0) {
 		return false;
 	} else {
 		enteredStyling++;
 		style &= stylingMask;
-		int prevEndStyled = endStyled;
-		if (cb.SetStyleFor(endStyled, length, style, stylingMask)) {
-			DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
-			                   prevEndStyled, length);
-			NotifyModified(mh);
-		}
+		Sci_Position changeStart = 0;
+		Sci_Position changeEnd = 0;
+		if (lexEnd < 0)
+			StylesInvalidFrom(endStyled);
+		if (cb.SetStyleFor(endStyled, length, style, stylingMask, changeStart, changeEnd))
+			StyleChanged(changeStart, changeEnd);
 		endStyled += length;
+		if (endStyled > Length())
+			endStyled = Length();
 		enteredStyling--;
 		return true;
 	}
 }
 
-bool SCI_METHOD Document::SetStyles(int length, const char *styles) {
+bool SCI_METHOD Document::SetStyles(Sci_Position length, const char *styles) {
 	if (enteredStyling != 0) {
 		return false;
 	} else {
 		enteredStyling++;
-		bool didChange = false;
-		int startMod = 0;
-		int endMod = 0;
-		for (int iPos = 0; iPos < length; iPos++, endStyled++) {
-			PLATFORM_ASSERT(endStyled < Length());
-			if (cb.SetStyleAt(endStyled, styles[iPos], stylingMask)) {
-				if (!didChange) {
-					startMod = endStyled;
-				}
-				didChange = true;
-				endMod = endStyled;
-			}
-		}
-		if (didChange) {
-			DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
-			                   startMod, endMod - startMod + 1);
-			NotifyModified(mh);
-		}
+		// Styles past the end are dropped by the cell buffer as a lexer may overrun by a character
+		PLATFORM_ASSERT(length >= 0);
+		Sci_Position changeStart = 0;
+		Sci_Position changeEnd = 0;
+		if (lexEnd < 0)
+			StylesInvalidFrom(endStyled);
+		if (cb.SetStyles(endStyled, length, styles, stylingMask, changeStart, changeEnd))
+			StyleChanged(changeStart, changeEnd);
+		endStyled += length;
+		if (endStyled > Length())
+			endStyled = Length();
 		enteredStyling--;
 		return true;
 	}
 }
 
+// Lexing sends many small style changes so, while it runs, combine them and
+// notify once so watchers invalidate and redraw once.
+void Document::BeginStyleBatch() {
+	if (styleBatchDepth == 0) {
+		styleBatchStart = 0;
+		styleBatchEnd = 0;
+	}
+	styleBatchDepth++;
+}
+
+void Document::EndStyleBatch() {
+	styleBatchDepth--;
+	if ((styleBatchDepth == 0) && (styleBatchEnd > styleBatchStart)) {
+		DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
+		                   styleBatchStart, styleBatchEnd - styleBatchStart);
+		styleBatchStart = 0;
+		styleBatchEnd = 0;
+		NotifyModified(mh);
+	}
+}
+
+void Document::StyleChanged(int start, int end) {
+	if (styleBatchDepth > 0) {
+		if (styleBatchEnd == styleBatchStart) {
+			styleBatchStart = start;
+			styleBatchEnd = end;
+		} else {
+			if (start < styleBatchStart)
+				styleBatchStart = start;
+			if (end > styleBatchEnd)
+				styleBatchEnd = end;
+		}
+	} else {
+		DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER, start, end - start);
+		NotifyModified(mh);
+	}
+}
+
+// Track which styles from earlier lexes may be kept so a lexer that reaches a
+// checkpoint with an unchanged state can stop there.
+void Document::LexStarting(int start, int end) {
+	lexStart = start;
+	lexEnd = end;
+	lexCheckpointLine = LineFromPosition(start) - 1;
+	lexConverged = false;
+}
+
+void Document::LexFinished() {
+	if (!lexConverged) {
+		ClearCheckpointsBefore(LineFromPosition(endStyled - 1) + 1);
+		StylesBreaksLexed(lexStart, endStyled);
+		if (endStyled >= stylesKeptEnd) {
+			// Lexers may report styling past the end
+			stylesKeptEnd = Platform::Minimum(endStyled, Length());
+		} else {
+			// Checkpoints before endStyled were just set from text that may differ from
+			// that which produced the styles after endStyled
+			StylesBreakAt(endStyled);
+		}
+	}
+	StylesBreakAt(lexStart);
+	lexEnd = -1;
+	lexConverged = false;
+}
+
+void Document::StylesInvalidFrom(int pos) {
+	if (stylesKeptEnd > pos)
+		StylesKeptTo(pos);
+}
+
+// Each edit moves the breaks after it so past this limit the last break is dropped along with
+// the styles kept after it.
+static const size_t stylesBreaksMax = 256;
+
+void Document::StylesBreakAt(int pos) {
+	if (pos >= stylesKeptEnd)
+		return;
+	std::vector<int>::iterator it = std::lower_bound(stylesBreaks.begin(), stylesBreaks.end(), pos);
+	if ((it == stylesBreaks.end()) || (*it != pos))
+		stylesBreaks.insert(it, pos);
+	if (stylesBreaks.size() > stylesBreaksMax)
+		StylesKeptTo(stylesBreaks.back());
+}
+
+void Document::StylesBreaksLexed(int start, int end) {
+	if (end > start)
+		stylesBreaks.erase(std::lower_bound(stylesBreaks.begin(), stylesBreaks.end(), start),
+			std::lower_bound(stylesBreaks.begin(), stylesBreaks.end(), end));
+}
+
+void Document::StylesKeptTo(int pos) {
+	stylesKeptEnd = pos;
+	stylesBreaks.erase(std::lower_bound(stylesBreaks.begin(), stylesBreaks.end(), pos),
+		stylesBreaks.end());
+}
+
+// Lines passed by the current lex without it setting a checkpoint, perhaps as the lexer
+// skipped over their starts, keep checkpoints that no longer match the styles after them.
+void Document::ClearCheckpointsBefore(int line) {
+	if (line > lexCheckpointLine + 1) {
+		static_cast<LineCheckpoints *>(perLineData[ldCheckpoints])->ClearRange(lexCheckpointLine + 1, line - 1);
+		lexCheckpointLine = line - 1;
+	}
+}
+
 void Document::EnsureStyledTo(int pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
 		IncrementStyleClock();
@@ -1771,7 +2047,20 @@ void Document::EnsureStyledTo(int pos) {
 	}
 }
 
+// Style and measure how long styling took so that later calls can choose how
+// much to style in the time available.
+void Document::StyleToAdjustingLineDuration(int pos) {
+	const int lineFirst = LineFromPosition(GetEndStyled());
+	ElapsedTime etStyling;
+	EnsureStyledTo(pos);
+	const double durationStyling = etStyling.Duration();
+	const int lineLast = LineFromPosition(GetEndStyled());
+	durationStyleOneLine.AddSample(lineLast - lineFirst, durationStyling);
+}
+
 void Document::LexerChanged() {
+	static_cast<LineCheckpoints *>(perLineData[ldCheckpoints])->ClearAll();
+	StylesKeptTo(0);
 	// Tell the watchers the lexer has changed.
 	for (int i = 0; i < lenWatchers; i++) {
 		watchers[i].watcher->NotifyLexerChanged(this, watchers[i].userData);
@@ -1795,11 +2084,41 @@ int Document::GetMaxLineState() {
 	return static_cast<LineState *>(perLineData[ldState])->GetMaxLineState();
 }
 
-void SCI_METHOD Document::ChangeLexerState(int start, int end) {
+void SCI_METHOD Document::ChangeLexerState(Sci_Position start, Sci_Position end) {
+	StylesInvalidFrom(start);
 	DocModification mh(SC_MOD_LEXERSTATE, start, end-start, 0, 0, 0);
 	NotifyModified(mh);
 }
 
+void SCI_METHOD Document::SetLineCheckpoint(int line, const char *state, int length) {
+	if (lexEnd >= 0) {
+		ClearCheckpointsBefore(line);
+		lexCheckpointLine = line;
+	}
+	static_cast<LineCheckpoints *>(perLineData[ldCheckpoints])->Set(line, state, length);
+}
+
+int SCI_METHOD Document::GetLineCheckpoint(int line, char *state, int length) const {
+	return static_cast<LineCheckpoints *>(perLineData[ldCheckpoints])->Get(line, state, length);
+}
+
+bool SCI_METHOD Document::StylesConverged(int line, Sci_Position position) {
+	if ((lexEnd < 0) || (position > LineStart(line)))
+		return false;
+	// Styles are kept up to the next break which must be past the range being lexed
+	int keptEnd = stylesKeptEnd;
+	std::vector<int>::const_iterator it = std::lower_bound(stylesBreaks.begin(), stylesBreaks.end(), position);
+	if (it != stylesBreaks.end())
+		keptEnd = *it;
+	if ((keptEnd < lexEnd) || (keptEnd <= LineStart(line)))
+		return false;
+	ClearCheckpointsBefore(line);
+	StylesBreaksLexed(lexStart, position);
+	endStyled = keptEnd;
+	lexConverged = true;
+	return true;
+}
+
 StyledText Document::MarginStyledText(int line) {
 	LineAnnotation *pla = static_cast<LineAnnotation *>(perLineData[ldMargin]);
 	return StyledText(pla->Length(line), pla->Text(line),
@@ -1887,7 +2206,7 @@ void Document::IncrementStyleClock() {
 	styleClock = (styleClock + 1) % 0x100000;
 }
 
-void SCI_METHOD Document::DecorationFillRange(int position, int value, int fillLength) {
+void SCI_METHOD Document::DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) {
 	if (decorations.FillRange(position, value, fillLength)) {
 		DocModification mh(SC_MOD_CHANGEINDICATOR | SC_PERFORMED_USER,
 							position, fillLength);
@@ -1895,6 +2214,115 @@ void SCI_METHOD Document::DecorationFillRange(int position, int value, int fillL
 	}
 }
 
+/**
+ * Replace ranges that are in ascending order and do not overlap. The replacement for
+ * range i ends at replacementEnds[i] in replacements and starts where the previous one ends.
+ * The text from the first range to the last is swapped for its new text in one step that
+ * is undone as one action. Only the ranges are changed so markers, annotations, margin text
+ * and indicators on the text between them are kept.
+ * On return starts and ends hold the positions of the replacements.
+ * @return The number of ranges replaced which is 0 when the document can not be changed.
+ */
+int Document::ReplaceRanges(std::vector<int> &starts, std::vector<int> &ends,
+	const std::string &replacements, const std::vector<int> &replacementEnds) {
+	const int count = static_cast<int>(starts.size());
+	if ((count == 0) || (starts[0] < 0) || (ends[count - 1] > Length()))
+		return 0;
+	CheckReadOnly();
+	if (enteredModification != 0)
+		return 0;
+	enteredModification++;
+	int replaced = 0;
+	if (!cb.IsReadOnly()) {
+		// Build the new text of the span from the first range to the last in one pass
+		const int position = starts[0];
+		const int lengthOld = ends[count - 1] - position;
+		std::string textOld(lengthOld, '\0');
+		if (lengthOld > 0)
+			cb.GetCharRange(&textOld[0], position, lengthOld);
+		std::string textNew;
+		textNew.reserve(lengthOld + replacements.length());
+		std::vector<ReplacedRange> ranges(count);
+		int replacementStart = 0;
+		int endPrevious = position;
+		for (int i = 0; i < count; i++) {
+			textNew.append(textOld, endPrevious - position, starts[i] - endPrevious);
+			endPrevious = ends[i];
+			ranges[i].offset = starts[i] - position;
+			ranges[i].lengthRemoved = ends[i] - starts[i];
+			ranges[i].lengthInserted = replacementEnds[i] - replacementStart;
+			starts[i] = static_cast<int>(textNew.length()) + position;
+			textNew.append(replacements, replacementStart, ranges[i].lengthInserted);
+			ends[i] = static_cast<int>(textNew.length()) + position;
+			replacementStart = replacementEnds[i];
+		}
+
+		NotifyModified(DocModification(SC_MOD_BEFOREDELETE | SC_PERFORMED_USER,
+			position, lengthOld, 0, 0));
+		NotifyModified(DocModification(SC_MOD_BEFOREINSERT | SC_PERFORMED_USER,
+			position, static_cast<int>(textNew.length()), 0, textNew.c_str()));
+		const int prevLinesTotal = LinesTotal();
+		const bool startSavePoint = cb.IsSavePoint();
+		bool startSequence = false;
+		const int linesRemoved = cb.ReplaceSpan(position, lengthOld, textNew.c_str(),
+			static_cast<int>(textNew.length()), &ranges[0], count, startSequence);
+		if (startSavePoint && cb.IsCollectingUndo())
+			NotifySavePoint(!startSavePoint);
+		ModifiedAt(position);
+		NotifyReplaced(SC_PERFORMED_USER | (startSequence ? SC_STARTACTION : 0), 0, position,
+			textOld, textNew, linesRemoved, LinesTotal() - prevLinesTotal + linesRemoved, &ranges[0], count);
+		replaced = count;
+	}
+	enteredModification--;
+	return replaced;
+}
+
+// Undo or redo a replacement with notifications like ReplaceRanges, returning the end of the new text.
+int Document::ReplaceStep(const Action &action, bool undo, int modFlags, bool lastStep, bool &multiLine) {
+	int linesRemoved = 0;
+	int linesInserted = 0;
+	const int count = CellBuffer::ReplaceStepRanges(action, undo, 0, linesRemoved, linesInserted);
+	std::vector<ReplacedRange> ranges(count);
+	CellBuffer::ReplaceStepRanges(action, undo, &ranges[0], linesRemoved, linesInserted);
+	const int position = static_cast<int>(action.position);
+	const int lengthOld = static_cast<int>(ranges[count - 1].offset + ranges[count - 1].lengthRemoved);
+	std::string textOld(lengthOld, '\0');
+	if (lengthOld > 0)
+		cb.GetCharRange(&textOld[0], position, lengthOld);
+	std::string textNew(cb.ReplaceStepText(action, undo, 0), '\0');
+	if (!textNew.empty())
+		cb.ReplaceStepText(action, undo, &textNew[0]);
+
+	NotifyModified(DocModification(SC_MOD_BEFOREDELETE | modFlags, position, lengthOld, 0, 0));
+	NotifyModified(DocModification(SC_MOD_BEFOREINSERT | modFlags,
+		position, static_cast<int>(textNew.length()), 0, textNew.c_str()));
+	if (undo)
+		cb.PerformUndoStep();
+	else
+		cb.PerformRedoStep();
+	ModifiedAt(position);
+	if ((linesRemoved != 0) || (linesInserted != 0))
+		multiLine = true;
+	int modFlagsLast = 0;
+	if (lastStep) {
+		modFlagsLast |= SC_LASTSTEPINUNDOREDO;
+		if (multiLine)
+			modFlagsLast |= SC_MULTILINEUNDOREDO;
+	}
+	NotifyReplaced(modFlags, modFlagsLast, position, textOld, textNew, linesRemoved, linesInserted,
+		&ranges[0], count);
+	return position + static_cast<int>(textNew.length());
+}
+
+// The ranges are in ascending order so one notification covers them all.
+void Document::DecorationFillRanges(const int *starts, const int *ends, int count, int value) {
+	if ((count > 0) && decorations.FillRanges(starts, ends, count, value)) {
+		DocModification mh(SC_MOD_CHANGEINDICATOR | SC_PERFORMED_USER,
+							starts[0], ends[count - 1] - starts[0]);
+		NotifyModified(mh);
+	}
+}
+
 bool Document::AddWatcher(DocWatcher *watcher, void *userData) {
 	for (int i = 0; i < lenWatchers; i++) {
 		if ((watchers[i].watcher == watcher) &&
@@ -1947,17 +2375,75 @@ void Document::NotifySavePoint(bool atSavePoint) {
 	}
 }
 
+void Document::StylesInserted(int position, int length) {
+	if (stylesKeptEnd > position)
+		stylesKeptEnd += length;
+	for (std::vector<int>::iterator it = stylesBreaks.begin(); it != stylesBreaks.end(); ++it) {
+		if (*it > position)
+			*it += length;
+	}
+	StylesBreakAt(position);
+}
+
+void Document::StylesDeleted(int position, int length) {
+	const int deleteEnd = position + length;
+	if (stylesKeptEnd > deleteEnd)
+		stylesKeptEnd -= length;
+	else if (stylesKeptEnd > position)
+		stylesKeptEnd = position;
+	for (std::vector<int>::iterator it = stylesBreaks.begin(); it != stylesBreaks.end(); ++it) {
+		if (*it > deleteEnd)
+			*it -= length;
+		else if (*it > position)
+			*it = position;
+	}
+	stylesBreaks.erase(std::unique(stylesBreaks.begin(), stylesBreaks.end()), stylesBreaks.end());
+	StylesBreakAt(position);
+}
+
 void Document::NotifyModified(DocModification mh) {
 	if (mh.modificationType & SC_MOD_INSERTTEXT) {
 		decorations.InsertSpace(mh.position, mh.length);
+		StylesInserted(mh.position, mh.length);
 	} else if (mh.modificationType & SC_MOD_DELETETEXT) {
 		decorations.DeleteRange(mh.position, mh.length);
+		StylesDeleted(mh.position, mh.length);
 	}
+	NotifyWatchers(mh);
+}
+
+void Document::NotifyWatchers(const DocModification &mh) {
+	if (mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
+		textClock = (textClock + 1) % 0x40000000;
 	for (int i = 0; i < lenWatchers; i++) {
 		watchers[i].watcher->NotifyModified(this, mh, watchers[i].userData);
 	}
 }
 
+// Watchers see a replacement as the deletion of the old span followed by the insertion of
+// the new span. Decorations move with each range so those between the ranges are kept.
+void Document::NotifyReplaced(int modFlags, int modFlagsLast, int position,
+	const std::string &textOld, const std::string &textNew, int linesRemoved, int linesInserted,
+	const ReplacedRange *ranges, int count) {
+	std::vector<int> starts(count);
+	std::vector<int> ends(count);
+	std::vector<int> lengthsInserted(count);
+	for (int i = 0; i < count; i++) {
+		starts[i] = position + static_cast<int>(ranges[i].offset);
+		ends[i] = starts[i] + static_cast<int>(ranges[i].lengthRemoved);
+		lengthsInserted[i] = static_cast<int>(ranges[i].lengthInserted);
+	}
+	decorations.ReplaceRanges(&starts[0], &ends[0], &lengthsInserted[0], count);
+	const int lengthOld = static_cast<int>(textOld.length());
+	const int lengthNew = static_cast<int>(textNew.length());
+	StylesDeleted(position, lengthOld);
+	StylesInserted(position, lengthNew);
+	NotifyWatchers(DocModification(SC_MOD_DELETETEXT | modFlags, position, lengthOld,
+		-linesRemoved, textOld.c_str()));
+	NotifyWatchers(DocModification(SC_MOD_INSERTTEXT | (modFlags & ~SC_STARTACTION) | modFlagsLast,
+		position, lengthNew, linesInserted, textNew.c_str()));
+}
+
 bool Document::IsWordPartSeparator(char ch) {
 	return (WordCharClass(ch) == CharClassify::ccWord) && IsPunctuation(ch);
 }
@@ -2128,7 +2614,9 @@ int Document::BraceMatch(int position, int /*maxReStyle*/) {
  */
 class BuiltinRegex : public RegexSearchBase {
 public:
-	BuiltinRegex(CharClassify *charClassTable) : search(charClassTable), substituted(NULL) {}
+	BuiltinRegex(CharClassify *charClassTable) : search(charClassTable), substituted(NULL),
+		compiled(false), caseSensitiveCompiled(false), posixCompiled(false), codePageCompiled(0),
+		lineCopyStart(-1), lineCopyClock(-1) {}
 
 	virtual ~BuiltinRegex() {
 		delete substituted;
@@ -2143,6 +2631,17 @@ public:
 private:
 	RESearch search;
 	char *substituted;
+	// The pattern currently compiled into search so repeated searches do not recompile it
+	bool compiled;
+	std::string patternCompiled;
+	bool caseSensitiveCompiled;
+	bool posixCompiled;
+	int codePageCompiled;
+	// Lines that are not stored contiguously are copied here to be searched and the copy
+	// is reused until the text changes
+	std::vector<char> lineCopy;
+	int lineCopyStart;
+	int lineCopyClock;
 };
 
 // Define a way for the Regular Expression code to access the document
@@ -2178,9 +2677,18 @@ long BuiltinRegex::FindText(Document *doc, int minPos, int maxPos, const char *s
 	startPos = doc->MovePositionOutsideChar(startPos, 1, false);
 	endPos = doc->MovePositionOutsideChar(endPos, 1, false);
 
-	const char *errmsg = search.Compile(s, *length, caseSensitive, posix);
-	if (errmsg) {
-		return -1;
+	if (!compiled || (caseSensitive != caseSensitiveCompiled) || (posix != posixCompiled) ||
+		(doc->dbcsCodePage != codePageCompiled) ||
+		(patternCompiled.compare(0, std::string::npos, s, *length) != 0)) {
+		const char *errmsg = search.Compile(s, *length, caseSensitive, posix);
+		compiled = !errmsg;
+		if (errmsg) {
+			return -1;
+		}
+		patternCompiled.assign(s, *length);
+		caseSensitiveCompiled = caseSensitive;
+		posixCompiled = posix;
+		codePageCompiled = doc->dbcsCodePage;
 	}
 	// Find a variable in a property file: \$(\([A-Za-z0-9_.]+\))
 	// Replace first '.' with '-' in each property file variable reference:
@@ -2233,7 +2741,20 @@ long BuiltinRegex::FindText(Document *doc, int minPos, int maxPos, const char *s
 			}
 		}
 
-		DocumentIndexer di(doc, endOfLine);
+		// Match directly against the stored text when possible, otherwise against a copy
+		const int lengthLine = Platform::Maximum(endOfLine - startOfLine, 0);
+		const char *textLine = doc->ContiguousRangePointer(startOfLine, lengthLine);
+		if (!textLine) {
+			if ((startOfLine != lineCopyStart) || (lengthLine + 1 != static_cast<int>(lineCopy.size())) ||
+				(doc->GetTextClock() != lineCopyClock)) {
+				lineCopy.resize(lengthLine + 1);
+				doc->GetCharRange(&lineCopy[0], startOfLine, lengthLine);
+				lineCopyStart = startOfLine;
+				lineCopyClock = doc->GetTextClock();
+			}
+			textLine = &lineCopy[0];
+		}
+		TextIndexer di(textLine, startOfLine, endOfLine);
 		int success = search.Execute(di, startOfLine, endOfLine);
 		if (success) {
 			pos = search.bopat[0];
@@ -2344,6 +2865,204 @@ const char *BuiltinRegex::SubstituteByPosition(Document *doc, const char *text,
 	return substituted;
 }
 
+/**
+ * Implementation of RegexSearchBase for the linear time regular expression engine
+ */
+class LinearTimeRegex : public RegexSearchBase {
+public:
+	LinearTimeRegex() : compiled(false), caseSensitiveCompiled(false), posixCompiled(false), codePageCompiled(0),
+		lineCopyStart(-1), lineCopyClock(-1) {
+		for (int g = 0; g < LinearRegex::maxGroups; g++) {
+			matchStart[g] = -1;
+			matchEnd[g] = -1;
+		}
+	}
+
+	virtual ~LinearTimeRegex() {
+	}
+
+	virtual long FindText(Document *doc, int minPos, int maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, int flags,
+                        int *length);
+
+	virtual const char *SubstituteByPosition(Document *doc, const char *text, int *length);
+
+private:
+	LinearRegex search;
+	// The pattern and tables currently compiled into search
+	bool compiled;
+	std::string patternCompiled;
+	bool caseSensitiveCompiled;
+	bool posixCompiled;
+	int codePageCompiled;
+	std::string tablesCompiled;
+	// Copy of the line that straddles the gap, kept until the text changes
+	std::vector<char> lineCopy;
+	int lineCopyStart;
+	int lineCopyClock;
+	int matchStart[LinearRegex::maxGroups];
+	int matchEnd[LinearRegex::maxGroups];
+	std::string substituted;
+
+	bool Compile(Document *doc, const char *s, int length, bool caseSensitive, bool posix);
+};
+
+bool LinearTimeRegex::Compile(Document *doc, const char *s, int length, bool caseSensitive, bool posix) {
+	char leadBytes[256];
+	char wordBytes[256];
+	for (int ch = 0; ch < 256; ch++) {
+		leadBytes[ch] = doc->IsDBCSLeadByte(static_cast<char>(ch));
+		wordBytes[ch] = doc->WordCharClass(static_cast<unsigned char>(ch)) == CharClassify::ccWord;
+	}
+	const char *fold = doc->FoldTable();
+	std::string tables(wordBytes, sizeof(wordBytes));
+	if (fold)
+		tables.append(fold, 256);
+	if (compiled && (caseSensitive == caseSensitiveCompiled) && (posix == posixCompiled) &&
+		(doc->dbcsCodePage == codePageCompiled) && (tables == tablesCompiled) &&
+		(patternCompiled.compare(0, std::string::npos, s, length) == 0))
+		return true;
+	LinearRegex::Encoding encoding = LinearRegex::encSingleByte;
+	if (doc->dbcsCodePage == SC_CP_UTF8)
+		encoding = LinearRegex::encUTF8;
+	else if (doc->dbcsCodePage)
+		encoding = LinearRegex::encDBCS;
+	search.SetEncoding(encoding, leadBytes, fold, wordBytes);
+	compiled = !search.Compile(s, length, caseSensitive, posix);
+	patternCompiled.assign(s, length);
+	caseSensitiveCompiled = caseSensitive;
+	posixCompiled = posix;
+	codePageCompiled = doc->dbcsCodePage;
+	tablesCompiled = tables;
+	return compiled;
+}
+
+/**
+ * Find a match within one line at a time, searching lines that do not match with a DFA
+ * so the time taken is linear in the length of the range.
+ */
+long LinearTimeRegex::FindText(Document *doc, int minPos, int maxPos, const char *s,
+                        bool caseSensitive, bool, bool, int flags,
+                        int *length) {
+	if (!Compile(doc, s, *length, caseSensitive, (flags & SCFIND_POSIX) != 0))
+		return -1;
+
+	const bool forward = minPos <= maxPos;
+	const int increment = forward ? 1 : -1;
+	const int startPos = doc->MovePositionOutsideChar(minPos, increment, false);
+	const int endPos = doc->MovePositionOutsideChar(maxPos, increment, false);
+	const int rangeStart = forward ? startPos : endPos;
+	const int rangeEnd = forward ? endPos : startPos;
+	const int lineRangeStart = doc->LineFromPosition(forward ? rangeStart : rangeEnd);
+	const int lineRangeEnd = doc->LineFromPosition(forward ? rangeEnd : rangeStart);
+	const int lineRangeBreak = lineRangeEnd + increment;
+	for (int line = lineRangeStart; line != lineRangeBreak; line += increment) {
+		const int startOfLine = doc->LineStart(line);
+		const int lengthLine = doc->LineEnd(line) - startOfLine;
+		const int startSearch = Platform::Maximum(rangeStart, startOfLine) - startOfLine;
+		const int endSearch = Platform::Minimum(rangeEnd - startOfLine, lengthLine);
+		if (startSearch > endSearch)
+			continue;
+		// The whole line is searched so that ^, $ and word boundaries see the surrounding text
+		const char *textLine = doc->ContiguousRangePointer(startOfLine, lengthLine);
+		if (!textLine) {
+			if ((startOfLine != lineCopyStart) || (lengthLine + 1 != static_cast<int>(lineCopy.size())) ||
+				(doc->GetTextClock() != lineCopyClock)) {
+				lineCopy.resize(lengthLine + 1);
+				doc->GetCharRange(&lineCopy[0], startOfLine, lengthLine);
+				lineCopyStart = startOfLine;
+				lineCopyClock = doc->GetTextClock();
+			}
+			textLine = &lineCopy[0];
+		}
+		bool found = false;
+		int from = startSearch;
+		while (search.Search(textLine, lengthLine, from, endSearch)) {
+			found = true;
+			for (int g = 0; g < LinearRegex::maxGroups; g++) {
+				matchStart[g] = (search.groupStart[g] >= 0) ? startOfLine + search.groupStart[g] : -1;
+				matchEnd[g] = (search.groupEnd[g] >= 0) ? startOfLine + search.groupEnd[g] : -1;
+			}
+			if (forward)
+				break;
+			// Searching backwards finds the last of the matches that do not overlap
+			if (search.groupEnd[0] > search.groupStart[0])
+				from = search.groupEnd[0];
+			else if (search.groupStart[0] < endSearch)
+				from = doc->MovePositionOutsideChar(matchStart[0] + 1, 1, false) - startOfLine;
+			else
+				break;
+		}
+		if (found) {
+			*length = matchEnd[0] - matchStart[0];
+			return matchStart[0];
+		}
+	}
+	return -1;
+}
+
+static int EscapedCharacter(char ch) {
+	switch (ch) {
+	case 'a':
+		return '\a';
+	case 'b':
+		return '\b';
+	case 'f':
+		return '\f';
+	case 'n':
+		return '\n';
+	case 'r':
+		return '\r';
+	case 't':
+		return '\t';
+	case 'v':
+		return '\v';
+	case '\\':
+		return '\\';
+	default:
+		return -1;
+	}
+}
+
+const char *LinearTimeRegex::SubstituteByPosition(Document *doc, const char *text, int *length) {
+	substituted.clear();
+	for (int i = 0; i < *length; i++) {
+		if ((text[i] == '\\') && (i + 1 < *length)) {
+			const char chNext = text[i + 1];
+			if (chNext >= '0' && chNext <= '9') {
+				const int patNum = chNext - '0';
+				for (int pos = matchStart[patNum]; (pos >= 0) && (pos < matchEnd[patNum]); pos++)
+					substituted.push_back(doc->CharAt(pos));
+				i++;
+				continue;
+			}
+			const int chEscaped = EscapedCharacter(chNext);
+			if (chEscaped >= 0) {
+				substituted.push_back(static_cast<char>(chEscaped));
+				i++;
+				continue;
+			}
+		}
+		substituted.push_back(text[i]);
+	}
+	*length = static_cast<int>(substituted.length());
+	return substituted.c_str();
+}
+
+#ifdef SCI_NAMESPACE
+
+RegexSearchBase *Scintilla::CreateLinearRegexSearch(CharClassify *) {
+	return new LinearTimeRegex();
+}
+
+#else
+
+RegexSearchBase *CreateLinearRegexSearch(CharClassify *) {
+	return new LinearTimeRegex();
+}
+
+#endif
+
 #ifndef SCI_OWNREGEX
 
 #ifdef SCI_NAMESPACE
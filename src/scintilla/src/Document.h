@@ -93,6 +93,9 @@ public:
 /// Factory function for RegexSearchBase
 extern RegexSearchBase *CreateRegexSearch(CharClassify *charClassTable);
 
+/// Factory function for the linear time RegexSearchBase used with SCFIND_LINEARREGEX
+extern RegexSearchBase *CreateLinearRegexSearch(CharClassify *charClassTable);
+
 struct StyledText {
 	size_t length;
 	const char *text;
@@ -173,6 +176,21 @@ public:
 	void StandardASCII();
 };
 
+/**
+ * Smoothed duration of one action such as wrapping a line, used to decide how many
+ * actions fit into the time allowed for an idle call.
+ */
+class ActionDuration {
+	double duration;
+	double minDuration;
+	double maxDuration;
+public:
+	ActionDuration(double duration_, double minDuration_, double maxDuration_);
+	void AddSample(int numberActions, double durationOfActions);
+	double Duration() const;
+	int ActionsInAllowedTime(double secondsAllowed) const;
+};
+
 class Document;
 
 class LexInterface {
@@ -194,7 +212,7 @@ public:
 
 /**
  */
-class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
+class Document : PerLine, public IDocumentWithCheckpoints, public ILoaderWithView {
 
 public:
 	/** Used to pair watcher pointer with user data. */
@@ -214,22 +232,56 @@ private:
 	CellBuffer cb;
 	CharClassify charClass;
 	CaseFolder *pcf;
+	/// Each byte folded by pcf, built when first needed for searching.
+	char foldTable[256];
+	enum { foldTableNone, foldTableValid, foldTableInvalid } foldTableState;
 	char stylingMask;
 	int endStyled;
 	int styleClock;
+	/// Changes whenever text is inserted or deleted so copies of the text can be reused
+	int textClock;
 	int enteredModification;
 	int enteredStyling;
 	int enteredReadOnlyCount;
+	/// While positive, style changes are combined into one notification sent by EndStyleBatch
+	int styleBatchDepth;
+	int styleBatchStart;
+	int styleBatchEnd;
+	/// Styles and checkpoints before stylesKeptEnd were set by earlier lexes and, where the
+	/// text after them is unchanged, may be kept when a lexer converges
+	int stylesKeptEnd;
+	/// Sorted positions after which kept styles may not follow on from the checkpoints
+	/// before them: changed text, lexes restarting from partial state and lexes stopping
+	/// short. Lexing over a break removes it.
+	std::vector<int> stylesBreaks;
+	/// Range being lexed with lexEnd -1 when not lexing. Lexers may back up and restyle
+	/// from before the requested start so lexStart follows the earliest styling.
+	int lexStart;
+	int lexEnd;
+	/// Last line given a checkpoint by the current lex
+	int lexCheckpointLine;
+	bool lexConverged;
 
 	WatcherWithUserData *watchers;
 	int lenWatchers;
 
 	// ldSize is not real data - it is for dimensions and loops
-	enum lineData { ldMarkers, ldLevels, ldState, ldMargin, ldAnnotation, ldSize };
+	enum lineData { ldMarkers, ldLevels, ldState, ldMargin, ldAnnotation, ldCheckpoints, ldSize };
 	PerLine *perLineData[ldSize];
 
 	bool matchesValid;
 	RegexSearchBase *regex;
+	bool regexLinear;
+
+	/// Memory that the text may refer to, released when the text no longer refers to it.
+	std::vector<IMemoryView *> views;
+	void ReleaseViews();
+
+	void StylesBreakAt(int pos);
+	void StylesBreaksLexed(int start, int end);
+	void StylesKeptTo(int pos);
+	void StylesInserted(int position, int length);
+	void StylesDeleted(int position, int length);
 
 public:
 
@@ -250,6 +302,7 @@ public:
 	bool backspaceUnindents;
 
 	DecorationList decorations;
+	ActionDuration durationStyleOneLine;
 
 	Document();
 	virtual ~Document();
@@ -267,19 +320,19 @@ public:
 	virtual void RemoveLine(int line);
 
 	int SCI_METHOD Version() const {
-		return dvLineEnd;
+		return dvCheckpoints;
 	}
 
 	void SCI_METHOD SetErrorStatus(int status);
 
-	int SCI_METHOD LineFromPosition(int pos) const;
+	int SCI_METHOD LineFromPosition(Sci_Position pos) const;
 	int ClampPositionIntoDocument(int pos);
-	bool IsCrLf(int pos);
+	bool IsCrLf(Sci_Position pos);
 	int LenChar(int pos);
-	bool InGoodUTF8(int pos, int &start, int &end) const;
-	int MovePositionOutsideChar(int pos, int moveDir, bool checkLineEnd=true);
-	int NextPosition(int pos, int moveDir) const;
-	bool NextCharacter(int &pos, int moveDir);	// Returns true if pos changed
+	bool InGoodUTF8(Sci_Position pos, Sci_Position &start, Sci_Position &end) const;
+	Sci_Position MovePositionOutsideChar(Sci_Position pos, int moveDir, bool checkLineEnd=true);
+	Sci_Position NextPosition(Sci_Position pos, int moveDir) const;
+	bool NextCharacter(Sci_Position &pos, int moveDir);	// Returns true if pos changed
 	int SCI_METHOD CodePage() const;
 	bool SCI_METHOD IsDBCSLeadByte(char ch) const;
 	int SafeSegment(const char *text, int length, int lengthSegment);
@@ -289,8 +342,12 @@ public:
 	void CheckReadOnly();
 	bool DeleteChars(int pos, int len);
 	bool InsertString(int position, const char *s, int insertLength);
+	int ReplaceRanges(std::vector<int> &starts, std::vector<int> &ends,
+		const std::string &replacements, const std::vector<int> &replacementEnds);
 	int SCI_METHOD AddData(char *data, int length);
 	void * SCI_METHOD ConvertToDocument();
+	int SCI_METHOD AddView(IMemoryView *view);
+	bool SCI_METHOD KeepsViews();
 	int Undo();
 	int Redo();
 	bool CanUndo() { return cb.CanUndo(); }
@@ -300,14 +357,22 @@ public:
 		return cb.SetUndoCollection(collectUndo);
 	}
 	bool IsCollectingUndo() { return cb.IsCollectingUndo(); }
+	void SetUndoMemoryLimit(size_t limit) { cb.SetUndoMemoryLimit(limit); }
+	size_t GetUndoMemoryLimit() const { return cb.GetUndoMemoryLimit(); }
 	void BeginUndoAction() { cb.BeginUndoAction(); }
 	void EndUndoAction() { cb.EndUndoAction(); }
 	void AddUndoAction(int token, bool mayCoalesce) { cb.AddUndoAction(token, mayCoalesce); }
 	void SetSavePoint();
 	bool IsSavePoint() { return cb.IsSavePoint(); }
-	const char * SCI_METHOD BufferPointer() { return cb.BufferPointer(); }
+	const char * SCI_METHOD BufferPointer();
 	const char *RangePointer(int position, int rangeLength) { return cb.RangePointer(position, rangeLength); }
+	const char *ContiguousRangePointer(int position, int rangeLength) const {
+		return cb.ContiguousRangePointer(position, rangeLength);
+	}
 	int GapPosition() const { return cb.GapPosition(); }
+	const char * SCI_METHOD ContiguousRange(Sci_Position position, Sci_Position *start, Sci_Position *length) const {
+		return cb.ContiguousRange(position, *start, *length);
+	}
 
 	int SCI_METHOD GetLineIndentation(int line);
 	void SetLineIndentation(int line, int indent);
@@ -327,11 +392,11 @@ public:
 	void DelChar(int pos);
 	void DelCharBack(int pos);
 
-	char CharAt(int position) { return cb.CharAt(position); }
-	void SCI_METHOD GetCharRange(char *buffer, int position, int lengthRetrieve) const {
+	char CharAt(Sci_Position position) { return cb.CharAt(position); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
 		cb.GetCharRange(buffer, position, lengthRetrieve);
 	}
-	char SCI_METHOD StyleAt(int position) const { return cb.StyleAt(position); }
+	char SCI_METHOD StyleAt(Sci_Position position) const { return cb.StyleAt(position); }
 	void GetStyleRange(unsigned char *buffer, int position, int lengthRetrieve) const {
 		cb.GetStyleRange(buffer, position, lengthRetrieve);
 	}
@@ -343,8 +408,8 @@ public:
 	void DeleteMarkFromHandle(int markerHandle);
 	void DeleteAllMarks(int markerNum);
 	int LineFromHandle(int markerHandle);
-	int SCI_METHOD LineStart(int line) const;
-	int SCI_METHOD LineEnd(int line) const;
+	Sci_Position SCI_METHOD LineStart(int line) const;
+	Sci_Position SCI_METHOD LineEnd(int line) const;
 	int LineEndPosition(int position) const;
 	bool IsLineEndPosition(int position) const;
 	bool IsPositionInLineEnd(int position) const;
@@ -361,12 +426,15 @@ public:
 	int ExtendWordSelect(int pos, int delta, bool onlyWordCharacters=false);
 	int NextWordStart(int pos, int delta);
 	int NextWordEnd(int pos, int delta);
-	int SCI_METHOD Length() const { return cb.Length(); }
-	void Allocate(int newSize) { cb.Allocate(newSize); }
-	bool MatchesWordOptions(bool word, bool wordStart, int pos, int length);
+	Sci_Position SCI_METHOD Length() const { return cb.Length(); }
+	void Allocate(Sci_Position newSize) { cb.Allocate(newSize); }
+	bool MatchesWordOptions(bool word, bool wordStart, Sci_Position pos, Sci_Position length);
 	bool HasCaseFolder(void) const;
 	void SetCaseFolder(CaseFolder *pcf_);
-	long FindText(int minPos, int maxPos, const char *search, bool caseSensitive, bool word,
+	const char *FoldTable();
+	Sci_Position FindLiteral(Sci_Position rangeStart, Sci_Position rangeEnd, const char *s, int length,
+		const char *fold, bool forward, bool word, bool wordStart);
+	Sci_Position FindText(Sci_Position minPos, Sci_Position maxPos, const char *search, bool caseSensitive, bool word,
 		bool wordStart, bool regExp, int flags, int *length);
 	const char *SubstituteByPosition(const char *text, int *length);
 	int LinesTotal() const;
@@ -377,23 +445,36 @@ public:
 	void SetCharClasses(const unsigned char *chars, CharClassify::cc newCharClass);
 	int GetCharsOfClass(CharClassify::cc charClass, unsigned char *buffer);
 	void SetStylingBits(int bits);
-	void SCI_METHOD StartStyling(int position, char mask);
-	bool SCI_METHOD SetStyleFor(int length, char style);
-	bool SCI_METHOD SetStyles(int length, const char *styles);
+	void SCI_METHOD StartStyling(Sci_Position position, char mask);
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style);
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles);
 	int GetEndStyled() { return endStyled; }
+	void BeginStyleBatch();
+	void EndStyleBatch();
+	void StyleChanged(int start, int end);
+	void LexStarting(int start, int end);
+	void LexFinished();
+	void StylesInvalidFrom(int pos);
+	void ClearCheckpointsBefore(int line);
 	void EnsureStyledTo(int pos);
+	void StyleToAdjustingLineDuration(int pos);
 	void LexerChanged();
 	int GetStyleClock() { return styleClock; }
 	void IncrementStyleClock();
+	int GetTextClock() const { return textClock; }
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) {
 		decorations.SetCurrentIndicator(indicator);
 	}
-	void SCI_METHOD DecorationFillRange(int position, int value, int fillLength);
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength);
+	void DecorationFillRanges(const int *starts, const int *ends, int count, int value);
 
 	int SCI_METHOD SetLineState(int line, int state);
 	int SCI_METHOD GetLineState(int line) const;
 	int GetMaxLineState();
-	void SCI_METHOD ChangeLexerState(int start, int end);
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end);
+	void SCI_METHOD SetLineCheckpoint(int line, const char *state, int length);
+	int SCI_METHOD GetLineCheckpoint(int line, char *state, int length) const;
+	bool SCI_METHOD StylesConverged(int line, Sci_Position position);
 
 	StyledText MarginStyledText(int line);
 	void MarginSetStyle(int line, int style);
@@ -435,6 +516,11 @@ private:
 	void NotifyModifyAttempt();
 	void NotifySavePoint(bool atSavePoint);
 	void NotifyModified(DocModification mh);
+	void NotifyWatchers(const DocModification &mh);
+	void NotifyReplaced(int modFlags, int modFlagsLast, int position,
+		const std::string &textOld, const std::string &textNew, int linesRemoved, int linesInserted,
+		const ReplacedRange *ranges, int count);
+	int ReplaceStep(const Action &action, bool undo, int modFlags, bool lastStep, bool &multiLine);
 };
 
 class UndoGroup {
@@ -24,6 +24,7 @@
 
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "RunStyles.h"
 #include "ContractionState.h"
 #include "CellBuffer.h"
@@ -99,7 +100,7 @@ static inline bool IsAllSpacesOrTabs(char *s, unsigned int len) {
 	return true;
 }
 
-Editor::Editor() {
+Editor::Editor() : posCache(PositionCache::Shared()), durationWrapOneLine(0.00001, 0.000001, 0.0001) {
 	ctrlID = 0;
 
 	stylesValid = false;
@@ -198,6 +199,14 @@ Editor::Editor() {
 
 	paintState = notPainting;
 	willRedrawAll = false;
+	idleStyling = SC_IDLESTYLING_NONE;
+	needIdleStyling = false;
+	matchFlags = 0;
+	matchSearchEnd = 0;
+	idleFillFlags = 0;
+	idleFillIndicator = 0;
+	idleFillValue = 0;
+	idleFillStyle = -1;
 
 	modEventMask = SC_MODEVENTMASKALL;
 
@@ -227,7 +236,6 @@ Editor::Editor() {
 	hsEnd = -1;
 
 	llc.SetLevel(LineLayoutCache::llcCaret);
-	posCache.SetSize(0x400);
 }
 
 Editor::~Editor() {
@@ -243,6 +251,7 @@ void Editor::Finalise() {
 }
 
 void Editor::DropGraphics(bool freeObjects) {
+	lineImages.Release();
 	if (freeObjects) {
 		delete pixmapLine;
 		pixmapLine = 0;
@@ -287,7 +296,6 @@ void Editor::InvalidateStyleData() {
 	DropGraphics(false);
 	AllocateGraphics();
 	llc.Invalidate(LineLayout::llInvalid);
-	posCache.Clear();
 }
 
 void Editor::InvalidateStyleRedraw() {
@@ -350,6 +358,19 @@ int Editor::MaxScrollPos() {
 	}
 }
 
+/**
+ * While idle wrapping is incomplete, the lines still to be wrapped are counted at the average
+ * height of the lines already wrapped so the scroll range does not keep growing as wrapping proceeds.
+ */
+int Editor::LinesPendingWrapEstimate() {
+	if ((wrapState == eWrapNone) || (wrapStart <= 0) || (wrapStart >= wrapEnd))
+		return 0;
+	const double extraPerLine = static_cast<double>(cs.DisplayFromDoc(wrapStart) - wrapStart) / wrapStart;
+	if (extraPerLine <= 0.0)
+		return 0;
+	return static_cast<int>(extraPerLine * (Platform::Minimum(wrapEnd, pdoc->LinesTotal()) - wrapStart));
+}
+
 const char *ControlCharacterString(unsigned char ch) {
 	const char *reps[] = {
 		"NUL", "SOH", "STX", "ETX", "EOT", "ENQ", "ACK", "BEL",
@@ -621,11 +642,22 @@ void Editor::RedrawRect(PRectangle rc) {
 
 void Editor::Redraw() {
 	//Platform::DebugPrintf("Redraw all\n");
+	// Any setting may have changed so retained line images can not be trusted
+	lineImages.Invalidate();
 	PRectangle rcClient = GetClientRectangle();
 	wMain.InvalidateRectangle(rcClient);
 	//wMain.InvalidateAll();
 }
 
+/**
+ * Redraw everything after a change to the document or scroll position.
+ * Retained line images remain valid as their keys include everything these can change.
+ */
+void Editor::RedrawRetained() {
+	PRectangle rcClient = GetClientRectangle();
+	wMain.InvalidateRectangle(rcClient);
+}
+
 void Editor::RedrawSelMargin(int line, bool allAfter) {
 	if (!AbandonPaint()) {
 		if (vs.maskInLine) {
@@ -993,13 +1025,13 @@ void Editor::ScrollTo(int line, bool moveThumb) {
 		SetTopLine(topLineNew);
 		// Optimize by styling the view as this will invalidate any needed area
 		// which could abort the initial paint if discovered later.
-		StyleToPositionInView(PositionAfterArea(GetClientRectangle()));
+		StyleAreaBounded(GetClientRectangle(), true);
 #ifndef UNDER_CE
 		// Perform redraw rather than scroll if many lines would be redrawn anyway.
 		if (performBlit) {
 			ScrollText(linesToMove);
 		} else {
-			Redraw();
+			RedrawRetained();
 		}
 		willRedrawAll = false;
 #else
@@ -1013,7 +1045,7 @@ void Editor::ScrollTo(int line, bool moveThumb) {
 
 void Editor::ScrollText(int /* linesToMove */) {
 	//Platform::DebugPrintf("Editor::ScrollText %d\n", linesToMove);
-	Redraw();
+	RedrawRetained();
 }
 
 void Editor::HorizontalScrollTo(int xPos) {
@@ -1501,6 +1533,11 @@ bool Editor::WrapOneLine(Surface *surface, int lineToWrap) {
 bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 	// If there are any pending wraps, do them during idle if possible.
 	int linesInOneCall = LinesOnScreen() + 100;
+	// Idle wrapping does as many lines as fit in the time allowed so that it completes
+	// quickly even when idle calls are infrequent, as with the timer used on Windows.
+	const double secondsAllowed = 0.05;
+	const int linesInAllowedTime = Platform::Clamp(
+		durationWrapOneLine.ActionsInAllowedTime(secondsAllowed), linesInOneCall, 0x10000);
 	if (priorityWrapLineStart >= 0) {
 		// Using DocFromDisplay() here may result in chicken and egg problem in certain corner cases,
 		// which will hopefully be handled by added 100 lines. If some lines are still missed, idle wrapping will catch on.
@@ -1524,6 +1561,7 @@ bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 	}
 	int goodTopLine = topLine;
 	bool wrapOccurred = false;
+	bool wrapCompleted = false;
 	if (wrapStart <= pdoc->LinesTotal()) {
 		if (wrapState == eWrapNone) {
 			if (wrapWidth != LineLayout::wrapWidthInfinite) {
@@ -1560,7 +1598,7 @@ bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 						priorityWrap = true;
 					} else {
 						// This is idle wrap.
-						lastLineToWrap = wrapStart + linesInOneCall;
+						lastLineToWrap = wrapStart + linesInAllowedTime;
 					}
 					if (lastLineToWrap >= wrapEnd)
 						lastLineToWrap = wrapEnd;
@@ -1571,19 +1609,25 @@ bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 
 				// Platform::DebugPrintf("Wraplines: full = %d, priorityStart = %d (wrapping: %d to %d)\n", fullWrap, priorityWrapLineStart, lineToWrap, lastLineToWrap);
 				// Platform::DebugPrintf("Pending wraps: %d to %d\n", wrapStart, wrapEnd);
+				ElapsedTime et;
+				const int lineFirstWrapped = lineToWrap;
 				while (lineToWrap < lastLineToWrap) {
 					if (WrapOneLine(surface, lineToWrap)) {
 						wrapOccurred = true;
 					}
 					lineToWrap++;
 				}
+				durationWrapOneLine.AddSample(lineToWrap - lineFirstWrapped, et.Duration());
 				if (!priorityWrap)
 					wrapStart = lineToWrap;
 				// If wrapping is done, bring it to resting position
 				if (wrapStart >= wrapEnd) {
 					wrapStart = wrapLineLarge;
 					wrapEnd = wrapLineLarge;
+					wrapCompleted = true;
 				}
+				if (!fullWrap && !priorityWrap)
+					NotifyWrapProgress((wrapStart == wrapLineLarge) ? pdoc->LinesTotal() : wrapStart);
 			}
 			goodTopLine = cs.DisplayFromDoc(lineDocTop);
 			if (subLineTop < cs.GetHeight(lineDocTop))
@@ -1598,10 +1642,20 @@ bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 		SetScrollBars();
 		SetTopLine(Platform::Clamp(goodTopLine, 0, MaxScrollPos()));
 		SetVerticalScrollPos();
+	} else if (wrapCompleted) {
+		// Replace the estimated scroll range with the wrapped one
+		SetScrollBars();
 	}
 	return wrapOccurred;
 }
 
+void Editor::NotifyWrapProgress(int line) {
+	SCNotification scn = {0};
+	scn.nmhdr.code = SCN_WRAPPROGRESS;
+	scn.line = line;
+	NotifyParent(scn);
+}
+
 void Editor::LinesJoin() {
 	if (!RangeContainsProtected(targetStart, targetEnd)) {
 		UndoGroup ug(pdoc);
@@ -3443,6 +3497,108 @@ void Editor::DrawCarets(Surface *surface, ViewStyle &vsDraw, int lineDoc, int xS
 	}
 }
 
+static void AppendToKey(std::string &key, int value) {
+	key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Positions are recorded relative to the line and limited to just outside it so that
+// identical lines at different places in the document share a key.
+static int LinePositionForKey(int position, int posLineStart, int posLineEnd) {
+	if (position < posLineStart)
+		return -1;
+	if (position > posLineEnd)
+		return posLineEnd - posLineStart + 1;
+	return position - posLineStart;
+}
+
+/**
+ * Describe the state that determines how a line is drawn so that a retained image can be
+ * reused when the description matches. Settings are not included since changing them calls
+ * Redraw which invalidates all the images. The text, styles and indicators of the line are
+ * represented by its stamp which changes whenever they do.
+ * Returns false if the line can not be retained.
+ */
+bool Editor::LineImageKey(std::string &key, int lineDoc, int lineVisible, int subLine,
+	LineLayout *ll, int xStart, PRectangle rcLine) {
+	if ((vs.viewIndentationGuides == ivLookForward || vs.viewIndentationGuides == ivLookBoth) &&
+		(subLine == 0) && pdoc->IsWhiteLine(lineDoc)) {
+		// Indentation guides on blank lines depend on the surrounding lines
+		return false;
+	}
+	const int stamp = lineImages.LineStamp(lineDoc);
+	if (stamp == 0)
+		return false;
+	const int posLineStart = pdoc->LineStart(lineDoc);
+	const int posLineEnd = pdoc->LineStart(lineDoc + 1);
+
+	key.clear();
+	AppendToKey(key, stamp);
+	AppendToKey(key, subLine);
+	AppendToKey(key, lineVisible & 1);
+	AppendToKey(key, xStart);
+	AppendToKey(key, rcLine.right);
+
+	// Layout
+	AppendToKey(key, ll->lines);
+	AppendToKey(key, ll->LineStart(subLine));
+	AppendToKey(key, ll->LineStart(subLine + 1));
+	AppendToKey(key, static_cast<int>(ll->wrapIndent));
+	AppendToKey(key, ll->xHighlightGuide);
+	AppendToKey(key, ll->highlightColumn);
+	AppendToKey(key, ll->containsCaret);
+	AppendToKey(key, (ll->hsStart == -1) ? -2 : LinePositionForKey(ll->hsStart, posLineStart, posLineEnd));
+	AppendToKey(key, (ll->hsStart == -1) ? -2 : LinePositionForKey(ll->hsEnd, posLineStart, posLineEnd));
+	AppendToKey(key, LinePositionForKey(braces[0], posLineStart, posLineEnd));
+	AppendToKey(key, LinePositionForKey(braces[1], posLineStart, posLineEnd));
+	AppendToKey(key, bracesMatchStyle);
+
+	// Markers, folding and indicators
+	AppendToKey(key, pdoc->GetMark(lineDoc));
+	AppendToKey(key, pdoc->GetLevel(lineDoc));
+	AppendToKey(key, pdoc->GetLevel(lineDoc + 1));
+	AppendToKey(key, cs.GetExpanded(lineDoc));
+
+	// Selection and carets. Caret state is only added for lines that show a caret or
+	// the caret line background so other lines keep their images as the caret blinks.
+	AppendToKey(key, hideSelection);
+	AppendToKey(key, hasFocus);
+	AppendToKey(key, primarySelection);
+	AppendToKey(key, sel.selType);
+	if (ll->containsCaret)
+		AppendToKey(key, caret.active);
+	for (size_t r=0; r<sel.Count(); r++) {
+		const SelectionRange &range = sel.Range(r);
+		if ((range.End().Position() >= posLineStart) && (range.Start().Position() <= posLineEnd)) {
+			AppendToKey(key, r == sel.Main());
+			AppendToKey(key, LinePositionForKey(range.caret.Position(), posLineStart, posLineEnd));
+			AppendToKey(key, range.caret.VirtualSpace());
+			AppendToKey(key, LinePositionForKey(range.anchor.Position(), posLineStart, posLineEnd));
+			AppendToKey(key, range.anchor.VirtualSpace());
+			if ((range.caret.Position() >= posLineStart) && (range.caret.Position() <= posLineEnd)) {
+				AppendToKey(key, caret.active);
+				AppendToKey(key, caret.on);
+				AppendToKey(key, inOverstrike);
+			}
+		}
+	}
+	if (posDrag.IsValid()) {
+		AppendToKey(key, LinePositionForKey(posDrag.Position(), posLineStart, posLineEnd));
+		AppendToKey(key, posDrag.VirtualSpace());
+	}
+
+	// Annotation lines follow the text
+	if (subLine >= ll->lines) {
+		StyledText stAnnotation = pdoc->AnnotationStyledText(lineDoc);
+		AppendToKey(key, static_cast<int>(stAnnotation.length));
+		if (stAnnotation.text)
+			key.append(stAnnotation.text, stAnnotation.length);
+		AppendToKey(key, static_cast<int>(stAnnotation.style));
+		if (stAnnotation.multipleStyles && stAnnotation.styles)
+			key.append(reinterpret_cast<const char *>(stAnnotation.styles), stAnnotation.length);
+	}
+	return true;
+}
+
 void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	//Platform::DebugPrintf("Paint:%1d (%3d,%3d) ... (%3d,%3d)\n",
 	//	paintingAllText, rcArea.left, rcArea.top, rcArea.right, rcArea.bottom);
@@ -3453,7 +3609,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 		return;	// Scroll bars may have changed so need redraw
 	RefreshPixMaps(surfaceWindow);
 
-	StyleToPositionInView(PositionAfterArea(rcArea));
+	StyleAreaBounded(rcArea, false);
 
 	PRectangle rcClient = GetClientRectangle();
 	//Platform::DebugPrintf("Client: (%3d,%3d) ... (%3d,%3d)   %d\n",
@@ -3561,6 +3717,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 		//ElapsedTime etWhole;
 		int lineDocPrevious = -1;	// Used to avoid laying out one document line multiple times
 		AutoLineLayout ll(llc, 0);
+		std::string lineImageKey;
 		while (visibleLine < cs.LinesDisplayed() && yposScreen < rcArea.bottom) {
 
 			int lineDoc = cs.DocFromDisplay(visibleLine);
@@ -3602,50 +3759,76 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 				ll->SetBracesHighlight(rangeLine, braces, static_cast<char>(bracesMatchStyle),
 				        highlightGuideColumn * vs.spaceWidth, bracesIgnoreStyle);
 
-				if (leftTextOverlap && bufferedDraw) {
-					PRectangle rcSpacer = rcLine;
-					rcSpacer.right = rcSpacer.left;
-					rcSpacer.left -= 1;
-					surface->FillRectangle(rcSpacer, vs.styles[STYLE_DEFAULT].back);
+				// Copy a retained image of the line if one matches, otherwise draw into a new image
+				Surface *surfaceLine = surface;
+				bool imageCurrent = false;
+				if (bufferedDraw && lineImages.GetSize() &&
+					LineImageKey(lineImageKey, lineDoc, visibleLine, subLine, ll, xStart, rcLine)) {
+					Surface *surfaceImage = lineImages.Find(lineImageKey);
+					if (surfaceImage) {
+						imageCurrent = true;
+					} else {
+						surfaceImage = lineImages.Allocate(lineImageKey, technology);
+						if (surfaceImage && !surfaceImage->Initialised()) {
+							surfaceImage->InitPixMap(rcClient.Width(), vs.lineHeight,
+							        surfaceWindow, wMain.GetID());
+						}
+					}
+					if (surfaceImage && surfaceImage->Initialised()) {
+						surfaceLine = surfaceImage;
+						surfaceLine->SetUnicodeMode(IsUnicodeMode());
+						surfaceLine->SetDBCSMode(CodePage());
+					} else {
+						imageCurrent = false;
+					}
 				}
 
-				// Draw the line
-				DrawLine(surface, vs, lineDoc, visibleLine, xStart, rcLine, ll, subLine);
-				//durPaint += et.Duration(true);
-
-				// Restore the previous styles for the brace highlights in case layout is in cache.
-				ll->RestoreBracesHighlight(rangeLine, braces, bracesIgnoreStyle);
-
-				bool expanded = cs.GetExpanded(lineDoc);
-				const int level = pdoc->GetLevel(lineDoc);
-				const int levelNext = pdoc->GetLevel(lineDoc + 1);
-				if ((level & SC_FOLDLEVELHEADERFLAG) &&
-					((level & SC_FOLDLEVELNUMBERMASK) < (levelNext & SC_FOLDLEVELNUMBERMASK))) {
-					// Paint the line above the fold
-					if ((expanded && (foldFlags & SC_FOLDFLAG_LINEBEFORE_EXPANDED))
-						||
-						(!expanded && (foldFlags & SC_FOLDFLAG_LINEBEFORE_CONTRACTED))) {
-						PRectangle rcFoldLine = rcLine;
-						rcFoldLine.bottom = rcFoldLine.top + 1;
-						surface->FillRectangle(rcFoldLine, vs.styles[STYLE_DEFAULT].fore);
+				if (!imageCurrent) {
+					if (leftTextOverlap && bufferedDraw) {
+						PRectangle rcSpacer = rcLine;
+						rcSpacer.right = rcSpacer.left;
+						rcSpacer.left -= 1;
+						surfaceLine->FillRectangle(rcSpacer, vs.styles[STYLE_DEFAULT].back);
 					}
-					// Paint the line below the fold
-					if ((expanded && (foldFlags & SC_FOLDFLAG_LINEAFTER_EXPANDED))
-						||
-						(!expanded && (foldFlags & SC_FOLDFLAG_LINEAFTER_CONTRACTED))) {
-						PRectangle rcFoldLine = rcLine;
-						rcFoldLine.top = rcFoldLine.bottom - 1;
-						surface->FillRectangle(rcFoldLine, vs.styles[STYLE_DEFAULT].fore);
+
+					// Draw the line
+					DrawLine(surfaceLine, vs, lineDoc, visibleLine, xStart, rcLine, ll, subLine);
+					//durPaint += et.Duration(true);
+
+					bool expanded = cs.GetExpanded(lineDoc);
+					const int level = pdoc->GetLevel(lineDoc);
+					const int levelNext = pdoc->GetLevel(lineDoc + 1);
+					if ((level & SC_FOLDLEVELHEADERFLAG) &&
+						((level & SC_FOLDLEVELNUMBERMASK) < (levelNext & SC_FOLDLEVELNUMBERMASK))) {
+						// Paint the line above the fold
+						if ((expanded && (foldFlags & SC_FOLDFLAG_LINEBEFORE_EXPANDED))
+							||
+							(!expanded && (foldFlags & SC_FOLDFLAG_LINEBEFORE_CONTRACTED))) {
+							PRectangle rcFoldLine = rcLine;
+							rcFoldLine.bottom = rcFoldLine.top + 1;
+							surfaceLine->FillRectangle(rcFoldLine, vs.styles[STYLE_DEFAULT].fore);
+						}
+						// Paint the line below the fold
+						if ((expanded && (foldFlags & SC_FOLDFLAG_LINEAFTER_EXPANDED))
+							||
+							(!expanded && (foldFlags & SC_FOLDFLAG_LINEAFTER_CONTRACTED))) {
+							PRectangle rcFoldLine = rcLine;
+							rcFoldLine.top = rcFoldLine.bottom - 1;
+							surfaceLine->FillRectangle(rcFoldLine, vs.styles[STYLE_DEFAULT].fore);
+						}
 					}
+
+					DrawCarets(surfaceLine, vs, lineDoc, xStart, rcLine, ll, subLine);
 				}
 
-				DrawCarets(surface, vs, lineDoc, xStart, rcLine, ll, subLine);
+				// Restore the previous styles for the brace highlights in case layout is in cache.
+				ll->RestoreBracesHighlight(rangeLine, braces, bracesIgnoreStyle);
 
 				if (bufferedDraw) {
 					Point from(vs.fixedColumnWidth-leftTextOverlap, 0);
 					PRectangle rcCopyArea(vs.fixedColumnWidth-leftTextOverlap, yposScreen,
 					        rcClient.right - vs.rightMarginWidth, yposScreen + vs.lineHeight);
-					surfaceWindow->Copy(rcCopyArea, from, *pixmapLine);
+					surfaceWindow->Copy(rcCopyArea, from, *surfaceLine);
 				}
 
 				lineWidthMaxSeen = Platform::Maximum(
@@ -3914,7 +4097,7 @@ void Editor::ReconfigureScrollBars() {}
 void Editor::SetScrollBars() {
 	RefreshStyleData();
 
-	int nMax = MaxScrollPos();
+	int nMax = MaxScrollPos() + LinesPendingWrapEstimate();
 	int nPage = LinesOnScreen();
 	bool modified = ModifyScrollBars(nMax + nPage - 1, nPage);
 	if (modified) {
@@ -4569,6 +4752,10 @@ static inline int MovePositionForDeletion(int position, int startDeletion, int l
 
 void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	ContainerNeedsUpdate(SC_UPDATE_CONTENT);
+	if (mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) {
+		// Positions still to be searched are no longer valid
+		StopIdleFill();
+	}
 	if (paintState == painting) {
 		CheckForChangeOutsidePaint(Range(mh.position, mh.position + mh.length));
 	}
@@ -4578,7 +4765,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			    Range(pdoc->LineStart(mh.line), pdoc->LineStart(mh.line + 1)));
 		} else {
 			// Could check that change is before last visible line.
-			Redraw();
+			RedrawRetained();
 		}
 	}
 	if (mh.modificationType & SC_MOD_LEXERSTATE) {
@@ -4586,7 +4773,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			CheckForChangeOutsidePaint(
 			    Range(mh.position, mh.position + mh.length));
 		} else {
-			Redraw();
+			RedrawRetained();
 		}
 	}
 	if (mh.modificationType & (SC_MOD_CHANGESTYLE | SC_MOD_CHANGEINDICATOR)) {
@@ -4596,7 +4783,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		if (paintState == notPainting) {
 			if (mh.position < pdoc->LineStart(topLine)) {
 				// Styling performed before this view
-				Redraw();
+				RedrawRetained();
 			} else {
 				InvalidateRange(mh.position, mh.position + mh.length);
 			}
@@ -4604,6 +4791,10 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		if (mh.modificationType & SC_MOD_CHANGESTYLE) {
 			llc.Invalidate(LineLayout::llCheckTextAndStyle);
 		}
+		if (lineImages.GetSize()) {
+			lineImages.LinesChanged(pdoc->LineFromPosition(mh.position),
+				pdoc->LineFromPosition(mh.position + mh.length));
+		}
 	} else {
 		// Move selection and brace highlights
 		if (mh.modificationType & SC_MOD_INSERTTEXT) {
@@ -4639,15 +4830,21 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			int lineOfPos = pdoc->LineFromPosition(mh.position);
 			if (mh.linesAdded > 0) {
 				cs.InsertLines(lineOfPos, mh.linesAdded);
+				lineImages.InsertLines(lineOfPos + 1, mh.linesAdded);
 			} else {
 				cs.DeleteLines(lineOfPos, -mh.linesAdded);
+				lineImages.DeleteLines(lineOfPos + 1, -mh.linesAdded);
 			}
 		}
+		if ((mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) && lineImages.GetSize()) {
+			const int lineOfPos = pdoc->LineFromPosition(mh.position);
+			lineImages.LinesChanged(lineOfPos, lineOfPos);
+		}
 		if (mh.modificationType & SC_MOD_CHANGEANNOTATION) {
 			int lineDoc = pdoc->LineFromPosition(mh.position);
 			if (vs.annotationVisible) {
 				cs.SetHeight(lineDoc, cs.GetHeight(lineDoc) + mh.annotationLinesAdded);
-				Redraw();
+				RedrawRetained();
 			}
 		}
 		CheckModificationForWrap(mh);
@@ -4666,7 +4863,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			//InvalidateRange(mh.position, mh.position + mh.length);
 			if (paintState == notPainting && !CanDeferToLastStep(mh)) {
 				QueueStyling(pdoc->Length());
-				Redraw();
+				RedrawRetained();
 			}
 		} else {
 			//Platform::DebugPrintf("** %x Line Changed %d .. %d\n", this,
@@ -4696,7 +4893,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	// NOW pay the piper WRT "deferred" visual updates
 	if (IsLastStep(mh)) {
 		SetScrollBars();
-		Redraw();
+		RedrawRetained();
 	}
 
 	// If client wants to see this modification
@@ -5765,7 +5962,7 @@ CaseFolder *Editor::CaseFolderForEncoding() {
  * Search of a text in the document, in the given range.
  * @return The position of the found text, -1 if not found.
  */
-long Editor::FindText(
+sptr_t Editor::FindText(
     uptr_t wParam,		///< Search modes : @c SCFIND_MATCHCASE, @c SCFIND_WHOLEWORD,
     ///< @c SCFIND_WORDSTART, @c SCFIND_REGEXP or @c SCFIND_POSIX.
     sptr_t lParam) {	///< @c TextToFind structure: The text to search for in the given range.
@@ -5774,7 +5971,7 @@ long Editor::FindText(
 	int lengthFound = istrlen(ft->lpstrText);
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
-	int pos = pdoc->FindText(ft->chrg.cpMin, ft->chrg.cpMax, ft->lpstrText,
+	Sci_Position pos = pdoc->FindText(ft->chrg.cpMin, ft->chrg.cpMax, ft->lpstrText,
 	        (wParam & SCFIND_MATCHCASE) != 0,
 	        (wParam & SCFIND_WHOLEWORD) != 0,
 	        (wParam & SCFIND_WORDSTART) != 0,
@@ -5808,14 +6005,14 @@ void Editor::SearchAnchor() {
  * Used for next text and previous text requests.
  * @return The position of the found text, -1 if not found.
  */
-long Editor::SearchText(
+sptr_t Editor::SearchText(
     unsigned int iMessage,		///< Accepts both @c SCI_SEARCHNEXT and @c SCI_SEARCHPREV.
     uptr_t wParam,				///< Search modes : @c SCFIND_MATCHCASE, @c SCFIND_WHOLEWORD,
     ///< @c SCFIND_WORDSTART, @c SCFIND_REGEXP or @c SCFIND_POSIX.
     sptr_t lParam) {			///< The text to search for.
 
 	const char *txt = reinterpret_cast<char *>(lParam);
-	int pos;
+	Sci_Position pos;
 	int lengthFound = istrlen(txt);
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
@@ -5864,12 +6061,12 @@ std::string Editor::CaseMapString(const std::string &s, int caseMapping) {
  * Search for text in the target range of the document.
  * @return The position of the found text, -1 if not found.
  */
-long Editor::SearchInTarget(const char *text, int length) {
+sptr_t Editor::SearchInTarget(const char *text, int length) {
 	int lengthFound = length;
 
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
-	int pos = pdoc->FindText(targetStart, targetEnd, text,
+	Sci_Position pos = pdoc->FindText(targetStart, targetEnd, text,
 	        (searchFlags & SCFIND_MATCHCASE) != 0,
 	        (searchFlags & SCFIND_WHOLEWORD) != 0,
 	        (searchFlags & SCFIND_WORDSTART) != 0,
@@ -5883,6 +6080,198 @@ long Editor::SearchInTarget(const char *text, int length) {
 	return pos;
 }
 
+/**
+ * Append the start and end of every occurrence of text between start and end.
+ */
+void Editor::FindAllInRange(int start, int end, const char *text, int length, int flags,
+	std::vector<int> &starts, std::vector<int> &ends) {
+	if (!pdoc->HasCaseFolder())
+		pdoc->SetCaseFolder(CaseFolderForEncoding());
+	while (start <= end) {
+		int lengthFound = length;
+		const Sci_Position pos = pdoc->FindText(start, end, text,
+		        (flags & SCFIND_MATCHCASE) != 0,
+		        (flags & SCFIND_WHOLEWORD) != 0,
+		        (flags & SCFIND_WORDSTART) != 0,
+		        (flags & SCFIND_REGEXP) != 0,
+		        flags,
+		        &lengthFound);
+		if (pos < 0)
+			break;
+		starts.push_back(pos);
+		ends.push_back(pos + lengthFound);
+		if (lengthFound > 0) {
+			start = pos + lengthFound;
+		} else {
+			// Step over empty matches so the search always progresses, treating a line end
+			// as one character so an empty match at the end of a line is only found once
+			if (pos >= end)
+				break;
+			start = pdoc->MovePositionOutsideChar(pos + 1, 1, true);
+		}
+	}
+}
+
+/**
+ * Search for every occurrence of text in the target range of the document.
+ * The matches are retrieved with SCI_GETMATCHSTART and SCI_GETMATCHEND.
+ * @return The number of matches found.
+ */
+int Editor::SearchAllInTarget(const char *text, int length) {
+	matchStarts.clear();
+	matchEnds.clear();
+	matchText.assign(text, length);
+	matchFlags = searchFlags;
+	matchSearchEnd = Platform::Maximum(targetStart, targetEnd);
+	FindAllInRange(Platform::Minimum(targetStart, targetEnd), matchSearchEnd,
+		text, length, searchFlags, matchStarts, matchEnds);
+	return static_cast<int>(matchStarts.size());
+}
+
+/**
+ * Replace the matches found by SCI_SEARCHALLINTARGET with text in a single pass.
+ * With patterns, a match that is not found again where it was is left unchanged.
+ * The matches are then the replacements and the target covers them all.
+ * @return The number of matches replaced.
+ */
+int Editor::ReplaceMatches(bool replacePatterns, const char *text, int length) {
+	if (length == -1)
+		length = istrlen(text);
+	std::vector<int> replaceStarts;
+	std::vector<int> replaceEnds;
+	std::string replacements;
+	std::vector<int> replacementEnds;
+	for (size_t i = 0; i < matchStarts.size(); i++) {
+		if (replacePatterns) {
+			// Search again from the match so its groups can be substituted
+			int lengthFound = static_cast<int>(matchText.length());
+			const Sci_Position pos = pdoc->FindText(matchStarts[i], matchSearchEnd, matchText.c_str(),
+			        (matchFlags & SCFIND_MATCHCASE) != 0,
+			        (matchFlags & SCFIND_WHOLEWORD) != 0,
+			        (matchFlags & SCFIND_WORDSTART) != 0,
+			        (matchFlags & SCFIND_REGEXP) != 0,
+			        matchFlags,
+			        &lengthFound);
+			if ((pos != matchStarts[i]) || (pos + lengthFound != matchEnds[i]))
+				continue;
+			int lengthSubstituted = length;
+			const char *substituted = pdoc->SubstituteByPosition(text, &lengthSubstituted);
+			if (!substituted)
+				continue;
+			replacements.append(substituted, lengthSubstituted);
+		} else {
+			replacements.append(text, length);
+		}
+		replaceStarts.push_back(matchStarts[i]);
+		replaceEnds.push_back(matchEnds[i]);
+		replacementEnds.push_back(static_cast<int>(replacements.length()));
+	}
+	const int replaced = pdoc->ReplaceRanges(replaceStarts, replaceEnds, replacements, replacementEnds);
+	replaceStarts.resize(replaced);
+	replaceEnds.resize(replaced);
+	matchStarts.swap(replaceStarts);
+	matchEnds.swap(replaceEnds);
+	if (replaced > 0) {
+		targetStart = matchStarts.front();
+		targetEnd = matchEnds.back();
+	}
+	return replaced;
+}
+
+/**
+ * Fill the current indicator with its current value over matches in one operation.
+ * When style is not -1 only the matches that start in that style are filled.
+ * @return The number of matches filled.
+ */
+int Editor::FillMatches(const std::vector<int> &starts, const std::vector<int> &ends, int style) {
+	if (starts.empty())
+		return 0;
+	const int value = pdoc->decorations.GetCurrentValue();
+	if (style == -1) {
+		pdoc->DecorationFillRanges(&starts[0], &ends[0], static_cast<int>(starts.size()), value);
+		return static_cast<int>(starts.size());
+	}
+	pdoc->EnsureStyledTo(ends.back());
+	std::vector<int> fillStarts;
+	std::vector<int> fillEnds;
+	for (size_t i = 0; i < starts.size(); i++) {
+		if (static_cast<unsigned char>(pdoc->StyleAt(starts[i])) == style) {
+			fillStarts.push_back(starts[i]);
+			fillEnds.push_back(ends[i]);
+		}
+	}
+	if (!fillStarts.empty())
+		pdoc->DecorationFillRanges(&fillStarts[0], &fillEnds[0], static_cast<int>(fillStarts.size()), value);
+	return static_cast<int>(fillStarts.size());
+}
+
+/**
+ * Fill the current indicator over every occurrence of text in the target.
+ * The visible lines are filled now and the rest of the target in idle time
+ * so large documents remain responsive. The ranges are split at line starts.
+ */
+void Editor::IndicatorFillAllInTarget(int style, const char *text) {
+	StopIdleFill();
+	if (!*text)
+		return;
+	idleFillText = text;
+	idleFillFlags = searchFlags;
+	idleFillIndicator = pdoc->decorations.GetCurrentIndicator();
+	idleFillValue = pdoc->decorations.GetCurrentValue();
+	idleFillStyle = style;
+	const int start = Platform::Minimum(targetStart, targetEnd);
+	const int end = Platform::Maximum(targetStart, targetEnd);
+	const int visibleStart = Platform::Clamp(pdoc->LineStart(cs.DocFromDisplay(topLine)), start, end);
+	const int visibleEnd = Platform::Clamp(PositionAfterArea(GetClientRectangle()), visibleStart, end);
+	FillFoundInRange(visibleStart, visibleEnd);
+	if (visibleEnd < end)
+		idleFillRanges.push_back(Range(visibleEnd, end));
+	if (start < visibleStart)
+		idleFillRanges.push_back(Range(start, visibleStart));
+	if (!idleFillRanges.empty() && !SetIdle(true)) {
+		// No idle time on this platform so fill everything now
+		for (size_t i = 0; i < idleFillRanges.size(); i++)
+			FillFoundInRange(idleFillRanges[i].start, idleFillRanges[i].end);
+		StopIdleFill();
+	}
+}
+
+void Editor::FillFoundInRange(int start, int end) {
+	std::vector<int> starts;
+	std::vector<int> ends;
+	FindAllInRange(start, end, idleFillText.c_str(), static_cast<int>(idleFillText.length()),
+		idleFillFlags, starts, ends);
+	const int indicatorCurrent = pdoc->decorations.GetCurrentIndicator();
+	const int valueCurrent = pdoc->decorations.GetCurrentValue();
+	pdoc->decorations.SetCurrentIndicator(idleFillIndicator);
+	pdoc->decorations.SetCurrentValue(idleFillValue);
+	FillMatches(starts, ends, idleFillStyle);
+	pdoc->decorations.SetCurrentIndicator(indicatorCurrent);
+	pdoc->decorations.SetCurrentValue(valueCurrent);
+}
+
+// Called from Idle to fill the matches in the next few blocks of lines.
+void Editor::IdleFillRange() {
+	// Filling in idle time is not a change the container has to react to
+	const int needUpdateUIBefore = needUpdateUI;
+	ElapsedTime et;
+	while (!idleFillRanges.empty() && (et.Duration() < 0.01)) {
+		Range &range = idleFillRanges.front();
+		const int blockEnd = Platform::Minimum(
+			pdoc->LineStart(pdoc->LineFromPosition(range.start + 0x10000) + 1), range.end);
+		FillFoundInRange(range.start, blockEnd);
+		if (blockEnd >= range.end)
+			idleFillRanges.erase(idleFillRanges.begin());
+		else
+			range.start = blockEnd;
+	}
+	needUpdateUI = needUpdateUIBefore;
+}
+
+void Editor::StopIdleFill() {
+	idleFillRanges.clear();
+}
+
 void Editor::GoToLine(int lineNo) {
 	if (lineNo > pdoc->LinesTotal())
 		lineNo = pdoc->LinesTotal();
@@ -6694,12 +7083,20 @@ bool Editor::Idle() {
 			wrappingDone = true;
 	}
 
+	if (needIdleStyling) {
+		IdleStyleRange();
+	}
+
+	if (!idleFillRanges.empty()) {
+		IdleFillRange();
+	}
+
 	// Add more idle things to do here, but make sure idleDone is
 	// set correctly before the function returns. returning
 	// false will stop calling this idle funtion until SetIdle() is
 	// called again.
 
-	idleDone = wrappingDone; // && thatDone && theOtherThingDone...
+	idleDone = wrappingDone && !needIdleStyling && idleFillRanges.empty(); // && thatDone && theOtherThingDone...
 
 	return !idleDone;
 }
@@ -6741,6 +7138,63 @@ void Editor::StyleToPositionInView(Position pos) {
 	}
 }
 
+// The end position to style to in the time allowed. Styling a large document from the
+// start when the view is far down would otherwise make the application unresponsive.
+int Editor::PositionAfterMaxStyling(int posMax, bool scrolling) const {
+	// Less time is allowed when scrolling to remain responsive
+	const double secondsAllowed = scrolling ? 0.005 : 0.02;
+	const int linesToStyle = Platform::Clamp(
+		pdoc->durationStyleOneLine.ActionsInAllowedTime(secondsAllowed), 10, 0x10000);
+	const int stylingMaxLine = Platform::Minimum(
+		pdoc->LineFromPosition(pdoc->GetEndStyled()) + linesToStyle, pdoc->LinesTotal());
+	return Platform::Minimum(pdoc->LineStart(stylingMaxLine), posMax);
+}
+
+void Editor::StartIdleStyling(bool truncatedLastStyling) {
+	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE)) {
+		if (pdoc->GetEndStyled() < pdoc->Length()) {
+			// Style remainder of document in idle time
+			needIdleStyling = true;
+		}
+	} else if (truncatedLastStyling) {
+		needIdleStyling = true;
+	}
+
+	if (needIdleStyling) {
+		SetIdle(true);
+	}
+}
+
+// Style for an area but bound the amount of styling to remain responsive.
+// The visible area is always styled before any text after it.
+void Editor::StyleAreaBounded(PRectangle rcArea, bool scrolling) {
+	const int posAfterArea = PositionAfterArea(rcArea);
+	// Only modes that style the visible area in idle time limit styling here
+	const int posAfterMax = ((idleStyling == SC_IDLESTYLING_TOVISIBLE) || (idleStyling == SC_IDLESTYLING_ALL)) ?
+		PositionAfterMaxStyling(posAfterArea, scrolling) : posAfterArea;
+	if (posAfterMax < posAfterArea) {
+		// Style a bit now then style further in idle time
+		pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	} else {
+		// Can style all wanted now.
+		StyleToPositionInView(posAfterArea);
+	}
+	StartIdleStyling(posAfterMax < posAfterArea);
+}
+
+// Called from Idle to style a time limited range. Each range styled invalidates
+// its area of the window so it is redrawn with the new styles.
+void Editor::IdleStyleRange() {
+	const int posAfterArea = PositionAfterArea(GetClientRectangle());
+	const int endGoal = (idleStyling >= SC_IDLESTYLING_AFTERVISIBLE) ?
+		pdoc->Length() : posAfterArea;
+	const int posAfterMax = PositionAfterMaxStyling(endGoal, false);
+	pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	if (pdoc->GetEndStyled() >= endGoal) {
+		needIdleStyling = false;
+	}
+}
+
 void Editor::IdleStyling() {
 	// Style the line after the modification as this allows modifications that change just the
 	// line of the modification to heal instead of propagating to the rest of the window.
@@ -6835,6 +7289,7 @@ void Editor::SetAnnotationHeights(int start, int end) {
 
 void Editor::SetDocPointer(Document *document) {
 	//Platform::DebugPrintf("** %x setdoc to %x\n", pdoc, document);
+	StopIdleFill();
 	pdoc->RemoveWatcher(this, 0);
 	pdoc->Release();
 	if (document == NULL) {
@@ -6857,6 +7312,7 @@ void Editor::SetDocPointer(Document *document) {
 	// Reset the contraction state to fully shown.
 	cs.Clear();
 	cs.InsertLines(0, pdoc->LinesTotal() - 1);
+	lineImages.ResetLines(pdoc->LinesTotal());
 	SetAnnotationHeights(0, pdoc->LinesTotal());
 	llc.Deallocate();
 	NeedWrapping();
@@ -7423,6 +7879,28 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		PLATFORM_ASSERT(lParam);
 		return SearchInTarget(CharPtrFromSPtr(lParam), wParam);
 
+	case SCI_SEARCHALLINTARGET:
+		PLATFORM_ASSERT(lParam);
+		return SearchAllInTarget(CharPtrFromSPtr(lParam), wParam);
+
+	case SCI_REPLACEMATCHES:
+		PLATFORM_ASSERT(lParam);
+		return ReplaceMatches(false, CharPtrFromSPtr(lParam), wParam);
+
+	case SCI_REPLACEMATCHESRE:
+		PLATFORM_ASSERT(lParam);
+		return ReplaceMatches(true, CharPtrFromSPtr(lParam), wParam);
+
+	case SCI_GETMATCHSTART:
+		if (wParam >= matchStarts.size())
+			return -1;
+		return matchStarts[wParam];
+
+	case SCI_GETMATCHEND:
+		if (wParam >= matchEnds.size())
+			return -1;
+		return matchEnds[wParam];
+
 	case SCI_SETSEARCHFLAGS:
 		searchFlags = wParam;
 		break;
@@ -7583,6 +8061,13 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETUNDOCOLLECTION:
 		return pdoc->IsCollectingUndo();
 
+	case SCI_SETUNDOMEMORYLIMIT:
+		pdoc->SetUndoMemoryLimit(wParam);
+		return 0;
+
+	case SCI_GETUNDOMEMORYLIMIT:
+		return pdoc->GetUndoMemoryLimit();
+
 	case SCI_BEGINUNDOACTION:
 		pdoc->BeginUndoAction();
 		return 0;
@@ -7818,6 +8303,7 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		if (pdoc->SetLineEndTypesAllowed(wParam)) {
 			cs.Clear();
 			cs.InsertLines(0, pdoc->LinesTotal() - 1);
+			lineImages.ResetLines(pdoc->LinesTotal());
 			SetAnnotationHeights(0, pdoc->LinesTotal());
 			InvalidateStyleRedraw();
 		}
@@ -8013,6 +8499,27 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETPOSITIONCACHE:
 		return posCache.GetSize();
 
+	case SCI_GETPOSITIONCACHEHITS:
+		return posCache.Hits();
+
+	case SCI_GETPOSITIONCACHEMISSES:
+		return posCache.Misses();
+
+	case SCI_SETLINEIMAGECACHE:
+		lineImages.SetSize(static_cast<int>(wParam), pdoc->LinesTotal());
+		Redraw();
+		break;
+
+	case SCI_GETLINEIMAGECACHE:
+		return lineImages.GetSize();
+
+	case SCI_SETIDLESTYLING:
+		idleStyling = wParam;
+		break;
+
+	case SCI_GETIDLESTYLING:
+		return idleStyling;
+
 	case SCI_SETSCROLLWIDTH:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int >(scrollWidth))) {
@@ -8129,6 +8636,7 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 			if (pdoc->SetDBCSCodePage(wParam)) {
 				cs.Clear();
 				cs.InsertLines(0, pdoc->LinesTotal() - 1);
+				lineImages.ResetLines(pdoc->LinesTotal());
 				SetAnnotationHeights(0, pdoc->LinesTotal());
 				InvalidateStyleRedraw();
 			}
@@ -8661,9 +9169,19 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		break;
 
 	case SCI_INDICATORCLEARRANGE:
+		if (pdoc->decorations.GetCurrentIndicator() == idleFillIndicator)
+			StopIdleFill();
 		pdoc->DecorationFillRange(wParam, 0, lParam);
 		break;
 
+	case SCI_INDICATORFILLMATCHES:
+		return FillMatches(matchStarts, matchEnds, static_cast<int>(wParam));
+
+	case SCI_INDICATORFILLALLINTARGET:
+		PLATFORM_ASSERT(lParam);
+		IndicatorFillAllInTarget(static_cast<int>(wParam), CharPtrFromSPtr(lParam));
+		break;
+
 	case SCI_INDICATORALLONFOR:
 		return pdoc->decorations.AllOnFor(wParam);
 
@@ -195,7 +195,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	Surface *pixmapIndentGuideHighlight;
 
 	LineLayoutCache llc;
-	PositionCache posCache;
+	PositionCache &posCache;
+	LineImageCache lineImages;
 
 	KeyMap kmap;
 
@@ -227,6 +228,19 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	int targetStart;
 	int targetEnd;
 	int searchFlags;
+	std::vector<int> matchStarts;
+	std::vector<int> matchEnds;
+	// What SCI_SEARCHALLINTARGET searched for so regular expression matches can be substituted
+	std::string matchText;
+	int matchFlags;
+	int matchSearchEnd;
+	// SCI_INDICATORFILLALLINTARGET continues over these ranges in idle time
+	std::vector<Range> idleFillRanges;
+	std::string idleFillText;
+	int idleFillFlags;
+	int idleFillIndicator;
+	int idleFillValue;
+	int idleFillStyle;
 	int topLine;
 	int posTopLine;
 	int lengthForEncode;
@@ -243,6 +257,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool paintingAllText;
 	bool willRedrawAll;
 	StyleNeeded styleNeeded;
+	int idleStyling;	// SC_IDLESTYLING_*
+	bool needIdleStyling;
 
 	int modEventMask;
 
@@ -276,6 +292,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	int wrapWidth;
 	int wrapStart;
 	int wrapEnd;
+	ActionDuration durationWrapOneLine;
 	int wrapVisualFlags;
 	int wrapVisualFlagsLocation;
 	int wrapVisualStartIndent;
@@ -306,6 +323,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	int LinesOnScreen();
 	int LinesToScroll();
 	int MaxScrollPos();
+	int LinesPendingWrapEstimate();
 	SelectionPosition ClampPositionIntoDocument(SelectionPosition sp) const;
 	Point LocationFromPosition(SelectionPosition pos);
 	Point LocationFromPosition(int pos);
@@ -321,6 +339,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool AbandonPaint();
 	void RedrawRect(PRectangle rc);
 	void Redraw();
+	void RedrawRetained();
 	void RedrawSelMargin(int line=-1, bool allAfter=false);
 	PRectangle RectangleFromRange(int start, int end);
 	void InvalidateRange(int start, int end);
@@ -378,6 +397,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void NeedWrapping(int docLineStart = 0, int docLineEnd = wrapLineLarge);
 	bool WrapOneLine(Surface *surface, int lineToWrap);
 	bool WrapLines(bool fullWrap, int priorityWrapLineStart);
+	void NotifyWrapProgress(int line);
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
 
@@ -407,6 +427,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void DrawCarets(Surface *surface, ViewStyle &vsDraw, int line, int xStart,
 		PRectangle rcLine, LineLayout *ll, int subLine);
 	void RefreshPixMaps(Surface *surfaceWindow);
+	bool LineImageKey(std::string &key, int lineDoc, int lineVisible, int subLine,
+		LineLayout *ll, int xStart, PRectangle rcLine);
 	void Paint(Surface *surfaceWindow, PRectangle rcArea);
 	long FormatRange(bool draw, Sci_RangeToFormat *pfr);
 	int TextWidth(int style, const char *text);
@@ -493,10 +515,19 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void Indent(bool forwards);
 
 	virtual CaseFolder *CaseFolderForEncoding();
-	long FindText(uptr_t wParam, sptr_t lParam);
+	sptr_t FindText(uptr_t wParam, sptr_t lParam);
 	void SearchAnchor();
-	long SearchText(unsigned int iMessage, uptr_t wParam, sptr_t lParam);
-	long SearchInTarget(const char *text, int length);
+	sptr_t SearchText(unsigned int iMessage, uptr_t wParam, sptr_t lParam);
+	sptr_t SearchInTarget(const char *text, int length);
+	void FindAllInRange(int start, int end, const char *text, int length, int flags,
+		std::vector<int> &starts, std::vector<int> &ends);
+	int SearchAllInTarget(const char *text, int length);
+	int ReplaceMatches(bool replacePatterns, const char *text, int length);
+	int FillMatches(const std::vector<int> &starts, const std::vector<int> &ends, int style);
+	void IndicatorFillAllInTarget(int style, const char *text);
+	void FillFoundInRange(int start, int end);
+	void IdleFillRange();
+	void StopIdleFill();
 	void GoToLine(int lineNo);
 
 	virtual void CopyToClipboard(const SelectionText &selectedText) = 0;
@@ -534,6 +565,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	int PositionAfterArea(PRectangle rcArea);
 	void StyleToPositionInView(Position pos);
+	int PositionAfterMaxStyling(int posMax, bool scrolling) const;
+	void StartIdleStyling(bool truncatedLastStyling);
+	void StyleAreaBounded(PRectangle rcArea, bool scrolling);
+	void IdleStyleRange();
 	void IdleStyling();
 	virtual void QueueStyling(int upTo);
 
@@ -0,0 +1,1353 @@
+// Scintilla source code edit control
+/** @file LinearRegex.cxx
+ ** Linear time regular expression engine.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+/*
+ * Syntax:
+ *
+ *      char        matches itself unless it is one of . \ [ ] * + ? { | ^ $
+ *                  or ( ) in posix mode.
+ *      .           any character.
+ *      [set]       any character in the set which may contain ranges such as a-z
+ *                  and the escapes \d \D \s \S \w \W. [^set] negates the set.
+ *      \(form\)    a group, written (form) in posix mode. The first 9 groups are
+ *                  tagged for substitution. \(?:form\) is never tagged.
+ *      a|b         either alternative.
+ *      * + ?       zero or more, one or more and zero or one repetitions.
+ *      {m} {m,} {m,n}  counted repetitions, with at most 1000 for each count.
+ *                  A following ? makes any repetition match as few as possible.
+ *      ^ $         start and end of line.
+ *      \< \> \b \B start of word, end of word, word boundary and not word boundary.
+ *      \d \s \w    digit, space and word characters, negated by \D \S \W.
+ *      \t \n \r \f \v \a \e  control characters.
+ *      \xHH \x{H...} \uHHHH  the character with the hexadecimal code.
+ *      \char       the character itself.
+ *
+ * Characters are code points for UTF-8 and DBCS text and bytes for other text.
+ * Without case sensitivity, Latin, Greek and Cyrillic letters match their other case.
+ *
+ * The pattern is compiled into a Thompson NFA over bytes. Each search first runs
+ * a DFA that is built lazily from sets of NFA instructions to find the earliest
+ * position where any match ends. Lines that can not match are only scanned by
+ * the DFA. When there is a match, a Pike VM simulates the NFA with a priority
+ * for each thread to find the same match as a backtracking engine along with
+ * its groups. Both are bounded by the product of the pattern and text sizes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "LinearRegex.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+namespace {
+
+const int maxInstructions = 20000;
+const int maxRepeat = 1000;
+const int maxNesting = 1000;
+const int maxStates = 2000;
+const int endOfText = 256;
+const int transitionsPerState = 257;
+
+enum Op { opRange, opSet, opSplit, opJmp, opSave, opAssert, opMatch };
+
+enum Assertion {
+	assertLineStart, assertLineEnd, assertWordStart, assertWordEnd,
+	assertWordBoundary, assertNotWordBoundary
+};
+
+struct Instruction {
+	int op;
+	int x;	// first byte of opRange, set of opSet, preferred target of opSplit, target of opJmp,
+		// slot of opSave or assertion of opAssert
+	int y;	// last byte of opRange or other target of opSplit
+	Instruction(int op_, int x_, int y_) : op(op_), x(x_), y(y_) {
+	}
+};
+
+struct ByteSet {
+	bool member[256];
+	ByteSet() {
+		memset(member, 0, sizeof(member));
+	}
+	bool Empty() const {
+		for (int b = 0; b < 256; b++) {
+			if (member[b])
+				return false;
+		}
+		return true;
+	}
+};
+
+struct ByteRange {
+	int first;
+	int last;
+	ByteRange(int first_, int last_) : first(first_), last(last_) {
+	}
+};
+
+typedef std::vector<ByteRange> ByteSequence;
+
+struct CodeRange {
+	int first;
+	int last;
+	CodeRange(int first_, int last_) : first(first_), last(last_) {
+	}
+	bool operator<(const CodeRange &other) const {
+		return first < other.first;
+	}
+};
+
+class CharacterSet {
+public:
+	std::vector<CodeRange> ranges;
+	void Add(int first, int last) {
+		ranges.push_back(CodeRange(first, last));
+	}
+	void Add(const CharacterSet &other) {
+		ranges.insert(ranges.end(), other.ranges.begin(), other.ranges.end());
+	}
+	void Normalize() {
+		std::sort(ranges.begin(), ranges.end());
+		std::vector<CodeRange> merged;
+		for (size_t i = 0; i < ranges.size(); i++) {
+			if (!merged.empty() && (ranges[i].first <= merged.back().last + 1))
+				merged.back().last = std::max(merged.back().last, ranges[i].last);
+			else
+				merged.push_back(ranges[i]);
+		}
+		ranges.swap(merged);
+	}
+	void Negate(int maxCode) {
+		Normalize();
+		std::vector<CodeRange> complement;
+		int next = 0;
+		for (size_t i = 0; i < ranges.size(); i++) {
+			if (ranges[i].first > next)
+				complement.push_back(CodeRange(next, ranges[i].first - 1));
+			next = ranges[i].last + 1;
+		}
+		if (next <= maxCode)
+			complement.push_back(CodeRange(next, maxCode));
+		ranges.swap(complement);
+	}
+};
+
+// Simple case mappings outside ASCII for the common alphabets.
+void AddUnicodeOtherCase(int code, CharacterSet &cs) {
+	if ((code >= 0xC0) && (code <= 0xDE) && (code != 0xD7)) {
+		cs.Add(code + 0x20, code + 0x20);
+	} else if ((code >= 0xE0) && (code <= 0xFE) && (code != 0xF7)) {
+		cs.Add(code - 0x20, code - 0x20);
+	} else if (code == 0xFF) {
+		cs.Add(0x178, 0x178);
+	} else if (code == 0x178) {
+		cs.Add(0xFF, 0xFF);
+	} else if (((code >= 0x100) && (code <= 0x12F)) || ((code >= 0x132) && (code <= 0x137)) ||
+		((code >= 0x14A) && (code <= 0x177)) || ((code >= 0x460) && (code <= 0x481)) ||
+		((code >= 0x48A) && (code <= 0x4BF)) || ((code >= 0x4D0) && (code <= 0x52F))) {
+		// Pairs with the upper case letter at the even code
+		cs.Add(code ^ 1, code ^ 1);
+	} else if (((code >= 0x139) && (code <= 0x148)) || ((code >= 0x179) && (code <= 0x17E)) ||
+		((code >= 0x4C1) && (code <= 0x4CE))) {
+		// Pairs with the upper case letter at the odd code
+		const int other = (code & 1) ? code + 1 : code - 1;
+		cs.Add(other, other);
+	} else if (((code >= 0x391) && (code <= 0x3A1)) || ((code >= 0x3A3) && (code <= 0x3AB)) ||
+		((code >= 0x410) && (code <= 0x42F))) {
+		cs.Add(code + 0x20, code + 0x20);
+		if (code == 0x3A3)
+			cs.Add(0x3C2, 0x3C2);	// Final sigma
+	} else if (((code >= 0x3B1) && (code <= 0x3C1)) || ((code >= 0x3C3) && (code <= 0x3CB)) ||
+		((code >= 0x430) && (code <= 0x44F))) {
+		cs.Add(code - 0x20, code - 0x20);
+	} else if (code == 0x3C2) {
+		cs.Add(0x3A3, 0x3A3);
+		cs.Add(0x3C3, 0x3C3);
+	} else if ((code >= 0x400) && (code <= 0x40F)) {
+		cs.Add(code + 0x50, code + 0x50);
+	} else if ((code >= 0x450) && (code <= 0x45F)) {
+		cs.Add(code - 0x50, code - 0x50);
+	}
+}
+
+int UTF8Length(int code) {
+	if (code < 0x80)
+		return 1;
+	else if (code < 0x800)
+		return 2;
+	else if (code < 0x10000)
+		return 3;
+	else
+		return 4;
+}
+
+void UTF8Encode(int code, int length, unsigned char *bytes) {
+	switch (length) {
+	case 1:
+		bytes[0] = static_cast<unsigned char>(code);
+		break;
+	case 2:
+		bytes[0] = static_cast<unsigned char>(0xC0 | (code >> 6));
+		bytes[1] = static_cast<unsigned char>(0x80 | (code & 0x3F));
+		break;
+	case 3:
+		bytes[0] = static_cast<unsigned char>(0xE0 | (code >> 12));
+		bytes[1] = static_cast<unsigned char>(0x80 | ((code >> 6) & 0x3F));
+		bytes[2] = static_cast<unsigned char>(0x80 | (code & 0x3F));
+		break;
+	default:
+		bytes[0] = static_cast<unsigned char>(0xF0 | (code >> 18));
+		bytes[1] = static_cast<unsigned char>(0x80 | ((code >> 12) & 0x3F));
+		bytes[2] = static_cast<unsigned char>(0x80 | ((code >> 6) & 0x3F));
+		bytes[3] = static_cast<unsigned char>(0x80 | (code & 0x3F));
+		break;
+	}
+}
+
+// Split a range of code points into ranges where every position of the UTF-8
+// encoding varies independently so each can be matched by a sequence of byte ranges.
+void SplitUTF8(int first, int last, std::vector<ByteSequence> &sequences) {
+	if (first > last)
+		return;
+	static const int boundaries[] = { 0x7F, 0x7FF, 0xFFFF };
+	for (int b = 0; b < 3; b++) {
+		if ((first <= boundaries[b]) && (boundaries[b] < last)) {
+			SplitUTF8(first, boundaries[b], sequences);
+			SplitUTF8(boundaries[b] + 1, last, sequences);
+			return;
+		}
+	}
+	const int length = UTF8Length(first);
+	for (int i = 1; i < length; i++) {
+		const int mask = (1 << (6 * i)) - 1;
+		if ((first & ~mask) != (last & ~mask)) {
+			if ((first & mask) != 0) {
+				SplitUTF8(first, first | mask, sequences);
+				SplitUTF8((first | mask) + 1, last, sequences);
+				return;
+			}
+			if ((last & mask) != mask) {
+				SplitUTF8(first, (last & ~mask) - 1, sequences);
+				SplitUTF8(last & ~mask, last, sequences);
+				return;
+			}
+		}
+	}
+	unsigned char bytesFirst[4];
+	unsigned char bytesLast[4];
+	UTF8Encode(first, length, bytesFirst);
+	UTF8Encode(last, length, bytesLast);
+	ByteSequence sequence;
+	for (int i = 0; i < length; i++)
+		sequence.push_back(ByteRange(bytesFirst[i], bytesLast[i]));
+	sequences.push_back(sequence);
+}
+
+/// The text encoding and character tables a pattern is compiled for.
+class RegexEnvironment {
+public:
+	LinearRegex::Encoding encoding;
+	const bool *leadByte;
+	const char *foldByte;
+	const bool *wordByte;
+
+	int MaxCode() const {
+		if (encoding == LinearRegex::encUTF8)
+			return 0x10FFFF;
+		else if (encoding == LinearRegex::encDBCS)
+			return 0xFFFF;
+		else
+			return 0xFF;
+	}
+
+	void AddOtherCases(CharacterSet &cs) const {
+		const int foldedBytes = (encoding == LinearRegex::encSingleByte) ? 0x100 : 0x80;
+		const size_t rangesOriginal = cs.ranges.size();
+		for (size_t r = 0; r < rangesOriginal; r++) {
+			const int first = cs.ranges[r].first;
+			const int last = cs.ranges[r].last;
+			for (int code = first; (code <= last) && (code < foldedBytes); code++) {
+				for (int other = 0; other < foldedBytes; other++) {
+					if ((other != code) && (foldByte[other] == foldByte[code]))
+						cs.Add(other, other);
+				}
+			}
+			if (encoding == LinearRegex::encUTF8) {
+				for (int code = std::max(first, 0x80); (code <= last) && (code < 0x530); code++)
+					AddUnicodeOtherCase(code, cs);
+			}
+		}
+	}
+
+	void AddWordCharacters(CharacterSet &cs) const {
+		const int singleBytes = (encoding == LinearRegex::encUTF8) ? 0x80 : 0x100;
+		for (int b = 0; b < singleBytes; b++) {
+			if (wordByte[b])
+				cs.Add(b, b);
+		}
+		// Characters of more than one byte are always treated as word characters
+		if (MaxCode() >= singleBytes)
+			cs.Add(singleBytes, MaxCode());
+	}
+
+	/// Convert a set of characters into a set of single bytes and sequences of byte ranges.
+	void Sequences(CharacterSet &cs, ByteSet &singles, std::vector<ByteSequence> &sequences) const {
+		cs.Normalize();
+		for (size_t r = 0; r < cs.ranges.size(); r++) {
+			const int first = cs.ranges[r].first;
+			const int last = cs.ranges[r].last;
+			const int singleLast = (encoding == LinearRegex::encUTF8) ? 0x7F : 0xFF;
+			for (int b = first; (b <= last) && (b <= singleLast); b++) {
+				if ((encoding != LinearRegex::encDBCS) || !leadByte[b])
+					singles.member[b] = true;
+			}
+			if (last <= singleLast)
+				continue;
+			const int firstMulti = std::max(first, singleLast + 1);
+			if (encoding == LinearRegex::encUTF8) {
+				SplitUTF8(firstMulti, last, sequences);
+			} else {
+				// Double byte characters grouped into runs of lead bytes with the same trail bytes
+				const int leadFirst = firstMulti >> 8;
+				const int leadLast = last >> 8;
+				for (int lead = leadFirst; lead <= leadLast; lead++) {
+					if (!leadByte[lead])
+						continue;
+					const int trailFirst = (lead == leadFirst) ? (firstMulti & 0xFF) : 0;
+					const int trailLast = (lead == leadLast) ? (last & 0xFF) : 0xFF;
+					int leadEnd = lead;
+					if ((trailFirst == 0) && (trailLast == 0xFF)) {
+						while ((leadEnd + 1 < leadLast) && leadByte[leadEnd + 1])
+							leadEnd++;
+					}
+					ByteSequence sequence;
+					sequence.push_back(ByteRange(lead, leadEnd));
+					sequence.push_back(ByteRange(trailFirst, trailLast));
+					sequences.push_back(sequence);
+					lead = leadEnd;
+				}
+			}
+		}
+	}
+};
+
+}
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+/// Compiled form of a pattern.
+class RegexProgram {
+public:
+	std::vector<Instruction> code;
+	std::vector<ByteSet> sets;
+	int slots;
+	RegexProgram() : slots(2) {
+	}
+	int Emit(int op, int x=0, int y=0) {
+		code.push_back(Instruction(op, x, y));
+		return static_cast<int>(code.size()) - 1;
+	}
+	int Next() const {
+		return static_cast<int>(code.size());
+	}
+	bool Overflowed() const {
+		return code.size() > maxInstructions;
+	}
+	bool Accepts(const Instruction &ins, int ch) const {
+		if (ins.op == opRange)
+			return (ch >= ins.x) && (ch <= ins.y);
+		else
+			return (ch < endOfText) && sets[ins.x].member[ch];
+	}
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+namespace {
+
+/// What surrounds a position in the text for evaluating assertions.
+struct PositionContext {
+	bool lineStart;
+	bool lineEnd;
+	bool wordBefore;
+	bool wordAfter;
+	PositionContext(bool lineStart_, bool lineEnd_, bool wordBefore_, bool wordAfter_) :
+		lineStart(lineStart_), lineEnd(lineEnd_), wordBefore(wordBefore_), wordAfter(wordAfter_) {
+	}
+	bool Holds(int assertion) const {
+		switch (assertion) {
+		case assertLineStart:
+			return lineStart;
+		case assertLineEnd:
+			return lineEnd;
+		case assertWordStart:
+			return !wordBefore && wordAfter;
+		case assertWordEnd:
+			return wordBefore && !wordAfter;
+		case assertWordBoundary:
+			return wordBefore != wordAfter;
+		default:
+			return wordBefore == wordAfter;
+		}
+	}
+};
+
+struct Node {
+	enum Kind { nCharacters, nConcatenation, nAlternation, nRepeat, nGroup, nAssert };
+	Kind kind;
+	CharacterSet characters;
+	std::vector<Node *> children;
+	int minimum;
+	int maximum;
+	bool greedy;
+	int value;	// group number or assertion
+	explicit Node(Kind kind_) : kind(kind_), minimum(0), maximum(0), greedy(true), value(0) {
+	}
+};
+
+class RegexParser {
+public:
+	const char *error;
+	int groups;
+
+	RegexParser(const RegexEnvironment &env_, const char *pattern_, int length_, bool caseSensitive_, bool posix_) :
+		error(0), groups(1), env(env_), pattern(reinterpret_cast<const unsigned char *>(pattern_)),
+		length(length_), pos(0), caseSensitive(caseSensitive_), posix(posix_) {
+	}
+	~RegexParser() {
+		for (size_t i = 0; i < nodes.size(); i++)
+			delete nodes[i];
+	}
+	Node *Parse() {
+		Node *root = ParseAlternation(0);
+		if (root && (pos < length))
+			return Fail(posix ? "Unmatched )" : "Unmatched \\)");
+		return root;
+	}
+
+private:
+	const RegexEnvironment &env;
+	const unsigned char *pattern;
+	int length;
+	int pos;
+	bool caseSensitive;
+	bool posix;
+	std::vector<Node *> nodes;
+
+	Node *NewNode(Node::Kind kind) {
+		nodes.push_back(new Node(kind));
+		return nodes.back();
+	}
+	Node *Fail(const char *message) {
+		if (!error)
+			error = message;
+		return 0;
+	}
+	bool At(unsigned char ch) const {
+		return (pos < length) && (pattern[pos] == ch);
+	}
+	bool AtGroupStart() const {
+		if (posix)
+			return At('(');
+		return At('\\') && (pos + 1 < length) && (pattern[pos + 1] == '(');
+	}
+	bool AtGroupEnd() const {
+		if (posix)
+			return At(')');
+		return At('\\') && (pos + 1 < length) && (pattern[pos + 1] == ')');
+	}
+
+	Node *ParseAlternation(int depth) {
+		if (depth > maxNesting)
+			return Fail("Too many nested groups");
+		Node *first = ParseConcatenation(depth);
+		if (!first || !At('|'))
+			return first;
+		Node *alternation = NewNode(Node::nAlternation);
+		alternation->children.push_back(first);
+		while (At('|')) {
+			pos++;
+			Node *alternative = ParseConcatenation(depth);
+			if (!alternative)
+				return 0;
+			alternation->children.push_back(alternative);
+		}
+		return alternation;
+	}
+
+	Node *ParseConcatenation(int depth) {
+		Node *concatenation = NewNode(Node::nConcatenation);
+		while ((pos < length) && !At('|') && !AtGroupEnd()) {
+			Node *item = ParseRepeat(depth);
+			if (!item)
+				return 0;
+			concatenation->children.push_back(item);
+		}
+		return concatenation;
+	}
+
+	int ParseNumber() {
+		int value = -1;
+		while ((pos < length) && (pattern[pos] >= '0') && (pattern[pos] <= '9')) {
+			value = ((value < 0) ? 0 : value * 10) + (pattern[pos] - '0');
+			if (value > maxRepeat)
+				value = maxRepeat + 1;
+			pos++;
+		}
+		return value;
+	}
+
+	// Parse {m}, {m,} or {m,n} leaving pos unchanged if it is not a count.
+	bool ParseCount(int &minimum, int &maximum) {
+		const int start = pos;
+		pos++;
+		minimum = ParseNumber();
+		maximum = minimum;
+		if (At(',')) {
+			pos++;
+			maximum = ParseNumber();
+		}
+		if ((minimum < 0) || !At('}')) {
+			pos = start;
+			return false;
+		}
+		pos++;
+		return true;
+	}
+
+	Node *ParseRepeat(int depth) {
+		Node *atom = ParseAtom(depth);
+		while (atom && (pos < length)) {
+			int minimum = 0;
+			int maximum = -1;
+			if (At('*')) {
+				pos++;
+			} else if (At('+')) {
+				pos++;
+				minimum = 1;
+			} else if (At('?')) {
+				pos++;
+				maximum = 1;
+			} else if (!At('{') || !ParseCount(minimum, maximum)) {
+				break;
+			}
+			if ((minimum > maxRepeat) || (maximum > maxRepeat))
+				return Fail("Repetition count too large");
+			if ((maximum >= 0) && (maximum < minimum))
+				return Fail("Invalid repetition count");
+			Node *repeat = NewNode(Node::nRepeat);
+			repeat->minimum = minimum;
+			repeat->maximum = maximum;
+			repeat->greedy = !At('?');
+			if (!repeat->greedy)
+				pos++;
+			repeat->children.push_back(atom);
+			atom = repeat;
+		}
+		return atom;
+	}
+
+	Node *Characters(CharacterSet &cs) {
+		if (!caseSensitive)
+			env.AddOtherCases(cs);
+		Node *node = NewNode(Node::nCharacters);
+		node->characters = cs;
+		return node;
+	}
+
+	Node *Assert(int assertion) {
+		Node *node = NewNode(Node::nAssert);
+		node->value = assertion;
+		return node;
+	}
+
+	Node *ParseAtom(int depth) {
+		if (AtGroupStart()) {
+			pos += posix ? 1 : 2;
+			Node *group = NewNode(Node::nGroup);
+			group->value = -1;
+			if (At('?') && (pos + 1 < length) && (pattern[pos + 1] == ':')) {
+				pos += 2;
+			} else if (groups < LinearRegex::maxGroups) {
+				group->value = groups++;
+			}
+			Node *inner = ParseAlternation(depth + 1);
+			if (!inner)
+				return 0;
+			if (!AtGroupEnd())
+				return Fail(posix ? "Unmatched (" : "Unmatched \\(");
+			pos += posix ? 1 : 2;
+			group->children.push_back(inner);
+			return group;
+		}
+		CharacterSet cs;
+		switch (pattern[pos]) {
+		case '.': {
+				pos++;
+				Node *node = NewNode(Node::nCharacters);
+				node->characters.Add(0, env.MaxCode());
+				return node;
+			}
+		case '^':
+			pos++;
+			return Assert(assertLineStart);
+		case '$':
+			pos++;
+			return Assert(assertLineEnd);
+		case '[':
+			pos++;
+			return ParseClass();
+		case '*':
+		case '+':
+		case '?':
+			return Fail("Nothing to repeat");
+		case '\\':
+			pos++;
+			if (pos >= length)
+				return Fail("Trailing \\");
+			switch (pattern[pos]) {
+			case '<':
+				pos++;
+				return Assert(assertWordStart);
+			case '>':
+				pos++;
+				return Assert(assertWordEnd);
+			case 'b':
+				pos++;
+				return Assert(assertWordBoundary);
+			case 'B':
+				pos++;
+				return Assert(assertNotWordBoundary);
+			}
+			if ((pattern[pos] >= '1') && (pattern[pos] <= '9'))
+				return Fail("Back references are not supported");
+			if (!ParseClassEscape(cs)) {
+				const int code = ParseEscape();
+				if (code < 0)
+					return 0;
+				cs.Add(code, code);
+			}
+			return Characters(cs);
+		default: {
+				const int code = ParseCharacter();
+				if (code < 0)
+					return 0;
+				cs.Add(code, code);
+				return Characters(cs);
+			}
+		}
+	}
+
+	Node *ParseClass() {
+		CharacterSet cs;
+		const bool negate = At('^');
+		if (negate)
+			pos++;
+		bool first = true;
+		for (;;) {
+			if (pos >= length)
+				return Fail("Missing ]");
+			if (At(']') && !first) {
+				pos++;
+				break;
+			}
+			first = false;
+			int low;
+			if (At('\\')) {
+				pos++;
+				if (pos >= length)
+					return Fail("Missing ]");
+				if (ParseClassEscape(cs))
+					continue;
+				low = ParseEscape();
+			} else {
+				low = ParseCharacter();
+			}
+			if (low < 0)
+				return 0;
+			int high = low;
+			if (At('-') && (pos + 1 < length) && (pattern[pos + 1] != ']')) {
+				pos++;
+				if (At('\\')) {
+					pos++;
+					if (pos >= length)
+						return Fail("Missing ]");
+					high = ParseEscape();
+				} else {
+					high = ParseCharacter();
+				}
+				if (high < 0)
+					return 0;
+				if (high < low)
+					return Fail("Invalid range");
+			}
+			cs.Add(low, high);
+		}
+		if (!caseSensitive)
+			env.AddOtherCases(cs);
+		if (negate)
+			cs.Negate(env.MaxCode());
+		Node *node = NewNode(Node::nCharacters);
+		node->characters = cs;
+		return node;
+	}
+
+	// Add the characters of \d \s \w or their negations when at one.
+	bool ParseClassEscape(CharacterSet &cs) {
+		CharacterSet escaped;
+		switch (pattern[pos]) {
+		case 'd':
+		case 'D':
+			escaped.Add('0', '9');
+			break;
+		case 's':
+		case 'S':
+			escaped.Add('\t', '\r');
+			escaped.Add(' ', ' ');
+			break;
+		case 'w':
+		case 'W':
+			env.AddWordCharacters(escaped);
+			break;
+		default:
+			return false;
+		}
+		if ((pattern[pos] >= 'A') && (pattern[pos] <= 'Z'))
+			escaped.Negate(env.MaxCode());
+		pos++;
+		cs.Add(escaped);
+		return true;
+	}
+
+	int ParseHex(int digits) {
+		int value = 0;
+		int count = 0;
+		while ((pos < length) && (count < digits)) {
+			const int ch = pattern[pos];
+			int digit;
+			if ((ch >= '0') && (ch <= '9'))
+				digit = ch - '0';
+			else if ((ch >= 'a') && (ch <= 'f'))
+				digit = ch - 'a' + 10;
+			else if ((ch >= 'A') && (ch <= 'F'))
+				digit = ch - 'A' + 10;
+			else
+				break;
+			value = value * 16 + digit;
+			if (value > 0x10FFFF)
+				value = 0x110000;
+			pos++;
+			count++;
+		}
+		return (count > 0) ? value : -1;
+	}
+
+	// The character after a backslash.
+	int ParseEscape() {
+		const int ch = pattern[pos];
+		int code = -1;
+		switch (ch) {
+		case 'a':
+			code = '\a';
+			break;
+		case 'e':
+			code = 0x1B;
+			break;
+		case 'f':
+			code = '\f';
+			break;
+		case 'n':
+			code = '\n';
+			break;
+		case 'r':
+			code = '\r';
+			break;
+		case 't':
+			code = '\t';
+			break;
+		case 'v':
+			code = '\v';
+			break;
+		case 'x':
+		case 'u':
+			pos++;
+			if ((ch == 'x') && At('{')) {
+				pos++;
+				code = ParseHex(8);
+				if (!At('}'))
+					code = -1;
+				pos++;
+			} else {
+				code = ParseHex((ch == 'x') ? 2 : 4);
+			}
+			if (code < 0) {
+				Fail("Invalid hexadecimal escape");
+				return -1;
+			}
+			if (code > env.MaxCode()) {
+				Fail("Character out of range");
+				return -1;
+			}
+			return code;
+		default:
+			return ParseCharacter();
+		}
+		pos++;
+		return code;
+	}
+
+	int ParseCharacter() {
+		const int lead = pattern[pos];
+		if ((env.encoding == LinearRegex::encDBCS) && env.leadByte[lead] && (pos + 1 < length)) {
+			const int code = (lead << 8) | pattern[pos + 1];
+			pos += 2;
+			return code;
+		}
+		if ((env.encoding != LinearRegex::encUTF8) || (lead < 0x80)) {
+			pos++;
+			return lead;
+		}
+		int trail;
+		int code;
+		if ((lead >= 0xC2) && (lead <= 0xDF)) {
+			trail = 1;
+			code = lead & 0x1F;
+		} else if ((lead >= 0xE0) && (lead <= 0xEF)) {
+			trail = 2;
+			code = lead & 0x0F;
+		} else if ((lead >= 0xF0) && (lead <= 0xF4)) {
+			trail = 3;
+			code = lead & 0x07;
+		} else {
+			Fail("Invalid UTF-8 in pattern");
+			return -1;
+		}
+		if (pos + trail >= length) {
+			Fail("Invalid UTF-8 in pattern");
+			return -1;
+		}
+		for (int i = 1; i <= trail; i++) {
+			const int ch = pattern[pos + i];
+			if ((ch & 0xC0) != 0x80) {
+				Fail("Invalid UTF-8 in pattern");
+				return -1;
+			}
+			code = (code << 6) | (ch & 0x3F);
+		}
+		static const int minimumCode[] = { 0, 0x80, 0x800, 0x10000 };
+		if ((code < minimumCode[trail]) || (code > 0x10FFFF)) {
+			Fail("Invalid UTF-8 in pattern");
+			return -1;
+		}
+		pos += trail + 1;
+		return code;
+	}
+};
+
+class RegexCompiler {
+public:
+	RegexCompiler(const RegexEnvironment &env_, RegexProgram &program_) : env(env_), program(program_) {
+	}
+	void Compile(Node *root, int groups) {
+		program.slots = groups * 2;
+		program.Emit(opSave, 0);
+		EmitNode(root);
+		program.Emit(opSave, 1);
+		program.Emit(opMatch);
+	}
+
+private:
+	const RegexEnvironment &env;
+	RegexProgram &program;
+
+	void EmitRanges(const ByteSequence &sequence) {
+		for (size_t i = 0; i < sequence.size(); i++)
+			program.Emit(opRange, sequence[i].first, sequence[i].last);
+	}
+
+	void EmitSingles(const ByteSet &singles) {
+		int first = 0;
+		while ((first < 256) && !singles.member[first])
+			first++;
+		int last = first;
+		while ((last < 255) && singles.member[last + 1])
+			last++;
+		bool contiguous = true;
+		for (int b = last + 1; b < 256; b++) {
+			if (singles.member[b])
+				contiguous = false;
+		}
+		if (contiguous && (first < 256)) {
+			program.Emit(opRange, first, last);
+		} else {
+			program.sets.push_back(singles);
+			program.Emit(opSet, static_cast<int>(program.sets.size()) - 1);
+		}
+	}
+
+	void EmitCharacters(Node *node) {
+		ByteSet singles;
+		std::vector<ByteSequence> sequences;
+		env.Sequences(node->characters, singles, sequences);
+		const bool hasSingles = !singles.Empty();
+		if (!hasSingles && sequences.empty()) {
+			// Can never match
+			EmitSingles(singles);
+			return;
+		}
+		const size_t alternatives = sequences.size() + (hasSingles ? 1 : 0);
+		std::vector<int> jumps;
+		for (size_t alternative = 0; alternative < alternatives; alternative++) {
+			int split = -1;
+			if (alternative + 1 < alternatives)
+				split = program.Emit(opSplit, program.Next() + 1);
+			if (hasSingles && (alternative == 0))
+				EmitSingles(singles);
+			else
+				EmitRanges(sequences[alternative - (hasSingles ? 1 : 0)]);
+			if (split >= 0) {
+				jumps.push_back(program.Emit(opJmp));
+				program.code[split].y = program.Next();
+			}
+		}
+		for (size_t j = 0; j < jumps.size(); j++)
+			program.code[jumps[j]].x = program.Next();
+	}
+
+	void EmitNode(Node *node) {
+		if (program.Overflowed())
+			return;
+		switch (node->kind) {
+		case Node::nCharacters:
+			EmitCharacters(node);
+			break;
+		case Node::nConcatenation:
+			for (size_t i = 0; i < node->children.size(); i++)
+				EmitNode(node->children[i]);
+			break;
+		case Node::nAlternation: {
+				std::vector<int> jumps;
+				for (size_t i = 0; i + 1 < node->children.size(); i++) {
+					const int split = program.Emit(opSplit, program.Next() + 1);
+					EmitNode(node->children[i]);
+					jumps.push_back(program.Emit(opJmp));
+					program.code[split].y = program.Next();
+				}
+				EmitNode(node->children.back());
+				for (size_t j = 0; j < jumps.size(); j++)
+					program.code[jumps[j]].x = program.Next();
+			}
+			break;
+		case Node::nRepeat: {
+				Node *child = node->children[0];
+				for (int i = 0; i < node->minimum; i++)
+					EmitNode(child);
+				std::vector<int> splits;
+				if (node->maximum < 0) {
+					const int loop = program.Emit(opSplit);
+					splits.push_back(loop);
+					EmitNode(child);
+					program.Emit(opJmp, loop);
+				} else {
+					for (int i = node->minimum; i < node->maximum; i++) {
+						splits.push_back(program.Emit(opSplit));
+						EmitNode(child);
+					}
+				}
+				const int after = program.Next();
+				for (size_t s = 0; s < splits.size(); s++) {
+					Instruction &split = program.code[splits[s]];
+					split.x = node->greedy ? splits[s] + 1 : after;
+					split.y = node->greedy ? after : splits[s] + 1;
+				}
+			}
+			break;
+		case Node::nGroup:
+			if (node->value >= 0)
+				program.Emit(opSave, node->value * 2);
+			EmitNode(node->children[0]);
+			if (node->value >= 0)
+				program.Emit(opSave, node->value * 2 + 1);
+			break;
+		case Node::nAssert:
+			program.Emit(opAssert, node->value);
+			break;
+		}
+	}
+};
+
+}
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+/// Lazily built DFA that finds the earliest end of any match.
+/// A state is the set of instructions reached after consuming a byte along with
+/// whether the previous position was a line start or a word character, as
+/// assertions are only evaluated when the next byte is known.
+class RegexAutomaton {
+public:
+	RegexAutomaton(const RegexProgram &program_, const bool *wordByte_) :
+		program(program_), wordByte(wordByte_), generation(0), resets(0) {
+		visited.resize(program.code.size(), 0);
+		Reset();
+	}
+
+	int EarliestEnd(const unsigned char *text, int length, int start, int end) {
+		int context = (start == 0) ? contextLineStart : 0;
+		if ((start > 0) && wordByte[text[start - 1]])
+			context |= contextWord;
+		if (initial[context] < 0)
+			initial[context] = StateFor(std::vector<int>(), context);
+		int state = initial[context];
+		for (int position = start; position < end; position++) {
+			const int ch = text[position];
+			int transition = transitions[state * transitionsPerState + ch];
+			if (transition < 0)
+				transition = Compute(state, ch);
+			if (transition & 1)
+				return position;
+			state = transition >> 1;
+		}
+		const int ch = (end < length) ? text[end] : endOfText;
+		int transition = transitions[state * transitionsPerState + ch];
+		if (transition < 0)
+			transition = Compute(state, ch);
+		return (transition & 1) ? end : -1;
+	}
+
+private:
+	enum { contextLineStart = 1, contextWord = 2 };
+	struct State {
+		std::vector<int> instructions;
+		int context;
+	};
+	const RegexProgram &program;
+	const bool *wordByte;
+	std::vector<State> states;
+	std::vector<int> transitions;
+	std::map<std::vector<int>, int> stateIndex;
+	int initial[4];
+	std::vector<int> visited;
+	int generation;
+	int resets;
+	std::vector<int> stack;
+
+	void Reset() {
+		states.clear();
+		transitions.clear();
+		stateIndex.clear();
+		for (int i = 0; i < 4; i++)
+			initial[i] = -1;
+	}
+
+	int StateFor(const std::vector<int> &instructions, int context) {
+		std::vector<int> key(instructions);
+		key.push_back(context);
+		std::map<std::vector<int>, int>::const_iterator it = stateIndex.find(key);
+		if (it != stateIndex.end())
+			return it->second;
+		if (states.size() >= maxStates) {
+			// Discard the cache which is rebuilt as needed so memory stays bounded
+			Reset();
+			resets++;
+		}
+		State state;
+		state.instructions = instructions;
+		state.context = context;
+		states.push_back(state);
+		transitions.resize(states.size() * transitionsPerState, -1);
+		const int index = static_cast<int>(states.size()) - 1;
+		stateIndex[key] = index;
+		return index;
+	}
+
+	// Follow the instructions of state with the empty string then step over ch,
+	// returning the next state shifted left with the low bit set when a match ends here.
+	int Compute(int state, int ch) {
+		const int context = states[state].context;
+		const bool wordAfter = (ch != endOfText) && wordByte[ch];
+		const PositionContext around((context & contextLineStart) != 0, ch == endOfText,
+			(context & contextWord) != 0, wordAfter);
+		generation++;
+		stack = states[state].instructions;
+		// Unanchored so a match may start at any position
+		stack.push_back(0);
+		bool matched = false;
+		std::vector<int> next;
+		while (!stack.empty()) {
+			const int pc = stack.back();
+			stack.pop_back();
+			if (visited[pc] == generation)
+				continue;
+			visited[pc] = generation;
+			const Instruction &ins = program.code[pc];
+			switch (ins.op) {
+			case opRange:
+			case opSet:
+				if (program.Accepts(ins, ch))
+					next.push_back(pc + 1);
+				break;
+			case opSplit:
+				stack.push_back(ins.y);
+				stack.push_back(ins.x);
+				break;
+			case opJmp:
+				stack.push_back(ins.x);
+				break;
+			case opSave:
+				stack.push_back(pc + 1);
+				break;
+			case opAssert:
+				if (around.Holds(ins.x))
+					stack.push_back(pc + 1);
+				break;
+			case opMatch:
+				matched = true;
+				break;
+			}
+		}
+		std::sort(next.begin(), next.end());
+		next.erase(std::unique(next.begin(), next.end()), next.end());
+		const int resetsBefore = resets;
+		const int target = StateFor(next, wordAfter ? contextWord : 0);
+		const int transition = (target << 1) | (matched ? 1 : 0);
+		// When the cache was discarded the source state no longer exists
+		if (resets == resetsBefore)
+			transitions[state * transitionsPerState + ch] = transition;
+		return transition;
+	}
+};
+
+/// Thread lists for the Pike VM. Each list is a sparse set of instructions in
+/// priority order with the group positions of each thread.
+class RegexThreads {
+public:
+	struct List {
+		std::vector<int> sparse;
+		std::vector<int> dense;
+		std::vector<int> slots;
+		int count;
+		List() : count(0) {
+		}
+		bool Contains(int pc) const {
+			const int index = sparse[pc];
+			return (index < count) && (dense[index] == pc);
+		}
+		int Insert(int pc) {
+			sparse[pc] = count;
+			dense[count] = pc;
+			return count++;
+		}
+	};
+	struct Entry {
+		int pc;
+		int slot;	// when not -1, restore this slot to value
+		int value;
+		Entry(int pc_, int slot_, int value_) : pc(pc_), slot(slot_), value(value_) {
+		}
+	};
+	List lists[2];
+	std::vector<int> work;
+	std::vector<int> matched;
+	std::vector<Entry> stack;
+
+	/// Add a thread at pc and all the threads reachable from it without consuming
+	/// a byte, in priority order, with the group positions from work.
+	void Add(List &list, const RegexProgram &program, int pc, int position, const PositionContext &around) {
+		const int slots = program.slots;
+		stack.push_back(Entry(pc, -1, 0));
+		while (!stack.empty()) {
+			const Entry entry = stack.back();
+			stack.pop_back();
+			if (entry.slot >= 0) {
+				work[entry.slot] = entry.value;
+				continue;
+			}
+			pc = entry.pc;
+			while (!list.Contains(pc)) {
+				const int index = list.Insert(pc);
+				const Instruction &ins = program.code[pc];
+				if (ins.op == opJmp) {
+					pc = ins.x;
+				} else if (ins.op == opSplit) {
+					stack.push_back(Entry(ins.y, -1, 0));
+					pc = ins.x;
+				} else if (ins.op == opSave) {
+					stack.push_back(Entry(0, ins.x, work[ins.x]));
+					work[ins.x] = position;
+					pc++;
+				} else if (ins.op == opAssert) {
+					if (!around.Holds(ins.x))
+						break;
+					pc++;
+				} else {
+					std::copy(work.begin(), work.end(), list.slots.begin() + index * slots);
+					break;
+				}
+			}
+		}
+	}
+
+	void Allocate(size_t instructions, int slots) {
+		for (int l = 0; l < 2; l++) {
+			lists[l].sparse.assign(instructions, 0);
+			lists[l].dense.assign(instructions, 0);
+			lists[l].slots.assign(instructions * slots, -1);
+			lists[l].count = 0;
+		}
+		work.assign(slots, -1);
+		matched.assign(slots, -1);
+	}
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+LinearRegex::LinearRegex() : encoding(encSingleByte), program(0), automaton(0), threads(0) {
+	for (int b = 0; b < 256; b++) {
+		leadByte[b] = false;
+		foldByte[b] = static_cast<char>(((b >= 'A') && (b <= 'Z')) ? (b - 'A' + 'a') : b);
+		wordByte[b] = ((b >= '0') && (b <= '9')) || ((b >= 'A') && (b <= 'Z')) ||
+			((b >= 'a') && (b <= 'z')) || (b == '_') || (b >= 0x80);
+	}
+	for (int g = 0; g < maxGroups; g++) {
+		groupStart[g] = -1;
+		groupEnd[g] = -1;
+	}
+}
+
+LinearRegex::~LinearRegex() {
+	Clear();
+}
+
+void LinearRegex::Clear() {
+	delete automaton;
+	automaton = 0;
+	delete program;
+	program = 0;
+	delete threads;
+	threads = 0;
+}
+
+void LinearRegex::SetEncoding(Encoding encoding_, const char *leadBytes, const char *fold, const char *wordBytes) {
+	Clear();
+	encoding = encoding_;
+	for (int b = 0; b < 256; b++) {
+		leadByte[b] = (encoding == encDBCS) && leadBytes && leadBytes[b];
+		if (fold)
+			foldByte[b] = fold[b];
+		else
+			foldByte[b] = static_cast<char>(((b >= 'A') && (b <= 'Z')) ? (b - 'A' + 'a') : b);
+		wordByte[b] = wordBytes[b] != 0;
+	}
+}
+
+const char *LinearRegex::Compile(const char *pattern, int length, bool caseSensitive, bool posix) {
+	Clear();
+	RegexEnvironment env;
+	env.encoding = encoding;
+	env.leadByte = leadByte;
+	env.foldByte = foldByte;
+	env.wordByte = wordByte;
+	RegexParser parser(env, pattern, length, caseSensitive, posix);
+	Node *root = parser.Parse();
+	if (!root)
+		return parser.error;
+	program = new RegexProgram();
+	RegexCompiler compiler(env, *program);
+	compiler.Compile(root, parser.groups);
+	if (program->Overflowed()) {
+		Clear();
+		return "Regular expression too large";
+	}
+	automaton = new RegexAutomaton(*program, wordByte);
+	threads = new RegexThreads();
+	threads->Allocate(program->code.size(), program->slots);
+	return 0;
+}
+
+bool LinearRegex::Search(const char *text, int length, int start, int end) {
+	for (int g = 0; g < maxGroups; g++) {
+		groupStart[g] = -1;
+		groupEnd[g] = -1;
+	}
+	if (!program || (start < 0) || (start > end) || (end > length))
+		return false;
+	const int earliestEnd = automaton->EarliestEnd(reinterpret_cast<const unsigned char *>(text),
+		length, start, end);
+	if (earliestEnd < 0)
+		return false;
+	// The leftmost match can not start after the end of the earliest match
+	return PikeSearch(text, length, start, end, earliestEnd) >= 0;
+}
+
+int LinearRegex::PikeSearch(const char *text, int length, int start, int end, int startLimit) {
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(text);
+	const int slots = program->slots;
+	RegexThreads::List *current = &threads->lists[0];
+	RegexThreads::List *next = &threads->lists[1];
+	current->count = 0;
+	bool matched = false;
+	for (int position = start; ; position++) {
+		const PositionContext around(position == 0, position == length,
+			(position > 0) && wordByte[us[position - 1]], (position < length) && wordByte[us[position]]);
+		if (!matched && (position <= startLimit)) {
+			// Add a thread starting here with a lower priority than all existing threads
+			std::fill(threads->work.begin(), threads->work.end(), -1);
+			threads->Add(*current, *program, 0, position, around);
+		}
+		if (current->count == 0) {
+			if (matched || (position >= startLimit))
+				break;
+			continue;
+		}
+		const int ch = (position < end) ? us[position] : -1;
+		const PositionContext aroundNext(false, position + 1 == length,
+			around.wordAfter, (position + 1 < length) && wordByte[us[position + 1]]);
+		next->count = 0;
+		for (int t = 0; t < current->count; t++) {
+			const Instruction &ins = program->code[current->dense[t]];
+			std::vector<int>::const_iterator slotsThread = current->slots.begin() + t * slots;
+			if (ins.op == opMatch) {
+				matched = true;
+				std::copy(slotsThread, slotsThread + slots, threads->matched.begin());
+				// Threads of lower priority can not produce the leftmost-first match
+				break;
+			}
+			if (((ins.op == opRange) || (ins.op == opSet)) && (ch >= 0) && program->Accepts(ins, ch)) {
+				std::copy(slotsThread, slotsThread + slots, threads->work.begin());
+				threads->Add(*next, *program, current->dense[t] + 1, position + 1, aroundNext);
+			}
+		}
+		std::swap(current, next);
+		if (position >= end)
+			break;
+	}
+	if (!matched)
+		return -1;
+	for (int g = 0; (g < maxGroups) && (g * 2 + 1 < slots); g++) {
+		if ((threads->matched[g * 2] >= 0) && (threads->matched[g * 2 + 1] >= 0)) {
+			groupStart[g] = threads->matched[g * 2];
+			groupEnd[g] = threads->matched[g * 2 + 1];
+		}
+	}
+	return groupStart[0];
+}
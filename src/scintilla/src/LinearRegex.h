@@ -0,0 +1,69 @@
+// Scintilla source code edit control
+/** @file LinearRegex.h
+ ** Interface to the linear time regular expression engine.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LINEARREGEX_H
+#define LINEARREGEX_H
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+class RegexProgram;
+class RegexAutomaton;
+class RegexThreads;
+
+/**
+ * Regular expression engine that compiles patterns into an automaton over bytes.
+ * A lazily built DFA finds whether and where a match can end, then a Pike VM
+ * finds the leftmost-first match and its groups. Both take time proportional
+ * to the product of the text and pattern lengths so no pattern can hang.
+ * Back references are not supported as they can not be matched in linear time.
+ */
+class LinearRegex {
+public:
+	enum Encoding { encSingleByte, encUTF8, encDBCS };
+	enum { maxGroups = 10 };
+
+	LinearRegex();
+	~LinearRegex();
+
+	/// Describe the text to be searched. Each table has 256 entries indexed by byte.
+	/// leadBytes is only used for encDBCS and fold may be null for ASCII folding.
+	void SetEncoding(Encoding encoding_, const char *leadBytes, const char *fold, const char *wordBytes);
+
+	/// Returns a short error string or null if the pattern compiled.
+	const char *Compile(const char *pattern, int length, bool caseSensitive, bool posix);
+
+	/// Find the first match starting and ending within [start, end] of text which
+	/// is a complete line so ^ and $ only match at 0 and length.
+	bool Search(const char *text, int length, int start, int end);
+
+	int groupStart[maxGroups];
+	int groupEnd[maxGroups];
+
+private:
+	Encoding encoding;
+	bool leadByte[256];
+	char foldByte[256];
+	bool wordByte[256];
+	RegexProgram *program;
+	RegexAutomaton *automaton;
+	RegexThreads *threads;
+
+	void Clear();
+	int PikeSearch(const char *text, int length, int start, int end, int startLimit);
+
+	// Private so LinearRegex objects can not be copied
+	LinearRegex(const LinearRegex &);
+	LinearRegex &operator=(const LinearRegex &);
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+#endif
@@ -8,35 +8,53 @@
 #ifndef PARTITIONING_H
 #define PARTITIONING_H
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define PARTITIONING_SSE2
+#endif
+
 /// A split vector of integers with a method for adding a value to all elements
 /// in a range.
 /// Used by the Partitioning class.
 
-class SplitVectorWithRangeAdd : public SplitVector<int> {
+class SplitVectorWithRangeAdd : public SplitVector<Sci_Position> {
+	/// Add delta to each of length values, 16 bytes at a time when SSE2 is available.
+	static void AddToRange(Sci_Position *values, Sci_Position length, Sci_Position delta) {
+		Sci_Position i = 0;
+#ifdef PARTITIONING_SSE2
+		const int lanes = 16 / sizeof(Sci_Position);
+		Sci_Position deltas[lanes];
+		for (int lane = 0; lane < lanes; lane++)
+			deltas[lane] = delta;
+		const __m128i vDelta = _mm_loadu_si128(reinterpret_cast<const __m128i *>(deltas));
+		for (; i + lanes <= length; i += lanes) {
+			__m128i *pv = reinterpret_cast<__m128i *>(values + i);
+			const __m128i v = _mm_loadu_si128(pv);
+			_mm_storeu_si128(pv, (sizeof(Sci_Position) == 4) ?
+				_mm_add_epi32(v, vDelta) : _mm_add_epi64(v, vDelta));
+		}
+#endif
+		for (; i < length; i++)
+			values[i] += delta;
+	}
 public:
-	SplitVectorWithRangeAdd(int growSize_) {
+	SplitVectorWithRangeAdd(Sci_Position growSize_) {
 		SetGrowSize(growSize_);
 		ReAllocate(growSize_);
 	}
 	~SplitVectorWithRangeAdd() {
 	}
-	void RangeAddDelta(int start, int end, int delta) {
+	void RangeAddDelta(Sci_Position start, Sci_Position end, Sci_Position delta) {
 		// end is 1 past end, so end-start is number of elements to change
-		int i = 0;
-		int rangeLength = end - start;
-		int range1Length = rangeLength;
-		int part1Left = part1Length - start;
+		Sci_Position rangeLength = end - start;
+		Sci_Position range1Length = rangeLength;
+		Sci_Position part1Left = part1Length - start;
 		if (range1Length > part1Left)
 			range1Length = part1Left;
-		while (i < range1Length) {
-			body[start++] += delta;
-			i++;
-		}
-		start += gapLength;
-		while (i < rangeLength) {
-			body[start++] += delta;
-			i++;
-		}
+		if (range1Length < 0)
+			range1Length = 0;
+		AddToRange(body + start, range1Length, delta);
+		AddToRange(body + start + range1Length + gapLength, rangeLength - range1Length, delta);
 	}
 };
 
@@ -52,7 +70,7 @@ private:
 	// To avoid calculating all the partition positions whenever any text is inserted
 	// there may be a step somewhere in the list.
 	int stepPartition;
-	int stepLength;
+	Sci_Position stepLength;
 	SplitVectorWithRangeAdd *body;
 
 	// Move step forward
@@ -62,7 +80,7 @@ private:
 		}
 		stepPartition = partitionUpTo;
 		if (stepPartition >= body->Length()-1) {
-			stepPartition = body->Length()-1;
+			stepPartition = static_cast<int>(body->Length()-1);
 			stepLength = 0;
 		}
 	}
@@ -75,7 +93,7 @@ private:
 		stepPartition = partitionDownTo;
 	}
 
-	void Allocate(int growSize) {
+	void Allocate(Sci_Position growSize) {
 		body = new SplitVectorWithRangeAdd(growSize);
 		stepPartition = 0;
 		stepLength = 0;
@@ -94,10 +112,10 @@ public:
 	}
 
 	int Partitions() const {
-		return body->Length()-1;
+		return static_cast<int>(body->Length()-1);
 	}
 
-	void InsertPartition(int partition, int pos) {
+	void InsertPartition(int partition, Sci_Position pos) {
 		if (stepPartition < partition) {
 			ApplyStep(partition);
 		}
@@ -105,7 +123,7 @@ public:
 		stepPartition++;
 	}
 
-	void SetPartitionStartPosition(int partition, int pos) {
+	void SetPartitionStartPosition(int partition, Sci_Position pos) {
 		ApplyStep(partition+1);
 		if ((partition < 0) || (partition > body->Length())) {
 			return;
@@ -113,7 +131,7 @@ public:
 		body->SetValueAt(partition, pos);
 	}
 
-	void InsertText(int partitionInsert, int delta) {
+	void InsertText(int partitionInsert, Sci_Position delta) {
 		// Point all the partitions after the insertion point further along in the buffer
 		if (stepLength != 0) {
 			if (partitionInsert >= stepPartition) {
@@ -125,7 +143,7 @@ public:
 				BackStep(partitionInsert);
 				stepLength += delta;
 			} else {
-				ApplyStep(body->Length()-1);
+				ApplyStep(static_cast<int>(body->Length()-1));
 				stepPartition = partitionInsert;
 				stepLength = delta;
 			}
@@ -145,29 +163,29 @@ public:
 		body->Delete(partition);
 	}
 
-	int PositionFromPartition(int partition) const {
+	Sci_Position PositionFromPartition(int partition) const {
 		PLATFORM_ASSERT(partition >= 0);
 		PLATFORM_ASSERT(partition < body->Length());
 		if ((partition < 0) || (partition >= body->Length())) {
 			return 0;
 		}
-		int pos = body->ValueAt(partition);
+		Sci_Position pos = body->ValueAt(partition);
 		if (partition > stepPartition)
 			pos += stepLength;
 		return pos;
 	}
 
 	/// Return value in range [0 .. Partitions() - 1] even for arguments outside interval
-	int PartitionFromPosition(int pos) const {
+	int PartitionFromPosition(Sci_Position pos) const {
 		if (body->Length() <= 1)
 			return 0;
 		if (pos >= (PositionFromPartition(body->Length()-1)))
-			return body->Length() - 1 - 1;
+			return static_cast<int>(body->Length() - 1 - 1);
 		int lower = 0;
-		int upper = body->Length()-1;
+		int upper = static_cast<int>(body->Length()-1);
 		do {
 			int middle = (upper + lower + 1) / 2; 	// Round high
-			int posMiddle = body->ValueAt(middle);
+			Sci_Position posMiddle = body->ValueAt(middle);
 			if (middle > stepPartition)
 				posMiddle += stepLength;
 			if (pos < posMiddle) {
@@ -180,10 +198,248 @@ public:
 	}
 
 	void DeleteAll() {
-		int growSize = body->GetGrowSize();
+		Sci_Position growSize = body->GetGrowSize();
 		delete body;
 		Allocate(growSize);
 	}
 };
 
+/// Partitioning with the same interface that holds the partition starts in blocks of
+/// around blockSize partitions. Starts are relative to the start of their block and the
+/// starts of the blocks are held in a Partitioning so inserting text changes the rest of
+/// one block and moves the step over blocks rather than over every partition.
+/// The number of the first partition in each block is held in another Partitioning.
+
+class BlockPartitioning {
+	typedef SplitVectorWithRangeAdd Block;
+
+	SplitVector<Block *> blocks;
+	Partitioning blockPositions;
+	Partitioning blockPartitions;
+	Sci_Position growSize;
+	int blockSize;
+	/// Most recently used block, so that sequential access does not search.
+	mutable int blockCurrent;
+
+	// Private so BlockPartitioning objects can not be copied
+	BlockPartitioning(const BlockPartitioning &);
+
+	void Init() {
+		Block *pb = new Block(growSize);
+		pb->Insert(0, 0);
+		blocks.Insert(0, pb);
+		// The first block holds the first partition
+		blockPartitions.InsertText(0, 1);
+		blockCurrent = 0;
+	}
+
+	void Free() {
+		for (Sci_Position b = 0; b < blocks.Length(); b++) {
+			delete blocks.ValueAt(b);
+		}
+		blocks.DeleteAll();
+		blockPositions.DeleteAll();
+		blockPartitions.DeleteAll();
+	}
+
+	int Blocks() const {
+		return blockPartitions.Partitions();
+	}
+
+	Block *BlockAt(int block) const {
+		return blocks.ValueAt(block);
+	}
+
+	Sci_Position BlockPosition(int block) const {
+		return blockPositions.PositionFromPartition(block);
+	}
+
+	int BlockFirstPartition(int block) const {
+		return static_cast<int>(blockPartitions.PositionFromPartition(block));
+	}
+
+	/// Block containing partition, which must be less than Partitions().
+	int BlockFromPartition(int partition) const {
+		if ((blockCurrent < Blocks()) &&
+			(BlockFirstPartition(blockCurrent) <= partition) &&
+			(partition < BlockFirstPartition(blockCurrent + 1))) {
+			return blockCurrent;
+		}
+		blockCurrent = blockPartitions.PartitionFromPosition(partition);
+		return blockCurrent;
+	}
+
+	/// Move the start of a block by delta without moving its other partitions.
+	void MoveBlockStart(int block, Sci_Position delta) {
+		// Partitioning::SetPartitionStartPosition expects the step to be before the
+		// partition so move the start with two insertions that both respect the step.
+		blockPositions.InsertText(block - 1, delta);
+		blockPositions.InsertText(block, -delta);
+		Block *pb = BlockAt(block);
+		pb->RangeAddDelta(1, pb->Length(), -delta);
+	}
+
+	/// Move the back half of an oversized block into a new block.
+	void SplitBlock(int block) {
+		Block *pb = BlockAt(block);
+		const Sci_Position lengthBlock = pb->Length();
+		const Sci_Position half = lengthBlock / 2;
+		const Sci_Position offset = pb->ValueAt(half);
+		Block *pbBack = new Block(growSize);
+		pbBack->ReAllocate(lengthBlock - half + growSize);
+		for (Sci_Position i = half; i < lengthBlock; i++) {
+			pbBack->Insert(i - half, pb->ValueAt(i) - offset);
+		}
+		pb->DeleteRange(half, lengthBlock - half);
+		blocks.Insert(block + 1, pbBack);
+		blockPositions.InsertPartition(block + 1, BlockPosition(block) + offset);
+		blockPartitions.InsertPartition(block + 1, BlockFirstPartition(block) + static_cast<int>(half));
+	}
+
+	/// Append the starts of the following block to block and remove the following block.
+	void MergeWithNext(int block) {
+		Block *pb = BlockAt(block);
+		Block *pbNext = BlockAt(block + 1);
+		const Sci_Position offset = BlockPosition(block + 1) - BlockPosition(block);
+		for (Sci_Position i = 0; i < pbNext->Length(); i++) {
+			pb->Insert(pb->Length(), pbNext->ValueAt(i) + offset);
+		}
+		delete pbNext;
+		blocks.Delete(block + 1);
+		blockPositions.RemovePartition(block + 1);
+		blockPartitions.RemovePartition(block + 1);
+		blockCurrent = block;
+	}
+
+	/// After a removal, merge a block that has become small with the following block.
+	void MergeIfSmall(int block) {
+		if ((block < 0) || (block + 1 >= Blocks()))
+			return;
+		const Sci_Position lengthBlock = BlockAt(block)->Length();
+		const Sci_Position lengthNext = BlockAt(block + 1)->Length();
+		if (((lengthBlock < blockSize / 2) || (lengthNext < blockSize / 2)) &&
+			(lengthBlock + lengthNext <= blockSize)) {
+			MergeWithNext(block);
+		}
+	}
+
+public:
+	explicit BlockPartitioning(int growSize_, int blockSize_=256) :
+		blockPositions(growSize_), blockPartitions(growSize_),
+		growSize(growSize_), blockSize(blockSize_) {
+		Init();
+	}
+
+	~BlockPartitioning() {
+		Free();
+	}
+
+	int Partitions() const {
+		return BlockFirstPartition(Blocks());
+	}
+
+	void InsertPartition(int partition, Sci_Position pos) {
+		PLATFORM_ASSERT((partition > 0) && (partition <= Partitions()));
+		if ((partition <= 0) || (partition > Partitions())) {
+			return;
+		}
+		// The new partition follows partition - 1 in its block
+		const int block = BlockFromPartition(partition - 1);
+		Block *pb = BlockAt(block);
+		pb->Insert(partition - BlockFirstPartition(block), pos - BlockPosition(block));
+		blockPartitions.InsertText(block, 1);
+		if (pb->Length() > 2 * blockSize) {
+			SplitBlock(block);
+		}
+	}
+
+	void SetPartitionStartPosition(int partition, Sci_Position pos) {
+		if ((partition < 0) || (partition >= Partitions())) {
+			return;
+		}
+		const int block = BlockFromPartition(partition);
+		Block *pb = BlockAt(block);
+		const Sci_Position index = partition - BlockFirstPartition(block);
+		if ((index == 0) && (block > 0)) {
+			// Moving the start of a block so keep the other starts in place
+			MoveBlockStart(block, pos - BlockPosition(block));
+		} else {
+			pb->SetValueAt(index, pos - BlockPosition(block));
+		}
+	}
+
+	void InsertText(int partitionInsert, Sci_Position delta) {
+		// Point all the partitions after the insertion point further along in the buffer
+		const int block = BlockFromPartition(partitionInsert);
+		Block *pb = BlockAt(block);
+		pb->RangeAddDelta(partitionInsert - BlockFirstPartition(block) + 1, pb->Length(), delta);
+		blockPositions.InsertText(block, delta);
+	}
+
+	void RemovePartition(int partition) {
+		PLATFORM_ASSERT((partition > 0) && (partition < Partitions()));
+		if ((partition <= 0) || (partition >= Partitions())) {
+			return;
+		}
+		const int block = BlockFromPartition(partition);
+		Block *pb = BlockAt(block);
+		const Sci_Position index = partition - BlockFirstPartition(block);
+		if (index > 0) {
+			pb->Delete(index);
+			blockPartitions.InsertText(block, -1);
+		} else if (pb->Length() > 1) {
+			// The following partition becomes the start of the block
+			MoveBlockStart(block, pb->ValueAt(1));
+			pb->Delete(0);
+			blockPartitions.InsertText(block, -1);
+		} else {
+			// Only partition in the block so remove the block
+			delete pb;
+			blocks.Delete(block);
+			blockPositions.RemovePartition(block);
+			blockPartitions.RemovePartition(block);
+			blockPartitions.InsertText(block - 1, -1);
+		}
+		blockCurrent = 0;
+		MergeIfSmall(block);
+		MergeIfSmall(block - 1);
+	}
+
+	Sci_Position PositionFromPartition(int partition) const {
+		PLATFORM_ASSERT(partition >= 0);
+		PLATFORM_ASSERT(partition <= Partitions());
+		if ((partition < 0) || (partition > Partitions())) {
+			return 0;
+		}
+		if (partition == Partitions()) {
+			return BlockPosition(Blocks());
+		}
+		const int block = BlockFromPartition(partition);
+		return BlockPosition(block) + BlockAt(block)->ValueAt(partition - BlockFirstPartition(block));
+	}
+
+	/// Return value in range [0 .. Partitions() - 1] even for arguments outside interval
+	int PartitionFromPosition(Sci_Position pos) const {
+		const int block = blockPositions.PartitionFromPosition(pos);
+		const Block *pb = BlockAt(block);
+		const Sci_Position posInBlock = pos - BlockPosition(block);
+		int lower = 0;
+		int upper = static_cast<int>(pb->Length() - 1);
+		while (lower < upper) {
+			int middle = (upper + lower + 1) / 2; 	// Round high
+			if (posInBlock < pb->ValueAt(middle)) {
+				upper = middle - 1;
+			} else {
+				lower = middle;
+			}
+		}
+		return BlockFirstPartition(block) + lower;
+	}
+
+	void DeleteAll() {
+		Free();
+		Init();
+	}
+};
+
 #endif
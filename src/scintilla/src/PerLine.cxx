@@ -12,6 +12,7 @@
 #include "Scintilla.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "CellBuffer.h"
 #include "PerLine.h"
 
@@ -501,3 +502,65 @@ int LineAnnotation::Lines(int line) const {
 	else
 		return 0;
 }
+
+LineCheckpoints::~LineCheckpoints() {
+	ClearAll();
+}
+
+void LineCheckpoints::Init() {
+	ClearAll();
+}
+
+void LineCheckpoints::InsertLine(int line) {
+	if (checkpoints.Length()) {
+		checkpoints.EnsureLength(line);
+		checkpoints.Insert(line, 0);
+	}
+}
+
+void LineCheckpoints::RemoveLine(int line) {
+	if (checkpoints.Length() && (line < checkpoints.Length())) {
+		delete []checkpoints[line];
+		checkpoints.Delete(line);
+	}
+}
+
+void LineCheckpoints::ClearAll() {
+	for (int line = 0; line < checkpoints.Length(); line++) {
+		delete []checkpoints[line];
+		checkpoints[line] = 0;
+	}
+	checkpoints.DeleteAll();
+}
+
+void LineCheckpoints::ClearRange(int lineFirst, int lineLast) {
+	if (lineLast >= checkpoints.Length())
+		lineLast = checkpoints.Length() - 1;
+	for (int line = (lineFirst < 0) ? 0 : lineFirst; line <= lineLast; line++) {
+		delete []checkpoints[line];
+		checkpoints[line] = 0;
+	}
+}
+
+void LineCheckpoints::Set(int line, const char *state, int length) {
+	if (line < 0)
+		return;
+	checkpoints.EnsureLength(line + 1);
+	char *checkpoint = checkpoints[line];
+	if (!checkpoint || (*reinterpret_cast<int *>(checkpoint) != length)) {
+		delete []checkpoint;
+		checkpoint = new char[sizeof(int) + length];
+		*reinterpret_cast<int *>(checkpoint) = length;
+		checkpoints[line] = checkpoint;
+	}
+	memcpy(checkpoint + sizeof(int), state, length);
+}
+
+int LineCheckpoints::Get(int line, char *state, int length) const {
+	if ((line < 0) || (line >= checkpoints.Length()) || !checkpoints[line])
+		return -1;
+	const char *checkpoint = checkpoints[line];
+	const int lengthState = *reinterpret_cast<const int *>(checkpoint);
+	memcpy(state, checkpoint + sizeof(int), (lengthState < length) ? lengthState : length);
+	return lengthState;
+}
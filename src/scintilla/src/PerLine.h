@@ -114,6 +114,25 @@ public:
 	int Lines(int line) const;
 };
 
+/// Lexer state saved at the start of some lines so lexing can stop where it matches again.
+/// Each is a length followed by that many bytes and moves with its line.
+class LineCheckpoints : public PerLine {
+	SplitVector<char *> checkpoints;
+public:
+	LineCheckpoints() {
+	}
+	virtual ~LineCheckpoints();
+	virtual void Init();
+	virtual void InsertLine(int line);
+	virtual void RemoveLine(int line);
+
+	void ClearAll();
+	void ClearRange(int lineFirst, int lineLast);
+	void Set(int line, const char *state, int length);
+	/// Copy up to length bytes of the state of line, returning its full length or -1 if there is none.
+	int Get(int line, char *state, int length) const;
+};
+
 #ifdef SCI_NAMESPACE
 }
 #endif
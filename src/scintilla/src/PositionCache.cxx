@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "Platform.h"
 
@@ -20,6 +21,7 @@
 
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "RunStyles.h"
 #include "ContractionState.h"
 #include "CellBuffer.h"
@@ -498,16 +500,140 @@ int BreakFinder::Next() {
 	}
 }
 
+LineImageCache::LineImageCache() : clock(0), stampClock(0) {
+}
+
+LineImageCache::~LineImageCache() {
+	Release();
+}
+
+void LineImageCache::Release() {
+	for (size_t i=0; i<images.size(); i++) {
+		delete images[i].surface;
+		images[i].surface = 0;
+		images[i].key.clear();
+		images[i].lastUsed = 0;
+	}
+	clock = 0;
+}
+
+void LineImageCache::Invalidate() {
+	for (size_t i=0; i<images.size(); i++) {
+		images[i].key.clear();
+		images[i].lastUsed = 0;
+	}
+	clock = 0;
+}
+
+void LineImageCache::SetSize(int size_, int lines) {
+	Release();
+	images.resize(size_);
+	ResetLines(lines);
+}
+
+Surface *LineImageCache::Find(const std::string &key) {
+	for (size_t i=0; i<images.size(); i++) {
+		if (images[i].surface && (images[i].key == key) && images[i].surface->Initialised()) {
+			images[i].lastUsed = ++clock;
+			return images[i].surface;
+		}
+	}
+	return 0;
+}
+
+Surface *LineImageCache::Allocate(const std::string &key, int technology) {
+	if (images.empty())
+		return 0;
+	if (clock > 0x40000000) {
+		// Restart the clock before it overflows, losing the order of use
+		Invalidate();
+	}
+	// Reuse the least recently used image
+	size_t oldest = 0;
+	for (size_t i=1; i<images.size(); i++) {
+		if (images[i].lastUsed < images[oldest].lastUsed)
+			oldest = i;
+	}
+	LineImage &image = images[oldest];
+	if (!image.surface)
+		image.surface = Surface::Allocate(technology);
+	if (!image.surface)
+		return 0;
+	image.key = key;
+	image.lastUsed = ++clock;
+	return image.surface;
+}
+
+// Stamps are only kept while there are images to match
+void LineImageCache::ResetLines(int lines) {
+	Invalidate();
+	lineStamps.DeleteAll();
+	stampClock = 0;
+	if (!images.empty()) {
+		lineStamps.InsertValue(0, lines, 0);
+		for (int line = 0; line < lines; line++)
+			lineStamps.SetValueAt(line, ++stampClock);
+	}
+}
+
+void LineImageCache::InsertLines(int line, int lines) {
+	if (lineStamps.Length() > 0) {
+		lineStamps.InsertValue(line, lines, 0);
+		LinesChanged(line, line + lines - 1);
+	}
+}
+
+void LineImageCache::DeleteLines(int line, int lines) {
+	if (lineStamps.Length() > 0)
+		lineStamps.DeleteRange(line, lines);
+}
+
+void LineImageCache::LinesChanged(int lineFirst, int lineLast) {
+	if (lineStamps.Length() > 0) {
+		if (stampClock > 0x40000000) {
+			// Number the lines again before the clock overflows, losing the images
+			ResetLines(static_cast<int>(lineStamps.Length()));
+			return;
+		}
+		lineLast = Platform::Minimum(lineLast, static_cast<int>(lineStamps.Length()) - 1);
+		for (int line = lineFirst; line <= lineLast; line++)
+			lineStamps.SetValueAt(line, ++stampClock);
+	}
+}
+
+int LineImageCache::LineStamp(int line) const {
+	if ((line >= 0) && (line < lineStamps.Length()))
+		return lineStamps.ValueAt(line);
+	return 0;
+}
+
+PositionCacheFont::PositionCacheFont(const Style &style, int technology_, int codePage_) :
+	fontName(style.fontName ? style.fontName : ""), weight(style.weight), italic(style.italic),
+	sizeZoomed(style.sizeZoomed), characterSet(style.characterSet),
+	extraFontFlag(style.extraFontFlag), technology(technology_), codePage(codePage_) {
+}
+
+bool PositionCacheFont::Matches(const Style &style, int technology_, int codePage_) const {
+	return (codePage == codePage_) &&
+		(weight == style.weight) &&
+		(italic == style.italic) &&
+		(sizeZoomed == style.sizeZoomed) &&
+		(characterSet == style.characterSet) &&
+		(extraFontFlag == style.extraFontFlag) &&
+		(technology == technology_) &&
+		(fontName == (style.fontName ? style.fontName : ""));
+}
+
 PositionCacheEntry::PositionCacheEntry() :
-	styleNumber(0), len(0), clock(0), positions(0) {
+	hash(0), font(-1), len(0), positions(0) {
 }
 
-void PositionCacheEntry::Set(unsigned int styleNumber_, const char *s_,
-	unsigned int len_, XYPOSITION *positions_, unsigned int clock_) {
+void PositionCacheEntry::Set(unsigned int hash_, int font_, const char *s_,
+	unsigned int len_, XYPOSITION *positions_) {
 	Clear();
-	styleNumber = styleNumber_;
+	hash = hash_;
+	font = font_;
 	len = len_;
-	clock = clock_;
 	if (s_ && positions_) {
 		positions = new XYPOSITION[len + (len + 1) / 2];
 		for (unsigned int i=0; i<len; i++) {
@@ -524,14 +650,14 @@ PositionCacheEntry::~PositionCacheEntry() {
 void PositionCacheEntry::Clear() {
 	delete []positions;
 	positions = 0;
-	styleNumber = 0;
+	hash = 0;
+	font = -1;
 	len = 0;
-	clock = 0;
 }
 
-bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, const char *s_,
+bool PositionCacheEntry::Retrieve(unsigned int hash_, int font_, const char *s_,
 	unsigned int len_, XYPOSITION *positions_) const {
-	if ((styleNumber == styleNumber_) && (len == len_) &&
+	if ((hash == hash_) && (font == font_) && (len == len_) &&
 		(memcmp(reinterpret_cast<char *>(positions + len), s_, len)== 0)) {
 		for (unsigned int i=0; i<len; i++) {
 			positions_[i] = positions[i];
@@ -542,7 +668,7 @@ bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, const char *s_,
 	}
 }
 
-int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s, unsigned int len_) {
+unsigned int PositionCacheEntry::Hash(int font_, const char *s, unsigned int len_) {
 	unsigned int ret = s[0] << 7;
 	for (unsigned int i=0; i<len_; i++) {
 		ret *= 1000003;
@@ -551,25 +677,13 @@ int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s, unsigned
 	ret *= 1000003;
 	ret ^= len_;
 	ret *= 1000003;
-	ret ^= styleNumber_;
+	ret ^= font_;
 	return ret;
 }
 
-bool PositionCacheEntry::NewerThan(const PositionCacheEntry &other) const {
-	return clock > other.clock;
-}
-
-void PositionCacheEntry::ResetClock() {
-	if (clock > 0) {
-		clock = 1;
-	}
-}
-
-PositionCache::PositionCache() {
-	size = 0x400;
-	clock = 1;
-	pces = new PositionCacheEntry[size];
-	allClear = true;
+PositionCache::PositionCache() :
+	pces(0), size(0), used(0), newest(-1), oldest(-1), fontLast(-1), hits(0), misses(0) {
+	SetSize(0x1000);
 }
 
 PositionCache::~PositionCache() {
@@ -577,14 +691,21 @@ PositionCache::~PositionCache() {
 	delete []pces;
 }
 
+PositionCache &PositionCache::Shared() {
+	static PositionCache cache;
+	return cache;
+}
+
 void PositionCache::Clear() {
-	if (!allClear) {
-		for (size_t i=0; i<size; i++) {
-			pces[i].Clear();
-		}
+	for (size_t i=0; i<used; i++) {
+		pces[i].Clear();
 	}
-	clock = 1;
-	allClear = true;
+	used = 0;
+	std::fill(buckets.begin(), buckets.end(), -1);
+	newest = -1;
+	oldest = -1;
+	fonts.clear();
+	fontLast = -1;
 }
 
 void PositionCache::SetSize(size_t size_) {
@@ -592,31 +713,103 @@ void PositionCache::SetSize(size_t size_) {
 	delete []pces;
 	size = size_;
 	pces = new PositionCacheEntry[size];
+	// Power of 2 number of buckets so the hash can be masked
+	size_t sizeBuckets = 1;
+	while (sizeBuckets < size)
+		sizeBuckets *= 2;
+	buckets.assign(sizeBuckets, -1);
+	chain.assign(size, -1);
+	newer.assign(size, -1);
+	older.assign(size, -1);
+	hits = 0;
+	misses = 0;
+}
+
+int PositionCache::FontIndex(const Style &style, int technology, int codePage) {
+	if ((fontLast >= 0) && fonts[fontLast].Matches(style, technology, codePage))
+		return fontLast;
+	for (size_t i=0; i<fonts.size(); i++) {
+		if (fonts[i].Matches(style, technology, codePage)) {
+			fontLast = static_cast<int>(i);
+			return fontLast;
+		}
+	}
+	if (fonts.size() >= 0x100) {
+		// Many fonts seen, perhaps from repeated zooming, so start again
+		Clear();
+	}
+	fonts.push_back(PositionCacheFont(style, technology, codePage));
+	fontLast = static_cast<int>(fonts.size() - 1);
+	return fontLast;
+}
+
+void PositionCache::Unlink(int entry) {
+	if (newer[entry] >= 0)
+		older[newer[entry]] = older[entry];
+	else
+		newest = older[entry];
+	if (older[entry] >= 0)
+		newer[older[entry]] = newer[entry];
+	else
+		oldest = newer[entry];
+}
+
+void PositionCache::LinkNewest(int entry) {
+	newer[entry] = -1;
+	older[entry] = newest;
+	if (newest >= 0)
+		newer[newest] = entry;
+	else
+		oldest = entry;
+	newest = entry;
+}
+
+void PositionCache::RemoveFromBucket(int entry) {
+	int *link = &buckets[pces[entry].Hash() & (buckets.size() - 1)];
+	while (*link != entry)
+		link = &chain[*link];
+	*link = chain[entry];
+}
+
+void PositionCache::Add(unsigned int hash, int font, const char *s, unsigned int len, XYPOSITION *positions) {
+	int entry;
+	if (used < size) {
+		entry = static_cast<int>(used);
+		used++;
+	} else {
+		// Full so replace the least recently used entry
+		entry = oldest;
+		Unlink(entry);
+		RemoveFromBucket(entry);
+	}
+	pces[entry].Set(hash, font, s, len, positions);
+	const size_t bucket = hash & (buckets.size() - 1);
+	chain[entry] = buckets[bucket];
+	buckets[bucket] = entry;
+	LinkNewest(entry);
 }
 
 void PositionCache::MeasureWidths(Surface *surface, ViewStyle &vstyle, unsigned int styleNumber,
 	const char *s, unsigned int len, XYPOSITION *positions, Document *pdoc) {
 
-	allClear = false;
-	int probe = -1;
-	if ((size > 0) && (len < 30)) {
-		// Only store short strings in the cache so it doesn't churn with
-		// long comments with only a single comment.
-
-		// Two way associative: try two probe positions.
-		int hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
-		probe = static_cast<int>(hashValue % size);
-		if (pces[probe].Retrieve(styleNumber, s, len, positions)) {
-			return;
-		}
-		int probe2 = static_cast<int>((hashValue * 37) % size);
-		if (pces[probe2].Retrieve(styleNumber, s, len, positions)) {
-			return;
-		}
-		// Not found. Choose the oldest of the two slots to replace
-		if (pces[probe].NewerThan(pces[probe2])) {
-			probe = probe2;
+	// Runs of any length are cached. BreakFinder divides text into runs of at most
+	// lengthStartSubdivision bytes so no entry holds a long line.
+	int font = -1;
+	unsigned int hashValue = 0;
+	if ((size > 0) && (len > 0)) {
+		font = FontIndex(vstyle.styles[styleNumber], vstyle.technology, pdoc->dbcsCodePage);
+		hashValue = PositionCacheEntry::Hash(font, s, len);
+		for (int entry = buckets[hashValue & (buckets.size() - 1)]; entry >= 0; entry = chain[entry]) {
+			if (pces[entry].Retrieve(hashValue, font, s, len, positions)) {
+				hits++;
+				if (entry != newest) {
+					Unlink(entry);
+					LinkNewest(entry);
+				}
+				return;
+			}
 		}
+		misses++;
 	}
 	if (len > BreakFinder::lengthStartSubdivision) {
 		// Break up into segments
@@ -634,16 +827,7 @@ void PositionCache::MeasureWidths(Surface *surface, ViewStyle &vstyle, unsigned
 	} else {
 		surface->MeasureWidths(vstyle.styles[styleNumber].font, s, len, positions);
 	}
-	if (probe >= 0) {
-		clock++;
-		if (clock > 60000) {
-			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
-			for (size_t i=0; i<size; i++) {
-				pces[i].ResetClock();
-			}
-			clock = 2;
-		}
-		pces[probe].Set(styleNumber, s, len, positions, clock);
+	if (font >= 0) {
+		Add(hashValue, font, s, len, positions);
 	}
 }
@@ -99,20 +99,77 @@ public:
 	void Dispose(LineLayout *ll);
 };
 
+/**
+ * Retained images of drawn lines, each identified by a key describing everything that
+ * affects how the line is drawn, so unchanged lines can be copied rather than drawn.
+ * While images are retained each document line has a stamp that is given a new value
+ * whenever its text, styles or indicators change so keys hold the stamp instead of the
+ * contents of the line.
+ */
+class LineImageCache {
+	struct LineImage {
+		Surface *surface;
+		std::string key;
+		int lastUsed;
+		LineImage() : surface(0), lastUsed(0) {
+		}
+	};
+	std::vector<LineImage> images;
+	int clock;
+	SplitVector<int> lineStamps;
+	int stampClock;
+	// Private so LineImageCache objects can not be copied
+	LineImageCache(const LineImageCache &);
+public:
+	LineImageCache();
+	~LineImageCache();
+	void Release();
+	void Invalidate();
+	void SetSize(int size_, int lines);
+	int GetSize() const { return static_cast<int>(images.size()); }
+	Surface *Find(const std::string &key);
+	Surface *Allocate(const std::string &key, int technology);
+	void ResetLines(int lines);
+	void InsertLines(int line, int lines);
+	void DeleteLines(int line, int lines);
+	void LinesChanged(int lineFirst, int lineLast);
+	int LineStamp(int line) const;
+};
+
+/**
+ * Identifies a font by its description rather than by the platform font object so that
+ * measurements survive styles being reset and can be shared between views.
+ * The code page is included as it decides how the bytes of a run form characters.
+ */
+class PositionCacheFont {
+	std::string fontName;
+	int weight;
+	bool italic;
+	int sizeZoomed;
+	int characterSet;
+	int extraFontFlag;
+	int technology;
+	int codePage;
+public:
+	PositionCacheFont(const Style &style, int technology_, int codePage_);
+	bool Matches(const Style &style, int technology_, int codePage_) const;
+};
+
 class PositionCacheEntry {
-	unsigned int styleNumber:8;
-	unsigned int len:8;
-	unsigned int clock:16;
+	unsigned int hash;
+	int font;
+	unsigned int len;
 	XYPOSITION *positions;
+	// Private so PositionCacheEntry objects can not be copied
+	PositionCacheEntry(const PositionCacheEntry &);
 public:
 	PositionCacheEntry();
 	~PositionCacheEntry();
-	void Set(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_, unsigned int clock);
+	void Set(unsigned int hash_, int font_, const char *s_, unsigned int len_, XYPOSITION *positions_);
 	void Clear();
-	bool Retrieve(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_) const;
-	static int Hash(unsigned int styleNumber_, const char *s, unsigned int len);
-	bool NewerThan(const PositionCacheEntry &other) const;
-	void ResetClock();
+	bool Retrieve(unsigned int hash_, int font_, const char *s_, unsigned int len_, XYPOSITION *positions_) const;
+	unsigned int Hash() const { return hash; }
+	static unsigned int Hash(int font_, const char *s, unsigned int len);
 };
 
 // Class to break a line of text into shorter runs at sensible places.
@@ -145,19 +202,42 @@ public:
 	int Next();
 };
 
+/**
+ * Least recently used cache of the positions of runs of text measured in a font.
+ * One cache is shared by all views in the process as fonts are identified by their
+ * description.
+ */
 class PositionCache {
 	PositionCacheEntry *pces;
 	size_t size;
-	unsigned int clock;
-	bool allClear;
+	size_t used;
+	std::vector<int> buckets;
+	// Indices of the next entry with the same bucket and of neighbours in use order
+	std::vector<int> chain;
+	std::vector<int> newer;
+	std::vector<int> older;
+	int newest;
+	int oldest;
+	std::vector<PositionCacheFont> fonts;
+	int fontLast;
+	size_t hits;
+	size_t misses;
 	// Private so PositionCache objects can not be copied
 	PositionCache(const PositionCache &);
+	int FontIndex(const Style &style, int technology, int codePage);
+	void Unlink(int entry);
+	void LinkNewest(int entry);
+	void RemoveFromBucket(int entry);
+	void Add(unsigned int hash, int font, const char *s, unsigned int len, XYPOSITION *positions);
 public:
 	PositionCache();
 	~PositionCache();
+	static PositionCache &Shared();
 	void Clear();
 	void SetSize(size_t size_);
 	size_t GetSize() const { return size; }
+	size_t Hits() const { return hits; }
+	size_t Misses() const { return misses; }
 	void MeasureWidths(Surface *surface, ViewStyle &vstyle, unsigned int styleNumber,
 		const char *s, unsigned int len, XYPOSITION *positions, Document *pdoc);
 };
@@ -42,6 +42,7 @@
  *  RESearch::Execute:      execute the NFA to match a pattern.
  *
  *          int RESearch::Execute(characterIndexer &ci, int lp, int endp)
+ *          int RESearch::Execute(const TextIndexer &ti, int lp, int endp)
  *
  *  RESearch::Substitute:   substitute the matched portions in a new string.
  *
@@ -763,7 +764,8 @@ const char *RESearch::Compile(const char *pattern, int length, bool caseSensitiv
  *  respectively.
  *
  */
-int RESearch::Execute(CharacterIndexer &ci, int lp, int endp) {
+template <typename Indexer>
+int RESearch::ExecuteIndexer(Indexer &ci, int lp, int endp) {
 	unsigned char c;
 	int ep = NOTFOUND;
 	char *ap = nfa;
@@ -852,7 +854,8 @@ extern void re_fail(char *,char);
 #define CHRSKIP 3	/* [CLO] CHR chr END      */
 #define CCLSKIP 34	/* [CLO] CCL 32 bytes END */
 
-int RESearch::PMatch(CharacterIndexer &ci, int lp, int endp, char *ap) {
+template <typename Indexer>
+int RESearch::PMatch(Indexer &ci, int lp, int endp, char *ap) {
 	int op, c, n;
 	int e;		/* extra pointer for CLO  */
 	int bp;		/* beginning of subpat... */
@@ -967,6 +970,14 @@ int RESearch::PMatch(CharacterIndexer &ci, int lp, int endp, char *ap) {
 	return lp;
 }
 
+int RESearch::Execute(CharacterIndexer &ci, int lp, int endp) {
+	return ExecuteIndexer(ci, lp, endp);
+}
+
+int RESearch::Execute(const TextIndexer &ti, int lp, int endp) {
+	return ExecuteIndexer(ti, lp, endp);
+}
+
 /*
  * RESearch::Substitute:
  *  substitute the matched portions of the src in dst.
@@ -28,6 +28,24 @@ public:
 	}
 };
 
+/// Indexes a contiguous copy or view of the text from start to end so that
+/// matching does not need a virtual call for each character.
+class TextIndexer {
+	const char *text;
+	int start;
+	int end;
+public:
+	TextIndexer(const char *text_, int start_, int end_) :
+		text(text_), start(start_), end(end_) {
+	}
+	char CharAt(int index) const {
+		if (index < start || index >= end)
+			return 0;
+		else
+			return text[index - start];
+	}
+};
+
 class RESearch {
 
 public:
@@ -36,6 +54,7 @@ public:
 	bool GrabMatches(CharacterIndexer &ci);
 	const char *Compile(const char *pattern, int length, bool caseSensitive, bool posix);
 	int Execute(CharacterIndexer &ci, int lp, int endp);
+	int Execute(const TextIndexer &ti, int lp, int endp);
 	int Substitute(CharacterIndexer &ci, char *src, char *dst);
 
 	enum { MAXTAG=10 };
@@ -53,7 +72,10 @@ private:
 	void ChSetWithCase(unsigned char c, bool caseSensitive);
 	int GetBackslashExpression(const char *pattern, int &incr);
 
-	int PMatch(CharacterIndexer &ci, int lp, int endp, char *ap);
+	template <typename Indexer>
+	int ExecuteIndexer(Indexer &ci, int lp, int endp);
+	template <typename Indexer>
+	int PMatch(Indexer &ci, int lp, int endp, char *ap);
 
 	int bol;
 	int tagstk[MAXTAG];  /* subpat tag stack */
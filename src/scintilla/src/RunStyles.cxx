@@ -21,7 +21,7 @@ using namespace Scintilla;
 #endif
 
 // Find the first run at a position
-int RunStyles::RunFromPosition(int position) const {
+int RunStyles::RunFromPosition(Sci_Position position) const {
 	int run = starts->PartitionFromPosition(position);
 	// Go to first element with this position
 	while ((run > 0) && (position == starts->PositionFromPartition(run-1))) {
@@ -31,9 +31,9 @@ int RunStyles::RunFromPosition(int position) const {
 }
 
 // If there is no run boundary at position, insert one continuing style.
-int RunStyles::SplitRun(int position) {
+int RunStyles::SplitRun(Sci_Position position) {
 	int run = RunFromPosition(position);
-	int posRun = starts->PositionFromPartition(run);
+	Sci_Position posRun = starts->PositionFromPartition(run);
 	if (posRun < position) {
 		int runStyle = ValueAt(position);
 		run++;
@@ -77,21 +77,21 @@ RunStyles::~RunStyles() {
 	styles = NULL;
 }
 
-int RunStyles::Length() const {
+Sci_Position RunStyles::Length() const {
 	return starts->PositionFromPartition(starts->Partitions());
 }
 
-int RunStyles::ValueAt(int position) const {
+int RunStyles::ValueAt(Sci_Position position) const {
 	return styles->ValueAt(starts->PartitionFromPosition(position));
 }
 
-int RunStyles::FindNextChange(int position, int end) {
+Sci_Position RunStyles::FindNextChange(Sci_Position position, Sci_Position end) {
 	int run = starts->PartitionFromPosition(position);
 	if (run < starts->Partitions()) {
-		int runChange = starts->PositionFromPartition(run);
+		Sci_Position runChange = starts->PositionFromPartition(run);
 		if (runChange > position)
 			return runChange;
-		int nextChange = starts->PositionFromPartition(run + 1);
+		Sci_Position nextChange = starts->PositionFromPartition(run + 1);
 		if (nextChange > position) {
 			return nextChange;
 		} else if (position < end) {
@@ -104,16 +104,16 @@ int RunStyles::FindNextChange(int position, int end) {
 	}
 }
 
-int RunStyles::StartRun(int position) {
+Sci_Position RunStyles::StartRun(Sci_Position position) {
 	return starts->PositionFromPartition(starts->PartitionFromPosition(position));
 }
 
-int RunStyles::EndRun(int position) {
+Sci_Position RunStyles::EndRun(Sci_Position position) {
 	return starts->PositionFromPartition(starts->PartitionFromPosition(position) + 1);
 }
 
-bool RunStyles::FillRange(int &position, int value, int &fillLength) {
-	int end = position + fillLength;
+bool RunStyles::FillRange(Sci_Position &position, int value, Sci_Position &fillLength) {
+	Sci_Position end = position + fillLength;
 	int runEnd = RunFromPosition(end);
 	if (styles->ValueAt(runEnd) == value) {
 		// End already has value so trim range.
@@ -155,12 +155,12 @@ bool RunStyles::FillRange(int &position, int value, int &fillLength) {
 	}
 }
 
-void RunStyles::SetValueAt(int position, int value) {
-	int len = 1;
+void RunStyles::SetValueAt(Sci_Position position, int value) {
+	Sci_Position len = 1;
 	FillRange(position, value, len);
 }
 
-void RunStyles::InsertSpace(int position, int insertLength) {
+void RunStyles::InsertSpace(Sci_Position position, Sci_Position insertLength) {
 	int runStart = RunFromPosition(position);
 	if (starts->PositionFromPartition(runStart) == position) {
 		int runStyle = ValueAt(position);
@@ -198,8 +198,8 @@ void RunStyles::DeleteAll() {
 	styles->InsertValue(0, 2, 0);
 }
 
-void RunStyles::DeleteRange(int position, int deleteLength) {
-	int end = position + deleteLength;
+void RunStyles::DeleteRange(Sci_Position position, Sci_Position deleteLength) {
+	Sci_Position end = position + deleteLength;
 	int runStart = RunFromPosition(position);
 	int runEnd = RunFromPosition(end);
 	if (runStart == runEnd) {
@@ -235,7 +235,7 @@ bool RunStyles::AllSameAs(int value) const {
 	return AllSame() && (styles->ValueAt(0) == value);
 }
 
-int RunStyles::Find(int value, int start) const {
+Sci_Position RunStyles::Find(int value, Sci_Position start) const {
 	if (start < Length()) {
 		int run = start ? RunFromPosition(start) : 0;
 		if (styles->ValueAt(run) == value)
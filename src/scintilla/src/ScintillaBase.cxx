@@ -28,6 +28,7 @@
 #endif
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "RunStyles.h"
 #include "ContractionState.h"
 #include "CellBuffer.h"
@@ -941,6 +942,8 @@ sptr_t ScintillaBase::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lPara
 			pdoc->ModifiedAt(wParam);
 			NotifyStyleToNeeded((lParam == -1) ? pdoc->Length() : lParam);
 		} else {
+			// An explicit request restyles even where styles could be kept
+			pdoc->StylesInvalidFrom(wParam);
 			DocumentLexState()->Colourise(wParam, lParam);
 		}
 		Redraw();
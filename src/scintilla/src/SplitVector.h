@@ -13,16 +13,16 @@ template <typename T>
 class SplitVector {
 protected:
 	T *body;
-	int size;
-	int lengthBody;
-	int part1Length;
-	int gapLength;	/// invariant: gapLength == size - lengthBody
-	int growSize;
+	Sci_Position size;
+	Sci_Position lengthBody;
+	Sci_Position part1Length;
+	Sci_Position gapLength;	/// invariant: gapLength == size - lengthBody
+	Sci_Position growSize;
 
 	/// Move the gap to a particular position so that insertion and
 	/// deletion at that point will not require much copying and
 	/// hence be fast.
-	void GapTo(int position) {
+	void GapTo(Sci_Position position) {
 		if (position != part1Length) {
 			if (position < part1Length) {
 				memmove(
@@ -41,7 +41,7 @@ protected:
 
 	/// Check that there is room in the buffer for an insertion,
 	/// reallocating if more space needed.
-	void RoomFor(int insertionLength) {
+	void RoomFor(Sci_Position insertionLength) {
 		if (gapLength <= insertionLength) {
 			while (growSize < size / 6)
 				growSize *= 2;
@@ -69,18 +69,18 @@ public:
 		body = 0;
 	}
 
-	int GetGrowSize() const {
+	Sci_Position GetGrowSize() const {
 		return growSize;
 	}
 
-	void SetGrowSize(int growSize_) {
+	void SetGrowSize(Sci_Position growSize_) {
 		growSize = growSize_;
 	}
 
 	/// Reallocate the storage for the buffer to be newSize and
 	/// copy exisiting contents to the new buffer.
 	/// Must not be used to decrease the size of the buffer.
-	void ReAllocate(int newSize) {
+	void ReAllocate(Sci_Position newSize) {
 		if (newSize > size) {
 			// Move the gap to the end
 			GapTo(lengthBody);
@@ -99,7 +99,7 @@ public:
 	/// Retrieving positions outside the range of the buffer returns 0.
 	/// The assertions here are disabled since calling code can be
 	/// simpler if out of range access works and returns 0.
-	T ValueAt(int position) const {
+	T ValueAt(Sci_Position position) const {
 		if (position < part1Length) {
 			//PLATFORM_ASSERT(position >= 0);
 			if (position < 0) {
@@ -117,7 +117,7 @@ public:
 		}
 	}
 
-	void SetValueAt(int position, T v) {
+	void SetValueAt(Sci_Position position, T v) {
 		if (position < part1Length) {
 			PLATFORM_ASSERT(position >= 0);
 			if (position < 0) {
@@ -135,7 +135,7 @@ public:
 		}
 	}
 
-	T &operator[](int position) const {
+	T &operator[](Sci_Position position) const {
 		PLATFORM_ASSERT(position >= 0 && position < lengthBody);
 		if (position < part1Length) {
 			return body[position];
@@ -145,13 +145,13 @@ public:
 	}
 
 	/// Retrieve the length of the buffer.
-	int Length() const {
+	Sci_Position Length() const {
 		return lengthBody;
 	}
 
 	/// Insert a single value into the buffer.
 	/// Inserting at positions outside the current range fails.
-	void Insert(int position, T v) {
+	void Insert(Sci_Position position, T v) {
 		PLATFORM_ASSERT((position >= 0) && (position <= lengthBody));
 		if ((position < 0) || (position > lengthBody)) {
 			return;
@@ -166,7 +166,7 @@ public:
 
 	/// Insert a number of elements into the buffer setting their value.
 	/// Inserting at positions outside the current range fails.
-	void InsertValue(int position, int insertLength, T v) {
+	void InsertValue(Sci_Position position, Sci_Position insertLength, T v) {
 		PLATFORM_ASSERT((position >= 0) && (position <= lengthBody));
 		if (insertLength > 0) {
 			if ((position < 0) || (position > lengthBody)) {
@@ -174,7 +174,7 @@ public:
 			}
 			RoomFor(insertLength);
 			GapTo(position);
-			for (int i = 0; i < insertLength; i++)
+			for (Sci_Position i = 0; i < insertLength; i++)
 				body[part1Length + i] = v;
 			lengthBody += insertLength;
 			part1Length += insertLength;
@@ -184,14 +184,14 @@ public:
 
 	/// Ensure at least length elements allocated,
 	/// appending zero valued elements if needed.
-	void EnsureLength(int wantedLength) {
+	void EnsureLength(Sci_Position wantedLength) {
 		if (Length() < wantedLength) {
 			InsertValue(Length(), wantedLength - Length(), 0);
 		}
 	}
 
 	/// Insert text into the buffer from an array.
-	void InsertFromArray(int positionToInsert, const T s[], int positionFrom, int insertLength) {
+	void InsertFromArray(Sci_Position positionToInsert, const T s[], Sci_Position positionFrom, Sci_Position insertLength) {
 		PLATFORM_ASSERT((positionToInsert >= 0) && (positionToInsert <= lengthBody));
 		if (insertLength > 0) {
 			if ((positionToInsert < 0) || (positionToInsert > lengthBody)) {
@@ -207,7 +207,7 @@ public:
 	}
 
 	/// Delete one element from the buffer.
-	void Delete(int position) {
+	void Delete(Sci_Position position) {
 		PLATFORM_ASSERT((position >= 0) && (position < lengthBody));
 		if ((position < 0) || (position >= lengthBody)) {
 			return;
@@ -217,7 +217,7 @@ public:
 
 	/// Delete a range from the buffer.
 	/// Deleting positions outside the current range fails.
-	void DeleteRange(int position, int deleteLength) {
+	void DeleteRange(Sci_Position position, Sci_Position deleteLength) {
 		PLATFORM_ASSERT((position >= 0) && (position + deleteLength <= lengthBody));
 		if ((position < 0) || ((position + deleteLength) > lengthBody)) {
 			return;
@@ -239,11 +239,11 @@ public:
 	}
 
 	// Retrieve a range of elements into an array
-	void GetRange(T *buffer, int position, int retrieveLength) const {
+	void GetRange(T *buffer, Sci_Position position, Sci_Position retrieveLength) const {
 		// Split into up to 2 ranges, before and after the split then use memcpy on each.
-		int range1Length = 0;
+		Sci_Position range1Length = 0;
 		if (position < part1Length) {
-			int part1AfterPosition = part1Length - position;
+			Sci_Position part1AfterPosition = part1Length - position;
 			range1Length = retrieveLength;
 			if (range1Length > part1AfterPosition)
 				range1Length = part1AfterPosition;
@@ -251,10 +251,27 @@ public:
 		memcpy(buffer, body + position, range1Length * sizeof(T));
 		buffer += range1Length;
 		position = position + range1Length + gapLength;
-		int range2Length = retrieveLength - range1Length;
+		Sci_Position range2Length = retrieveLength - range1Length;
 		memcpy(buffer, body + position, range2Length * sizeof(T));
 	}
 
+	/// Overwrite a range of elements from an array without moving the gap.
+	void SetRange(const T *buffer, Sci_Position position, Sci_Position setLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + setLength <= lengthBody));
+		Sci_Position range1Length = 0;
+		if (position < part1Length) {
+			Sci_Position part1AfterPosition = part1Length - position;
+			range1Length = setLength;
+			if (range1Length > part1AfterPosition)
+				range1Length = part1AfterPosition;
+		}
+		memcpy(body + position, buffer, range1Length * sizeof(T));
+		buffer += range1Length;
+		position = position + range1Length + gapLength;
+		Sci_Position range2Length = setLength - range1Length;
+		memcpy(body + position, buffer, range2Length * sizeof(T));
+	}
+
 	T *BufferPointer() {
 		RoomFor(1);
 		GapTo(lengthBody);
@@ -262,7 +279,7 @@ public:
 		return body;
 	}
 
-	T *RangePointer(int position, int rangeLength) {
+	T *RangePointer(Sci_Position position, Sci_Position rangeLength) {
 		if (position < part1Length) {
 			if ((position + rangeLength) > part1Length) {
 				// Range overlaps gap, so move gap to start of range.
@@ -276,7 +293,21 @@ public:
 		}
 	}
 
-	int GapPosition() const {
+	/// Retrieve the storage before or after the gap that contains position without
+	/// moving the gap. The start position and length of that part are returned.
+	const T *ContiguousRange(Sci_Position position, Sci_Position &start, Sci_Position &length) const {
+		if (position < part1Length) {
+			start = 0;
+			length = part1Length;
+			return body;
+		} else {
+			start = part1Length;
+			length = lengthBody - part1Length;
+			return body ? body + part1Length + gapLength : 0;
+		}
+	}
+
+	Sci_Position GapPosition() const {
 		return part1Length; 
 	}
 };
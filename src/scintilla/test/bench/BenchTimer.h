@@ -0,0 +1,22 @@
+// Benchmarks for Scintilla internal data structures
+/** @file BenchTimer.h
+ ** Simple CPU timer and reporting for benchmarks.
+ **/
+
+#ifndef BENCHTIMER_H
+#define BENCHTIMER_H
+
+class BenchTimer {
+	clock_t start;
+public:
+	BenchTimer() : start(clock()) {
+	}
+	double Duration() const {
+		return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+	}
+	void Report(const char *name) const {
+		printf("%8.3f %s\n", Duration(), name);
+	}
+};
+
+#endif
@@ -0,0 +1,204 @@
+// Benchmarks for Scintilla internal data structures
+/** @file benchCatalogue.cxx
+ ** Time lexing, folding and restyling after an edit for every lexer in the Catalogue.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+
+#include "LexerModule.h"
+#include "Catalogue.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "Document.h"
+
+#include "BenchTimer.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+static const int defaultDocumentSize = 1024 * 1024;
+static const int edits = 8;
+
+// Languages with an example file in test/examples, others lex synthesised text
+static const char *examples[][2] = {
+	{"cpp", "x.cxx"},
+	{"d", "x.d"},
+	{"hypertext", "x.html"},
+	{"phpscript", "x.php"},
+	{"python", "x.py"},
+	{"vb", "x.vb"},
+	{"vbscript", "x.vb"},
+};
+
+// Common keywords set into every word list so keyword lookups are exercised
+static const char keywords[] =
+	"and begin break call case char class const def do else end for function if int "
+	"let not or pass procedure return select string then var void while";
+
+// Text with the comments, strings, numbers, operators, blocks and markup of many
+// languages so that each lexer finds something of its own.
+static const char *sampleLines[] = {
+	"# comment %d with words and 123",
+	"// line comment %d",
+	"/* block comment %d",
+	"   continues here */",
+	"-- dash comment %d",
+	"; semicolon comment %d",
+	"' quote comment %d",
+	"REM remark %d",
+	"function name%d(argument, other) {",
+	"\tif (value == 42 && other != \"string %d\") {",
+	"\t\treturn value + 3.14e10 - 0x1F * %d;",
+	"\t} else {",
+	"\t\tcall('single', \"double \\\"escaped\\\" %d\");",
+	"\t}",
+	"}",
+	"begin",
+	"\tx%d := y * (z / 2); end;",
+	"def method%d(self):",
+	"    pass",
+	"<tag attribute=\"value%d\">text &amp; more</tag>",
+	"%%macro $variable%d @attribute",
+	"[section%d]",
+	"key = value %d",
+	"#include <stdio.h>",
+	"#define MACRO%d(a) ((a) + 1)",
+	"",
+};
+
+static std::string ReadFile(const char *path) {
+	std::string text;
+	FILE *fp = fopen(path, "rb");
+	if (fp) {
+		char block[4096];
+		size_t lenBlock;
+		while ((lenBlock = fread(block, 1, sizeof(block), fp)) > 0)
+			text.append(block, lenBlock);
+		fclose(fp);
+	}
+	return text;
+}
+
+static std::string SampleText(const char *languageName, int size) {
+	std::string example;
+	for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+		if (0 == strcmp(languageName, examples[i][0]))
+			example = ReadFile((std::string("../examples/") + examples[i][1]).c_str());
+	}
+	std::string text;
+	if (!example.empty()) {
+		while (text.length() < static_cast<size_t>(size))
+			text += example;
+	} else {
+		for (int n = 0; text.length() < static_cast<size_t>(size); n++) {
+			for (size_t i = 0; i < sizeof(sampleLines) / sizeof(sampleLines[0]); i++) {
+				char line[200];
+				sprintf(line, sampleLines[i], n);
+				text += line;
+				text += "\n";
+			}
+		}
+	}
+	return text;
+}
+
+// Gives the document its lexer as the platform layers do
+class BenchLexInterface : public LexInterface {
+public:
+	BenchLexInterface(Document *pdoc_, ILexer *instance_) : LexInterface(pdoc_) {
+		instance = instance_;
+	}
+	virtual ~BenchLexInterface() {
+		instance->Release();
+	}
+};
+
+// Times under a millisecond are shown as "-" as they are mostly clock resolution, such as
+// for lexers that fold while lexing
+static std::string MBPerSecond(int length, double duration) {
+	char rate[40];
+	if (duration < 0.001)
+		sprintf(rate, "%9s", "-");
+	else
+		sprintf(rate, "%9.1f", length / duration / 1024 / 1024);
+	return rate;
+}
+
+static void Bench(const LexerModule *plm, int size) {
+	const std::string text = SampleText(plm->languageName, size);
+	Document *pdoc = new Document();
+	pdoc->AddRef();
+	pdoc->SetUndoCollection(false);
+	pdoc->SetStylingBits(plm->GetStyleBitsNeeded());
+	pdoc->InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	const int length = pdoc->Length();
+
+	ILexer *lexer = plm->Create();
+	for (int i = 0; i < plm->GetNumWordLists(); i++)
+		lexer->WordListSet(i, keywords);
+	const char *foldProperties[] = {"fold", "fold.comment", "fold.compact", "fold.html", "fold.preprocessor"};
+	for (size_t i = 0; i < sizeof(foldProperties) / sizeof(foldProperties[0]); i++)
+		lexer->PropertySet(foldProperties[i], "1");
+
+	BenchTimer btLex;
+	lexer->Lex(0, length, 0, pdoc);
+	const double durationLex = btLex.Duration();
+	BenchTimer btFold;
+	lexer->Fold(0, length, 0, pdoc);
+	const double durationFold = btFold.Duration();
+
+	// Insert a character at points through the document and restyle to its end as happens
+	// when typing with the end of the document visible
+	pdoc->pli = new BenchLexInterface(pdoc, lexer);
+	pdoc->EnsureStyledTo(length);
+	double durationEdits = 0;
+	for (int i = 0; i < edits; i++) {
+		const int position = pdoc->LineStart(pdoc->LineFromPosition(length * (2 * i + 1) / (2 * edits))) + 1;
+		pdoc->InsertString(position, "x", 1);
+		BenchTimer btEdit;
+		pdoc->EnsureStyledTo(pdoc->Length());
+		durationEdits += btEdit.Duration();
+		pdoc->DeleteChars(position, 1);
+		pdoc->EnsureStyledTo(pdoc->Length());
+	}
+
+	printf("%s %s %9.3f %s\n", MBPerSecond(length, durationLex).c_str(),
+		MBPerSecond(length, durationFold).c_str(), durationEdits * 1000 / edits, plm->languageName);
+	pdoc->Release();
+}
+
+int main(int argc, char *argv[]) {
+	const char *languageName = (argc > 1) ? argv[1] : 0;
+	const int size = (argc > 2) ? atoi(argv[2]) * 1024 : defaultDocumentSize;
+	printf("%9s %9s %9s %s\n", "lex MB/s", "fold MB/s", "edit ms", "lexer");
+	BenchTimer bt;
+	int lexers = 0;
+	// Lexers are found by language including those numbered from SCLEX_AUTOMATIC
+	for (int language = 0; language < SCLEX_AUTOMATIC + 100; language++) {
+		const LexerModule *plm = Catalogue::Find(language);
+		if (plm && plm->languageName && (!languageName || (0 == strcmp(languageName, plm->languageName)))) {
+			Bench(plm, size);
+			lexers++;
+		}
+	}
+	printf("%8.3f %d lexers\n", bt.Duration(), lexers);
+	return 0;
+}
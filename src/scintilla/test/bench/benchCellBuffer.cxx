@@ -0,0 +1,179 @@
+// Benchmarks for Scintilla internal data structures
+/** @file benchCellBuffer.cxx
+ ** Time common editing patterns on CellBuffer with its SplitVector and Partitioning members.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Platform.h"
+
+#include "Scintilla.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+#include "CellBuffer.h"
+
+#include "BenchTimer.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+// Linear congruential generator so runs are repeatable on all platforms
+static unsigned int Random(unsigned int &seed) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+static const int lineCount = 1000000;
+static const int editCount = 20000;
+// Each scattered edit may move the gap over much of the document
+static const int scatteredCount = 1000;
+// Same as SciTE's FileLoader
+static const Sci_Position loadBlockSize = 131072;
+
+int main() {
+	printf("Sci_Position is %d bytes\n", static_cast<int>(sizeof(Sci_Position)));
+#ifdef SCI_BLOCK_STORAGE
+	printf("Block storage\n");
+#else
+	printf("Gap buffer storage\n");
+#endif
+
+	CellBuffer cb;
+	cb.SetUndoCollection(false);
+	bool startSequence = false;
+	const char line[] = "abcdefghijklmnopqrstuvwxyz0123456789\n";
+	const Sci_Position lenLine = static_cast<Sci_Position>(strlen(line));
+
+	{
+		BenchTimer bt;
+		for (int i = 0; i < lineCount; i++) {
+			cb.InsertString(cb.Length(), line, lenLine, startSequence);
+		}
+		bt.Report("append lines");
+	}
+
+	{
+		// Loading a file adds large blocks so most time goes to finding line ends
+		const Sci_Position lenFile = lenLine * lineCount;
+		char *file = new char[lenFile];
+		for (int i = 0; i < lineCount; i++) {
+			memcpy(file + i * lenLine, line, lenLine);
+		}
+		CellBuffer cbLoad;
+		cbLoad.SetUndoCollection(false);
+		BenchTimer bt;
+		for (Sci_Position pos = 0; pos < lenFile; pos += loadBlockSize) {
+			const Sci_Position lenBlock = (lenFile - pos < loadBlockSize) ? lenFile - pos : loadBlockSize;
+			cbLoad.InsertString(pos, file + pos, lenBlock, startSequence);
+		}
+		bt.Report("load blocks");
+		delete []file;
+	}
+
+	{
+		BenchTimer bt;
+		for (int i = 0; i < editCount; i++) {
+			cb.InsertString(10 + i, "x", 1, startSequence);
+		}
+		bt.Report("type near start");
+	}
+
+	{
+		BenchTimer bt;
+		unsigned int seed = 1;
+		for (int i = 0; i < scatteredCount; i++) {
+			const Sci_Position pos = Random(seed) % cb.Length();
+			cb.InsertString(pos, "y\n", 2, startSequence);
+		}
+		bt.Report("scattered inserts");
+	}
+
+	{
+		BenchTimer bt;
+		unsigned int seed = 2;
+		int total = 0;
+		for (int i = 0; i < lineCount; i++) {
+			const Sci_Position pos = Random(seed) % cb.Length();
+			total += cb.LineFromPosition(pos) & 1;
+			total += static_cast<int>(cb.LineStart(total) & 1);
+		}
+		bt.Report("line lookups");
+		if (total < 0)
+			printf("%d\n", total);
+	}
+
+	{
+		BenchTimer bt;
+		unsigned int seed = 3;
+		for (int i = 0; i < scatteredCount; i++) {
+			const Sci_Position pos = Random(seed) % (cb.Length() - 2);
+			cb.DeleteChars(pos, 2, startSequence);
+		}
+		bt.Report("scattered deletes");
+	}
+
+	{
+		BenchTimer bt;
+		Sci_Position sum = 0;
+		const Sci_Position length = cb.Length();
+		for (Sci_Position pos = 0; pos < length; pos++) {
+			sum += cb.CharAt(pos);
+		}
+		bt.Report("read every character");
+		if (sum == 0)
+			printf("empty\n");
+	}
+
+	{
+		// Searching for text near the end as Find Next does for a distant match
+		const char needle[] = "Needle";
+		const Sci_Position lenNeedle = static_cast<Sci_Position>(strlen(needle));
+		cb.InsertString(cb.Length() - 10, needle, lenNeedle, startSequence);
+		// Place the gap in the middle so the search crosses it
+		cb.InsertString(cb.Length() / 2, "\n", 1, startSequence);
+		const Sci_Position length = cb.Length();
+		Sci_Position found = -1;
+		{
+			BenchTimer bt;
+			for (Sci_Position pos = 0; (pos + lenNeedle <= length) && (found < 0); pos++) {
+				if (cb.CharAt(pos) == needle[0]) {
+					bool matches = true;
+					for (Sci_Position i = 1; (i < lenNeedle) && matches; i++)
+						matches = cb.CharAt(pos + i) == needle[i];
+					if (matches)
+						found = pos;
+				}
+			}
+			bt.Report("find at end by character");
+		}
+		{
+			BenchTimer bt;
+			if (cb.FindBytes(0, length, needle, lenNeedle, 0, true) != found)
+				printf("find mismatch\n");
+			bt.Report("find at end");
+		}
+		{
+			BenchTimer bt;
+			if (cb.FindBytes(0, length, needle, lenNeedle, 0, false) != found)
+				printf("find backwards mismatch\n");
+			bt.Report("find backwards from end");
+		}
+		{
+			char fold[256];
+			for (int ch = 0; ch < 0x100; ch++)
+				fold[ch] = static_cast<char>(((ch >= 'A') && (ch <= 'Z')) ? ch - 'A' + 'a' : ch);
+			const char needleFolded[] = "needle";
+			BenchTimer bt;
+			if (cb.FindBytes(0, length, needleFolded, lenNeedle, fold, true) != found)
+				printf("find folded mismatch\n");
+			bt.Report("find folded at end");
+		}
+	}
+
+	return 0;
+}
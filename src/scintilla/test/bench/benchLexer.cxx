@@ -0,0 +1,176 @@
+// Benchmarks for Scintilla internal data structures
+/** @file benchLexer.cxx
+ ** Time keyword lookup and lexing C++ with a large keyword list.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+
+#include "WordList.h"
+#include "LexerModule.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "Document.h"
+
+#include "BenchTimer.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+extern LexerModule lmCPP;
+
+// Linear congruential generator so runs are repeatable on all platforms
+static unsigned int Random(unsigned int &seed) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+// About as many as an API file turned into keywords
+static const int apiWordCount = 20000;
+static const int documentSize = 8 * 1024 * 1024;
+static const int lexRepeats = 3;
+
+static const char cppKeywords[] =
+	"and and_eq asm auto bitand bitor bool break case catch char class compl const "
+	"const_cast continue default delete do double dynamic_cast else enum explicit "
+	"export extern false float for friend goto if inline int long mutable namespace "
+	"new not not_eq operator or or_eq private protected public register "
+	"reinterpret_cast return short signed sizeof static static_cast struct switch "
+	"template this throw true try typedef typeid typename union unsigned using "
+	"virtual void volatile wchar_t while xor xor_eq";
+
+// Lookup through the first character index as WordList::InList did before it was hashed
+static bool LinearInList(const WordList &wl, const char *s) {
+	unsigned char firstChar = s[0];
+	int j = wl.starts[firstChar];
+	if (j >= 0) {
+		while (static_cast<unsigned char>(wl.words[j][0]) == firstChar) {
+			if (s[1] == wl.words[j][1]) {
+				const char *a = wl.words[j] + 1;
+				const char *b = s + 1;
+				while (*a && *a == *b) {
+					a++;
+					b++;
+				}
+				if (!*a && !*b)
+					return true;
+			}
+			j++;
+		}
+	}
+	return false;
+}
+
+static std::string ReadFile(const char *path) {
+	std::string text;
+	FILE *fp = fopen(path, "rb");
+	if (fp) {
+		char block[4096];
+		size_t lenBlock;
+		while ((lenBlock = fread(block, 1, sizeof(block), fp)) > 0)
+			text.append(block, lenBlock);
+		fclose(fp);
+	}
+	return text;
+}
+
+// Identifiers starting with the letters most common in the example so lookups scan long runs
+static std::string ApiWords() {
+	const char firstLetters[] = "dfimpx";
+	std::string words(cppKeywords);
+	unsigned int seed = 1;
+	for (int i = 0; i < apiWordCount; i++) {
+		char word[40];
+		sprintf(word, " %c%s_%u", firstLetters[i % (sizeof(firstLetters) - 1)],
+			(i & 1) ? "Api" : "api", Random(seed) % 1000000);
+		words += word;
+	}
+	return words;
+}
+
+static void Lex(const char *name, const char *keywords, Document *pdoc) {
+	ILexer *lexer = lmCPP.Create();
+	lexer->WordListSet(0, keywords);
+	BenchTimer bt;
+	for (int i = 0; i < lexRepeats; i++)
+		lexer->Lex(0, pdoc->Length(), 0, pdoc);
+	const double duration = bt.Duration();
+	printf("%8.3f %s %6.1f MB/s\n", duration, name,
+		(duration > 0) ? lexRepeats * pdoc->Length() / duration / 1024 / 1024 : 0.0);
+	lexer->Release();
+}
+
+int main(int argc, char *argv[]) {
+	const char *examplePath = (argc > 1) ? argv[1] : "../examples/x.cxx";
+	const std::string example = ReadFile(examplePath);
+	if (example.empty()) {
+		fprintf(stderr, "Can not read %s\n", examplePath);
+		return 1;
+	}
+	std::string text;
+	while (text.length() < static_cast<size_t>(documentSize))
+		text += example;
+
+	const std::string apiWords = ApiWords();
+	WordList wl;
+	wl.Set(apiWords.c_str());
+
+	// Lookups of every identifier in the text as a keyword heavy lexer does
+	std::vector<std::string> identifiers;
+	for (size_t pos = 0; pos < example.length();) {
+		const size_t start = pos;
+		while ((pos < example.length()) && (isalnum(example[pos]) || (example[pos] == '_')))
+			pos++;
+		if (pos > start)
+			identifiers.push_back(example.substr(start, pos - start));
+		else
+			pos++;
+	}
+	const int lookupRepeats = documentSize / static_cast<int>(example.length());
+	int foundLinear = 0;
+	{
+		BenchTimer bt;
+		for (int r = 0; r < lookupRepeats; r++) {
+			for (size_t i = 0; i < identifiers.size(); i++)
+				foundLinear += LinearInList(wl, identifiers[i].c_str());
+		}
+		bt.Report("linear lookups");
+	}
+	int found = 0;
+	{
+		BenchTimer bt;
+		for (int r = 0; r < lookupRepeats; r++) {
+			for (size_t i = 0; i < identifiers.size(); i++)
+				found += wl.InList(identifiers[i].c_str());
+		}
+		bt.Report("hashed lookups");
+	}
+	if (found != foundLinear)
+		printf("lookup mismatch %d %d\n", found, foundLinear);
+
+	Document *pdoc = new Document();
+	pdoc->AddRef();
+	pdoc->SetUndoCollection(false);
+	pdoc->InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	Lex("lex with C++ keywords", cppKeywords, pdoc);
+	Lex("lex with API keywords", apiWords.c_str(), pdoc);
+	pdoc->Release();
+	return 0;
+}
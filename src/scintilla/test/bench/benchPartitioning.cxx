@@ -0,0 +1,99 @@
+// Benchmarks for Scintilla internal data structures
+/** @file benchPartitioning.cxx
+ ** Time the line start operations of Partitioning and BlockPartitioning.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Platform.h"
+
+#include "SplitVector.h"
+#include "Partitioning.h"
+
+#include "BenchTimer.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+// Linear congruential generator so runs are repeatable on all platforms
+static unsigned int Random(unsigned int &seed) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+static const int lineCount = 2000000;
+static const int lineLength = 40;
+static const int typeCount = 1000000;
+// Each far edit moves the step of a Partitioning over every line
+static const int farCount = 2000;
+static const int lookupCount = 2000000;
+
+template <typename Starts>
+static void Bench(const char *name) {
+	printf("%s\n", name);
+	Starts starts(256);
+	{
+		BenchTimer bt;
+		for (int line = 0; line < lineCount; line++) {
+			starts.InsertText(line, lineLength);
+			starts.InsertPartition(line + 1, static_cast<Sci_Position>(line + 1) * lineLength);
+		}
+		bt.Report("append lines");
+	}
+	{
+		BenchTimer bt;
+		for (int i = 0; i < typeCount; i++) {
+			starts.InsertText(100, 1);
+		}
+		bt.Report("type on one line");
+	}
+	{
+		BenchTimer bt;
+		for (int i = 0; i < farCount; i++) {
+			starts.InsertText(10, 1);
+			starts.InsertText(lineCount - 10, 1);
+		}
+		bt.Report("alternate start and end");
+	}
+	{
+		unsigned int seed = 1;
+		BenchTimer bt;
+		for (int i = 0; i < farCount; i++) {
+			starts.InsertText(Random(seed) % lineCount, 1);
+		}
+		bt.Report("type on random lines");
+	}
+	{
+		BenchTimer bt;
+		Sci_Position total = 0;
+		for (int line = 0; line < starts.Partitions(); line++) {
+			total += starts.PositionFromPartition(line);
+		}
+		bt.Report("line starts in order");
+		if (total == 0)
+			printf("No lines\n");
+	}
+	{
+		unsigned int seed = 1;
+		const Sci_Position length = starts.PositionFromPartition(starts.Partitions());
+		BenchTimer bt;
+		int total = 0;
+		for (int i = 0; i < lookupCount; i++) {
+			total += starts.PartitionFromPosition(Random(seed) % length);
+		}
+		bt.Report("random line from position");
+		if (total == 0)
+			printf("No lines\n");
+	}
+}
+
+int main() {
+	printf("Sci_Position is %d bytes\n", static_cast<int>(sizeof(Sci_Position)));
+	Bench<Partitioning>("Partitioning");
+	Bench<BlockPartitioning>("BlockPartitioning");
+	return 0;
+}
@@ -0,0 +1,183 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <string.h>
+
+#include "Platform.h"
+
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+
+#include <gtest/gtest.h>
+
+// Test BlockVector.
+
+class BlockVectorTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		// Small blocks so that tests cross block boundaries
+		pbv = new BlockVector<int>(4);
+	}
+
+	virtual void TearDown() {
+		delete pbv;
+		pbv = 0;
+	}
+
+	BlockVector<int> *pbv;
+};
+
+const int lengthTestArray = 20;
+static const int testArray[lengthTestArray] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+
+TEST_F(BlockVectorTest, IsEmptyInitially) {
+	EXPECT_EQ(0, pbv->Length());
+	EXPECT_EQ(1, pbv->Blocks());
+}
+
+TEST_F(BlockVectorTest, InsertOne) {
+	pbv->InsertValue(0, 10, 0);
+	pbv->Insert(5, 3);
+	EXPECT_EQ(11, pbv->Length());
+	for (int i=0; i<pbv->Length(); i++) {
+		EXPECT_EQ((i == 5) ? 3 : 0, pbv->ValueAt(i));
+	}
+}
+
+TEST_F(BlockVectorTest, InsertFromArraySplits) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	EXPECT_EQ(lengthTestArray, pbv->Length());
+	EXPECT_LT(1, pbv->Blocks());
+	for (int i=0; i<pbv->Length(); i++) {
+		EXPECT_EQ(i+3, pbv->ValueAt(i));
+	}
+}
+
+TEST_F(BlockVectorTest, SetValue) {
+	pbv->InsertValue(0, 20, 0);
+	pbv->SetValueAt(15, 3);
+	for (int i=0; i<pbv->Length(); i++) {
+		EXPECT_EQ((i == 15) ? 3 : 0, pbv->ValueAt(i));
+	}
+}
+
+TEST_F(BlockVectorTest, DeleteRangeOverBlocks) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	pbv->DeleteRange(2, 13);
+	EXPECT_EQ(7, pbv->Length());
+	EXPECT_EQ(3, pbv->ValueAt(0));
+	EXPECT_EQ(4, pbv->ValueAt(1));
+	for (int i=2; i<pbv->Length(); i++) {
+		EXPECT_EQ(i+16, pbv->ValueAt(i));
+	}
+}
+
+TEST_F(BlockVectorTest, DeleteAll) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	pbv->DeleteRange(0, lengthTestArray);
+	EXPECT_EQ(0, pbv->Length());
+	EXPECT_EQ(1, pbv->Blocks());
+	pbv->InsertValue(0, 3, 7);
+	EXPECT_EQ(7, pbv->ValueAt(2));
+}
+
+TEST_F(BlockVectorTest, GetRange) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	int retrieveArray[lengthTestArray] = {0};
+	pbv->GetRange(retrieveArray, 1, lengthTestArray-1);
+	for (int i=0; i<lengthTestArray-1; i++) {
+		EXPECT_EQ(i+4, retrieveArray[i]);
+	}
+}
+
+TEST_F(BlockVectorTest, BufferPointer) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	const int *retrievePointer = pbv->BufferPointer();
+	EXPECT_EQ(1, pbv->Blocks());
+	for (int i=0; i<pbv->Length(); i++) {
+		EXPECT_EQ(i+3, retrievePointer[i]);
+	}
+	// Editing after gathering divides into blocks again
+	pbv->Delete(0);
+	EXPECT_LT(1, pbv->Blocks());
+	EXPECT_EQ(4, pbv->ValueAt(0));
+}
+
+TEST_F(BlockVectorTest, RangePointer) {
+	pbv->InsertFromArray(0, testArray, 0, lengthTestArray);
+	const int *range = pbv->RangePointer(5, 10);
+	for (int i=0; i<10; i++) {
+		EXPECT_EQ(i+8, range[i]);
+	}
+}
+
+TEST_F(BlockVectorTest, OutsideBounds) {
+	pbv->InsertValue(0, 10, 87);
+	EXPECT_EQ(0, pbv->ValueAt(-1));
+	EXPECT_EQ(0, pbv->ValueAt(10));
+}
+
+TEST_F(BlockVectorTest, AppendShared) {
+	pbv->InsertValue(0, 2, 1);
+	pbv->AppendShared(testArray, lengthTestArray);
+	EXPECT_EQ(lengthTestArray + 2, pbv->Length());
+	EXPECT_TRUE(pbv->HoldsShared());
+	EXPECT_EQ(1, pbv->ValueAt(1));
+	EXPECT_EQ(3, pbv->ValueAt(2));
+	// Shared elements are returned without copying
+	EXPECT_EQ(testArray + 1, pbv->RangePointer(3, 2));
+	// Modifying copies the block and leaves the shared elements alone
+	pbv->SetValueAt(3, 99);
+	EXPECT_EQ(99, pbv->ValueAt(3));
+	EXPECT_EQ(4, testArray[1]);
+	pbv->Delete(2);
+	EXPECT_EQ(99, pbv->ValueAt(2));
+	EXPECT_TRUE(pbv->HoldsShared());
+	const int *retrievePointer = pbv->BufferPointer();
+	EXPECT_FALSE(pbv->HoldsShared());
+	EXPECT_EQ(lengthTestArray + 1, pbv->Length());
+	EXPECT_EQ(lengthTestArray + 2, retrievePointer[lengthTestArray]);
+}
+
+TEST_F(BlockVectorTest, AppendSharedZeros) {
+	pbv->AppendShared(0, 10);
+	EXPECT_EQ(10, pbv->Length());
+	EXPECT_EQ(3, pbv->Blocks());
+	int retrieveArray[10] = {1};
+	pbv->GetRange(retrieveArray, 0, 10);
+	for (int i=0; i<10; i++) {
+		EXPECT_EQ(0, retrieveArray[i]);
+	}
+	pbv->InsertValue(5, 2, 7);
+	EXPECT_EQ(7, pbv->ValueAt(5));
+	EXPECT_EQ(0, pbv->ValueAt(7));
+}
+
+TEST_F(BlockVectorTest, MatchesSplitVector) {
+	// Perform the same pseudo-random edits on a SplitVector and compare
+	SplitVector<int> sv;
+	unsigned int seed = 1;
+	for (int step=0; step<2000; step++) {
+		seed = seed * 1103515245 + 12345;
+		const int r = (seed >> 8) & 0xffff;
+		const int len = static_cast<int>(sv.Length());
+		if ((r % 3) || (len == 0)) {
+			const int pos = r % (len + 1);
+			const int lengthInsert = 1 + (r % 7);
+			sv.InsertFromArray(pos, testArray, 0, lengthInsert);
+			pbv->InsertFromArray(pos, testArray, 0, lengthInsert);
+		} else {
+			const int pos = r % len;
+			int lengthDelete = 1 + (r % 11);
+			if (pos + lengthDelete > len)
+				lengthDelete = len - pos;
+			sv.DeleteRange(pos, lengthDelete);
+			pbv->DeleteRange(pos, lengthDelete);
+		}
+		ASSERT_EQ(sv.Length(), pbv->Length());
+	}
+	for (int i=0; i<sv.Length(); i++) {
+		EXPECT_EQ(sv.ValueAt(i), pbv->ValueAt(i));
+	}
+}
@@ -0,0 +1,254 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <string.h>
+
+#include <string>
+
+#include "Platform.h"
+
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+#include "CellBuffer.h"
+
+#include <gtest/gtest.h>
+
+// Test CellBuffer undo history.
+
+class CellBufferTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		pcb = new CellBuffer();
+	}
+
+	virtual void TearDown() {
+		delete pcb;
+		pcb = 0;
+	}
+
+	void Type(const char *s) {
+		bool startSequence;
+		while (*s) {
+			pcb->InsertString(pcb->Length(), s, 1, startSequence);
+			s++;
+		}
+	}
+
+	void InsertOperation(Sci_Position position, const char *s) {
+		bool startSequence;
+		pcb->BeginUndoAction();
+		pcb->InsertString(position, s, strlen(s), startSequence);
+		pcb->EndUndoAction();
+	}
+
+	int Undo() {
+		const int steps = pcb->StartUndo();
+		for (int step = 0; step < steps; step++)
+			pcb->PerformUndoStep();
+		return steps;
+	}
+
+	int Redo() {
+		const int steps = pcb->StartRedo();
+		for (int step = 0; step < steps; step++)
+			pcb->PerformRedoStep();
+		return steps;
+	}
+
+	std::string Text() const {
+		std::string text;
+		for (Sci_Position i = 0; i < pcb->Length(); i++)
+			text += pcb->CharAt(i);
+		return text;
+	}
+
+	CellBuffer *pcb;
+};
+
+TEST_F(CellBufferTest, IsEmptyInitially) {
+	EXPECT_EQ(0, pcb->Length());
+	EXPECT_FALSE(pcb->CanUndo());
+	EXPECT_FALSE(pcb->CanRedo());
+	EXPECT_EQ(0u, pcb->GetUndoMemoryLimit());
+}
+
+TEST_F(CellBufferTest, UndoRedo) {
+	InsertOperation(0, "abc");
+	InsertOperation(1, "xy");
+	EXPECT_EQ("axybc", Text());
+	EXPECT_TRUE(pcb->CanUndo());
+	Undo();
+	EXPECT_EQ("abc", Text());
+	EXPECT_TRUE(pcb->CanRedo());
+	Redo();
+	EXPECT_EQ("axybc", Text());
+	Undo();
+	Undo();
+	EXPECT_EQ("", Text());
+	EXPECT_FALSE(pcb->CanUndo());
+}
+
+TEST_F(CellBufferTest, TypingMergedIntoOneAction) {
+	Type("typing");
+	EXPECT_EQ(1, Undo());
+	EXPECT_EQ("", Text());
+	EXPECT_FALSE(pcb->CanUndo());
+	EXPECT_EQ(1, Redo());
+	EXPECT_EQ("typing", Text());
+}
+
+TEST_F(CellBufferTest, ForwardDeletesMerged) {
+	Type("abcdef");
+	pcb->SetSavePoint();
+	bool startSequence;
+	pcb->DeleteChars(1, 1, startSequence);
+	EXPECT_TRUE(startSequence);
+	pcb->DeleteChars(1, 1, startSequence);
+	EXPECT_FALSE(startSequence);
+	pcb->DeleteChars(1, 1, startSequence);
+	EXPECT_EQ("aef", Text());
+	EXPECT_EQ(1, Undo());
+	EXPECT_EQ("abcdef", Text());
+	EXPECT_TRUE(pcb->IsSavePoint());
+}
+
+TEST_F(CellBufferTest, UndoThenTypeDiscardsRedo) {
+	InsertOperation(0, "one");
+	InsertOperation(3, "two");
+	Undo();
+	Type("3");
+	EXPECT_FALSE(pcb->CanRedo());
+	EXPECT_EQ("one3", Text());
+	Undo();
+	EXPECT_EQ("one", Text());
+	Redo();
+	EXPECT_EQ("one3", Text());
+}
+
+TEST_F(CellBufferTest, MemoryLimitDropsOldest) {
+	const std::string chunk(0x1000, 'x');
+	pcb->SetSavePoint();
+	for (int i = 0; i < 100; i++)
+		InsertOperation(pcb->Length(), chunk.c_str());
+	pcb->SetUndoMemoryLimit(0x20000);
+	EXPECT_EQ(0x20000u, pcb->GetUndoMemoryLimit());
+	int undos = 0;
+	while (pcb->CanUndo()) {
+		Undo();
+		undos++;
+	}
+	EXPECT_LT(0, undos);
+	EXPECT_GT(100, undos);
+	EXPECT_EQ(static_cast<Sci_Position>((100 - undos) * chunk.length()), pcb->Length());
+	// Save point was dropped so can not be reached
+	EXPECT_FALSE(pcb->IsSavePoint());
+	while (pcb->CanRedo())
+		Redo();
+	EXPECT_EQ(static_cast<Sci_Position>(100 * chunk.length()), pcb->Length());
+}
+
+TEST_F(CellBufferTest, MemoryLimitKeepsCurrentOperation) {
+	pcb->SetUndoMemoryLimit(0x100);
+	const std::string big(0x1000, 'b');
+	InsertOperation(0, "a");
+	InsertOperation(1, big.c_str());
+	EXPECT_EQ(1, Undo());
+	EXPECT_EQ("a", Text());
+	EXPECT_FALSE(pcb->CanUndo());
+}
+
+TEST_F(CellBufferTest, FindBytes) {
+	Type("one two one two");
+	EXPECT_EQ(4, pcb->FindBytes(0, pcb->Length(), "two", 3, 0, true));
+	EXPECT_EQ(12, pcb->FindBytes(0, pcb->Length(), "two", 3, 0, false));
+	// Match must lie entirely within the range
+	EXPECT_EQ(-1, pcb->FindBytes(0, 6, "two", 3, 0, true));
+	EXPECT_EQ(-1, pcb->FindBytes(5, 14, "two", 3, 0, false));
+	EXPECT_EQ(-1, pcb->FindBytes(0, pcb->Length(), "three", 5, 0, true));
+}
+
+TEST_F(CellBufferTest, FindBytesAcrossGap) {
+	const std::string text = std::string(500, 'a') + "bc" + std::string(498, 'a');
+	bool startSequence;
+	pcb->InsertString(0, text.c_str(), static_cast<Sci_Position>(text.length()), startSequence);
+	// Leave the gap between 'b' and 'c'
+	pcb->InsertString(501, "x", 1, startSequence);
+	pcb->DeleteChars(501, 1, startSequence);
+#ifndef SCI_BLOCK_STORAGE
+	EXPECT_EQ(501, pcb->GapPosition());
+#endif
+	EXPECT_EQ(499, pcb->FindBytes(0, pcb->Length(), "abc", 3, 0, true));
+	EXPECT_EQ(499, pcb->FindBytes(0, pcb->Length(), "abc", 3, 0, false));
+	EXPECT_EQ(-1, pcb->FindBytes(0, 501, "abc", 3, 0, true));
+}
+
+TEST_F(CellBufferTest, FindBytesFolded) {
+	char fold[256];
+	for (int ch = 0; ch < 0x100; ch++)
+		fold[ch] = static_cast<char>(((ch >= 'A') && (ch <= 'Z')) ? ch - 'A' + 'a' : ch);
+	const std::string prefix(100, '-');
+	Type(prefix.c_str());
+	Type("Alpha BETA gamma beta");
+	EXPECT_EQ(106, pcb->FindBytes(0, pcb->Length(), "beta", 4, fold, true));
+	EXPECT_EQ(117, pcb->FindBytes(0, pcb->Length(), "beta", 4, fold, false));
+	EXPECT_EQ(100, pcb->FindBytes(0, pcb->Length(), "alpha", 5, fold, true));
+	EXPECT_EQ(-1, pcb->FindBytes(0, pcb->Length(), "BETA", 4, fold, true));
+}
+
+TEST_F(CellBufferTest, ContiguousRangePointer) {
+	const std::string text = std::string(100, 'a') + std::string(100, 'b');
+	bool startSequence;
+	pcb->InsertString(0, text.c_str(), static_cast<Sci_Position>(text.length()), startSequence);
+	const char *range = pcb->ContiguousRangePointer(90, 20);
+	ASSERT_TRUE(range != 0);
+	EXPECT_EQ(0, memcmp(range, text.c_str() + 90, 20));
+#ifndef SCI_BLOCK_STORAGE
+	// Leave the gap at 100 so a range over it is not contiguous
+	pcb->InsertString(100, "x", 1, startSequence);
+	pcb->DeleteChars(100, 1, startSequence);
+	EXPECT_TRUE(pcb->ContiguousRangePointer(90, 20) == 0);
+	EXPECT_EQ(0, memcmp(pcb->ContiguousRangePointer(100, 20), text.c_str() + 100, 20));
+#endif
+}
+
+TEST_F(CellBufferTest, SetStylesReportsChange) {
+	const std::string text(10000, 'a');
+	bool startSequence;
+	pcb->InsertString(0, text.c_str(), static_cast<Sci_Position>(text.length()), startSequence);
+	// Move the gap into the middle so styles are set across it
+	pcb->InsertString(5000, "x", 1, startSequence);
+	Sci_Position changeStart = -1;
+	Sci_Position changeEnd = -1;
+	std::string styles(10001, '\0');
+	EXPECT_FALSE(pcb->SetStyles(0, 10001, styles.c_str(), '\377', changeStart, changeEnd));
+	styles[4500] = 3;
+	styles[5500] = 3;
+	EXPECT_TRUE(pcb->SetStyles(0, 10001, styles.c_str(), '\377', changeStart, changeEnd));
+	EXPECT_EQ(4500, changeStart);
+	EXPECT_EQ(5501, changeEnd);
+	EXPECT_EQ(3, pcb->StyleAt(4500));
+	EXPECT_EQ(0, pcb->StyleAt(4501));
+	EXPECT_EQ(3, pcb->StyleAt(5500));
+	// Bits outside the mask are kept and do not count as changes
+	styles[4500] = 0x43;
+	EXPECT_FALSE(pcb->SetStyles(0, 10001, styles.c_str(), 0x1f, changeStart, changeEnd));
+	EXPECT_EQ(3, pcb->StyleAt(4500));
+	EXPECT_TRUE(pcb->SetStyleFor(9000, 1001, 0x25, 0x1f, changeStart, changeEnd));
+	EXPECT_EQ(9000, changeStart);
+	EXPECT_EQ(10001, changeEnd);
+	EXPECT_EQ(5, pcb->StyleAt(10000));
+}
+
+TEST_F(CellBufferTest, SetStylesPastEnd) {
+	bool startSequence;
+	pcb->InsertString(0, "abc", 3, startSequence);
+	Sci_Position changeStart = -1;
+	Sci_Position changeEnd = -1;
+	EXPECT_TRUE(pcb->SetStyles(1, 4, "\1\2\3\4", '\377', changeStart, changeEnd));
+	EXPECT_EQ(1, changeStart);
+	EXPECT_EQ(3, changeEnd);
+	EXPECT_EQ(0, pcb->StyleAt(0));
+	EXPECT_EQ(2, pcb->StyleAt(2));
+	EXPECT_FALSE(pcb->SetStyles(3, 1, "\5", '\377', changeStart, changeEnd));
+	EXPECT_FALSE(pcb->SetStyleFor(2, 2, 2, '\377', changeStart, changeEnd));
+}
@@ -0,0 +1,203 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "BlockVector.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "Document.h"
+
+#include <gtest/gtest.h>
+
+// Test Document.
+
+class DocumentTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		pdoc = new Document();
+		pdoc->AddRef();
+	}
+
+	virtual void TearDown() {
+		pdoc->Release();
+		pdoc = 0;
+	}
+
+	void Insert(const char *s) {
+		pdoc->InsertString(pdoc->Length(), s, static_cast<int>(strlen(s)));
+	}
+
+	std::string Text() {
+		std::string text(pdoc->Length(), '\0');
+		if (!text.empty())
+			pdoc->GetCharRange(&text[0], 0, pdoc->Length());
+		return text;
+	}
+
+	// Replace every occurrence of find in the document with replacement
+	int ReplaceAll(const char *find, const char *replacement) {
+		const std::string text = Text();
+		starts.clear();
+		ends.clear();
+		std::string replacements;
+		std::vector<int> replacementEnds;
+		for (size_t pos = text.find(find); pos != std::string::npos; pos = text.find(find, pos + strlen(find))) {
+			starts.push_back(static_cast<int>(pos));
+			ends.push_back(static_cast<int>(pos + strlen(find)));
+			replacements += replacement;
+			replacementEnds.push_back(static_cast<int>(replacements.length()));
+		}
+		return pdoc->ReplaceRanges(starts, ends, replacements, replacementEnds);
+	}
+
+	// The line starts must be those found by scanning the text for line ends
+	void CheckLines() {
+		const std::string text = Text();
+		std::vector<int> lineStarts(1, 0);
+		for (size_t i = 0; i < text.length(); i++) {
+			if ((text[i] == '\n') || ((text[i] == '\r') && (text[i + 1] != '\n')))
+				lineStarts.push_back(static_cast<int>(i + 1));
+		}
+		ASSERT_EQ(static_cast<int>(lineStarts.size()), pdoc->LinesTotal()) << text;
+		for (size_t line = 0; line < lineStarts.size(); line++)
+			EXPECT_EQ(lineStarts[line], pdoc->LineStart(static_cast<int>(line))) << text;
+	}
+
+	Document *pdoc;
+	std::vector<int> starts;
+	std::vector<int> ends;
+};
+
+TEST_F(DocumentTest, ReplaceRanges) {
+	Insert("a=1;\nb=1;\nc=2;\nd=1;\n");
+	EXPECT_EQ(3, ReplaceAll("1", "one"));
+	EXPECT_EQ("a=one;\nb=one;\nc=2;\nd=one;\n", Text());
+	EXPECT_EQ(2, starts[0]);
+	EXPECT_EQ(5, ends[0]);
+	EXPECT_EQ(9, starts[1]);
+	EXPECT_EQ(21, starts[2]);
+	EXPECT_EQ(24, ends[2]);
+	EXPECT_EQ(3, ReplaceAll("one", ""));
+	EXPECT_EQ(0, ReplaceAll("one", "x"));
+	EXPECT_EQ("a=;\nb=;\nc=2;\nd=;\n", Text());
+}
+
+TEST_F(DocumentTest, ReplaceRangesKeepsLineData) {
+	Insert("find\nkeep\nkeep\nfind\n");
+	pdoc->AnnotationSetText(1, "annotation");
+	pdoc->MarginSetText(2, "margin");
+	pdoc->AddMark(1, 3);
+	pdoc->DecorationSetCurrentIndicator(0);
+	pdoc->DecorationFillRange(10, 1, 4);
+	EXPECT_EQ(2, ReplaceAll("find", "replaced"));
+	EXPECT_EQ("replaced\nkeep\nkeep\nreplaced\n", Text());
+	EXPECT_EQ(10, pdoc->AnnotationLength(1));
+	EXPECT_EQ(6, pdoc->MarginLength(2));
+	EXPECT_EQ(1 << 3, pdoc->GetMark(1));
+	EXPECT_EQ(0, pdoc->decorations.ValueAt(0, 13));
+	EXPECT_EQ(1, pdoc->decorations.ValueAt(0, 14));
+	EXPECT_EQ(1, pdoc->decorations.ValueAt(0, 17));
+	EXPECT_EQ(0, pdoc->decorations.ValueAt(0, 18));
+}
+
+TEST_F(DocumentTest, ReplaceRangesUndoneAsOne) {
+	Insert("find\nkeep\nfind\nkeep\nfind");
+	pdoc->DeleteUndoHistory();
+	pdoc->AddMark(1, 3);
+	pdoc->AddMark(3, 4);
+	EXPECT_EQ(3, ReplaceAll("find", "x\ny"));
+	EXPECT_EQ("x\ny\nkeep\nx\ny\nkeep\nx\ny", Text());
+	CheckLines();
+	EXPECT_EQ(1 << 3, pdoc->GetMark(2));
+	EXPECT_EQ(1 << 4, pdoc->GetMark(5));
+	pdoc->Undo();
+	EXPECT_EQ("find\nkeep\nfind\nkeep\nfind", Text());
+	CheckLines();
+	EXPECT_EQ(1 << 3, pdoc->GetMark(1));
+	EXPECT_EQ(1 << 4, pdoc->GetMark(3));
+	EXPECT_FALSE(pdoc->CanUndo());
+	pdoc->Redo();
+	EXPECT_EQ("x\ny\nkeep\nx\ny\nkeep\nx\ny", Text());
+	CheckLines();
+	EXPECT_EQ(1 << 3, pdoc->GetMark(2));
+	EXPECT_EQ(1 << 4, pdoc->GetMark(5));
+	EXPECT_FALSE(pdoc->CanRedo());
+}
+
+TEST_F(DocumentTest, ReplaceRangesLineEnds) {
+	// Replacements that split, join, make and remove crlf pairs and line ends
+	Insert("a\r\nb\rc\nd\r\r\ne");
+	const std::string original = Text();
+	EXPECT_EQ(4, ReplaceAll("\r", "\n"));
+	CheckLines();
+	pdoc->Undo();
+	EXPECT_EQ(original, Text());
+	CheckLines();
+	EXPECT_EQ(3, ReplaceAll("\n", "\r"));
+	EXPECT_EQ("a\r\rb\rc\rd\r\r\re", Text());
+	CheckLines();
+	EXPECT_EQ(1, ReplaceAll("c\r", "\n"));
+	CheckLines();
+	EXPECT_EQ(2, ReplaceAll("\r\r", "x\r\n"));
+	EXPECT_EQ("ax\r\nb\r\ndx\r\n\re", Text());
+	CheckLines();
+	EXPECT_EQ(3, ReplaceAll("\n", ""));
+	EXPECT_EQ("ax\rb\rdx\r\re", Text());
+	CheckLines();
+	while (pdoc->CanUndo())
+		pdoc->Undo();
+	EXPECT_EQ("", Text());
+	while (pdoc->CanRedo())
+		pdoc->Redo();
+	EXPECT_EQ("ax\rb\rdx\r\re", Text());
+	CheckLines();
+}
+
+TEST_F(DocumentTest, SetStylesPastEnd) {
+	Insert("abc");
+	pdoc->StartStyling(1, '\377');
+	EXPECT_TRUE(pdoc->SetStyles(4, "\1\2\3\4"));
+	EXPECT_EQ(0, pdoc->StyleAt(0));
+	EXPECT_EQ(1, pdoc->StyleAt(1));
+	EXPECT_EQ(2, pdoc->StyleAt(2));
+	EXPECT_EQ(3, pdoc->GetEndStyled());
+	pdoc->StartStyling(2, '\377');
+	EXPECT_TRUE(pdoc->SetStyleFor(3, 5));
+	EXPECT_EQ(5, pdoc->StyleAt(2));
+	EXPECT_EQ(3, pdoc->GetEndStyled());
+}
+
+// A line that is copied to be searched must be copied again once its text changes
+TEST_F(DocumentTest, RegexSeesChangedLine) {
+	const int flagsEngine[] = { 0, SCFIND_LINEARREGEX };
+	pdoc->SetCaseFolder(new CaseFolderTable());
+	for (int e = 0; e < 2; e++) {
+		pdoc->DeleteChars(0, pdoc->Length());
+		Insert("one two\nthree\n");
+		// Leaves the gap inside the first line
+		pdoc->InsertString(3, "X", 1);
+		int length = 3;
+		EXPECT_EQ(3, pdoc->FindText(0, pdoc->Length(), "X t", true, false, false, true, flagsEngine[e], &length));
+		length = 3;
+		EXPECT_EQ(3, pdoc->FindText(0, pdoc->Length(), "X t", true, false, false, true, flagsEngine[e], &length));
+		// Same line start and length but different text
+		pdoc->DeleteChars(3, 1);
+		pdoc->InsertString(3, "Y", 1);
+		length = 3;
+		EXPECT_EQ(-1, pdoc->FindText(0, pdoc->Length(), "X t", true, false, false, true, flagsEngine[e], &length));
+		length = 3;
+		EXPECT_EQ(3, pdoc->FindText(0, pdoc->Length(), "Y t", true, false, false, true, flagsEngine[e], &length));
+	}
+}
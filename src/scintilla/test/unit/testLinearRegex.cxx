@@ -0,0 +1,114 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <string.h>
+#include <ctype.h>
+
+#include <string>
+
+#include "Platform.h"
+
+#include "LinearRegex.h"
+
+#include <gtest/gtest.h>
+
+// Test LinearRegex.
+
+class LinearRegexTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		for (int ch = 0; ch < 256; ch++)
+			wordBytes[ch] = (ch >= 0x80) || isalnum(ch) || (ch == '_');
+		Encoding(LinearRegex::encUTF8);
+	}
+
+	void Encoding(LinearRegex::Encoding encoding) {
+		lr.SetEncoding(encoding, 0, 0, wordBytes);
+	}
+
+	// Returns the text matched by pattern or "-" when there is no match.
+	std::string Match(const char *pattern, const std::string &text, bool caseSensitive=true) {
+		if (lr.Compile(pattern, static_cast<int>(strlen(pattern)), caseSensitive, true))
+			return "error";
+		const int length = static_cast<int>(text.length());
+		if (!lr.Search(text.c_str(), length, 0, length))
+			return "-";
+		return text.substr(lr.groupStart[0], lr.groupEnd[0] - lr.groupStart[0]);
+	}
+
+	LinearRegex lr;
+	char wordBytes[256];
+};
+
+TEST_F(LinearRegexTest, Literals) {
+	EXPECT_EQ("abc", Match("abc", "xxabcxx"));
+	EXPECT_EQ("-", Match("abd", "xxabcxx"));
+	EXPECT_EQ("a.c", Match("a\\.c", "abc a.c"));
+	EXPECT_EQ("error", Match("\\1", "aa"));
+	EXPECT_EQ("error", Match("(a", "a"));
+	EXPECT_EQ("error", Match("[a", "a"));
+}
+
+TEST_F(LinearRegexTest, LeftmostFirst) {
+	EXPECT_EQ("b", Match("a|b|c", "xbca"));
+	EXPECT_EQ("ab", Match("ab|abcd", "abcd"));
+	EXPECT_EQ("aaa", Match("a+", "baaab"));
+	EXPECT_EQ("a", Match("a+?", "baaab"));
+	EXPECT_EQ("aa", Match("a{2}", "aaaa"));
+	EXPECT_EQ("aaa", Match("a{1,3}", "aaaa"));
+	EXPECT_EQ("xy", Match("x[^a]", "xaxy"));
+}
+
+TEST_F(LinearRegexTest, Groups) {
+	ASSERT_EQ("key=value", Match("(\\w+)=(\\w*)", " key=value"));
+	EXPECT_EQ(1, lr.groupStart[1]);
+	EXPECT_EQ(4, lr.groupEnd[1]);
+	EXPECT_EQ(5, lr.groupStart[2]);
+	EXPECT_EQ(10, lr.groupEnd[2]);
+	ASSERT_EQ("b", Match("(a)|(b)", "b"));
+	EXPECT_EQ(-1, lr.groupStart[1]);
+	EXPECT_EQ(0, lr.groupStart[2]);
+}
+
+TEST_F(LinearRegexTest, Assertions) {
+	EXPECT_EQ("-", Match("^b", "ab"));
+	EXPECT_EQ("a", Match("^a", "ab"));
+	EXPECT_EQ("b", Match("b$", "bab"));
+	EXPECT_EQ("cat", Match("\\<cat\\>", "concat cat"));
+	lr.Compile("\\bx", 3, true, true);
+	EXPECT_FALSE(lr.Search("ax x", 4, 0, 2));
+	ASSERT_TRUE(lr.Search("ax x", 4, 0, 4));
+	EXPECT_EQ(3, lr.groupStart[0]);
+}
+
+TEST_F(LinearRegexTest, Range) {
+	lr.Compile("ab", 2, true, true);
+	// Matches must lie within the range but assertions see the whole line
+	EXPECT_FALSE(lr.Search("abab", 4, 1, 3));
+	ASSERT_TRUE(lr.Search("abab", 4, 1, 4));
+	EXPECT_EQ(2, lr.groupStart[0]);
+	lr.Compile("b$", 2, true, true);
+	EXPECT_FALSE(lr.Search("abab", 4, 0, 2));
+}
+
+TEST_F(LinearRegexTest, UTF8) {
+	EXPECT_EQ("\xc3\xa9", Match(".", "\xc3\xa9"));
+	EXPECT_EQ("\xc3\xa9t\xc3\xa9", Match("[^a]+", "a\xc3\xa9t\xc3\xa9"));
+	EXPECT_EQ("\xc3\x89", Match("\xc3\xa9", "e\xc3\x89", false));
+	EXPECT_EQ("\xd0\x96\xd0\xb6", Match("\xd0\xb6+", "\xd0\x96\xd0\xb6", false));
+	EXPECT_EQ("\xe2\x82\xac", Match("\\x{20ac}", "$\xe2\x82\xac"));
+	EXPECT_EQ("caf\xc3\xa9", Match("\\w+", " caf\xc3\xa9 "));
+}
+
+TEST_F(LinearRegexTest, SingleByte) {
+	Encoding(LinearRegex::encSingleByte);
+	EXPECT_EQ("\xe9", Match(".", "\xe9\xe9"));
+	EXPECT_EQ("\xe9", Match("\\xe9", "e\xe9"));
+}
+
+TEST_F(LinearRegexTest, Pathological) {
+	// Would take exponential time with a backtracking matcher
+	const std::string text(10000, 'a');
+	EXPECT_EQ("-", Match("(a*)*b", text));
+	EXPECT_EQ("-", Match("(a|aa)*c", text));
+	EXPECT_EQ("error", Match("(a{1000}){1000}", text));
+}
@@ -12,7 +12,7 @@
 const int growSize = 4;
 
 const int lengthTestArray = 8;
-static const int testArray[lengthTestArray] = {3, 4, 5, 6, 7, 8, 9, 10};
+static const Sci_Position testArray[lengthTestArray] = {3, 4, 5, 6, 7, 8, 9, 10};
 
 // Test SplitVectorWithRangeAdd.
 
@@ -206,3 +206,115 @@ TEST_F(PartitioningTest, OutOfRangeDeathTest) {
 	ASSERT_DEATH(pp->PositionFromPartition(3), "Assertion");
 }
 #endif
+
+// Test BlockPartitioning.
+
+class BlockPartitioningTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		// Small blocks so that tests cross block boundaries
+		pbp = new BlockPartitioning(growSize, 4);
+	}
+
+	virtual void TearDown() {
+		delete pbp;
+		pbp = 0;
+	}
+
+	BlockPartitioning *pbp;
+};
+
+TEST_F(BlockPartitioningTest, IsEmptyInitially) {
+	EXPECT_EQ(1, pbp->Partitions());
+	EXPECT_EQ(0, pbp->PositionFromPartition(pbp->Partitions()));
+	EXPECT_EQ(0, pbp->PartitionFromPosition(0));
+}
+
+TEST_F(BlockPartitioningTest, TestMany) {
+	pbp->InsertText(0, 42);
+	for (int i=0; i<20; i++) {
+		pbp->InsertPartition(i+1, (i+1) * 2);
+	}
+	for (int i=20; i>0; i--) {
+		pbp->InsertText(i,2);
+	}
+	EXPECT_EQ(21, pbp->Partitions());
+	for (int i=1; i<20; i++) {
+		EXPECT_EQ(i*4 - 2, pbp->PositionFromPartition(i));
+		EXPECT_EQ(i, pbp->PartitionFromPosition(i*4 - 2));
+	}
+	pbp->InsertText(19,2);
+	EXPECT_EQ(3, pbp->PartitionFromPosition(10));
+	pbp->InsertText(0,2);
+	pbp->InsertText(0,-2);
+	pbp->RemovePartition(1);
+	EXPECT_EQ(0, pbp->PositionFromPartition(0));
+	EXPECT_EQ(6, pbp->PositionFromPartition(1));
+	EXPECT_EQ(10, pbp->PositionFromPartition(2));
+	pbp->RemovePartition(10);
+	EXPECT_EQ(46, pbp->PositionFromPartition(10));
+	EXPECT_EQ(10, pbp->PartitionFromPosition(46));
+	EXPECT_EQ(50, pbp->PositionFromPartition(11));
+	EXPECT_EQ(11, pbp->PartitionFromPosition(50));
+}
+
+TEST_F(BlockPartitioningTest, MatchesSimpleArray) {
+	// Perform the same pseudo-random edits on an array of all the starts and compare
+	SplitVector<Sci_Position> starts;
+	starts.Insert(0, 0);
+	starts.Insert(1, 0);
+	unsigned int seed = 1;
+	int partitionsMost = 0;
+	for (int step=0; step<2000; step++) {
+		seed = seed * 1103515245 + 12345;
+		const int r = (seed >> 8) & 0xffff;
+		const int partitions = static_cast<int>(starts.Length() - 1);
+		const int partition = r % partitions;
+		const Sci_Position start = starts.ValueAt(partition);
+		const Sci_Position end = starts.ValueAt(partition + 1);
+		switch (r % 6) {
+		case 0:
+		case 1: {
+				const Sci_Position delta = r % 7 + 1;
+				for (int i=partition+1; i<=partitions; i++)
+					starts.SetValueAt(i, starts.ValueAt(i) + delta);
+				pbp->InsertText(partition, delta);
+			}
+			break;
+		case 2:
+		case 3:
+			if (end - start > 1) {
+				const Sci_Position pos = start + 1 + r % (end - start - 1);
+				starts.Insert(partition + 1, pos);
+				pbp->InsertPartition(partition + 1, pos);
+			}
+			break;
+		case 4:
+			if (partition > 0) {
+				starts.Delete(partition);
+				pbp->RemovePartition(partition);
+			}
+			break;
+		case 5:
+			if ((partition > 0) && (end - start > 1)) {
+				starts.SetValueAt(partition, start + 1);
+				pbp->SetPartitionStartPosition(partition, start + 1);
+			}
+			break;
+		}
+		ASSERT_EQ(starts.Length() - 1, pbp->Partitions());
+		if (partitionsMost < pbp->Partitions())
+			partitionsMost = pbp->Partitions();
+		for (int i=0; i<=pbp->Partitions(); i++) {
+			ASSERT_EQ(starts.ValueAt(i), pbp->PositionFromPartition(i));
+		}
+		int partitionExpected = 0;
+		for (Sci_Position pos=0; pos<=starts.ValueAt(pbp->Partitions()); pos+=(step % 7) + 1) {
+			while ((partitionExpected + 1 < pbp->Partitions()) && (starts.ValueAt(partitionExpected + 1) <= pos))
+				partitionExpected++;
+			ASSERT_EQ(partitionExpected, pbp->PartitionFromPosition(pos));
+		}
+	}
+	// Enough partitions to have split and merged blocks
+	EXPECT_LT(20, partitionsMost);
+}
@@ -92,8 +92,8 @@ TEST_F(RunStylesTest, LongerRuns) {
 
 TEST_F(RunStylesTest, FillRange) {
 	prs->InsertSpace(0, 5);
-	int startFill = 1;
-	int lengthFill = 3;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 3;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(1, startFill);
 	EXPECT_EQ(3, lengthFill);
@@ -113,14 +113,14 @@ TEST_F(RunStylesTest, FillRange) {
 
 TEST_F(RunStylesTest, FillRangeAlreadyFilled) {
 	prs->InsertSpace(0, 5);
-	int startFill = 1;
-	int lengthFill = 3;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 3;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(1, startFill);
 	EXPECT_EQ(3, lengthFill);
 
-	int startFill2 = 2;
-	int lengthFill2 = 1;
+	Sci_Position startFill2 = 2;
+	Sci_Position lengthFill2 = 1;
 	// Compiler warnings if 'false' used instead of '0' as expected value:
 	EXPECT_EQ(0, prs->FillRange(startFill2, 99, lengthFill2));
 	EXPECT_EQ(2, startFill2);
@@ -135,14 +135,14 @@ TEST_F(RunStylesTest, FillRangeAlreadyFilled) {
 
 TEST_F(RunStylesTest, FillRangeAlreadyPartFilled) {
 	prs->InsertSpace(0, 5);
-	int startFill = 1;
-	int lengthFill = 2;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 2;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(1, startFill);
 	EXPECT_EQ(2, lengthFill);
 
-	int startFill2 = 2;
-	int lengthFill2 = 2;
+	Sci_Position startFill2 = 2;
+	Sci_Position lengthFill2 = 2;
 	EXPECT_EQ(true, prs->FillRange(startFill2, 99, lengthFill2));
 	EXPECT_EQ(3, startFill2);
 	EXPECT_EQ(1, lengthFill2);
@@ -173,8 +173,8 @@ TEST_F(RunStylesTest, DeleteRange) {
 
 TEST_F(RunStylesTest, Find) {
 	prs->InsertSpace(0, 5);
-	int startFill = 1;
-	int lengthFill = 3;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 3;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(1, startFill);
 	EXPECT_EQ(3, lengthFill);
@@ -210,8 +210,8 @@ TEST_F(RunStylesTest, AllSame) {
 	EXPECT_EQ(true, prs->AllSame());
 	EXPECT_EQ(0, prs->AllSameAs(88));
 	EXPECT_EQ(true, prs->AllSameAs(0));
-	int startFill = 1;
-	int lengthFill = 3;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 3;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(0, prs->AllSame());
 	EXPECT_EQ(0, prs->AllSameAs(88));
@@ -226,8 +226,8 @@ TEST_F(RunStylesTest, FindWithReversion) {
 	prs->InsertSpace(0, 5);
 	EXPECT_EQ(1, prs->Runs());
 
-	int startFill = 1;
-	int lengthFill = 1;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 1;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(1, startFill);
 	EXPECT_EQ(1, lengthFill);
@@ -283,8 +283,8 @@ TEST_F(RunStylesTest, DeleteAll) {
 
 TEST_F(RunStylesTest, DeleteSecond) {
 	prs->InsertSpace(0, 3);
-	int startFill = 1;
-	int lengthFill = 1;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 1;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(3, prs->Length());
 	EXPECT_EQ(3, prs->Runs());
@@ -295,8 +295,8 @@ TEST_F(RunStylesTest, DeleteSecond) {
 
 TEST_F(RunStylesTest, DeleteEndRun) {
 	prs->InsertSpace(0, 2);
-	int startFill = 1;
-	int lengthFill = 1;
+	Sci_Position startFill = 1;
+	Sci_Position lengthFill = 1;
 	EXPECT_EQ(true, prs->FillRange(startFill, 99, lengthFill));
 	EXPECT_EQ(2, prs->Length());
 	EXPECT_EQ(2, prs->Runs());
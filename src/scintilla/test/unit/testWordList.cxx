@@ -0,0 +1,131 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "Platform.h"
+
+#include "WordList.h"
+
+#include <gtest/gtest.h>
+
+// Test WordList.
+
+class WordListTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		pwl = new WordList();
+	}
+
+	virtual void TearDown() {
+		delete pwl;
+		pwl = 0;
+	}
+
+	WordList *pwl;
+};
+
+TEST_F(WordListTest, IsEmptyInitially) {
+	EXPECT_FALSE(*pwl);
+	EXPECT_FALSE(pwl->InList("int"));
+}
+
+TEST_F(WordListTest, InList) {
+	pwl->Set("int char\tdouble\nif else");
+	EXPECT_EQ(5, pwl->len);
+	EXPECT_TRUE(pwl->InList("int"));
+	EXPECT_TRUE(pwl->InList("double"));
+	EXPECT_TRUE(pwl->InList("else"));
+	EXPECT_FALSE(pwl->InList("in"));
+	EXPECT_FALSE(pwl->InList("integer"));
+	EXPECT_FALSE(pwl->InList("Int"));
+	EXPECT_FALSE(pwl->InList(""));
+}
+
+TEST_F(WordListTest, WordsStaySorted) {
+	pwl->Set("zeta alpha mu");
+	EXPECT_STREQ("alpha", pwl->words[0]);
+	EXPECT_STREQ("mu", pwl->words[1]);
+	EXPECT_STREQ("zeta", pwl->words[2]);
+	EXPECT_EQ(1, pwl->starts[static_cast<unsigned char>('m')]);
+	EXPECT_EQ(-1, pwl->starts[static_cast<unsigned char>('b')]);
+}
+
+TEST_F(WordListTest, Prefixes) {
+	pwl->Set("^GTK_ ^gdk_pixbuf int");
+	EXPECT_TRUE(pwl->InList("GTK_"));
+	EXPECT_TRUE(pwl->InList("GTK_MAJOR_VERSION"));
+	EXPECT_TRUE(pwl->InList("gdk_pixbuf_new"));
+	EXPECT_FALSE(pwl->InList("GTK"));
+	EXPECT_FALSE(pwl->InList("gdk_pix"));
+	EXPECT_TRUE(pwl->InList("int"));
+	EXPECT_FALSE(pwl->InList("integer"));
+}
+
+TEST_F(WordListTest, EmptyPrefixMatchesAll) {
+	pwl->Set("^ int");
+	EXPECT_TRUE(pwl->InList("anything"));
+}
+
+TEST_F(WordListTest, Abbreviated) {
+	pwl->Set("def~ine pro~mpt exit");
+	EXPECT_TRUE(pwl->InListAbbreviated("def", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("defi", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("define", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("de", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("defines", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("prompt", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("exit", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("exi", '~'));
+}
+
+TEST_F(WordListTest, AbbreviatedAmongManyWords) {
+	std::string words;
+	for (int i = 0; i < 5000; i++) {
+		char word[20];
+		sprintf(word, "d%d ", i);
+		words += word;
+	}
+	words += "def~ine d~o d.x ~tilde";
+	pwl->Set(words.c_str());
+	EXPECT_TRUE(pwl->InListAbbreviated("d42", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("d42x", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("defin", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("do", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("d.x", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("d.", '~'));
+	EXPECT_TRUE(pwl->InListAbbreviated("~tilde", '~'));
+	EXPECT_FALSE(pwl->InListAbbreviated("def~ine", '~'));
+	// Markers other than punctuation are found by scanning every word
+	EXPECT_TRUE(pwl->InListAbbreviated("d4", '2'));
+	EXPECT_FALSE(pwl->InListAbbreviated("e4", '2'));
+}
+
+TEST_F(WordListTest, ManyWords) {
+	std::string words;
+	for (int i = 0; i < 5000; i++) {
+		char word[20];
+		sprintf(word, "w%d ", i * 3);
+		words += word;
+	}
+	pwl->Set(words.c_str());
+	for (int i = 0; i < 15000; i++) {
+		char word[20];
+		sprintf(word, "w%d", i);
+		EXPECT_EQ((i % 3) == 0, pwl->InList(word));
+	}
+}
+
+TEST_F(WordListTest, SetReplaces) {
+	pwl->Set("one two");
+	pwl->Set("three ^fo");
+	EXPECT_FALSE(pwl->InList("one"));
+	EXPECT_TRUE(pwl->InList("three"));
+	EXPECT_TRUE(pwl->InList("four"));
+	pwl->Set("five");
+	EXPECT_FALSE(pwl->InList("four"));
+	pwl->Clear();
+	EXPECT_FALSE(pwl->InList("five"));
+}
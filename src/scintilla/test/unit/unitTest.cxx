@@ -6,16 +6,18 @@
         Partitioning
         RunStyles
         ContractionState
+        BlockVector
+        CellBuffer
+        LinearRegex
+        Document
 
     To do:
         Decoration
         DecorationList
         PerLine *
-        CellBuffer *
         Range
         StyledText
         CaseFolder ...
-        Document
         RESearch
         Selection
         UniConversion
@@ -32,6 +34,9 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
 
 #include "Platform.h"
 
@@ -44,6 +49,56 @@ void Platform::Assert(const char *c, const char *file, int line) {
 	abort();
 }
 
+void Platform::DebugPrintf(const char *format, ...) {
+	va_list pArguments;
+	va_start(pArguments, format);
+	vfprintf(stderr, format, pArguments);
+	va_end(pArguments);
+}
+
+// Needed by Document
+
+ElapsedTime::ElapsedTime() {
+	bigBit = static_cast<long>(clock());
+	littleBit = 0;
+}
+
+double ElapsedTime::Duration(bool reset) {
+	const long now = static_cast<long>(clock());
+	const double duration = static_cast<double>(now - bigBit) / CLOCKS_PER_SEC;
+	if (reset)
+		bigBit = now;
+	return duration;
+}
+
+int Platform::Minimum(int a, int b) {
+	return (a < b) ? a : b;
+}
+
+int Platform::Maximum(int a, int b) {
+	return (a > b) ? a : b;
+}
+
+int Platform::Clamp(int val, int minVal, int maxVal) {
+	if (val > maxVal)
+		val = maxVal;
+	if (val < minVal)
+		val = minVal;
+	return val;
+}
+
+bool Platform::IsDBCSLeadByte(int, char) {
+	return false;
+}
+
+int Platform::DBCSCharLength(int, const char *) {
+	return 1;
+}
+
+int Platform::DBCSCharMaxLength() {
+	return 2;
+}
+
 int main(int argc, char **argv) {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -46,6 +46,7 @@
 #endif
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "BlockVector.h"
 #include "RunStyles.h"
 #include "ContractionState.h"
 #include "CellBuffer.h"
@@ -1307,7 +1308,7 @@ void ScintillaWin::ScrollText(int /* linesToMove */) {
 	//::ScrollWindow(MainHWND(), 0,
 	//	vs.lineHeight * linesToMove, 0, 0);
 	//::UpdateWindow(MainHWND());
-	Redraw();
+	RedrawRetained();
 }
 
 void ScintillaWin::UpdateSystemCaret() {
@@ -50,6 +50,14 @@ LDFLAGS=$(LDDEBUG) $(LDFLAGS)
 CXXFLAGS=$(CXXFLAGS) $(CXXNDEBUG)
 !ENDIF
 
+!IFDEF LARGE_FILE
+CXXFLAGS=$(CXXFLAGS) -DSCI_LARGE_FILE_SUPPORT
+!ENDIF
+
+!IFDEF BLOCK_STORAGE
+CXXFLAGS=$(CXXFLAGS) -DSCI_BLOCK_STORAGE
+!ENDIF
+
 INCLUDEDIRS=-I../include -I../src -I../lexlib
 CXXFLAGS=$(CXXFLAGS) $(INCLUDEDIRS)
 
@@ -72,6 +80,7 @@ SOBJS=\
 	$(DIR_O)\Indicator.obj \
 	$(DIR_O)\KeyMap.obj \
 	$(DIR_O)\LineMarker.obj \
+	$(DIR_O)\LinearRegex.obj \
 	$(DIR_O)\PerLine.obj \
 	$(DIR_O)\PlatWin.obj \
 	$(DIR_O)\PositionCache.obj \
@@ -203,6 +212,7 @@ LOBJS=\
 	$(DIR_O)\LexerModule.obj \
 	$(DIR_O)\LexerSimple.obj \
 	$(DIR_O)\LineMarker.obj \
+	$(DIR_O)\LinearRegex.obj \
 	$(DIR_O)\PerLine.obj \
 	$(DIR_O)\PlatWin.obj \
 	$(DIR_O)\PositionCache.obj \
@@ -279,7 +289,7 @@ $(DIR_O)\Document.obj: ../src/Document.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SVector.h ../src/SplitVector.h \
   ../src/Partitioning.h ../src/RunStyles.h ../src/CellBuffer.h \
   ../src/CharClassify.h ../src/Decoration.h ../src/Document.h \
-  ../src/RESearch.h ../src/PerLine.h
+  ../src/RESearch.h ../src/LinearRegex.h ../src/PerLine.h
 $(DIR_O)\Editor.obj: ../src/Editor.cxx ../include/Platform.h ../include/Scintilla.h \
   ../src/ContractionState.h ../src/SVector.h ../src/SplitVector.h \
   ../src/Partitioning.h ../src/CellBuffer.h ../src/KeyMap.h \
@@ -502,6 +512,7 @@ $(DIR_O)\PositionCache.obj: ../src/PositionCache.cxx ../include/Platform.h ../in
   ../src/Decoration.h ../src/Document.h ../src/Editor.h ../src/Selection.h ../src/PositionCache.h
 $(DIR_O)\PropSetSimple.obj: ../lexlib/PropSetSimple.cxx ../include/Platform.h
 $(DIR_O)\RESearch.obj: ../src/RESearch.cxx ../src/CharClassify.h ../src/RESearch.h
+$(DIR_O)\LinearRegex.obj: ../src/LinearRegex.cxx ../src/LinearRegex.h
 $(DIR_O)\RunStyles.obj: ../src/RunStyles.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
   ../src/RunStyles.h
@@ -67,6 +67,7 @@ SOBJS=\
 	$(DIR_O)\Indicator.obj \
 	$(DIR_O)\KeyMap.obj \
 	$(DIR_O)\LineMarker.obj \
+	$(DIR_O)\LinearRegex.obj \
 	$(DIR_O)\PerLine.obj \
 	$(DIR_O)\PlatWin.obj \
 	$(DIR_O)\PositionCache.obj \
@@ -198,6 +199,7 @@ LOBJS=\
 	$(DIR_O)\LexerModule.obj \
 	$(DIR_O)\LexerSimple.obj \
 	$(DIR_O)\LineMarker.obj \
+	$(DIR_O)\LinearRegex.obj \
 	$(DIR_O)\PerLine.obj \
 	$(DIR_O)\PlatWin.obj \
 	$(DIR_O)\PositionCache.obj \
@@ -271,7 +273,7 @@ $(DIR_O)\Document.obj: ../src/Document.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SVector.h ../src/SplitVector.h \
   ../src/Partitioning.h ../src/RunStyles.h ../src/CellBuffer.h \
   ../src/CharClassify.h ../src/Decoration.h ../src/Document.h \
-  ../src/RESearch.h ../src/PerLine.h
+  ../src/RESearch.h ../src/LinearRegex.h ../src/PerLine.h
 $(DIR_O)\Editor.obj: ../src/Editor.cxx ../include/Platform.h ../include/Scintilla.h \
   ../src/ContractionState.h ../src/SVector.h ../src/SplitVector.h \
   ../src/Partitioning.h ../src/CellBuffer.h ../src/KeyMap.h \
@@ -494,6 +496,7 @@ $(DIR_O)\PositionCache.obj: ../src/Editor.cxx ../include/Platform.h ../include/S
   ../src/Decoration.h ../src/Document.h ../src/Editor.h ../src/Selection.h ../src/PositionCache.h
 $(DIR_O)\PropSetSimple.obj: ../lexlib/PropSetSimple.cxx ../include/Platform.h
 $(DIR_O)\RESearch.obj: ../src/RESearch.cxx ../src/CharClassify.h ../src/RESearch.h
+$(DIR_O)\LinearRegex.obj: ../src/LinearRegex.cxx ../src/LinearRegex.h
 $(DIR_O)\RunStyles.obj: ../src/RunStyles.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
   ../src/RunStyles.h
@@ -563,6 +563,10 @@ SOURCE=..\..\scintilla\src\LineMarker.cxx
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\scintilla\src\LinearRegex.cxx
+# End Source File
+# Begin Source File
+
 SOURCE=..\lua\src\lib\linit.c
 # End Source File
 # Begin Source File
@@ -8,17 +8,54 @@
 
 // http://www.microsoft.com/msj/0797/win320797.aspx
 
+#include <glib.h>
+
 #include "Mutex.h"
 
+// Find in Files searches on several threads so this must really exclude them
 class GTKMutex : public Mutex {
 private:
-	virtual void Lock() {}
-	virtual void Unlock() {}
-	GTKMutex() {}
-	virtual ~GTKMutex() {}
+#if GLIB_CHECK_VERSION(2,31,0)
+	GMutex mutex;
+	virtual void Lock() { g_mutex_lock(&mutex); }
+	virtual void Unlock() { g_mutex_unlock(&mutex); }
+	GTKMutex() { g_mutex_init(&mutex); }
+	virtual ~GTKMutex() { g_mutex_clear(&mutex); }
+#else
+	// A static mutex may be created before g_thread_init is called
+	GStaticMutex mutex;
+	virtual void Lock() { g_static_mutex_lock(&mutex); }
+	virtual void Unlock() { g_static_mutex_unlock(&mutex); }
+	GTKMutex() { g_static_mutex_init(&mutex); }
+	virtual ~GTKMutex() { g_static_mutex_free(&mutex); }
+#endif
 	friend class Mutex;
+	friend class GTKCondition;
 };
 
 Mutex *Mutex::Create() {
    return new GTKMutex();
 }
+
+class GTKCondition : public Condition {
+private:
+	GTKMutex *mutex;
+#if GLIB_CHECK_VERSION(2,31,0)
+	GCond cond;
+	virtual void Wait() { g_cond_wait(&cond, &mutex->mutex); }
+	virtual void Broadcast() { g_cond_broadcast(&cond); }
+	GTKCondition(GTKMutex *mutex_) : mutex(mutex_) { g_cond_init(&cond); }
+	virtual ~GTKCondition() { g_cond_clear(&cond); }
+#else
+	GCond *cond;
+	virtual void Wait() { g_cond_wait(cond, g_static_mutex_get_mutex(&mutex->mutex)); }
+	virtual void Broadcast() { g_cond_broadcast(cond); }
+	GTKCondition(GTKMutex *mutex_) : mutex(mutex_), cond(g_cond_new()) {}
+	virtual ~GTKCondition() { g_cond_free(cond); }
+#endif
+	friend class Condition;
+};
+
+Condition *Condition::Create(Mutex *mutex) {
+   return new GTKCondition(static_cast<GTKMutex *>(mutex));
+}
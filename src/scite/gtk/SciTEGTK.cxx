@@ -344,6 +344,7 @@ public:
 	WComboBoxEntry comboDir;
 	WToggle toggleWord;
 	WToggle toggleCase;
+	WToggle toggleRegExp;
 	WButton btnDotDot;
 	WButton btnBrowse;
 	void GrabFields();
@@ -490,6 +491,7 @@ protected:
 	FilePath sciteExecutable;
 	int icmd;
 	int originalEnd;
+	sptr_t originalTrimmed;
 	int fdFIFO;
 	int pidShell;
 	bool triedKill;
@@ -770,6 +772,7 @@ SciTEGTK::SciTEGTK(Extension *ext) : SciTEBase(ext) {
 	// Control of sub process
 	icmd = 0;
 	originalEnd = 0;
+	originalTrimmed = 0;
 	fdFIFO = 0;
 	pidShell = 0;
 	triedKill = false;
@@ -2101,6 +2104,8 @@ void DialogFindInFiles::GrabFields() {
 		pSearcher->wholeWord = toggleWord.Active();
 	if (toggleCase.Sensitive())
 		pSearcher->matchCase = toggleCase.Active();
+	if (toggleRegExp.Sensitive())
+		pSearcher->regExp = toggleRegExp.Active();
 }
 
 void DialogFindInFiles::FillFields() {
@@ -2109,6 +2114,8 @@ void DialogFindInFiles::FillFields() {
 		toggleWord.SetActive(pSearcher->wholeWord);
 	if (toggleCase.Sensitive())
 		toggleCase.SetActive(pSearcher->matchCase);
+	if (toggleRegExp.Sensitive())
+		toggleRegExp.SetActive(pSearcher->regExp);
 }
 
 void SciTEGTK::FindInFilesCmd() {
@@ -2136,6 +2143,7 @@ void SciTEGTK::FindInFilesCmd() {
 		findCommand += (matchCase ? "c" : "~");
 		findCommand += props.GetInt("find.in.dot") ? "d" : "~";
 		findCommand += props.GetInt("find.in.binary") ? "b" : "~";
+		findCommand += (regExp ? "r" : "~");
 		findCommand += " \"";
 		findCommand += props.Get("find.files");
 		findCommand += "\" \"";
@@ -2479,6 +2487,11 @@ void SciTEGTK::FindInFiles() {
 	gtk_widget_set_sensitive(dlgFindInFiles.toggleCase, enableToggles);
 	table.Add(dlgFindInFiles.toggleCase, 1, true, 3, 0);
 
+	// Regular Expression
+	dlgFindInFiles.toggleRegExp.Create(localiser.Text(toggles[SearchOption::tRegExp].label));
+	gtk_widget_set_sensitive(dlgFindInFiles.toggleRegExp, enableToggles);
+	table.Add(dlgFindInFiles.toggleRegExp, 1, true, 3, 0);
+
 	AttachResponse<&SciTEGTK::FindInFilesResponse>(PWidget(dlgFindInFiles), this);
 	dlgFindInFiles.ResponseButton(localiser.Text("_Cancel"), GTK_RESPONSE_CANCEL);
 	dlgFindInFiles.ResponseButton(localiser.Text("F_ind"), GTK_RESPONSE_OK);
@@ -2556,7 +2569,7 @@ void SciTEGTK::ContinueExecute(int fromPoll) {
 		// Move selection back to beginning of this run so that F4 will go
 		// to first error of this run.
 		if ((scrollOutput == 1) && returnOutputToCommand)
-			wOutput.Send(SCI_GOTOPOS, originalEnd);
+			wOutput.Send(SCI_GOTOPOS, OutputPositionTrimmed(originalEnd, originalTrimmed));
 		returnOutputToCommand = true;
 		g_source_remove(inputHandle);
 		inputHandle = 0;
@@ -2657,6 +2670,7 @@ void SciTEGTK::Execute() {
 	if (scrollOutput)
 		wOutput.Send(SCI_GOTOPOS, wOutput.Send(SCI_GETTEXTLENGTH));
 	originalEnd = wOutput.Send(SCI_GETCURRENTPOS);
+	originalTrimmed = OutputTrimmedLength();
 
 	lastOutput = "";
 	lastFlags = jobQueue.jobQueue[icmd].flags;
@@ -5017,16 +5031,21 @@ static void *WorkerThread(void *ptr) {
 
 bool SciTEGTK::PerformOnNewThread(Worker *pWorker) {
 	GError *err = NULL;
+	// Workers report completion themselves so threads are not joined and their resources
+	// are released when they end.
 #if GLIB_CHECK_VERSION(2,31,0)
 	GThread *pThread = g_thread_try_new("SciTEWorker", WorkerThread, pWorker, &err);
 #else
-	GThread *pThread = g_thread_create(WorkerThread, pWorker,TRUE, &err);
+	GThread *pThread = g_thread_create(WorkerThread, pWorker, FALSE, &err);
 #endif
 	if (pThread == NULL) {
 		fprintf(stderr, "g_thread_create failed: %s\n", err->message);
 		g_error_free(err) ;
 		return false;
 	}
+#if GLIB_CHECK_VERSION(2,31,0)
+	g_thread_unref(pThread);
+#endif
 	return true;
 }
 
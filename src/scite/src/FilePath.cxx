@@ -74,6 +74,7 @@ const GUI::gui_char listSepString[] = ":";
 const GUI::gui_char configFileVisibilityString[] = ".";
 const GUI::gui_char fileRead[] = "rb";
 const GUI::gui_char fileWrite[] = "wb";
+const GUI::gui_char fileAppend[] = "ab";
 #endif
 #ifdef WIN32
 // Windows
@@ -83,6 +84,7 @@ const GUI::gui_char listSepString[] = GUI_TEXT(";");
 const GUI::gui_char configFileVisibilityString[] = GUI_TEXT("");
 const GUI::gui_char fileRead[] = GUI_TEXT("rb");
 const GUI::gui_char fileWrite[] = GUI_TEXT("wb");
+const GUI::gui_char fileAppend[] = GUI_TEXT("ab");
 #endif
 
 FilePath::FilePath(const GUI::gui_char *fileName_) : fileName(fileName_ ? fileName_ : GUI_TEXT("")) {}
@@ -474,6 +476,25 @@ time_t FilePath::ModifiedTime() const {
 		return 0;
 }
 
+bool FilePath::Status(long &size, time_t &modified) const {
+	if (IsUntitled())
+		return false;
+#ifdef _WIN32
+#if defined(_MSC_VER) && (_MSC_VER > 1310)
+	struct _stat64i32 statusFile;
+#else
+	struct _stat statusFile;
+#endif
+#else
+	struct stat statusFile;
+#endif
+	if (stat(AsInternal(), &statusFile) == -1)
+		return false;
+	size = statusFile.st_size;
+	modified = statusFile.st_mtime;
+	return true;
+}
+
 long FilePath::GetFileLength() const {
 	long size = -1;
 	if (IsSet()) {
@@ -11,6 +11,7 @@ extern const GUI::gui_char listSepString[];
 extern const GUI::gui_char configFileVisibilityString[];
 extern const GUI::gui_char fileRead[];
 extern const GUI::gui_char fileWrite[];
+extern const GUI::gui_char fileAppend[];
 
 #if defined(__unix__)
 #include <limits.h>
@@ -73,6 +74,7 @@ public:
 	FILE *Open(const GUI::gui_char *mode) const;
 	void Remove() const;
 	time_t ModifiedTime() const;
+	bool Status(long &size, time_t &modified) const;
 	long GetFileLength() const;
 	bool Exists() const;
 	bool IsDirectory() const;
@@ -14,9 +14,17 @@
 #if defined(__unix__)
 
 #include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
 
 #else
 
+#include <io.h>
+
 #undef _WIN32_WINNT
 #define _WIN32_WINNT  0x0500
 #ifdef _MSC_VER
@@ -44,6 +52,172 @@
 #include "Utf8_16.h"
 
 const double timeBetweenProgress = 0.4;
+// Size of each part of a mapped file added to the document
+const size_t viewSize = 64 * blockSize;
+
+#ifdef SCI_NAMESPACE
+using Scintilla::IMemoryView;
+#endif
+
+#if defined(__unix__)
+
+// Another program may truncate a mapped file and reading a page past its new end then raises
+// SIGBUS. Pages of mapped files that fault are replaced with zeros so the text is wrong
+// instead of the application crashing until CheckReload finds the file changed and stops
+// using the mapping. On Windows a mapped file can not be truncated.
+// The handler only reads the lock free table of mappings. Replacing the page needs mmap which
+// POSIX does not list as async-signal-safe but it is a single system call on Linux and BSD.
+const int mappingsMax = 64;
+static const char * volatile mappingBases[mappingsMax];
+static volatile size_t mappingLengths[mappingsMax];
+static volatile int faultHandlerInstalled = 0;
+static long pageSize = 0;
+static struct sigaction actionPrevious;
+
+static void MappedFileFault(int sig, siginfo_t *info, void *context) {
+	// Reading past the end of a truncated file is reported as a nonexistent address
+	if (info->si_code == BUS_ADRERR) {
+		const char *address = static_cast<const char *>(info->si_addr);
+		for (int i = 0; i < mappingsMax; i++) {
+			const char *base = mappingBases[i];
+			if (base && (address >= base) && (address < base + mappingLengths[i])) {
+				char *page = const_cast<char *>(base) + (address - base) / pageSize * pageSize;
+				if (mmap(page, pageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+					return;
+			}
+		}
+	}
+	// Not in a mapped file so pass the signal on to the handler installed before
+	if (actionPrevious.sa_flags & SA_SIGINFO) {
+		actionPrevious.sa_sigaction(sig, info, context);
+	} else if ((actionPrevious.sa_handler != SIG_DFL) && (actionPrevious.sa_handler != SIG_IGN)) {
+		actionPrevious.sa_handler(sig);
+	} else {
+		// Restore the default action. A fault then happens again when the instruction is
+		// retried while a signal sent by another process has to be raised again.
+		sigaction(SIGBUS, &actionPrevious, 0);
+		if (info->si_code <= 0)
+			raise(sig);
+	}
+}
+
+static void InstallFaultHandler() {
+	if (__sync_bool_compare_and_swap(&faultHandlerInstalled, 0, 1)) {
+		pageSize = sysconf(_SC_PAGESIZE);
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = MappedFileFault;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGBUS, &action, &actionPrevious);
+	}
+}
+
+// Returns the slot recording the mapping or -1 when all are in use
+static int AddMapping(const char *base, size_t length) {
+	for (int i = 0; i < mappingsMax; i++) {
+		if (__sync_bool_compare_and_swap(&mappingBases[i], static_cast<const char *>(0), base)) {
+			mappingLengths[i] = length;
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void RemoveMapping(const char *base) {
+	for (int i = 0; i < mappingsMax; i++) {
+		if (mappingBases[i] == base) {
+			mappingBases[i] = 0;
+			return;
+		}
+	}
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	if (base) {
+#if defined(__unix__)
+		RemoveMapping(base);
+		munmap(const_cast<char *>(base), lengthMapped);
+#else
+		::UnmapViewOfFile(base);
+#endif
+	}
+}
+
+void MappedFile::AddRef() {
+#if defined(__unix__)
+	__sync_add_and_fetch(&refCount, 1);
+#else
+	::InterlockedIncrement(&refCount);
+#endif
+}
+
+void MappedFile::Release() {
+#if defined(__unix__)
+	const long refs = __sync_sub_and_fetch(&refCount, 1);
+#else
+	const long refs = ::InterlockedDecrement(&refCount);
+#endif
+	if (refs == 0)
+		delete this;
+}
+
+bool MappedFile::Map(FILE *fp, size_t length) {
+	if (length == 0)
+		return false;
+#if defined(__unix__)
+	InstallFaultHandler();
+	void *pv = mmap(0, length, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if (pv == MAP_FAILED)
+		return false;
+	if (AddMapping(static_cast<const char *>(pv), length) < 0) {
+		// Without a slot a truncation could not be survived so read the file instead
+		munmap(pv, length);
+		return false;
+	}
+#else
+	HANDLE hFile = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+	HANDLE hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMap)
+		return false;
+	void *pv = ::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, length);
+	// The view keeps the mapping alive
+	::CloseHandle(hMap);
+	if (!pv)
+		return false;
+#endif
+	base = static_cast<const char *>(pv);
+	lengthMapped = length;
+	return true;
+}
+
+/// Range of a mapped file added to the document.
+class MappedFileView : public IMemoryView {
+	MappedFile *file;
+	const char *data;
+	size_t length;
+	// Private so MappedFileView objects can not be copied
+	MappedFileView(const MappedFileView &);
+public:
+	MappedFileView(MappedFile *file_, size_t start, size_t length_) :
+		file(file_), data(file_->Data() + start), length(length_) {
+		file->AddRef();
+	}
+	virtual ~MappedFileView() {
+	}
+	virtual const char * SCI_METHOD Data() {
+		return data;
+	}
+	virtual Sci_Position SCI_METHOD Length() {
+		return static_cast<Sci_Position>(length);
+	}
+	virtual void SCI_METHOD Release() {
+		file->Release();
+		delete this;
+	}
+};
 
 FileWorker::FileWorker(WorkerListener *pListener_, FilePath path_, long size_, FILE *fp_) :
 	pListener(pListener_), path(path_), size(size_), err(0), fp(fp_), sleepTime(0), nextProgress(timeBetweenProgress) {
@@ -57,7 +231,8 @@ double FileWorker::Duration() {
 }
 
 FileLoader::FileLoader(WorkerListener *pListener_, ILoader *pLoader_, FilePath path_, long size_, FILE *fp_) :
-	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit) {
+	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit),
+	mapView(false), viewed(false) {
 	jobSize = static_cast<int>(size);
 	jobProgress = 0;
 }
@@ -65,7 +240,64 @@ FileLoader::FileLoader(WorkerListener *pListener_, ILoader *pLoader_, FilePath p
 FileLoader::~FileLoader() {
 }
 
+// Make the document refer to a mapping of the file instead of copying the file into the document.
+// The file is added in views of viewSize so progress is shown while the document finds line ends.
+// The line index is built here on the loader thread but the document is only shown once it is
+// complete as the editor can not display a document that another thread is still extending.
+// Files that need conversion or can not be mapped are left open to be read normally as are
+// all files when the document would copy the mapping.
+void FileLoader::LoadView() {
+	ILoaderWithView *pLoaderView = static_cast<ILoaderWithView *>(pLoader);
+	if (!pLoaderView->KeepsViews())
+		return;
+	MappedFile *file = new MappedFile();
+	if (!file->Map(fp, size)) {
+		file->Release();
+		return;
+	}
+	const unsigned char *data = reinterpret_cast<const unsigned char *>(file->Data());
+	const size_t lenFile = file->Length();
+	const size_t lenStart = (lenFile < blockSize) ? lenFile : blockSize;
+	const bool utf16 = (lenFile >= 2) &&
+		(((data[0] == 0xFE) && (data[1] == 0xFF)) || ((data[0] == 0xFF) && (data[1] == 0xFE)));
+	UniMode umCodingCookie = CodingCookieValue(file->Data(), lenStart);
+	if (utf16 || (umCodingCookie==uni8Bit && check_utf8==1)) {
+		file->Release();
+		return;
+	}
+	if (umCodingCookie==uni8Bit && check_utf8==2) {
+		std::vector<unsigned char> dataStart(data, data + lenStart);
+		if (Has_UTF8_Char(&dataStart[0], static_cast<int>(lenStart))) {
+			umCodingCookie=uniCookie;
+		}
+	}
+	unicodeMode = umCodingCookie;
+	size_t start = 0;
+	if ((lenFile >= 3) && (data[0] == 0xEF) && (data[1] == 0xBB) && (data[2] == 0xBF)) {
+		// The byte order mark is not part of the document
+		start = 3;
+		unicodeMode = uniUTF8;
+	}
+	fclose(fp);
+	fp = 0;
+	while ((start < lenFile) && (err == 0) && (!cancelling)) {
+		const size_t lenView = (lenFile - start < viewSize) ? lenFile - start : viewSize;
+		err = pLoaderView->AddView(new MappedFileView(file, start, lenView));
+		start += lenView;
+		jobProgress = static_cast<int>(start);
+		if (et.Duration() > nextProgress) {
+			nextProgress = et.Duration() + timeBetweenProgress;
+			pListener->PostOnMainThread(WORK_FILEPROGRESS, this);
+		}
+	}
+	file->Release();
+	viewed = err == 0;
+}
+
 void FileLoader::Execute() {
+	if (fp && mapView) {
+		LoadView();
+	}
 	if (fp) {
 //!		Utf8_16_Read convert; //!-remove-[utf8.auto.check]
 		std::vector<char> data(blockSize);
@@ -8,6 +8,30 @@
 /// Base size of file I/O operations.
 const int blockSize = 131072;
 
+/// Read only mapping of a file shared by the views added to the document
+/// and used by Find in Files. The file is unmapped when all users have released it.
+/// Views may be released on other threads so the reference count changes atomically.
+class MappedFile {
+	const char *base;
+	size_t lengthMapped;
+	volatile long refCount;
+	// Private so MappedFile objects can not be copied
+	MappedFile(const MappedFile &);
+	~MappedFile();
+public:
+	MappedFile() : base(0), lengthMapped(0), refCount(1) {
+	}
+	bool Map(FILE *fp, size_t length);
+	const char *Data() const {
+		return base;
+	}
+	size_t Length() const {
+		return lengthMapped;
+	}
+	void AddRef();
+	void Release();
+};
+
 struct FileWorker : public Worker {
 	WorkerListener *pListener;
 	FilePath path;
@@ -30,6 +54,7 @@ struct FileWorker : public Worker {
 
 #ifdef SCI_NAMESPACE
 using Scintilla::ILoader;
+using Scintilla::ILoaderWithView;
 #endif
 
 class FileLoader : public FileWorker {
@@ -37,9 +62,12 @@ public:
 	ILoader *pLoader;
 	long readSoFar;
 	UniMode unicodeMode;
+	bool mapView;	///< Try to map the file instead of reading it
+	bool viewed;	///< The document refers to a mapping of the file
 
 	FileLoader(WorkerListener *pListener_, ILoader *pLoader_, FilePath path_, long size_, FILE *fp_);
 	virtual ~FileLoader();
+	void LoadView();
 	virtual void Execute();
 	virtual void Cancel();
 	virtual bool IsLoading() const {
@@ -68,5 +96,6 @@ enum {
 	WORK_FILEREAD = 1,
 	WORK_FILEWRITTEN = 2,
 	WORK_FILEPROGRESS = 3,
+	WORK_OUTPUT = 4,
 	WORK_PLATFORM = 100
 };
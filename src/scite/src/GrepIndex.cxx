@@ -0,0 +1,342 @@
+// SciTE - Scintilla based Text Editor
+/** @file GrepIndex.cxx
+ ** Implementation of the trigram index Find in Files uses to skip files that can not match.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "Scintilla.h"
+
+#include "GUI.h"
+#include "SString.h"
+
+#include "FilePath.h"
+#include "GrepIndex.h"
+
+static const char indexSignature[] = "SciTE grep index 2\n";
+// Bits set in the filter for each trigram which gives about 5% false positives per trigram
+const size_t bitsPerTrigram = 8;
+const size_t minimumFilterBytes = 8;
+
+static unsigned int Mix(unsigned int h) {
+	h ^= h >> 16;
+	h *= 0x7feb352dU;
+	h ^= h >> 15;
+	h *= 0x846ca68bU;
+	h ^= h >> 16;
+	return h;
+}
+
+int TrigramCollector::Trigram(const char *text) {
+	int trigram = 0;
+	for (int i = 0; i < 3; i++) {
+		int ch = static_cast<unsigned char>(text[i]);
+		if ((ch >= 'A') && (ch <= 'Z'))
+			ch = ch - 'A' + 'a';
+		trigram = (trigram << 8) | ch;
+	}
+	return trigram;
+}
+
+void TrigramCollector::Collect(const char *text, size_t length) {
+	if (present.empty())
+		present.resize((1 << 24) / 8);
+	for (size_t i = 0; i + 3 <= length; i++) {
+		const int trigram = Trigram(text + i);
+		unsigned char &bits = present[trigram >> 3];
+		const unsigned char bit = static_cast<unsigned char>(1 << (trigram & 7));
+		if (!(bits & bit)) {
+			bits |= bit;
+			found.push_back(trigram);
+		}
+	}
+}
+
+std::string TrigramCollector::Filter() {
+	size_t bytes = minimumFilterBytes;
+	while (bytes * 8 < found.size() * bitsPerTrigram)
+		bytes *= 2;
+	std::string filter(bytes, '\0');
+	const unsigned int mask = static_cast<unsigned int>(bytes * 8 - 1);
+	for (size_t i = 0; i < found.size(); i++) {
+		const unsigned int h1 = Mix(found[i]);
+		const unsigned int h2 = Mix(h1);
+		filter[(h1 & mask) >> 3] |= static_cast<char>(1 << (h1 & 7));
+		filter[(h2 & mask) >> 3] |= static_cast<char>(1 << (h2 & 7));
+		// Clear only what was set so the next file starts from nothing
+		present[found[i] >> 3] = 0;
+	}
+	found.clear();
+	return filter;
+}
+
+bool TrigramCollector::MayContain(const std::string &filter, int trigram) {
+	if (filter.empty())
+		return false;
+	const unsigned int mask = static_cast<unsigned int>(filter.length() * 8 - 1);
+	const unsigned int h1 = Mix(trigram);
+	const unsigned int h2 = Mix(h1);
+	return (filter[(h1 & mask) >> 3] & (1 << (h1 & 7))) &&
+		(filter[(h2 & mask) >> 3] & (1 << (h2 & 7)));
+}
+
+TrigramQuery::TrigramQuery(const std::vector<std::string> &texts) : filters(!texts.empty()) {
+	for (size_t t = 0; t < texts.size(); t++) {
+		if (texts[t].length() < 3)
+			filters = false;
+		std::vector<int> trigrams;
+		for (size_t i = 0; i + 3 <= texts[t].length(); i++)
+			trigrams.push_back(TrigramCollector::Trigram(texts[t].c_str() + i));
+		alternatives.push_back(trigrams);
+	}
+}
+
+bool TrigramQuery::MayMatch(const std::string &filter) const {
+	if (!filters)
+		return true;
+	for (size_t a = 0; a < alternatives.size(); a++) {
+		size_t t = 0;
+		while ((t < alternatives[a].size()) && TrigramCollector::MayContain(filter, alternatives[a][t]))
+			t++;
+		if (t == alternatives[a].size())
+			return true;
+	}
+	return false;
+}
+
+static std::string RootDirectory(const FilePath &root) {
+	std::string directory = root.AsUTF8();
+	if (directory.empty() || (directory[directory.length() - 1] != '/' && directory[directory.length() - 1] != '\\'))
+		directory += GUI::UTF8FromString(pathSepString);
+	return directory;
+}
+
+GrepIndex::GrepIndex(const FilePath &root_) :
+	root(RootDirectory(root_)), changed(false), skipped(0), sizeFile(-1), modifiedFile(0) {
+}
+
+bool GrepIndex::IsFor(const FilePath &root_) const {
+	return root == RootDirectory(root_);
+}
+
+static void AppendNumber(std::string &s, unsigned long value) {
+	while (value >= 0x80) {
+		s.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	s.push_back(static_cast<char>(value));
+}
+
+static bool ReadNumber(const std::string &s, size_t &pos, unsigned long &value) {
+	value = 0;
+	for (int shift = 0; (pos < s.length()) && (shift < static_cast<int>(sizeof(value) * 8)); shift += 7) {
+		const unsigned char ch = static_cast<unsigned char>(s[pos++]);
+		value |= static_cast<unsigned long>(ch & 0x7f) << shift;
+		if (!(ch & 0x80))
+			return true;
+	}
+	return false;
+}
+
+void GrepIndex::SetFileStatus(const FilePath &indexPath) {
+	if (!indexPath.Status(sizeFile, modifiedFile))
+		sizeFile = -1;
+}
+
+// Another instance may have written the file since this one loaded or saved it
+bool GrepIndex::FileUnchanged(const FilePath &indexPath) const {
+	long size = 0;
+	time_t modified = 0;
+	return (sizeFile >= 0) && indexPath.Status(size, modified) &&
+		(size == sizeFile) && (modified == modifiedFile);
+}
+
+// Entries are a key ended by NUL then 1 followed by the size, modification time and filter
+// length as variable length numbers and the filter. A removed file is its key then 0.
+// Entries appended later replace earlier entries with the same key.
+void GrepIndex::AppendEntry(std::string &contents, const std::string &key) const {
+	contents.append(key);
+	contents.push_back('\0');
+	std::map<std::string, Entry>::const_iterator it = entries.find(key);
+	if (it == entries.end()) {
+		AppendNumber(contents, 0);
+	} else {
+		AppendNumber(contents, 1);
+		AppendNumber(contents, static_cast<unsigned long>(it->second.size));
+		AppendNumber(contents, static_cast<unsigned long>(it->second.modified));
+		AppendNumber(contents, it->second.filter.length());
+		contents.append(it->second.filter);
+	}
+}
+
+// Roughly the length of the file when written in full
+size_t GrepIndex::LengthFull() const {
+	size_t length = strlen(indexSignature) + root.length() + 1;
+	for (std::map<std::string, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+		length += it->first.length() + it->second.filter.length() + 8;
+	return length;
+}
+
+bool GrepIndex::Load(const FilePath &indexPath) {
+	entries.clear();
+	changedKeys.clear();
+	changed = false;
+	sizeFile = -1;
+	FILE *fp = indexPath.Open(fileRead);
+	if (!fp)
+		return false;
+	std::string contents;
+	char data[64 * 1024];
+	size_t lenBlock;
+	while ((lenBlock = fread(data, 1, sizeof(data), fp)) > 0)
+		contents.append(data, lenBlock);
+	fclose(fp);
+	const std::string header = std::string(indexSignature) + root + "\n";
+	if (contents.compare(0, header.length(), header) != 0)
+		return false;
+	size_t pos = header.length();
+	while (pos < contents.length()) {
+		const size_t endKey = contents.find('\0', pos);
+		unsigned long present = 0;
+		unsigned long size = 0;
+		unsigned long modified = 0;
+		unsigned long lengthFilter = 0;
+		if (endKey == std::string::npos)
+			break;
+		const std::string key = contents.substr(pos, endKey - pos);
+		pos = endKey + 1;
+		if (!ReadNumber(contents, pos, present))
+			break;
+		if (!present) {
+			entries.erase(key);
+			continue;
+		}
+		if (!ReadNumber(contents, pos, size) || !ReadNumber(contents, pos, modified) ||
+			!ReadNumber(contents, pos, lengthFilter) || (lengthFilter > contents.length() - pos))
+			break;
+		Entry &entry = entries[key];
+		entry.size = static_cast<long>(size);
+		entry.modified = static_cast<time_t>(modified);
+		entry.filter = contents.substr(pos, static_cast<size_t>(lengthFilter));
+		pos += static_cast<size_t>(lengthFilter);
+	}
+	if (pos != contents.length()) {
+		// Damaged so start again
+		entries.clear();
+		return false;
+	}
+	SetFileStatus(indexPath);
+	return true;
+}
+
+bool GrepIndex::Begin(const FilePath &indexPath) {
+	skipped = 0;
+	if (!FileUnchanged(indexPath))
+		return Load(indexPath);
+	for (std::map<std::string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+		it->second.seen = false;
+	return true;
+}
+
+bool GrepIndex::Save(const FilePath &indexPath) {
+	std::string contents;
+	const GUI::gui_char *mode = fileWrite;
+	if (FileUnchanged(indexPath)) {
+		for (std::set<std::string>::const_iterator it = changedKeys.begin(); it != changedKeys.end(); ++it)
+			AppendEntry(contents, *it);
+		if (static_cast<size_t>(sizeFile) + contents.length() <= 2 * LengthFull())
+			mode = fileAppend;
+	}
+	if (mode == fileWrite) {
+		contents = std::string(indexSignature) + root + "\n";
+		for (std::map<std::string, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+			AppendEntry(contents, it->first);
+	}
+	FILE *fp = indexPath.Open(mode);
+	if (!fp)
+		return false;
+	const bool written = fwrite(contents.c_str(), 1, contents.length(), fp) == contents.length();
+	fclose(fp);
+	if (written) {
+		changedKeys.clear();
+		changed = false;
+		SetFileStatus(indexPath);
+	} else {
+		// A partly written file is found damaged when loaded and is then written in full
+		sizeFile = -1;
+	}
+	return written;
+}
+
+// The name is made unique to the root directory with a hash as the root may be long.
+FilePath GrepIndex::FileName(const FilePath &directory) const {
+	unsigned int hash = 2166136261U;
+	for (size_t i = 0; i < root.length(); i++) {
+		hash ^= static_cast<unsigned char>(root[i]);
+		hash *= 16777619U;
+	}
+	char name[40];
+	sprintf(name, "SciTE.grep.%08x", hash);
+	GUI::gui_string nameWithVisibility(configFileVisibilityString);
+	nameWithVisibility += GUI::StringFromUTF8(name);
+	return FilePath(directory, FilePath(nameWithVisibility));
+}
+
+std::string GrepIndex::Key(const FilePath &path) const {
+	const std::string full = path.AsUTF8();
+	if (full.compare(0, root.length(), root) == 0)
+		return full.substr(root.length());
+	return full;
+}
+
+GrepIndex::Check GrepIndex::Lookup(const std::string &key, long size, time_t modified, const TrigramQuery &query) {
+	std::map<std::string, Entry>::iterator it = entries.find(key);
+	if (it == entries.end())
+		return checkStale;
+	it->second.seen = true;
+	if ((it->second.size != size) || (it->second.modified != modified))
+		return checkStale;
+	if (query.MayMatch(it->second.filter))
+		return checkSearch;
+	skipped++;
+	return checkSkip;
+}
+
+void GrepIndex::Seen(const std::string &key) {
+	std::map<std::string, Entry>::iterator it = entries.find(key);
+	if (it != entries.end())
+		it->second.seen = true;
+}
+
+void GrepIndex::Update(const std::string &key, long size, time_t modified, std::string &filter) {
+	Entry &entry = entries[key];
+	entry.size = size;
+	entry.modified = modified;
+	entry.filter.swap(filter);
+	entry.seen = true;
+	changedKeys.insert(key);
+	changed = true;
+}
+
+void GrepIndex::Prune() {
+	std::map<std::string, Entry>::iterator it = entries.begin();
+	while (it != entries.end()) {
+		if (it->second.seen) {
+			++it;
+		} else {
+			changedKeys.insert(it->first);
+			entries.erase(it++);
+			changed = true;
+		}
+	}
+}
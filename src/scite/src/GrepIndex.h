@@ -0,0 +1,95 @@
+// SciTE - Scintilla based Text Editor
+/** @file GrepIndex.h
+ ** Definition of the trigram index Find in Files uses to skip files that can not match.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef GREPINDEX_H
+#define GREPINDEX_H
+
+/// Collects the distinct trigrams of a file and turns them into a Bloom filter.
+/// ASCII letters are folded to lower case so the filter serves case sensitive and
+/// insensitive searches.
+class TrigramCollector {
+	/// One bit for each of the 2^24 trigrams, allocated when first used
+	std::vector<unsigned char> present;
+	std::vector<int> found;
+public:
+	void Collect(const char *text, size_t length);
+	/// The filter of the trigrams collected since the last call.
+	std::string Filter();
+	static int Trigram(const char *text);
+	static bool MayContain(const std::string &filter, int trigram);
+};
+
+/// A file may match when all the trigrams of any one alternative may be present in it.
+class TrigramQuery {
+	std::vector<std::vector<int> > alternatives;
+	bool filters;
+public:
+	explicit TrigramQuery(const std::vector<std::string> &texts);
+	/// False when some alternative is shorter than a trigram so every file may match.
+	bool Filters() const {
+		return filters;
+	}
+	bool MayMatch(const std::string &filter) const;
+};
+
+/// The filters of the files below one directory. The size and modification time of each
+/// file are kept with its filter so files that have changed are searched and indexed again.
+/// The index stays loaded between searches and only the entries that changed are appended
+/// to its file, which is written again in full once it has grown to twice what it holds.
+class GrepIndex {
+	struct Entry {
+		long size;
+		time_t modified;
+		std::string filter;
+		bool seen;
+		Entry() : size(0), modified(0), seen(false) {
+		}
+	};
+	std::string root;
+	std::map<std::string, Entry> entries;
+	/// Keys updated or removed since the file was loaded or saved
+	std::set<std::string> changedKeys;
+	bool changed;
+	int skipped;
+	/// Size and modification time of the file when it was loaded or saved, size -1 when unknown
+	long sizeFile;
+	time_t modifiedFile;
+	void SetFileStatus(const FilePath &indexPath);
+	bool FileUnchanged(const FilePath &indexPath) const;
+	size_t LengthFull() const;
+	void AppendEntry(std::string &contents, const std::string &key) const;
+public:
+	enum Check { checkStale, checkSkip, checkSearch };
+
+	explicit GrepIndex(const FilePath &root_);
+	/// Whether this is the index of the root directory.
+	bool IsFor(const FilePath &root_) const;
+	bool Load(const FilePath &indexPath);
+	/// Prepare for a search, loading the file unless it has not been written since loaded or saved.
+	bool Begin(const FilePath &indexPath);
+	bool Save(const FilePath &indexPath);
+	/// The file in directory holding the index of this root directory.
+	FilePath FileName(const FilePath &directory) const;
+	/// The path relative to the root used to look up a file.
+	std::string Key(const FilePath &path) const;
+	/// Whether a file must be indexed again, can be skipped or may match the query.
+	Check Lookup(const std::string &key, long size, time_t modified, const TrigramQuery &query);
+	/// Files that exist are remembered even when their type is not searched.
+	void Seen(const std::string &key);
+	void Update(const std::string &key, long size, time_t modified, std::string &filter);
+	/// Forget the files that were not seen since the index was loaded.
+	void Prune();
+	bool Changed() const {
+		return changed;
+	}
+	/// The number of files found by Lookup to not match.
+	int Skipped() const {
+		return skipped;
+	}
+};
+
+#endif
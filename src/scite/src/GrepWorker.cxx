@@ -0,0 +1,605 @@
+// SciTE - Scintilla based Text Editor
+/** @file GrepWorker.cxx
+ ** Implementation of classes to search in files on several threads.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define GREP_SSE2
+#endif
+
+#if defined(__unix__)
+
+#include <unistd.h>
+
+#else
+
+#undef _WIN32_WINNT
+#define _WIN32_WINNT  0x0500
+#ifdef _MSC_VER
+// windows.h, et al, use a lot of nameless struct/unions - can't fix it, so allow it
+#pragma warning(disable: 4201)
+#endif
+#include <windows.h>
+#ifdef _MSC_VER
+// okay, that's done, don't allow it in our code
+#pragma warning(default: 4201)
+#endif
+
+#endif
+
+#include "Scintilla.h"
+#include "ILexer.h"
+
+#include "GUI.h"
+#include "SString.h"
+
+#include "FilePath.h"
+#include "Mutex.h"
+#include "Cookie.h"
+#include "Worker.h"
+#include "FileWorker.h"
+#include "LinearRegex.h"
+#include "GrepIndex.h"
+#include "GrepWorker.h"
+
+// The first block is checked for NUL bytes to decide whether a file is binary
+const size_t binaryCheckSize = 64 * 1024;
+
+static bool IsWordCharacter(int ch) {
+	return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z')  || (ch >= '0' && ch <= '9')  || (ch == '_');
+}
+
+static char UpperASCII(char ch) {
+	return ((ch >= 'a') && (ch <= 'z')) ? static_cast<char>(ch - 'a' + 'A') : ch;
+}
+
+static void SetFolding(char *fold, bool matchCase) {
+	for (int ch = 0; ch < 0x100; ch++) {
+		fold[ch] = static_cast<char>(ch);
+		if (!matchCase && (ch >= 'A') && (ch <= 'Z'))
+			fold[ch] = static_cast<char>(ch - 'A' + 'a');
+	}
+}
+
+static bool IsLineEnd(char ch) {
+	return (ch == '\r') || (ch == '\n');
+}
+
+static size_t LineEnd(const char *text, size_t pos, size_t length) {
+	while ((pos < length) && !IsLineEnd(text[pos]))
+		pos++;
+	return pos;
+}
+
+static size_t NextLineStart(const char *text, size_t lineEnd, size_t length) {
+	return lineEnd + (((text[lineEnd] == '\r') && (lineEnd + 1 < length) && (text[lineEnd + 1] == '\n')) ? 2 : 1);
+}
+
+static bool IsWholeWord(const char *text, size_t position, size_t lengthMatch, size_t length) {
+	return ((position == 0) || !IsWordCharacter(static_cast<unsigned char>(text[position - 1]))) &&
+		((position + lengthMatch >= length) || !IsWordCharacter(static_cast<unsigned char>(text[position + lengthMatch])));
+}
+
+LiteralMatcher::LiteralMatcher(const std::string &pattern_, bool matchCase_, bool wholeWord_) :
+	pattern(pattern_), matchCase(matchCase_), wholeWord(wholeWord_) {
+	SetFolding(fold, matchCase);
+	for (size_t i = 0; i < pattern.length(); i++)
+		pattern[i] = fold[static_cast<unsigned char>(pattern[i])];
+	if (!pattern.empty()) {
+		firstBytes[0] = pattern[0];
+		firstBytes[1] = matchCase ? pattern[0] : UpperASCII(pattern[0]);
+		lastBytes[0] = pattern[pattern.length() - 1];
+		lastBytes[1] = matchCase ? lastBytes[0] : UpperASCII(lastBytes[0]);
+	}
+}
+
+bool LiteralMatcher::MatchesAt(const char *text) const {
+	if (matchCase)
+		return memcmp(text, pattern.c_str(), pattern.length()) == 0;
+	for (size_t i = 0; i < pattern.length(); i++) {
+		if (fold[static_cast<unsigned char>(text[i])] != pattern[i])
+			return false;
+	}
+	return true;
+}
+
+// Candidates are filtered on their first and last bytes, 16 at a time with SSE2,
+// or by memchr on the first byte otherwise, before the whole match is compared.
+size_t LiteralMatcher::FindBytes(const char *data, size_t start, size_t length) const {
+	const size_t lengthPattern = pattern.length();
+	if ((lengthPattern == 0) || (length < lengthPattern))
+		return std::string::npos;
+	const size_t lastStart = length - lengthPattern;
+	size_t pos = start;
+#ifdef GREP_SSE2
+	const __m128i first0 = _mm_set1_epi8(firstBytes[0]);
+	const __m128i first1 = _mm_set1_epi8(firstBytes[1]);
+	const __m128i last0 = _mm_set1_epi8(lastBytes[0]);
+	const __m128i last1 = _mm_set1_epi8(lastBytes[1]);
+	while (pos + 16 <= lastStart + 1) {
+		const char *text = data + pos;
+		const __m128i chunkFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+		const __m128i chunkLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + lengthPattern - 1));
+		const __m128i matchFirst = _mm_or_si128(_mm_cmpeq_epi8(chunkFirst, first0), _mm_cmpeq_epi8(chunkFirst, first1));
+		const __m128i matchLast = _mm_or_si128(_mm_cmpeq_epi8(chunkLast, last0), _mm_cmpeq_epi8(chunkLast, last1));
+		int mask = _mm_movemask_epi8(_mm_and_si128(matchFirst, matchLast));
+		while (mask) {
+			int offset = 0;
+			while (!(mask & (1 << offset)))
+				offset++;
+			if (MatchesAt(text + offset))
+				return pos + offset;
+			mask &= mask - 1;
+		}
+		pos += 16;
+	}
+#endif
+	if (firstBytes[0] == firstBytes[1]) {
+		while (pos <= lastStart) {
+			const void *found = memchr(data + pos, static_cast<unsigned char>(firstBytes[0]), lastStart + 1 - pos);
+			if (!found)
+				return std::string::npos;
+			pos = static_cast<const char *>(found) - data;
+			if (MatchesAt(data + pos))
+				return pos;
+			pos++;
+		}
+	} else {
+		for (; pos <= lastStart; pos++) {
+			if (fold[static_cast<unsigned char>(data[pos])] == firstBytes[0] && MatchesAt(data + pos))
+				return pos;
+		}
+	}
+	return std::string::npos;
+}
+
+size_t LiteralMatcher::Find(const char *text, size_t start, size_t length, size_t &lengthMatch) {
+	lengthMatch = pattern.length();
+	if (lengthMatch == 0) {
+		// An empty string matches every line
+		return (start <= length) ? start : std::string::npos;
+	}
+	size_t position = FindBytes(text, start, length);
+	while (wholeWord && (position != std::string::npos) && !IsWholeWord(text, position, lengthMatch, length))
+		position = FindBytes(text, position + 1, length);
+	return position;
+}
+
+LiteralSetMatcher::LiteralSetMatcher(const std::vector<std::string> &patterns, bool matchCase, bool wholeWord_) :
+	wholeWord(wholeWord_) {
+	char fold[alphabetSize];
+	SetFolding(fold, matchCase);
+	for (int ch = 0; ch < alphabetSize; ch++)
+		startByte[ch] = false;
+	// Build a trie with -1 for missing transitions
+	AddState();
+	for (size_t p = 0; p < patterns.size(); p++) {
+		const std::string &pattern = patterns[p];
+		if (pattern.empty() || (pattern.find_first_of("\r\n") != std::string::npos))
+			continue;	// Can not match within a line
+		int state = 0;
+		for (size_t i = 0; i < pattern.length(); i++) {
+			const int ch = static_cast<unsigned char>(fold[static_cast<unsigned char>(pattern[i])]);
+			if (transitions[state * alphabetSize + ch] < 0) {
+				const int stateNew = AddState();
+				transitions[state * alphabetSize + ch] = stateNew;
+			}
+			state = transitions[state * alphabetSize + ch];
+		}
+		endings[state].push_back(pattern.length());
+	}
+	// Breadth first so each failure state is complete before it is used
+	std::vector<int> failure(transitions.size() / alphabetSize, 0);
+	std::deque<int> pending;
+	for (int ch = 0; ch < alphabetSize; ch++) {
+		const int next = transitions[ch];
+		if (next < 0) {
+			transitions[ch] = 0;
+		} else {
+			pending.push_back(next);
+		}
+	}
+	while (!pending.empty()) {
+		const int state = pending.front();
+		pending.pop_front();
+		const std::vector<size_t> &endingsFailure = endings[failure[state]];
+		endings[state].insert(endings[state].end(), endingsFailure.begin(), endingsFailure.end());
+		for (int ch = 0; ch < alphabetSize; ch++) {
+			const int next = transitions[state * alphabetSize + ch];
+			const int onFailure = transitions[failure[state] * alphabetSize + ch];
+			if (next < 0) {
+				transitions[state * alphabetSize + ch] = onFailure;
+			} else {
+				failure[next] = onFailure;
+				pending.push_back(next);
+			}
+		}
+	}
+	// Fold the input by sharing the transitions of each byte with its folded form
+	for (int state = 0; state < static_cast<int>(endings.size()); state++) {
+		for (int ch = 0; ch < alphabetSize; ch++) {
+			transitions[state * alphabetSize + ch] =
+				transitions[state * alphabetSize + static_cast<unsigned char>(fold[ch])];
+		}
+	}
+	for (int ch = 0; ch < alphabetSize; ch++)
+		startByte[ch] = transitions[ch] != 0;
+}
+
+int LiteralSetMatcher::AddState() {
+	transitions.insert(transitions.end(), alphabetSize, -1);
+	endings.push_back(std::vector<size_t>());
+	return static_cast<int>(endings.size()) - 1;
+}
+
+size_t LiteralSetMatcher::Find(const char *text, size_t start, size_t length, size_t &lengthMatch) {
+	int state = 0;
+	size_t pos = start;
+	while (pos < length) {
+		if (state == 0) {
+			// Skip quickly over bytes that can not start a pattern
+			while ((pos < length) && !startByte[static_cast<unsigned char>(text[pos])])
+				pos++;
+			if (pos >= length)
+				break;
+		}
+		state = transitions[state * alphabetSize + static_cast<unsigned char>(text[pos])];
+		pos++;
+		const std::vector<size_t> &ending = endings[state];
+		for (size_t e = 0; e < ending.size(); e++) {
+			const size_t position = pos - ending[e];
+			if ((position >= start) && (!wholeWord || IsWholeWord(text, position, ending[e], length))) {
+				lengthMatch = ending[e];
+				return position;
+			}
+		}
+	}
+	return std::string::npos;
+}
+
+RegexMatcher::RegexMatcher(bool unicode, bool wholeWord_) : wholeWord(wholeWord_), group(0) {
+	// Use the same word characters as whole word literals so alternatives found either way agree
+	char wordByte[256];
+	for (int ch = 0; ch < 0x100; ch++)
+		wordByte[ch] = IsWordCharacter(ch) ? 1 : 0;
+	regex.SetEncoding(unicode ? LinearRegex::encUTF8 : LinearRegex::encSingleByte, 0, 0, wordByte);
+}
+
+// Whole word is part of the expression rather than a check of each match found so an
+// alternative that is not a whole word does not hide a later one starting at the same place.
+const char *RegexMatcher::Compile(const std::string &pattern, bool matchCase, bool posix) {
+	std::string expression = pattern;
+	group = 0;
+	if (wholeWord) {
+		const std::string open = posix ? "(" : "\\(";
+		const std::string close = posix ? ")" : "\\)";
+		expression = open + "?:^|\\W" + close + open + pattern + close + open + "?:\\W|$" + close;
+		group = 1;
+	}
+	return regex.Compile(expression.c_str(), static_cast<int>(expression.length()), matchCase, posix);
+}
+
+// Only called at line starts by GrepSearcher so the whole line is available to the expression.
+size_t RegexMatcher::Find(const char *text, size_t start, size_t length, size_t &lengthMatch) {
+	size_t lineStart = start;
+	for (;;) {
+		const size_t lineEnd = LineEnd(text, lineStart, length);
+		const int lengthLine = static_cast<int>(lineEnd - lineStart);
+		if (regex.Search(text + lineStart, lengthLine, 0, lengthLine)) {
+			lengthMatch = regex.groupEnd[group] - regex.groupStart[group];
+			return lineStart + regex.groupStart[group];
+		}
+		if (lineEnd >= length)
+			return std::string::npos;
+		lineStart = NextLineStart(text, lineEnd, length);
+	}
+}
+
+GrepSpec::GrepSpec(const std::string &searchString_, bool matchCase_, bool wholeWord_, bool binary_,
+	int listStyle_, unsigned int basePath_) :
+	searchString(searchString_), matchCase(matchCase_), wholeWord(wholeWord_),
+	regExp(false), posix(false), unicode(false), binary(binary_),
+	listStyle(listStyle_), basePath(basePath_) {
+}
+
+// Literals and alternations of literals such as "one|two" are found without the regular
+// expression engine. Non-ASCII text is left to the engine when case insensitive as it folds
+// more than ASCII.
+bool GrepSpec::LiteralAlternatives(std::vector<std::string> &alternatives) const {
+	alternatives.assign(1, std::string());
+	if (!regExp) {
+		alternatives[0] = searchString;
+		return true;
+	}
+	for (size_t i = 0; i < searchString.length(); i++) {
+		const char ch = searchString[i];
+		if (ch == '|') {
+			alternatives.push_back(std::string());
+		} else if (strchr(".\\[]*+?{}()^$", ch) || (!matchCase && (static_cast<unsigned char>(ch) >= 0x80))) {
+			return false;
+		} else {
+			alternatives.back() += ch;
+		}
+	}
+	for (size_t a = 0; a < alternatives.size(); a++) {
+		if (alternatives[a].empty())
+			return false;
+	}
+	return true;
+}
+
+GrepMatcher *GrepSpec::CreateMatcher(const char **error) const {
+	std::vector<std::string> alternatives;
+	if (!LiteralAlternatives(alternatives)) {
+		RegexMatcher *matcher = new RegexMatcher(unicode, wholeWord);
+		const char *errorCompile = matcher->Compile(searchString, matchCase, posix);
+		if (errorCompile) {
+			delete matcher;
+			if (error)
+				*error = errorCompile;
+			return 0;
+		}
+		return matcher;
+	}
+	if (alternatives.size() > 1)
+		return new LiteralSetMatcher(alternatives, matchCase, wholeWord);
+	if (searchString.find_first_of("\r\n") != std::string::npos) {
+		// Each line is searched separately so this never matches
+		return new LiteralSetMatcher(std::vector<std::string>(), matchCase, wholeWord);
+	}
+	return new LiteralMatcher(searchString, matchCase, wholeWord);
+}
+
+GrepSearcher::GrepSearcher(const GrepSpec &spec_) : spec(spec_), matcher(spec_.CreateMatcher()) {
+}
+
+GrepSearcher::~GrepSearcher() {
+	delete matcher;
+	matcher = 0;
+}
+
+// Lines end with CR, LF or CR+LF. The text is searched as a whole and lines are only
+// counted up to each match so lines without matches are not examined one at a time.
+void GrepSearcher::SearchText(const std::string &displayPath, const char *text, size_t length, std::string &os) {
+	if (!matcher)
+		return;
+	int lineNumber = 1;
+	size_t lineStart = 0;
+	size_t pos = 0;
+	// The empty line after a final line end may match an empty pattern
+	while (pos <= length) {
+		size_t lengthMatch = 0;
+		const size_t match = matcher->Find(text, pos, length, lengthMatch);
+		if (match == std::string::npos)
+			break;
+		for (size_t i = lineStart; i < match; i++) {
+			if (IsLineEnd(text[i])) {
+				if ((text[i] == '\r') && (i + 1 < length) && (text[i + 1] == '\n'))
+					i++;
+				lineNumber++;
+				lineStart = i + 1;
+			}
+		}
+		const size_t lineEnd = LineEnd(text, match, length);
+		// Lines are only searched up to any NUL as they were when read as C strings
+		const char *nul = static_cast<const char *>(memchr(text + lineStart, '\0', lineEnd - lineStart));
+		if (!nul || (nul >= text + match + lengthMatch)) {
+			if (spec.listStyle) {
+#if !defined(GTK)
+				os.append(".");
+#endif
+				os.append(displayPath.c_str() + spec.basePath);
+			} else {
+				os.append(displayPath);
+			}
+			os.append(":");
+			char number[32];
+			sprintf(number, "%d", lineNumber);
+			os.append(number);
+			os.append(":");
+			const size_t lineShown = nul ? (nul - text) : lineEnd;
+			if (spec.listStyle == 1) {
+				// Tabs become spaces and runs of spaces are reduced to one
+				os.append(" ");
+				for (size_t i = lineStart; i < lineShown; i++) {
+					const char ch = (text[i] == '\t') ? ' ' : text[i];
+					if ((ch != ' ') || (os[os.length() - 1] != ' '))
+						os.push_back(ch);
+				}
+			} else {
+				os.append(text + lineStart, lineShown - lineStart);
+			}
+			os.append("\n");
+		}
+		if (lineEnd >= length)
+			break;
+		// Continue from the start of the next line
+		pos = NextLineStart(text, lineEnd, length);
+		lineNumber++;
+		lineStart = pos;
+	}
+}
+
+void GrepSearcher::SearchFile(const FilePath &path, std::string &os, std::string *filter) {
+	FILE *fp = path.Open(fileRead);
+	if (!fp)
+		return;
+	const long size = path.GetFileLength();
+	const char *text = "";
+	size_t length = 0;
+	MappedFile *file = new MappedFile();
+	if ((size > 0) && file->Map(fp, size)) {
+		text = file->Data();
+		length = file->Length();
+	} else if (size > 0) {
+		buffer.resize(size);
+		length = fread(&buffer[0], 1, size, fp);
+		text = &buffer[0];
+	}
+	fclose(fp);
+	if (spec.binary || !memchr(text, '\0', (length < binaryCheckSize) ? length : binaryCheckSize)) {
+		SearchText(path.AsUTF8(), text, length, os);
+	}
+	if (filter) {
+		// Indexed while in memory so files are only read once
+		trigrams.Collect(text, length);
+		*filter = trigrams.Filter();
+	}
+	file->Release();
+}
+
+GrepQueue::GrepQueue(const GrepSpec &spec_) :
+	spec(spec_), mutex(Mutex::Create()), changed(0), index(0), firstEntry(0), nextEntry(0),
+	walked(false), cancelled(false), workers(0) {
+	changed = Condition::Create(mutex);
+}
+
+GrepQueue::~GrepQueue() {
+	delete changed;
+	changed = 0;
+	delete mutex;
+	mutex = 0;
+}
+
+void GrepQueue::SetIndex(GrepIndex *index_) {
+	Lock lock(mutex);
+	index = index_;
+}
+
+void GrepQueue::Add(const FilePath &path) {
+	Lock lock(mutex);
+	entries.push_back(Entry(path));
+	changed->Broadcast();
+}
+
+void GrepQueue::Add(const FilePath &path, const std::string &key, long size, time_t modified) {
+	Lock lock(mutex);
+	entries.push_back(Entry(path));
+	Entry &entry = entries.back();
+	entry.indexing = true;
+	entry.key = key;
+	entry.size = size;
+	entry.modified = modified;
+	changed->Broadcast();
+}
+
+void GrepQueue::EndWalk() {
+	Lock lock(mutex);
+	walked = true;
+	changed->Broadcast();
+}
+
+void GrepQueue::Cancel() {
+	Lock lock(mutex);
+	cancelled = true;
+	changed->Broadcast();
+}
+
+bool GrepQueue::Cancelled() const {
+	Lock lock(mutex);
+	return cancelled;
+}
+
+// Called with the mutex locked
+bool GrepQueue::Exhausted() const {
+	return cancelled || (walked && (nextEntry == firstEntry + entries.size()));
+}
+
+bool GrepQueue::SearchOne(GrepSearcher &searcher, bool &exhausted, bool wait) {
+	FilePath path;
+	size_t entry = 0;
+	bool indexing = false;
+	{
+		Lock lock(mutex);
+		while (wait && !Exhausted() && (nextEntry == firstEntry + entries.size()))
+			changed->Wait();
+		exhausted = Exhausted();
+		if (exhausted || (nextEntry == firstEntry + entries.size()))
+			return false;
+		entry = nextEntry++;
+		path = entries[entry - firstEntry].path;
+		indexing = entries[entry - firstEntry].indexing;
+	}
+	std::string os;
+	std::string filter;
+	searcher.SearchFile(path, os, indexing ? &filter : 0);
+	Lock lock(mutex);
+	// Entries are only removed once searched so this one is still present
+	Entry &searched = entries[entry - firstEntry];
+	searched.result.swap(os);
+	searched.filter.swap(filter);
+	searched.searched = true;
+	changed->Broadcast();
+	return true;
+}
+
+bool GrepQueue::TakeResults(std::string &os) {
+	Lock lock(mutex);
+	while (!entries.empty() && entries.front().searched) {
+		Entry &front = entries.front();
+		os.append(front.result);
+		// Files that could not be read are left to be indexed another time
+		if (index && front.indexing && !front.filter.empty())
+			index->Update(front.key, front.size, front.modified, front.filter);
+		entries.pop_front();
+		firstEntry++;
+	}
+	return walked && entries.empty();
+}
+
+void GrepQueue::WaitForResults() {
+	Lock lock(mutex);
+	while (!cancelled && !entries.empty() && !entries.front().searched)
+		changed->Wait();
+}
+
+void GrepQueue::WorkerStarted() {
+	Lock lock(mutex);
+	workers++;
+}
+
+void GrepQueue::WorkerFinished() {
+	Lock lock(mutex);
+	workers--;
+	changed->Broadcast();
+}
+
+void GrepQueue::WaitForWorkers() {
+	Lock lock(mutex);
+	while (workers > 0)
+		changed->Wait();
+}
+
+int GrepQueue::ProcessorCount() {
+#ifdef __unix__
+	const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	return (processors > 0) ? static_cast<int>(processors) : 1;
+#else
+	SYSTEM_INFO info;
+	::GetSystemInfo(&info);
+	return static_cast<int>(info.dwNumberOfProcessors);
+#endif
+}
+
+void GrepWorker::Execute() {
+	GrepSearcher searcher(queue->Spec());
+	bool exhausted = false;
+	while (!exhausted)
+		queue->SearchOne(searcher, exhausted, true);
+	completed = true;
+	// The queue may be destroyed once the last worker has finished
+	queue->WorkerFinished();
+}
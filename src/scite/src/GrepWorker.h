@@ -0,0 +1,176 @@
+// SciTE - Scintilla based Text Editor
+/** @file GrepWorker.h
+ ** Definition of classes to search in files on several threads.
+ **/
+// Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef GREPWORKER_H
+#define GREPWORKER_H
+
+/// Finds matches in the contents of a file. Matches never span line ends.
+/// Each searching thread has its own matcher as they may keep state between calls.
+class GrepMatcher {
+public:
+	virtual ~GrepMatcher() {}
+	/// Position of a match at or after start or std::string::npos.
+	/// No match ends before the match returned so it is on the first line with a match.
+	virtual size_t Find(const char *text, size_t start, size_t length, size_t &lengthMatch) = 0;
+};
+
+/// Finds a literal string.
+/// Case insensitive matching only folds ASCII letters as that is what the
+/// output pane of earlier versions showed.
+class LiteralMatcher : public GrepMatcher {
+	std::string pattern;
+	bool matchCase;
+	bool wholeWord;
+	char fold[256];
+	char firstBytes[2];
+	char lastBytes[2];
+public:
+	LiteralMatcher(const std::string &pattern_, bool matchCase_, bool wholeWord_);
+	virtual size_t Find(const char *text, size_t start, size_t length, size_t &lengthMatch);
+	size_t FindBytes(const char *text, size_t start, size_t length) const;
+	bool MatchesAt(const char *text) const;
+};
+
+/// Finds any of a set of literal strings in one pass with an Aho-Corasick automaton.
+class LiteralSetMatcher : public GrepMatcher {
+	enum { alphabetSize = 256 };
+	/// Transitions for each state after following failure links so each byte is one step
+	std::vector<int> transitions;
+	/// Lengths of the patterns that end at each state, including those of its suffixes
+	std::vector<std::vector<size_t> > endings;
+	bool wholeWord;
+	bool startByte[alphabetSize];
+	int AddState();
+public:
+	LiteralSetMatcher(const std::vector<std::string> &patterns, bool matchCase, bool wholeWord_);
+	virtual size_t Find(const char *text, size_t start, size_t length, size_t &lengthMatch);
+};
+
+/// Finds a regular expression with the linear time engine one line at a time.
+class RegexMatcher : public GrepMatcher {
+	LinearRegex regex;
+	bool wholeWord;
+	/// Group of the expression that is the match reported
+	int group;
+public:
+	RegexMatcher(bool unicode, bool wholeWord_);
+	const char *Compile(const std::string &pattern, bool matchCase, bool posix);
+	virtual size_t Find(const char *text, size_t start, size_t length, size_t &lengthMatch);
+};
+
+/// How to search and how to show the lines found. Shared by all the threads of a search.
+struct GrepSpec {
+	std::string searchString;
+	bool matchCase;
+	bool wholeWord;
+	bool regExp;
+	bool posix;
+	bool unicode;
+	bool binary;
+	/// lexer.errorlist.findliststyle is read once rather than for each line found
+	int listStyle;
+	unsigned int basePath;
+
+	GrepSpec(const std::string &searchString_, bool matchCase_, bool wholeWord_, bool binary_,
+		int listStyle_, unsigned int basePath_);
+	/// The search as plain text alternatives, returning false for other regular expressions.
+	bool LiteralAlternatives(std::vector<std::string> &alternatives) const;
+	/// Create a matcher for one thread. Returns null and sets error when the expression is invalid.
+	GrepMatcher *CreateMatcher(const char **error=0) const;
+};
+
+/// The matcher and file buffer of one searching thread.
+class GrepSearcher {
+	const GrepSpec &spec;
+	GrepMatcher *matcher;
+	std::vector<char> buffer;
+	TrigramCollector trigrams;
+	// Private so GrepSearcher objects can not be copied
+	GrepSearcher(const GrepSearcher &);
+public:
+	explicit GrepSearcher(const GrepSpec &spec_);
+	~GrepSearcher();
+	/// Append the lines of text that match to os in the format of the output pane.
+	void SearchText(const std::string &displayPath, const char *text, size_t length, std::string &os);
+	/// Read or map the file then search it. When filter is set it receives the trigrams of the file.
+	void SearchFile(const FilePath &path, std::string &os, std::string *filter=0);
+};
+
+/// Files found by the thread walking the directories in the order they were found.
+/// Searching threads take files from the front and the results are reported in order
+/// as soon as all earlier files have been searched.
+class GrepQueue {
+	struct Entry {
+		FilePath path;
+		std::string result;
+		bool searched;
+		/// Set when the file is to be added to the index again
+		bool indexing;
+		std::string key;
+		long size;
+		time_t modified;
+		std::string filter;
+		Entry(const FilePath &path_) : path(path_), searched(false), indexing(false), size(0), modified(0) {
+		}
+	};
+	const GrepSpec &spec;
+	Mutex *mutex;
+	/// Broadcast when files are added or searched, when the walk ends and when a worker finishes
+	Condition *changed;
+	GrepIndex *index;
+	std::deque<Entry> entries;
+	/// Sequence number of the first entry not yet reported
+	size_t firstEntry;
+	/// Sequence number of the next entry to be searched
+	size_t nextEntry;
+	bool walked;
+	bool cancelled;
+	int workers;
+	bool Exhausted() const;
+	// Private so GrepQueue objects can not be copied
+	GrepQueue(const GrepQueue &);
+public:
+	explicit GrepQueue(const GrepSpec &spec_);
+	~GrepQueue();
+	const GrepSpec &Spec() const {
+		return spec;
+	}
+	/// The index is updated with the files it needs as their results are taken.
+	void SetIndex(GrepIndex *index_);
+	void Add(const FilePath &path);
+	/// Add a file that has changed since it was indexed.
+	void Add(const FilePath &path, const std::string &key, long size, time_t modified);
+	/// No more files will be added.
+	void EndWalk();
+	void Cancel();
+	bool Cancelled() const;
+	/// Search one file, returning false when there is no file waiting.
+	/// exhausted is set when no more files will ever be waiting.
+	/// With wait set, wait for a file to be added when none is waiting and the queue is not exhausted.
+	bool SearchOne(GrepSearcher &searcher, bool &exhausted, bool wait=false);
+	/// Move the results that can be reported into os, returning true when all have been reported.
+	bool TakeResults(std::string &os);
+	/// Wait until the first file not yet reported has been searched or the queue is cancelled.
+	void WaitForResults();
+	/// Count the threads searching files so they can be waited for.
+	void WorkerStarted();
+	void WorkerFinished();
+	void WaitForWorkers();
+	/// Number of threads to use when find.in.threads is not set.
+	static int ProcessorCount();
+};
+
+/// Searches files from a GrepQueue until it is exhausted.
+class GrepWorker : public Worker {
+	GrepQueue *queue;
+public:
+	explicit GrepWorker(GrepQueue *queue_) : queue(queue_) {
+	}
+	virtual void Execute();
+};
+
+#endif
@@ -1892,6 +1892,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCE_YAML_OPERATOR",9},
 	{"SCE_YAML_REFERENCE",5},
 	{"SCE_YAML_TEXT",7},
+	{"SCFIND_LINEARREGEX",0x01000000},
 	{"SCFIND_MATCHCASE",4},
 	{"SCFIND_POSIX",0x00400000},
 	{"SCFIND_REGEXP",0x00200000},
@@ -1985,6 +1986,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETHOTSPOTSINGLELINE",2497},
 	{"SCI_GETHSCROLLBAR",2131},
 	{"SCI_GETIDENTIFIER",2623},
+	{"SCI_GETIDLESTYLING",4040},
 	{"SCI_GETINDENT",2123},
 	{"SCI_GETINDENTATIONGUIDES",2133},
 	{"SCI_GETINDICATORCURRENT",2501},
@@ -1999,6 +2001,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETLINEENDTYPESACTIVE",2658},
 	{"SCI_GETLINEENDTYPESALLOWED",2657},
 	{"SCI_GETLINEENDTYPESSUPPORTED",4018},
+	{"SCI_GETLINEIMAGECACHE",4036},
 	{"SCI_GETLINEINDENTATION",2127},
 	{"SCI_GETLINEINDENTPOSITION",2128},
 	{"SCI_GETLINESTATE",2093},
@@ -2012,6 +2015,8 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETMARGINSENSITIVEN",2247},
 	{"SCI_GETMARGINTYPEN",2241},
 	{"SCI_GETMARGINWIDTHN",2243},
+	{"SCI_GETMATCHEND",4043},
+	{"SCI_GETMATCHSTART",4042},
 	{"SCI_GETMAXLINESTATE",2094},
 	{"SCI_GETMODEVENTMASK",2378},
 	{"SCI_GETMODIFY",2159},
@@ -2022,6 +2027,8 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETOVERTYPE",2187},
 	{"SCI_GETPASTECONVERTENDINGS",2468},
 	{"SCI_GETPOSITIONCACHE",2515},
+	{"SCI_GETPOSITIONCACHEHITS",4033},
+	{"SCI_GETPOSITIONCACHEMISSES",4034},
 	{"SCI_GETPRINTCOLOURMODE",2149},
 	{"SCI_GETPRINTMAGNIFICATION",2147},
 	{"SCI_GETPRINTWRAPMODE",2407},
@@ -2067,6 +2074,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETTEXTLENGTH",2183},
 	{"SCI_GETTWOPHASEDRAW",2283},
 	{"SCI_GETUNDOCOLLECTION",2019},
+	{"SCI_GETUNDOMEMORYLIMIT",4038},
 	{"SCI_GETUSETABS",2125},
 	{"SCI_GETVIEWEOL",2355},
 	{"SCI_GETVIEWWS",2020},
@@ -2154,6 +2162,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_SETHSCROLLBAR",2130},
 	{"SCI_SETIDENTIFIER",2622},
 	{"SCI_SETIDENTIFIERS",4024},
+	{"SCI_SETIDLESTYLING",4039},
 	{"SCI_SETINDENT",2122},
 	{"SCI_SETINDENTATIONGUIDES",2132},
 	{"SCI_SETINDICATORCURRENT",2500},
@@ -2164,6 +2173,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_SETLEXER",4001},
 	{"SCI_SETLEXERLANGUAGE",4006},
 	{"SCI_SETLINEENDTYPESALLOWED",2656},
+	{"SCI_SETLINEIMAGECACHE",4035},
 	{"SCI_SETLINEINDENTATION",2126},
 	{"SCI_SETLINESTATE",2092},
 	{"SCI_SETMAINSELECTION",2574},
@@ -2218,6 +2228,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_SETTECHNOLOGY",2630},
 	{"SCI_SETTWOPHASEDRAW",2284},
 	{"SCI_SETUNDOCOLLECTION",2012},
+	{"SCI_SETUNDOMEMORYLIMIT",4037},
 	{"SCI_SETUSETABS",2124},
 	{"SCI_SETVIEWEOL",2356},
 	{"SCI_SETVIEWWS",2021},
@@ -2465,6 +2476,10 @@ static IFaceConstant ifaceConstants[] = {
 	{"SC_FOLDLEVELNUMBERMASK",0x0FFF},
 	{"SC_FOLDLEVELWHITEFLAG",0x1000},
 	{"SC_FONT_SIZE_MULTIPLIER",100},
+	{"SC_IDLESTYLING_AFTERVISIBLE",2},
+	{"SC_IDLESTYLING_ALL",3},
+	{"SC_IDLESTYLING_NONE",0},
+	{"SC_IDLESTYLING_TOVISIBLE",1},
 	{"SC_IV_LOOKBOTH",3},
 	{"SC_IV_LOOKFORWARD",2},
 	{"SC_IV_NONE",0},
@@ -2718,6 +2733,8 @@ static IFaceFunction ifaceFunctions[] = {
 	{"IndicatorAllOnFor", 2506, iface_int, {iface_int, iface_void}},
 	{"IndicatorClearRange", 2505, iface_void, {iface_int, iface_int}},
 	{"IndicatorEnd", 2509, iface_int, {iface_int, iface_int}},
+	{"IndicatorFillAllInTarget", 4045, iface_void, {iface_int, iface_string}},
+	{"IndicatorFillMatches", 4044, iface_int, {iface_int, iface_void}},
 	{"IndicatorFillRange", 2504, iface_void, {iface_int, iface_int}},
 	{"IndicatorStart", 2508, iface_int, {iface_int, iface_int}},
 	{"IndicatorValueAt", 2507, iface_int, {iface_int, iface_int}},
@@ -2795,6 +2812,8 @@ static IFaceFunction ifaceFunctions[] = {
 	{"RegisterRGBAImage", 2627, iface_void, {iface_int, iface_string}},
 	{"ReleaseAllExtendedStyles", 2552, iface_void, {iface_void, iface_void}},
 	{"ReleaseDocument", 2377, iface_void, {iface_void, iface_int}},
+	{"ReplaceMatches", 4046, iface_int, {iface_length, iface_string}},
+	{"ReplaceMatchesRE", 4047, iface_int, {iface_length, iface_string}},
 	{"ReplaceSel", 2170, iface_void, {iface_void, iface_string}},
 	{"ReplaceTarget", 2194, iface_int, {iface_length, iface_string}},
 	{"ReplaceTargetRE", 2195, iface_int, {iface_length, iface_string}},
@@ -2802,6 +2821,7 @@ static IFaceFunction ifaceFunctions[] = {
 	{"ScrollCaret", 2169, iface_void, {iface_void, iface_void}},
 	{"ScrollToEnd", 2629, iface_void, {iface_void, iface_void}},
 	{"ScrollToStart", 2628, iface_void, {iface_void, iface_void}},
+	{"SearchAllInTarget", 4041, iface_int, {iface_length, iface_string}},
 	{"SearchAnchor", 2366, iface_void, {iface_void, iface_void}},
 	{"SearchInTarget", 2197, iface_int, {iface_length, iface_string}},
 	{"SearchNext", 2367, iface_int, {iface_int, iface_string}},
@@ -2957,6 +2977,7 @@ static IFaceProperty ifaceProperties[] = {
 	{"HotspotSingleLine", 2497, 2421, iface_bool, iface_void},
 	{"Identifier", 2623, 2622, iface_int, iface_void},
 	{"Identifiers", 0, 4024, iface_string, iface_int},
+	{"IdleStyling", 4040, 4039, iface_int, iface_void},
 	{"Indent", 2123, 2122, iface_int, iface_void},
 	{"IndentationGuides", 2133, 2132, iface_int, iface_void},
 	{"IndicAlpha", 2524, 2523, iface_int, iface_int},
@@ -2977,6 +2998,7 @@ static IFaceProperty ifaceProperties[] = {
 	{"LineEndTypesActive", 2658, 0, iface_int, iface_void},
 	{"LineEndTypesAllowed", 2657, 2656, iface_int, iface_void},
 	{"LineEndTypesSupported", 4018, 0, iface_int, iface_void},
+	{"LineImageCache", 4036, 4035, iface_int, iface_void},
 	{"LineIndentPosition", 2128, 0, iface_position, iface_int},
 	{"LineIndentation", 2127, 2126, iface_int, iface_int},
 	{"LineState", 2093, 2092, iface_int, iface_int},
@@ -2999,6 +3021,8 @@ static IFaceProperty ifaceProperties[] = {
 	{"MarkerBack", 0, 2042, iface_colour, iface_int},
 	{"MarkerBackSelected", 0, 2292, iface_colour, iface_int},
 	{"MarkerFore", 0, 2041, iface_colour, iface_int},
+	{"MatchEnd", 4043, 0, iface_position, iface_int},
+	{"MatchStart", 4042, 0, iface_position, iface_int},
 	{"MaxLineState", 2094, 0, iface_int, iface_void},
 	{"ModEventMask", 2378, 2359, iface_int, iface_void},
 	{"Modify", 2159, 0, iface_bool, iface_void},
@@ -3010,6 +3034,8 @@ static IFaceProperty ifaceProperties[] = {
 	{"Overtype", 2187, 2186, iface_bool, iface_void},
 	{"PasteConvertEndings", 2468, 2467, iface_bool, iface_void},
 	{"PositionCache", 2515, 2514, iface_int, iface_void},
+	{"PositionCacheHits", 4033, 0, iface_int, iface_void},
+	{"PositionCacheMisses", 4034, 0, iface_int, iface_void},
 	{"PrintColourMode", 2149, 2148, iface_int, iface_void},
 	{"PrintMagnification", 2147, 2146, iface_int, iface_void},
 	{"PrintWrapMode", 2407, 2406, iface_int, iface_void},
@@ -3074,6 +3100,7 @@ static IFaceProperty ifaceProperties[] = {
 	{"TextLength", 2183, 0, iface_int, iface_void},
 	{"TwoPhaseDraw", 2283, 2284, iface_bool, iface_void},
 	{"UndoCollection", 2019, 2012, iface_bool, iface_void},
+	{"UndoMemoryLimit", 4038, 4037, iface_int, iface_void},
 	{"UseTabs", 2125, 2124, iface_bool, iface_void},
 	{"VScrollBar", 2281, 2280, iface_bool, iface_void},
 	{"ViewEOL", 2355, 2356, iface_bool, iface_void},
@@ -3092,9 +3119,9 @@ static IFaceProperty ifaceProperties[] = {
 };
 
 enum {
-	ifaceFunctionCount = 281,
-	ifaceConstantCount = 2458,
-	ifacePropertyCount = 209
+	ifaceFunctionCount = 286,
+	ifaceConstantCount = 2473,
+	ifacePropertyCount = 216
 };
 
 //--Autogenerated
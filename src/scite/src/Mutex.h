@@ -19,6 +19,17 @@ public:
 	static Mutex *Create();
 };
 
+/// Lets threads wait for a change to state guarded by a mutex. Wait and Broadcast are
+/// called with the mutex locked. Wait unlocks it while waiting and may return without
+/// a Broadcast so callers check their state again.
+class Condition {
+public:
+	virtual void Wait() = 0;
+	virtual void Broadcast() = 0;
+	virtual ~Condition() {}
+	static Condition *Create(Mutex *mutex);
+};
+
 class Lock {
 	Mutex *mute;
 public:
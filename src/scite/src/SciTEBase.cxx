@@ -71,6 +71,7 @@
 #include "Cookie.h"
 #include "Worker.h"
 #include "FileWorker.h"
+#include "GrepIndex.h"
 #include "SciTEBase.h"
 #define _MAX_EXTENSION_RECURSIVE_CALL 100 //!-add-[OnMenuCommand]
 
@@ -158,6 +159,14 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), extender(ext) {
 	allowMenuActions = true;
 	scrollOutput = 1;
 	returnOutputToCommand = true;
+	mutexOutput = Mutex::Create();
+	conditionOutput = Condition::Create(mutexOutput);
+	outputAppending = false;
+	outputBufferSize = 0;
+	outputTrimmed = 0;
+	outputSpill = 0;
+	outputKept = 0;
+	grepIndex = 0;
 
 	ptStartDrag.x = 0;
 	ptStartDrag.y = 0;
@@ -228,6 +237,13 @@ SciTEBase::~SciTEBase() {
 	delete []languageMenu;
 	delete []shortCutItemList;
 //!	popup.Destroy(); //!-remove-[ExtendedContextMenu]
+	delete conditionOutput;
+	conditionOutput = 0;
+	delete mutexOutput;
+	mutexOutput = 0;
+	OutputSpillClose();
+	delete grepIndex;
+	grepIndex = 0;
 }
 //!-start-[OnSendEditor]
 static bool isInterruptableMessage(unsigned int msg) {
@@ -397,6 +413,9 @@ void SciTEBase::WorkerCommand(int cmd, Worker *pWorker) {
 	case WORK_FILEPROGRESS:
  		UpdateProgress(pWorker);
 		break;
+	case WORK_OUTPUT:
+		OutputAppendPending();
+		break;
 	}
 }
 
@@ -950,29 +969,11 @@ void SciTEBase::HighlightCurrentWord(bool highlight) {
 	wCurrent.Call(SCI_SETTARGETSTART, 0);
 	wCurrent.Call(SCI_SETTARGETEND, lenDoc);
 
-	//Monitor the amount of time took by the search.
-	GUI::ElapsedTime searchElapsedTime;
-
-	// Find the first occurrence of word.
-	int indexOf = wCurrent.CallString(SCI_SEARCHINTARGET,
-	        wordToFind.length(), wordToFind.c_str());
-	while (indexOf != -1 && indexOf < lenDoc) {
-		// Limit the search duration to 250 ms. Avoid to freeze editor for large files.
-		if (searchElapsedTime.Duration() > 0.25) {
-			// Clear all indicators because timer has expired.
-			wCurrent.Call(SCI_INDICATORCLEARRANGE, 0, lenDoc);
-			break;
-		}
-		if (!currentWordHighlight.isOnlyWithSameStyle || selectedStyle ==
-		        wCurrent.Call(SCI_GETSTYLEAT, indexOf)) {
-			wCurrent.Call(SCI_INDICATORFILLRANGE, indexOf, wordToFind.length());
-		}
-		// Try to find next occurrence of word.
-		wCurrent.Call(SCI_SETTARGETSTART, indexOf + wordToFind.length() + 1);
-		wCurrent.Call(SCI_SETTARGETEND, lenDoc);
-		indexOf = wCurrent.CallString(SCI_SEARCHINTARGET, wordToFind.length(),
-		        wordToFind.c_str());
-	}
+	// The visible lines are highlighted now and the rest of the document in idle time,
+	// until the indicator is cleared above or the text changes.
+	wCurrent.CallString(SCI_INDICATORFILLALLINTARGET,
+	        currentWordHighlight.isOnlyWithSameStyle ? (selectedStyle & 0xff) : -1,
+	        wordToFind.c_str());
 }
 
 SString SciTEBase::GetRange(GUI::ScintillaWindow &win, int selStart, int selEnd) {
@@ -1178,7 +1179,23 @@ int SciTEBase::MarkAll() {
 		RemoveFindMarks();
 		CurrentBuffer()->findMarks = Buffer::fmMarked;
 	}
-	if (posFirstFound != -1) {
+	if ((posFirstFound != -1) && !findInStyle) {
+		// FindNext has set the search flags so find the remaining matches in one call
+		SString findTarget = EncodeString(findWhat);
+		int lenFind = UnSlashAsNeeded(findTarget, unSlash, regExp);
+		wEditor.Call(SCI_SETTARGETSTART, wrapFind ? 0 : posFirstFound);
+		wEditor.Call(SCI_SETTARGETEND, LengthDocument());
+		marked = wEditor.CallString(SCI_SEARCHALLINTARGET, lenFind, findTarget.c_str());
+		if (props.GetInt("find.bookmark", 1)) { //!-add-[find.bookmark]
+			for (int match = 0; match < marked; match++) {
+				int posFound = wEditor.Call(SCI_GETMATCHSTART, match);
+				BookmarkAdd(wEditor.Call(SCI_LINEFROMPOSITION, posFound));
+			}
+		}
+		if (findMark.length()) {
+			wEditor.Call(SCI_INDICATORFILLMATCHES, static_cast<uptr_t>(-1));
+		}
+	} else if (posFirstFound != -1) {
 		int posEndFound;
 		int posFound = posFirstFound;
 		do {
@@ -1274,7 +1291,8 @@ int SciTEBase::FindNext(bool reverseDirection, bool showWarnings, bool allowRegE
 	int flags = (wholeWord ? SCFIND_WHOLEWORD : 0) |
 	        (matchCase ? SCFIND_MATCHCASE : 0) |
 	        ((allowRegExp && regExp) ? SCFIND_REGEXP : 0) |
-	        (props.GetInt("find.replace.regexp.posix") ? SCFIND_POSIX : 0);
+	        (props.GetInt("find.replace.regexp.posix") ? SCFIND_POSIX : 0) |
+	        (props.GetInt("find.replace.regexp.linear") ? SCFIND_LINEARREGEX : 0);
 
 	wEditor.Call(SCI_SETSEARCHFLAGS, flags);
 	int posFind = FindInTarget(findTarget.c_str(), lenFind, startPosition, endPosition);
@@ -1386,10 +1404,34 @@ int SciTEBase::DoReplaceAll(bool inSelection) {
 	int flags = (wholeWord ? SCFIND_WHOLEWORD : 0) |
 	        (matchCase ? SCFIND_MATCHCASE : 0) |
 	        (regExp ? SCFIND_REGEXP : 0) |
-	        (props.GetInt("find.replace.regexp.posix") ? SCFIND_POSIX : 0);
+	        (props.GetInt("find.replace.regexp.posix") ? SCFIND_POSIX : 0) |
+	        (props.GetInt("find.replace.regexp.linear") ? SCFIND_LINEARREGEX : 0);
 	wEditor.Call(SCI_SETSEARCHFLAGS, flags);
+	bool startOfLine = (findLen == 1) && regExp && (findTarget[0] == '^');
+	if (!startOfLine && !findInStyle && !(inSelection && countSelections > 1)) {
+		// Find every match then replace them all in a single pass
+		wEditor.Call(SCI_SETTARGETSTART, startPosition);
+		wEditor.Call(SCI_SETTARGETEND, endPosition);
+		if (wEditor.CallString(SCI_SEARCHALLINTARGET, findLen, findTarget.c_str()) == 0) {
+			return 0;
+		}
+		int lengthBefore = LengthDocument();
+		wEditor.Call(SCI_BEGINUNDOACTION);
+		int replacements = wEditor.CallString(regExp ? SCI_REPLACEMATCHESRE : SCI_REPLACEMATCHES,
+			replaceLen, replaceTarget.c_str());
+		endPosition += LengthDocument() - lengthBefore;
+		int lastMatch = wEditor.Call(SCI_GETTARGETEND);
+		if (inSelection) {
+			SetSelection(startPosition, endPosition);
+		} else {
+			if(!props.GetInt("find.replace.return.to.start")) //!-add-[ReturnBackAfterRALL]
+			SetSelection(lastMatch, lastMatch);
+		}
+		wEditor.Call(SCI_ENDUNDOACTION);
+		return replacements;
+	}
 	int posFind = FindInTarget(findTarget.c_str(), findLen, startPosition, endPosition);
-	if ((findLen == 1) && regExp && (findTarget[0] == '^')) {
+	if (startOfLine) {
 		// Special case for replace all start of line so it hits the first line
 		posFind = startPosition;
 		wEditor.Call(SCI_SETTARGETSTART, startPosition);
@@ -1513,9 +1555,12 @@ void SciTEBase::UIHasFocus() {
 }
 
 void SciTEBase::OutputAppendString(const char *s, int len) {
+	// Output from other threads was produced earlier so goes first
+	OutputAppendPending();
 	if (len == -1)
 		len = static_cast<int>(strlen(s));
 	wOutput.Call(SCI_APPENDTEXT, len, reinterpret_cast<sptr_t>(s));
+	OutputTrim();
 	if (scrollOutput) {
 		int line = wOutput.Call(SCI_GETLINECOUNT, 0, 0);
 		int lineStart = wOutput.Call(SCI_POSITIONFROMLINE, line);
@@ -1523,14 +1568,146 @@ void SciTEBase::OutputAppendString(const char *s, int len) {
 	}
 }
 
+// Output from a process that writes faster than it can be shown waits in outputPending
+// for no more than this before the thread producing it waits.
+static const size_t outputPendingMax = 8 * blockSize;
+
+// For threads other than the user interface thread. The text is added to outputPending and
+// the user interface thread is only told when outputPending was empty so it appends all the
+// text that arrived in the meantime with one SCI_APPENDTEXT and scrolls once.
 void SciTEBase::OutputAppendStringSynchronised(const char *s, int len) {
 	if (len == -1)
 		len = static_cast<int>(strlen(s));
-	wOutput.Send(SCI_APPENDTEXT, len, reinterpret_cast<sptr_t>(s));
+	bool notify = false;
+	{
+		Lock lock(mutexOutput);
+		while (!outputPending.empty() && (outputPending.length() + len > outputPendingMax))
+			conditionOutput->Wait();
+		notify = outputPending.empty();
+		outputPending.append(s, len);
+	}
+	if (notify)
+		PostOnMainThread(WORK_OUTPUT, 0);
+}
+
+void SciTEBase::OutputAppendPending() {
+	std::string text;
+	{
+		Lock lock(mutexOutput);
+		if (outputPending.empty())
+			return;
+		text.swap(outputPending);
+		outputAppending = true;
+		conditionOutput->Broadcast();
+	}
+	wOutput.Call(SCI_APPENDTEXT, text.length(), reinterpret_cast<sptr_t>(text.c_str()));
+	OutputTrim();
 	if (scrollOutput) {
-		sptr_t line = wOutput.Send(SCI_GETLINECOUNT);
-		sptr_t lineStart = wOutput.Send(SCI_POSITIONFROMLINE, line);
-		wOutput.Send(SCI_GOTOPOS, lineStart);
+		int line = wOutput.Call(SCI_GETLINECOUNT, 0, 0);
+		int lineStart = wOutput.Call(SCI_POSITIONFROMLINE, line);
+		wOutput.Call(SCI_GOTOPOS, lineStart);
+	}
+	Lock lock(mutexOutput);
+	outputAppending = false;
+	conditionOutput->Broadcast();
+}
+
+// Wait until the user interface thread has appended the output of this thread, before
+// reading positions from the output pane.
+void SciTEBase::OutputFlushSynchronised() {
+	Lock lock(mutexOutput);
+	while (!outputPending.empty() || outputAppending)
+		conditionOutput->Wait();
+}
+
+// Keep the output pane within output.buffer.size by removing whole lines from its start.
+// A quarter of the buffer is freed each time so trimming is rare. Lines that are not plain
+// output, such as commands and messages, are kept at the start while they fit in that
+// quarter so GoMessage and ShowMessages still reach messages of the whole log.
+void SciTEBase::OutputTrim() {
+	if (outputBufferSize <= 0)
+		return;
+	int length = wOutput.Call(SCI_GETLENGTH);
+	if (length <= outputBufferSize)
+		return;
+	const int cutLine = wOutput.Call(SCI_LINEFROMPOSITION, length - outputBufferSize / 4 * 3);
+	const int cut = wOutput.Call(SCI_POSITIONFROMLINE, cutLine);
+	if (cut <= 0)
+		return;
+	// Commands and messages are found by their styles so style up to the cut first
+	const int endStyled = wOutput.Call(SCI_GETENDSTYLED);
+	if (endStyled < cut)
+		wOutput.Call(SCI_COLOURISE, endStyled, cut);
+	const char *text = reinterpret_cast<const char *>(wOutput.CallReturnPointer(SCI_GETCHARACTERPOINTER));
+	// Lines kept by an earlier trim were spilled then so only the text after them is written
+	if (outputKept > cut)
+		outputKept = 0;
+	if (props.GetInt("output.spill")) {
+		if (!outputSpill) {
+			// Named for this process so that several instances do not write over each other
+			char spillName[40];
+#if defined(__unix__)
+			sprintf(spillName, "SciTE.%d.output", static_cast<int>(getpid()));
+#else
+			sprintf(spillName, "SciTE.%d.output", static_cast<int>(::GetCurrentProcessId()));
+#endif
+			outputSpill = UserFilePath(GUI::StringFromUTF8(spillName).c_str()).Open(fileWrite);
+		}
+		if (outputSpill)
+			fwrite(text + outputKept, 1, cut - outputKept, outputSpill);
+	}
+	// Choose the lines to keep starting from the most recent
+	std::vector<int> keptLines;
+	int keptLength = 0;
+	for (int line = cutLine - 1; line >= 0; line--) {
+		const int lineStart = wOutput.Call(SCI_POSITIONFROMLINE, line);
+		if (wOutput.Call(SCI_GETSTYLEAT, lineStart) != SCE_ERR_DEFAULT) {
+			const int lineLength = wOutput.Call(SCI_POSITIONFROMLINE, line + 1) - lineStart;
+			if (keptLength + lineLength > outputBufferSize / 4)
+				break;
+			keptLines.push_back(line);
+			keptLength += lineLength;
+		}
+	}
+	std::string kept;
+	kept.reserve(keptLength);
+	for (std::vector<int>::reverse_iterator it = keptLines.rbegin(); it != keptLines.rend(); ++it) {
+		const int lineStart = wOutput.Call(SCI_POSITIONFROMLINE, *it);
+		kept.append(text + lineStart, wOutput.Call(SCI_POSITIONFROMLINE, *it + 1) - lineStart);
+	}
+	// The removed text would otherwise stay in the undo history
+	wOutput.Call(SCI_SETUNDOCOLLECTION, 0);
+	wOutput.Call(SCI_DELETERANGE, 0, cut);
+	if (keptLength > 0)
+		wOutput.Call(SCI_INSERTTEXT, 0, reinterpret_cast<sptr_t>(kept.c_str()));
+	wOutput.Call(SCI_SETUNDOCOLLECTION, 1);
+	wOutput.Call(SCI_EMPTYUNDOBUFFER);
+	outputKept = keptLength;
+	// The error list lexer styles each line by itself so the lines after the cut keep their
+	// styles and only the kept lines are styled again.
+	if (keptLength > 0)
+		wOutput.Call(SCI_COLOURISE, 0, keptLength);
+	wOutput.Call(SCI_STARTSTYLING, ((endStyled > cut) ? endStyled : cut) - cut + keptLength, 0x1f);
+	Lock lock(mutexOutput);
+	outputTrimmed += cut - keptLength;
+}
+
+// Positions in the output pane that are kept while commands run are saved along with
+// OutputTrimmedLength so they can be moved back over text trimmed since.
+sptr_t SciTEBase::OutputTrimmedLength() {
+	Lock lock(mutexOutput);
+	return outputTrimmed;
+}
+
+sptr_t SciTEBase::OutputPositionTrimmed(sptr_t position, sptr_t trimmedAtSave) {
+	position -= OutputTrimmedLength() - trimmedAtSave;
+	return (position > 0) ? position : 0;
+}
+
+void SciTEBase::OutputSpillClose() {
+	if (outputSpill) {
+		fclose(outputSpill);
+		outputSpill = 0;
 	}
 }
 
@@ -1570,6 +1747,7 @@ void SciTEBase::Execute() {
 
 	if (jobQueue.ClearBeforeExecute()) {
 		wOutput.Send(SCI_CLEARALL);
+		outputKept = 0;
 	}
 
 	wOutput.Call(SCI_MARKERDELETEALL, static_cast<uptr_t>(-1));
@@ -3811,6 +3989,8 @@ void SciTEBase::MenuCommand(int cmdID, int source) {
 
 	case IDM_CLEAROUTPUT:
 		wOutput.Send(SCI_CLEARALL);
+		outputKept = 0;
+		OutputSpillClose();
 		break;
 
 	case IDM_SWITCHPANE:
@@ -5289,7 +5469,8 @@ bool SciTEBase::ProcessCommandLine(GUI::gui_string &args, int phase) {
 			} else if ((tolower(arg[0]) == 'p') && (arg[1] == 0)) {
 				performPrint = true;
 			} else if (GUI::gui_string(arg) == GUI_TEXT("grep") && (wlArgs.size() - i >= 4)) {
-				// in form -grep [w~][c~][d~][b~] "<file-patterns>" "<search-string>"
+				// in form -grep [w~][c~][d~][b~][r~] "<file-patterns>" "<search-string>"
+				// where the final [r~] for regular expressions is optional
 				GrepFlags gf = grepStdOut;
 				if (wlArgs[i+1][0] == 'w')
 					gf = static_cast<GrepFlags>(gf | grepWholeWord);
@@ -5299,6 +5480,8 @@ bool SciTEBase::ProcessCommandLine(GUI::gui_string &args, int phase) {
 					gf = static_cast<GrepFlags>(gf | grepDot);
 				if (wlArgs[i+1][3] == 'b')
 					gf = static_cast<GrepFlags>(gf | grepBinary);
+				if ((wlArgs[i+1].length() > 4) && (wlArgs[i+1][4] == 'r'))
+					gf = static_cast<GrepFlags>(gf | grepRegExp);
 				char unquoted[1000];
 				strcpy(unquoted, GUI::UTF8FromString(wlArgs[i+3].c_str()).c_str());
 				UnSlash(unquoted);
@@ -5395,7 +5578,7 @@ void SciTEBase::Insert(Pane p, int pos, const char *s) {
 
 void SciTEBase::Trace(const char *s) {
 	MakeOutputVisible();
-	OutputAppendStringSynchronised(s);
+	OutputAppendString(s);
 }
 
 char *SciTEBase::Property(const char *key) {
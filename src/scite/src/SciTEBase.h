@@ -110,6 +110,8 @@ public:
 	bool isDirty;
 	bool isReadOnly;
 	bool useMonoFont;
+	bool isView;	///< Text may still refer to a mapping of the file
+	long viewLength;	///< Length of the file when it was mapped
 	enum { empty, reading, readAll, open } lifeState;
 	UniMode unicodeMode;
 	time_t fileModTime;
@@ -123,7 +125,7 @@ public:
 	PropSetFile props;
 	enum FutureDo { fdNone=0, fdFinishSave=1 } futureDo;
 	Buffer() :
-			RecentFile(), doc(0), isDirty(false), isReadOnly(false), useMonoFont(false), lifeState(empty),
+			RecentFile(), doc(0), isDirty(false), isReadOnly(false), useMonoFont(false), isView(false), viewLength(0), lifeState(empty),
 			unicodeMode(uni8Bit), fileModTime(0), fileModLastAsk(0), documentModTime(0),
 			findMarks(fmNone), pFileWorker(0), futureDo(fdNone) {}
 
@@ -132,6 +134,8 @@ public:
 		isDirty = false;
 		isReadOnly = false;
 		useMonoFont = false;
+		isView = false;
+		viewLength = 0;
 		lifeState = empty;
 		unicodeMode = uni8Bit;
 		fileModTime = 0;
@@ -386,6 +390,11 @@ public:
 	}
 };
 
+class GrepSearcher;
+class GrepQueue;
+class GrepIndex;
+class TrigramQuery;
+
 class SciTEBase : public ExtensionAPI, public Searcher, public WorkerListener {
 protected:
 	virtual void SetToolBar() = 0;	//!-add-[user.toolbar]
@@ -551,6 +560,23 @@ protected:
 	int scrollOutput;
 	bool returnOutputToCommand;
 	JobQueue jobQueue;
+	/// Output from other threads waiting to be appended to the output pane in one batch
+	Mutex *mutexOutput;
+	/// Broadcast when outputPending has been taken and when it has been appended
+	Condition *conditionOutput;
+	std::string outputPending;
+	bool outputAppending;
+	/// Bytes the output pane may hold from output.buffer.size or 0 when it grows without limit
+	int outputBufferSize;
+	/// Length removed from the start of the output pane by OutputTrim, guarded by mutexOutput
+	sptr_t outputTrimmed;
+	/// Text removed from the start of the output pane when output.spill is set
+	FILE *outputSpill;
+	/// Length of the lines kept at the start of the output pane by OutputTrim, already spilled
+	int outputKept;
+	/// Index used by the last Find in Files, kept so the next search of the same directory
+	/// does not load it again
+	GrepIndex *grepIndex;
 
 	bool macrosEnabled;
 	SString currentMacro;
@@ -774,6 +800,12 @@ protected:
 	virtual void FindReplace(bool replace) = 0;
 	void OutputAppendString(const char *s, int len = -1);
 	virtual void OutputAppendStringSynchronised(const char *s, int len = -1);
+	void OutputAppendPending();
+	void OutputFlushSynchronised();
+	void OutputTrim();
+	sptr_t OutputTrimmedLength();
+	sptr_t OutputPositionTrimmed(sptr_t position, sptr_t trimmedAtSave);
+	void OutputSpillClose();
 	void MakeOutputVisible();
 	virtual void Execute();
 	virtual void StopExecute() = 0;
@@ -952,11 +984,12 @@ protected:
 	void OpenFilesFromStdin();
 	enum GrepFlags {
 	    grepNone = 0, grepWholeWord = 1, grepMatchCase = 2, grepStdOut = 4,
-	    grepDot = 8, grepBinary = 16, grepScroll = 32
+	    grepDot = 8, grepBinary = 16, grepScroll = 32, grepRegExp = 64
 	};
 	virtual bool GrepIntoDirectory(const FilePath &directory);
-//!	void GrepRecursive(GrepFlags gf, FilePath baseDir, const char *searchString, const GUI::gui_char *fileTypes);
-	void GrepRecursive(GrepFlags gf, FilePath baseDir, const char *searchString, const GUI::gui_char *fileTypes, unsigned int basePath); //!-change-[FindResultListStyle]
+	bool GrepResults(GrepFlags gf, GrepQueue &queue);
+	void GrepRecursive(GrepFlags gf, GrepQueue &queue, GrepSearcher *searcher, GrepIndex *index,
+		const TrigramQuery &query, FilePath baseDir, const GUI::gui_char *fileTypes);
 	void InternalGrep(GrepFlags gf, const GUI::gui_char *directory, const GUI::gui_char *files,
 			  const char *search, sptr_t &originalEnd);
 	void EnumProperties(const char *action);
@@ -16,6 +16,7 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <deque>
 
 #if defined(__unix__)
 
@@ -65,6 +66,9 @@
 #include "Cookie.h"
 #include "Worker.h"
 #include "FileWorker.h"
+#include "LinearRegex.h"
+#include "GrepIndex.h"
+#include "GrepWorker.h"
 #include "SciTEBase.h"
 #include "Utf8_16.h"
 
@@ -305,7 +309,10 @@ void SciTEBase::OpenFile(long fileSize, bool suppressMessage, bool asynchronous)
 		wEditor.Call(SCI_SETREADONLY, 1);
 		assert(CurrentBuffer()->pFileWorker == NULL);
 		ILoader *pdocLoad = reinterpret_cast<ILoader *>(wEditor.CallReturnPointer(SCI_CREATELOADER, fileSize + 1000));
-		CurrentBuffer()->pFileWorker = new FileLoader(this, pdocLoad, filePath, fileSize, fp);
+		FileLoader *pFileLoader = new FileLoader(this, pdocLoad, filePath, fileSize, fp);
+		const int mappedSize = props.GetInt("mapped.open.size");
+		pFileLoader->mapView = (mappedSize > 0) && (fileSize > mappedSize);
+		CurrentBuffer()->pFileWorker = pFileLoader;
 		CurrentBuffer()->pFileWorker->sleepTime = props.GetInt("asynchronous.sleep");
         CurrentBuffer()->pFileWorker->check_utf8 = check_utf8; //!-add-[utf8.auto.check]
 		PerformOnNewThread(CurrentBuffer()->pFileWorker);
@@ -350,6 +357,8 @@ void SciTEBase::TextRead(FileWorker *pFileWorker) {
 	// May not be found if load cancelled
 	if (iBuffer >= 0) {
 		buffers.buffers[iBuffer].unicodeMode = pFileLoader->unicodeMode;
+		buffers.buffers[iBuffer].isView = pFileLoader->viewed;
+		buffers.buffers[iBuffer].viewLength = pFileLoader->size;
 		buffers.buffers[iBuffer].lifeState = Buffer::readAll;
 		if (pFileLoader->err) {
 			GUI::gui_string msg = LocaliseMessage("Could not open file '^0'.", pFileLoader->path.AsInternal());
@@ -751,6 +760,23 @@ void SciTEBase::Revert() {
 }
 
 void SciTEBase::CheckReload() {
+	Buffer *buffer = CurrentBuffer();
+	const time_t viewModTime = buffer->isView ? filePath.ModifiedTime() : 0;
+	if ((viewModTime != 0) && !buffer->pFileWorker &&
+		((viewModTime != buffer->fileModTime) || (filePath.GetFileLength() != buffer->viewLength))) {
+		// The mapping shows the changed file while the document's line index is for the
+		// text that was loaded so stop referring to the file. A deleted file stays mapped.
+		buffer->isView = false;
+		if (buffer->isDirty) {
+			// Keep the edits and ask below whether to reload
+			wEditor.CallReturnPointer(SCI_GETCHARACTERPOINTER);
+		} else {
+			RecentFile rf = GetFilePosition();
+			Open(filePath, ofForceLoad);
+			DisplayAround(rf);
+			return;
+		}
+	}
 	if (props.GetInt("load.on.activate")) {
 		// Make a copy of fullPath as otherwise it gets aliased in Open
 		time_t newModTime = filePath.ModifiedTime();
@@ -1020,6 +1046,11 @@ bool SciTEBase::SaveBuffer(FilePath saveName, SaveFlags sf) {
 
 	if (!retVal) {
 
+		if (CurrentBuffer()->isView) {
+			// Copy the text out of the mapped file before the file is truncated
+			wEditor.CallReturnPointer(SCI_GETCHARACTERPOINTER);
+			CurrentBuffer()->isView = false;
+		}
 		FILE *fp = saveName.Open(fileWrite);
 		if (fp) {
 			int lengthDoc = LengthDocument();
@@ -1193,6 +1224,7 @@ void SciTEBase::OpenFromStdin(bool UseOutputPane) {
 	Open(GUI_TEXT(""));
 	if (UseOutputPane) {
 		wOutput.Call(SCI_CLEARALL);
+		outputKept = 0;
 	} else {
 		wEditor.Call(SCI_BEGINUNDOACTION);	// Group together clear and insert
 		wEditor.Call(SCI_CLEARALL);
@@ -1266,162 +1298,6 @@ void SciTEBase::OpenFilesFromStdin() {
 		Open(GUI_TEXT(""));
 }
 
-class BufferedFile {
-	FILE *fp;
-	bool readAll;
-	bool exhausted;
-	enum {bufLen = 64 * 1024};
-	char buffer[bufLen];
-	size_t pos;
-	size_t valid;
-	void EnsureData() {
-		if (pos >= valid) {
-			if (readAll || !fp) {
-				exhausted = true;
-			} else {
-				valid = fread(buffer, 1, bufLen, fp);
-				if (valid < bufLen) {
-					readAll = true;
-				}
-				pos = 0;
-			}
-		}
-	}
-public:
-	BufferedFile(FilePath fPath) {
-		fp = fPath.Open(fileRead);
-		readAll = false;
-		exhausted = fp == NULL;
-		pos = 0;
-		valid = 0;
-	}
-	~BufferedFile() {
-		if (fp) {
-			fclose(fp);
-		}
-		fp = NULL;
-	}
-	bool Exhausted() {
-		return exhausted;
-	}
-	int NextByte() {
-		EnsureData();
-		if (pos >= valid) {
-			return 0;
-		}
-		return buffer[pos++];
-	}
-	bool BufferContainsNull() {
-		EnsureData();
-		for (size_t i = 0;i < valid;i++) {
-			if (buffer[i] == '\0')
-				return true;
-		}
-		return false;
-	}
-};
-
-class FileReader {
-	BufferedFile *bf;
-	int lineNum;
-	bool lastWasCR;
-	enum {bufLen = 1000};
-/*!
-	char lineToCompare[bufLen+1];
-	char lineToShow[bufLen+1];
-*/
-//!-start-[FileReaderUnlimitedLen]
-	char buf[bufLen+1];
-	SString lineToCompare;
-	SString lineToShow;
-//!-end-[FileReaderUnlimitedLen]
-	bool caseSensitive;
-	// Private so FileReader objects can not be copied
-	FileReader(const FileReader &);
-public:
-
-	FileReader(FilePath fPath, bool caseSensitive_) {
-		bf = new BufferedFile(fPath);
-		lineNum = 0;
-		lastWasCR = false;
-		caseSensitive = caseSensitive_;
-	}
-	~FileReader() {
-		delete bf;
-		bf = NULL;
-	}
-	char *Next() {
-		if (bf->Exhausted()) {
-			return NULL;
-		}
-//!-start-[FileReaderUnlimitedLen]
-		lineToCompare.clear();
-		lineToShow.clear();
-//!-end-[FileReaderUnlimitedLen]
-		int i = 0;
-		while (!bf->Exhausted()) {
-			int ch = bf->NextByte();
-			if (i == 0 && lastWasCR && ch == '\n') {
-				lastWasCR = false;
-			} else if (ch == '\r' || ch == '\n') {
-				lastWasCR = ch == '\r';
-				break;
-/*!
-			} else if (i < bufLen) {
-				lineToShow[i++] = static_cast<char>(ch);
-			}
-		}
-		lineToShow[i] = '\0';
-*/
-//!-start-[FileReaderUnlimitedLen]
-			} else {
-				buf[i++] = static_cast<char>(ch);
-				if (i == bufLen) {
-					buf[i] = '\0';
-					lineToShow += buf;
-					i = 0;
-				}
-			}
-		}
-		buf[i] = '\0';
-		lineToShow += buf;
-//!-end-[FileReaderUnlimitedLen]
-		lineNum++;
-/*!
-		strcpy(lineToCompare, lineToShow);
-		if (!caseSensitive) {
-			for (int j = 0; j < i; j++) {
-				if (lineToCompare[j] >= 'A' && lineToCompare[j] <= 'Z') {
-					lineToCompare[j] = static_cast<char>(lineToCompare[j] - 'A' + 'a');
-				}
-			}
-		}
-		return lineToCompare;
-*/
-//!-start-[FileReaderUnlimitedLen]
-		lineToCompare = lineToShow;
-		if (!caseSensitive) {
-			lineToCompare.lowercase();
-		}
-		return const_cast<char *>(lineToCompare.c_str());
-//!-end-[FileReaderUnlimitedLen]
-	}
-	int LineNumber() const {
-		return lineNum;
-	}
-	const char *Original() {
-//!		return lineToShow;
-		return const_cast<char *>(lineToShow.c_str()); //!-change-[FileReaderUnlimitedLen]
-	}
-	bool BufferContainsNull() {
-		return bf->BufferContainsNull();
-	}
-};
-
-static bool IsWordCharacter(int ch) {
-	return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z')  || (ch >= '0' && ch <= '9')  || (ch == '_');
-}
-
 bool SciTEBase::GrepIntoDirectory(const FilePath &directory) {
     const GUI::gui_char *sDirectory = directory.AsInternal();
 #ifdef __APPLE__
@@ -1431,81 +1307,64 @@ bool SciTEBase::GrepIntoDirectory(const FilePath &directory) {
     return sDirectory[0] != '.';
 }
 
-//!void SciTEBase::GrepRecursive(GrepFlags gf, FilePath baseDir, const char *searchString, const GUI::gui_char *fileTypes) {
-void SciTEBase::GrepRecursive(GrepFlags gf, FilePath baseDir, const char *searchString, const GUI::gui_char *fileTypes, unsigned int basePath) { //!-change-[FindResultListStyle]
+bool SciTEBase::GrepResults(GrepFlags gf, GrepQueue &queue) {
+	std::string os;
+	const bool finished = queue.TakeResults(os);
+	if (os.length()) {
+		if (gf & grepStdOut) {
+			fwrite(os.c_str(), os.length(), 1, stdout);
+		} else {
+			OutputAppendStringSynchronised(os.c_str());
+		}
+	}
+	return finished;
+}
+
+// Adds the files to the queue for the searching threads and shows the results that are ready
+// after each directory. Without other threads searcher is used to search the files here.
+// With an index, files that have not changed since they were indexed are only searched
+// when they may contain the trigrams of the search.
+void SciTEBase::GrepRecursive(GrepFlags gf, GrepQueue &queue, GrepSearcher *searcher, GrepIndex *index,
+	const TrigramQuery &query, FilePath baseDir, const GUI::gui_char *fileTypes) {
 	FilePathSet directories;
 	FilePathSet files;
 	baseDir.List(directories, files);
-	size_t searchLength = strlen(searchString);
-	SString os;
 	for (size_t i = 0; i < files.size(); i ++) {
 		if (jobQueue.Cancelled())
 			return;
 		FilePath fPath = files[i];
 		if (*fileTypes == '\0' || fPath.Matches(fileTypes)) {
-			//OutputAppendStringSynchronised(i->AsInternal());
-			//OutputAppendStringSynchronised("\n");
-			FileReader fr(fPath, gf & grepMatchCase);
-			if ((gf & grepBinary) || !fr.BufferContainsNull()) {
-				while (char *line = fr.Next()) {
-					char *match = strstr(line, searchString);
-					if (match) {
-						if (gf & grepWholeWord) {
-							char *lineEnd = line + strlen(line);
-							while (match) {
-								if (((match == line) || !IsWordCharacter(match[-1])) &&
-								        ((match + searchLength == (lineEnd)) || !IsWordCharacter(match[searchLength]))) {
-									break;
-								}
-								match = strstr(match + 1, searchString);
-							}
-						}
-						if (match) {
-//!-start-[FindResultListStyle]
-							if (props.GetInt("lexer.errorlist.findliststyle", 1)) {
-#if !defined(GTK)
-								os.append(".");
-#endif
-								os.append(fPath.AsUTF8().c_str() + basePath);
-							}
-							else
-//!-end-[FindResultListStyle]
-							os.append(fPath.AsUTF8().c_str());
-							os.append(":");
-							SString lNumber(fr.LineNumber());
-							os.append(lNumber.c_str());
-							os.append(":");
-//!-start-[FindResultListStyle]
-							if (props.GetInt("lexer.errorlist.findliststyle", 1) == 1) {
-								lNumber = fr.Original();
-								lNumber.substitute('\t',' ');
-								lNumber.trimleft("\n\r ");
-								lNumber.insert(0," ",1);
-								while ( lNumber.substitute("  "," ") );
-								os.append(lNumber.c_str());
-							}
-							else
-//!-end-[FindResultListStyle]
-							os.append(fr.Original());
-							os.append("\n");
-						}
-					}
+			long size = 0;
+			time_t modified = 0;
+			if (!index || !fPath.Status(size, modified)) {
+				queue.Add(fPath);
+			} else {
+				const std::string key = index->Key(fPath);
+				switch (index->Lookup(key, size, modified, query)) {
+				case GrepIndex::checkStale:
+					queue.Add(fPath, key, size, modified);
+					break;
+				case GrepIndex::checkSearch:
+					queue.Add(fPath);
+					break;
+				case GrepIndex::checkSkip:
+					break;
 				}
 			}
+		} else if (index) {
+			index->Seen(index->Key(fPath));
 		}
 	}
-	if (os.length()) {
-		if (gf & grepStdOut) {
-			fwrite(os.c_str(), os.length(), 1, stdout);
-		} else {
-			OutputAppendStringSynchronised(os.c_str());
-		}
+	if (searcher) {
+		bool exhausted = false;
+		while (!jobQueue.Cancelled() && queue.SearchOne(*searcher, exhausted))
+			;
 	}
+	GrepResults(gf, queue);
 	for (size_t j = 0; j < directories.size(); j++) {
 		FilePath fPath = directories[j];
 		if ((gf & grepDot) || GrepIntoDirectory(fPath.Name())) {
-//!			GrepRecursive(gf, fPath, searchString, fileTypes);
-			GrepRecursive(gf, fPath, searchString, fileTypes, basePath); //!-change-[FindResultListStyle]
+			GrepRecursive(gf, queue, searcher, index, query, fPath, fileTypes);
 		}
 	}
 }
@@ -1513,13 +1372,14 @@ void SciTEBase::GrepRecursive(GrepFlags gf, FilePath baseDir, const char *search
 void SciTEBase::InternalGrep(GrepFlags gf, const GUI::gui_char *directory, const GUI::gui_char *fileTypes, const char *search, sptr_t &originalEnd) {
 	GUI::ElapsedTime commandTime;
 	unsigned int basePathLen = 0; //!-add-[FindResultListStyle]
+	const int listStyle = props.GetInt("lexer.errorlist.findliststyle", 1);
 	if (!(gf & grepStdOut)) {
 		SString os;
 		os.append(">Internal search for \"");
 		os.append(search);
 		os.append("\" in \"");
 //!-start-[FindResultListStyle]
-		if (props.GetInt("lexer.errorlist.findliststyle", 1)) {
+		if (listStyle) {
 			std::string dir = GUI::UTF8FromString(directory);
 			basePathLen = dir.length();
 			os.append(dir.c_str());
@@ -1536,18 +1396,93 @@ void SciTEBase::InternalGrep(GrepFlags gf, const GUI::gui_char *directory, const
 		MakeOutputVisible();
 		originalEnd += os.length();
 	}
-	SString searchString(search);
-	if (!(gf & grepMatchCase)) {
-		searchString.lowercase();
+	GrepSpec spec(search, (gf & grepMatchCase) != 0, (gf & grepWholeWord) != 0, (gf & grepBinary) != 0,
+		listStyle, basePathLen);
+	spec.regExp = (gf & grepRegExp) != 0;
+	spec.posix = props.GetInt("find.replace.regexp.posix") != 0;
+	spec.unicode = props.GetInt("code.page") == SC_CP_UTF8;
+	const char *errorRegExp = 0;
+	GrepMatcher *matcherCheck = spec.CreateMatcher(&errorRegExp);
+	if (!matcherCheck) {
+		if (!(gf & grepStdOut)) {
+			SString sError(">Invalid regular expression: ");
+			sError += errorRegExp;
+			sError += "\n";
+			OutputAppendStringSynchronised(sError.c_str());
+		} else {
+			fprintf(stderr, "Invalid regular expression: %s\n", errorRegExp);
+		}
+		return;
+	}
+	delete matcherCheck;
+	GrepQueue queue(spec);
+	int threads = props.GetInt("find.in.threads");
+	if (threads <= 0)
+		threads = GrepQueue::ProcessorCount();
+	// This thread walks the directories so starts one less thread to search
+	std::vector<GrepWorker *> workers;
+	for (int t = 1; t < threads; t++) {
+		GrepWorker *pWorker = new GrepWorker(&queue);
+		queue.WorkerStarted();
+		if (!PerformOnNewThread(pWorker)) {
+			queue.WorkerFinished();
+			delete pWorker;
+			break;
+		}
+		workers.push_back(pWorker);
+	}
+	std::vector<std::string> alternatives;
+	if (!spec.LiteralAlternatives(alternatives))
+		alternatives.clear();
+	const TrigramQuery query(alternatives);
+	GrepIndex *index = 0;
+	FilePath indexPath;
+	if (props.GetInt("find.in.index")) {
+		if (grepIndex && !grepIndex->IsFor(FilePath(directory))) {
+			delete grepIndex;
+			grepIndex = 0;
+		}
+		if (!grepIndex)
+			grepIndex = new GrepIndex(FilePath(directory));
+		index = grepIndex;
+		indexPath = index->FileName(GetSciteUserHome());
+		index->Begin(indexPath);
+		queue.SetIndex(index);
+	}
+	GrepSearcher searcher(spec);
+	GrepRecursive(gf, queue, workers.empty() ? &searcher : 0, index, query, FilePath(directory), fileTypes);
+	queue.EndWalk();
+	// Help search the remaining files while showing results in order
+	bool exhausted = false;
+	while (!jobQueue.Cancelled() && !GrepResults(gf, queue)) {
+		if (!queue.SearchOne(searcher, exhausted))
+			queue.WaitForResults();
+	}
+	const bool completed = !jobQueue.Cancelled();
+	queue.Cancel();
+	queue.WaitForWorkers();
+	for (size_t w = 0; w < workers.size(); w++)
+		delete workers[w];
+	int filesSkipped = 0;
+	if (index) {
+		// Only a complete walk shows which files no longer exist
+		if (completed)
+			index->Prune();
+		filesSkipped = index->Skipped();
+		if (index->Changed())
+			index->Save(indexPath);
+		queue.SetIndex(0);
 	}
-//!	GrepRecursive(gf, FilePath(directory), searchString.c_str(), fileTypes);
-	GrepRecursive(gf, FilePath(directory), searchString.c_str(), fileTypes, basePathLen); //!-change-[FindResultListStyle]
 	if (!(gf & grepStdOut)) {
 		SString sExitMessage(">");
 		if (jobQueue.TimeCommands()) {
 			sExitMessage += "    Time: ";
 			sExitMessage += SString(commandTime.Duration(), 3);
 		}
+		if (filesSkipped) {
+			sExitMessage += "    Skipped by index: ";
+			sExitMessage += SString(filesSkipped);
+		}
 		sExitMessage += "\n";
 		OutputAppendStringSynchronised(sExitMessage.c_str());
 	}
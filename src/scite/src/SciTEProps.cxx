@@ -1186,6 +1186,10 @@ void SciTEBase::ReadProperties() {
 
 	wEditor.Call(SCI_SETLAYOUTCACHE, props.GetInt("cache.layout", SC_CACHE_CARET));
 	wOutput.Call(SCI_SETLAYOUTCACHE, props.GetInt("output.cache.layout", SC_CACHE_CARET));
+	wEditor.Call(SCI_SETLINEIMAGECACHE, props.GetInt("cache.line.images"));
+	wOutput.Call(SCI_SETLINEIMAGECACHE, props.GetInt("output.cache.line.images"));
+	wEditor.Call(SCI_SETIDLESTYLING, props.GetInt("idle.styling", SC_IDLESTYLING_NONE));
+	wOutput.Call(SCI_SETIDLESTYLING, props.GetInt("output.idle.styling", SC_IDLESTYLING_NONE));
 
 	bracesCheck = props.GetInt("braces.check");
 	bracesSloppy = props.GetInt("braces.sloppy");
@@ -1285,6 +1289,7 @@ void SciTEBase::ReadProperties() {
 
 
 	scrollOutput = props.GetInt("output.scroll", 1);
+	outputBufferSize = props.GetInt("output.buffer.size") * 1024 * 1024;
 
 	tabHideOne = props.GetInt("tabbar.hide.one");
 
@@ -0,0 +1,58 @@
+// Tests for SciTE code that does not need a GUI
+/** @file TestFilePath.cxx
+ ** Minimal versions of the SciTE file name functions used by GrepIndex.
+ **/
+
+#include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "Scintilla.h"
+
+#include "GUI.h"
+#include "FilePath.h"
+
+const GUI::gui_char pathSepString[] = "/";
+const GUI::gui_char configFileVisibilityString[] = ".";
+const GUI::gui_char fileRead[] = "rb";
+const GUI::gui_char fileWrite[] = "wb";
+const GUI::gui_char fileAppend[] = "ab";
+
+namespace GUI {
+
+gui_string StringFromUTF8(const char *s) {
+	return s ? s : "";
+}
+
+std::string UTF8FromString(const gui_string &s) {
+	return s;
+}
+
+}
+
+FilePath::FilePath(const GUI::gui_char *fileName_) : fileName(fileName_ ? fileName_ : "") {}
+
+FilePath::FilePath(const GUI::gui_string &fileName_) : fileName(fileName_) {}
+
+FilePath::FilePath(FilePath const &directory, FilePath const &name) :
+	fileName(directory.fileName + pathSepString + name.fileName) {}
+
+std::string FilePath::AsUTF8() const {
+	return fileName;
+}
+
+FILE *FilePath::Open(const GUI::gui_char *mode) const {
+	return fopen(fileName.c_str(), mode);
+}
+
+bool FilePath::Status(long &size, time_t &modified) const {
+	struct stat statusFile;
+	if (stat(fileName.c_str(), &statusFile) == -1)
+		return false;
+	size = statusFile.st_size;
+	modified = statusFile.st_mtime;
+	return true;
+}
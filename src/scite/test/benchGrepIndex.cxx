@@ -0,0 +1,153 @@
+// Benchmarks for SciTE code that does not need a GUI
+/** @file benchGrepIndex.cxx
+ ** Time building and looking up the trigram index used by SciTE's Find in Files.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "Scintilla.h"
+
+#include "GUI.h"
+#include "FilePath.h"
+#include "GrepIndex.h"
+
+#include "BenchTimer.h"
+
+// Linear congruential generator so runs are repeatable on all platforms
+static unsigned int Random(unsigned int &seed) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+// About the size of a large source tree
+static const int fileCount = 20000;
+static const int fileSize = 4000;
+static const int vocabularyCount = 20000;
+static const int lookupRepeats = 10;
+
+static std::string Key(int file) {
+	char key[20];
+	sprintf(key, "dir/f%d.cxx", file);
+	return key;
+}
+
+int main() {
+	printf("benchGrepIndex %d files of %d bytes\n", fileCount, fileSize);
+	unsigned int seed = 1;
+	std::vector<std::string> vocabulary;
+	for (int w = 0; w < vocabularyCount; w++) {
+		std::string word;
+		const int length = 3 + Random(seed) % 10;
+		for (int i = 0; i < length; i++)
+			word += static_cast<char>(((i == 0) && (Random(seed) % 4 == 0) ? 'A' : 'a') + Random(seed) % 26);
+		vocabulary.push_back(word);
+	}
+	std::vector<std::string> files;
+	for (int f = 0; f < fileCount; f++) {
+		std::string text;
+		while (text.length() < static_cast<size_t>(fileSize)) {
+			text += vocabulary[Random(seed) % vocabularyCount];
+			text += (Random(seed) % 8) ? " " : ";\n";
+		}
+		files.push_back(text);
+	}
+
+	GrepIndex index(FilePath("root"));
+	const FilePath indexPath("benchGrepIndex.idx");
+	{
+		BenchTimer bt;
+		TrigramCollector trigrams;
+		for (int f = 0; f < fileCount; f++) {
+			trigrams.Collect(files[f].c_str(), files[f].length());
+			std::string filter = trigrams.Filter();
+			index.Update(Key(f), static_cast<long>(files[f].length()), 1000, filter);
+		}
+		bt.Report("build index");
+	}
+	{
+		BenchTimer bt;
+		index.Save(indexPath);
+		bt.Report("save index");
+	}
+	{
+		BenchTimer bt;
+		index.Load(indexPath);
+		bt.Report("load index");
+	}
+
+	// Searches for words in the vocabulary, which are in some files, and for words that are not
+	std::vector<std::string> searches;
+	for (int s = 0; s < 10; s++)
+		searches.push_back(vocabulary[Random(seed) % vocabularyCount]);
+	searches.push_back("vocabulary");
+	searches.push_back("xyzzy");
+	{
+		BenchTimer bt;
+		for (int r = 0; r < lookupRepeats; r++) {
+			for (size_t s = 0; s < searches.size(); s++) {
+				const TrigramQuery query(std::vector<std::string>(1, searches[s]));
+				for (int f = 0; f < fileCount; f++)
+					index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000, query);
+			}
+		}
+		bt.Report("lookup");
+	}
+	const int lookups = lookupRepeats * static_cast<int>(searches.size()) * fileCount;
+	printf("%8.1f%% files skipped\n", 100.0 * index.Skipped() / lookups);
+	{
+		// The search the index avoids for files it skips
+		BenchTimer bt;
+		int found = 0;
+		for (int r = 0; r < lookupRepeats; r++) {
+			for (size_t s = 0; s < searches.size(); s++) {
+				for (int f = 0; f < fileCount; f++) {
+					if (files[f].find(searches[s]) != std::string::npos)
+						found++;
+				}
+			}
+		}
+		bt.Report("substring scan");
+		if (found == 0)
+			printf("Nothing found\n");
+	}
+	{
+		// Each Find in Files after the first over an unchanged tree, without walking the directories
+		BenchTimer bt;
+		for (size_t s = 0; s < searches.size(); s++) {
+			index.Begin(indexPath);
+			const TrigramQuery query(std::vector<std::string>(1, searches[s]));
+			for (int f = 0; f < fileCount; f++)
+				index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000, query);
+			index.Prune();
+		}
+		printf("%8.3f ms each repeated search\n", bt.Duration() * 1000.0 / searches.size());
+	}
+	{
+		// One file in a hundred changes between searches so only those entries are appended
+		TrigramCollector trigrams;
+		for (int f = 0; f < fileCount; f += 100) {
+			trigrams.Collect(files[f].c_str(), files[f].length());
+			std::string filter = trigrams.Filter();
+			index.Update(Key(f), static_cast<long>(files[f].length()), 1001, filter);
+		}
+		long sizeBefore = 0;
+		time_t modified = 0;
+		indexPath.Status(sizeBefore, modified);
+		BenchTimer bt;
+		index.Save(indexPath);
+		bt.Report("save changed entries");
+		long sizeAfter = 0;
+		indexPath.Status(sizeAfter, modified);
+		printf("%8ld bytes appended to %ld\n", sizeAfter - sizeBefore, sizeBefore);
+	}
+	remove("benchGrepIndex.idx");
+	return 0;
+}
@@ -0,0 +1,248 @@
+// Unit Tests for SciTE code that does not need a GUI
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "Scintilla.h"
+
+#include "GUI.h"
+#include "FilePath.h"
+#include "GrepIndex.h"
+
+#include <gtest/gtest.h>
+
+// Test GrepIndex.
+
+namespace {
+
+const char *const words[] = {
+	"alpha", "Beta", "gamma", "DELTA", "Epsilon", "ab", "x", "trigram", "Index", "filter",
+	"zz", "caf\xc3\xa9", "line_end", "0x7f", "Find", "in", "Files", "q",
+};
+
+std::string Fold(const std::string &s) {
+	std::string folded(s);
+	for (size_t i = 0; i < folded.length(); i++) {
+		if ((folded[i] >= 'A') && (folded[i] <= 'Z'))
+			folded[i] = static_cast<char>(folded[i] - 'A' + 'a');
+	}
+	return folded;
+}
+
+// The plain scan the index must agree with: case insensitive searches fold ASCII only
+bool Contains(const std::string &text, const std::string &search, bool matchCase) {
+	if (matchCase)
+		return text.find(search) != std::string::npos;
+	return Fold(text).find(Fold(search)) != std::string::npos;
+}
+
+}
+
+class GrepIndexTest : public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		// Files of a few random words so that most trigrams of the words occur in some files
+		unsigned int seed = 1;
+		for (int f = 0; f < 300; f++) {
+			std::string text;
+			const int count = 1 + f % 40;
+			for (int w = 0; w < count; w++) {
+				seed = seed * 1103515245U + 12345U;
+				text += words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+				text += ((seed >> 8) % 7) ? " " : "\n";
+			}
+			files.push_back(text);
+		}
+		searches.push_back("alpha");
+		searches.push_back("ALPHA");
+		searches.push_back("beta gamma");
+		searches.push_back("Delta");
+		searches.push_back("epsilon\nab");
+		searches.push_back("CAF\xc3\xa9");
+		searches.push_back("caf\xc3\x89");
+		searches.push_back("x zz");
+		searches.push_back("Index filter");
+		searches.push_back("find in files");
+		searches.push_back("omega");
+		searches.push_back("ab");
+		searches.push_back("zz");
+		searches.push_back("x");
+		searches.push_back("a");
+	}
+
+	static std::string Key(size_t file) {
+		char key[20];
+		sprintf(key, "dir/f%d.txt", static_cast<int>(file));
+		return key;
+	}
+
+	void Index(GrepIndex &index) {
+		TrigramCollector trigrams;
+		for (size_t f = 0; f < files.size(); f++) {
+			trigrams.Collect(files[f].c_str(), files[f].length());
+			std::string filter = trigrams.Filter();
+			index.Update(Key(f), static_cast<long>(files[f].length()), 1000 + f, filter);
+		}
+	}
+
+	// Every file that contains one of the alternatives must be searched
+	void CheckLookup(GrepIndex &index, const std::vector<std::string> &alternatives, bool matchCase) {
+		const TrigramQuery query(alternatives);
+		for (size_t f = 0; f < files.size(); f++) {
+			bool contains = false;
+			for (size_t a = 0; a < alternatives.size(); a++)
+				contains = contains || Contains(files[f], alternatives[a], matchCase);
+			const GrepIndex::Check check = index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000 + f, query);
+			EXPECT_NE(GrepIndex::checkStale, check);
+			if (contains) {
+				EXPECT_EQ(GrepIndex::checkSearch, check) << "\"" << alternatives[0] << "\" in " << Key(f);
+			}
+		}
+	}
+
+	std::vector<std::string> files;
+	std::vector<std::string> searches;
+};
+
+TEST_F(GrepIndexTest, LookupKeepsMatches) {
+	GrepIndex index(FilePath("root"));
+	Index(index);
+	for (size_t s = 0; s < searches.size(); s++) {
+		CheckLookup(index, std::vector<std::string>(1, searches[s]), true);
+		CheckLookup(index, std::vector<std::string>(1, searches[s]), false);
+	}
+	// Absent and rare searches let some files be skipped
+	EXPECT_GT(index.Skipped(), 0);
+}
+
+TEST_F(GrepIndexTest, LookupAlternatives) {
+	GrepIndex index(FilePath("root"));
+	Index(index);
+	std::vector<std::string> alternatives;
+	alternatives.push_back("omega");
+	alternatives.push_back("Trigram");
+	CheckLookup(index, alternatives, false);
+	// One short alternative means any file may match
+	alternatives.push_back("zz");
+	const TrigramQuery query(alternatives);
+	EXPECT_FALSE(query.Filters());
+	for (size_t f = 0; f < files.size(); f++)
+		EXPECT_EQ(GrepIndex::checkSearch, index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000 + f, query));
+}
+
+TEST_F(GrepIndexTest, LookupStale) {
+	GrepIndex index(FilePath("root"));
+	Index(index);
+	const TrigramQuery query(std::vector<std::string>(1, "omega"));
+	EXPECT_EQ(GrepIndex::checkStale, index.Lookup("dir/new.txt", 10, 1000, query));
+	EXPECT_EQ(GrepIndex::checkStale, index.Lookup(Key(0), static_cast<long>(files[0].length()) + 1, 1000, query));
+	EXPECT_EQ(GrepIndex::checkStale, index.Lookup(Key(0), static_cast<long>(files[0].length()), 999, query));
+}
+
+TEST_F(GrepIndexTest, PruneKeepsSeen) {
+	const FilePath indexPath("testGrepIndex.idx");
+	{
+		GrepIndex index(FilePath("root"));
+		Index(index);
+		EXPECT_TRUE(index.Changed());
+		EXPECT_TRUE(index.Save(indexPath));
+	}
+	GrepIndex index(FilePath("root"));
+	EXPECT_TRUE(index.Load(indexPath));
+	remove("testGrepIndex.idx");
+	// Files that still exist are either looked up or, when their type is not searched, seen
+	const TrigramQuery query(std::vector<std::string>(1, "gamma"));
+	for (size_t f = 0; f < files.size(); f++) {
+		if (f % 3 == 0)
+			index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000 + f, query);
+		else if (f % 3 == 1)
+			index.Seen(Key(f));
+	}
+	index.Prune();
+	EXPECT_TRUE(index.Changed());
+	for (size_t s = 0; s < searches.size(); s++) {
+		const TrigramQuery querySearch(std::vector<std::string>(1, searches[s]));
+		for (size_t f = 0; f < files.size(); f++) {
+			const GrepIndex::Check check = index.Lookup(Key(f), static_cast<long>(files[f].length()), 1000 + f, querySearch);
+			if (f % 3 == 2) {
+				EXPECT_EQ(GrepIndex::checkStale, check);
+			} else {
+				EXPECT_NE(GrepIndex::checkStale, check);
+				if (Contains(files[f], searches[s], false)) {
+					EXPECT_EQ(GrepIndex::checkSearch, check);
+				}
+			}
+		}
+	}
+}
+
+TEST_F(GrepIndexTest, SaveAppendsChanges) {
+	const FilePath indexPath("testGrepIndex.idx");
+	GrepIndex index(FilePath("root"));
+	Index(index);
+	EXPECT_TRUE(index.Save(indexPath));
+	long sizeFull = 0;
+	time_t modified = 0;
+	EXPECT_TRUE(indexPath.Status(sizeFull, modified));
+	// A later search changes some files and finds others removed
+	EXPECT_TRUE(index.Begin(indexPath));
+	TrigramCollector trigrams;
+	for (size_t f = 0; f < files.size(); f++) {
+		if (f % 10 == 0) {
+			files[f] += " omega";
+			trigrams.Collect(files[f].c_str(), files[f].length());
+			std::string filter = trigrams.Filter();
+			index.Update(Key(f), static_cast<long>(files[f].length()), 2000 + f, filter);
+		} else if (f % 7 != 3) {
+			index.Seen(Key(f));
+		}
+	}
+	index.Prune();
+	EXPECT_TRUE(index.Save(indexPath));
+	long sizeAppended = 0;
+	EXPECT_TRUE(indexPath.Status(sizeAppended, modified));
+	EXPECT_GT(sizeAppended, sizeFull);
+	EXPECT_LT(sizeAppended, sizeFull + sizeFull / 4);
+	GrepIndex indexLoaded(FilePath("root"));
+	EXPECT_TRUE(indexLoaded.Load(indexPath));
+	remove("testGrepIndex.idx");
+	const TrigramQuery query(std::vector<std::string>(1, "omega"));
+	for (size_t f = 0; f < files.size(); f++) {
+		const time_t modifiedFile = ((f % 10 == 0) ? 2000 : 1000) + f;
+		const GrepIndex::Check check = indexLoaded.Lookup(Key(f), static_cast<long>(files[f].length()), modifiedFile, query);
+		if ((f % 10 != 0) && (f % 7 == 3)) {
+			EXPECT_EQ(GrepIndex::checkStale, check) << Key(f);
+		} else if (f % 10 == 0) {
+			EXPECT_EQ(GrepIndex::checkSearch, check) << Key(f);
+		} else {
+			EXPECT_NE(GrepIndex::checkStale, check) << Key(f);
+		}
+	}
+}
+
+TEST_F(GrepIndexTest, BeginLoadsWhenWritten) {
+	const FilePath indexPath("testGrepIndex.idx");
+	GrepIndex index(FilePath("root"));
+	EXPECT_TRUE(index.IsFor(FilePath("root/")));
+	EXPECT_FALSE(index.IsFor(FilePath("other")));
+	Index(index);
+	EXPECT_TRUE(index.Save(indexPath));
+	const TrigramQuery query(std::vector<std::string>(1, "omega"));
+	// Another instance updates the file
+	GrepIndex indexOther(FilePath("root"));
+	EXPECT_TRUE(indexOther.Begin(indexPath));
+	std::string filter;
+	indexOther.Update("dir/new.txt", 10, 1000, filter);
+	EXPECT_TRUE(indexOther.Save(indexPath));
+	EXPECT_EQ(GrepIndex::checkStale, index.Lookup("dir/new.txt", 10, 1000, query));
+	EXPECT_TRUE(index.Begin(indexPath));
+	remove("testGrepIndex.idx");
+	EXPECT_EQ(GrepIndex::checkSkip, index.Lookup("dir/new.txt", 10, 1000, query));
+	EXPECT_NE(GrepIndex::checkStale, index.Lookup(Key(0), static_cast<long>(files[0].length()), 1000, query));
+}
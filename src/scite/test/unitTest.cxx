@@ -0,0 +1,15 @@
+// Unit Tests for SciTE code that does not need a GUI
+
+/*
+    Currently tested:
+        TrigramCollector
+        TrigramQuery
+        GrepIndex
+*/
+
+#include <gtest/gtest.h>
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -751,6 +751,7 @@ void CommandWorker::Initialise(bool resetToStart) {
 	if (resetToStart)
 		icmd = 0;
     originalEnd = 0;
+    originalTrimmed = 0;
     exitStatus = 0;
     flags = 0;
 	seenOutput = false;
@@ -807,7 +808,7 @@ DWORD SciTEWin::ExecuteOne(const Job &jobToRun) {
 	}
 
 	if (jobToRun.jobType == jobGrep) {
-		// jobToRun.command is "(w|~)(c|~)(d|~)(b|~)\0files\0text"
+		// jobToRun.command is "(w|~)(c|~)(d|~)(b|~)(r|~)\0files\0text"
 		const char *grepCmd = jobToRun.command.c_str();
 		if (*grepCmd) {
 			GrepFlags gf = grepNone;
@@ -822,14 +823,20 @@ DWORD SciTEWin::ExecuteOne(const Job &jobToRun) {
 			grepCmd++;
 			if (*grepCmd == 'b')
 				gf = static_cast<GrepFlags>(gf | grepBinary);
+			grepCmd++;
+			if (*grepCmd == 'r')
+				gf = static_cast<GrepFlags>(gf | grepRegExp);
 			const char *findFiles = grepCmd + 2;
 			const char *findWhat = findFiles + strlen(findFiles) + 1;
 			if (cmdWorker.outputScroll == 1)
 				gf = static_cast<GrepFlags>(gf | grepScroll);
+			OutputFlushSynchronised();
 			sptr_t positionEnd = wOutput.Send(SCI_GETCURRENTPOS);
+			const sptr_t trimmedAtEnd = OutputTrimmedLength();
 			InternalGrep(gf, jobToRun.directory.AsInternal(), GUI::StringFromUTF8(findFiles).c_str(), findWhat, positionEnd);
+			OutputFlushSynchronised();
 			if ((gf & grepScroll) && returnOutputToCommand)
-				wOutput.Send(SCI_GOTOPOS, positionEnd, 0);
+				wOutput.Send(SCI_GOTOPOS, OutputPositionTrimmed(positionEnd, trimmedAtEnd), 0);
 		}
 		return exitcode;
 	}
@@ -1040,8 +1047,6 @@ DWORD SciTEWin::ExecuteOne(const Job &jobToRun) {
 						// Display the data
 						OutputAppendStringSynchronised(buffer, bytesRead);
 					}
-
-					::UpdateWindow(MainHWND());
 				} else {
 					running = false;
 				}
@@ -1138,8 +1143,9 @@ void SciTEWin::ProcessExecute() {
 	// to first error of this run.
 	// scroll and return only if output.scroll equals
 	// one in the properties file
+	OutputFlushSynchronised();
 	if ((cmdWorker.outputScroll == 1) && returnOutputToCommand)
-		wOutput.Send(SCI_GOTOPOS, cmdWorker.originalEnd, 0);
+		wOutput.Send(SCI_GOTOPOS, OutputPositionTrimmed(cmdWorker.originalEnd, cmdWorker.originalTrimmed), 0);
 	returnOutputToCommand = true;
 	PostOnMainThread(WORK_EXECUTE, &cmdWorker);
 }
@@ -1246,6 +1252,7 @@ void SciTEWin::Execute() {
 	cmdWorker.Initialise(false);
 	cmdWorker.outputScroll = props.GetInt("output.scroll", 1);
 	cmdWorker.originalEnd = wOutput.Call(SCI_GETTEXTLENGTH);
+	cmdWorker.originalTrimmed = OutputTrimmedLength();
 	cmdWorker.commandTime.Duration(true);
 	cmdWorker.flags = jobQueue.jobQueue[cmdWorker.icmd].flags;
 	if (scrollOutput)
@@ -1287,13 +1294,13 @@ void SciTEWin::StopExecute() {
 #ifdef USE_CONSOLE_EVENT
 	if (subProcessGroupId) {
 		// this also doesn't work
-		OutputAppendStringSynchronised("\n>Attempting to cancel process...");
+		OutputAppendString("\n>Attempting to cancel process...");
 
 		if (!GenerateConsoleCtrlEvent(CTRL_BREAK_EVENT, subProcessGroupId)) {
 			LONG errCode = GetLastError();
-			OutputAppendStringSynchronised("\n>BREAK Failed ");
-			OutputAppendStringSynchronised(SString(errCode).c_str());
-			OutputAppendStringSynchronised("\n");
+			OutputAppendString("\n>BREAK Failed ");
+			OutputAppendString(SString(errCode).c_str());
+			OutputAppendString("\n");
 		}
 		Sleep(100L);
 	}
@@ -102,6 +102,7 @@ public:
 	SciTEWin *pSciTE;
 	int icmd;
 	int originalEnd;
+	sptr_t originalTrimmed;
 	int exitStatus;
 	GUI::ElapsedTime commandTime;
 	std::string output;
@@ -1155,13 +1155,15 @@ void SciTEWin::PerformGrep() {
 	SString findCommand = props.GetNewExpand("find.command");
 	if (findCommand == "") {
 		// Call InternalGrep in a new thread
-		// searchParams is "(w|~)(c|~)(d|~)(b|~)\0files\0text"
-		// A "w" indicates whole word, "c" case sensitive, "d" dot directories, "b" binary files
+		// searchParams is "(w|~)(c|~)(d|~)(b|~)(r|~)\0files\0text"
+		// A "w" indicates whole word, "c" case sensitive, "d" dot directories, "b" binary files,
+		// "r" regular expression
 		SString searchParams;
 		searchParams.append(wholeWord ? "w" : "~");
 		searchParams.append(matchCase ? "c" : "~");
 		searchParams.append(props.GetInt("find.in.dot") ? "d" : "~");
 		searchParams.append(props.GetInt("find.in.binary") ? "b" : "~");
+		searchParams.append(regExp ? "r" : "~");
 		searchParams.append("\0", 1);
 		searchParams.append(props.Get("find.files").c_str());
 		searchParams.append("\0", 1);
@@ -1199,9 +1201,11 @@ BOOL SciTEWin::GrepMessage(HWND hDlg, UINT message, WPARAM wParam) {
 			// Empty means use internal that can respond to flags
 			dlg.SetCheck(IDWHOLEWORD, wholeWord);
 			dlg.SetCheck(IDMATCHCASE, matchCase);
+			dlg.SetCheck(IDREGEXP, regExp);
 		} else {
 			dlg.Enable(IDWHOLEWORD, false);
 			dlg.Enable(IDMATCHCASE, false);
+			dlg.Enable(IDREGEXP, false);
 		}
 		return TRUE;
 
@@ -1236,6 +1240,7 @@ BOOL SciTEWin::GrepMessage(HWND hDlg, UINT message, WPARAM wParam) {
 
 			wholeWord = dlg.Checked(IDWHOLEWORD);
 			matchCase = dlg.Checked(IDMATCHCASE);
+			regExp = dlg.Checked(IDREGEXP);
 
 			FillCombos(dlg);
 
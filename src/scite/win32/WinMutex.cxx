@@ -8,6 +8,10 @@
 
 // http://www.microsoft.com/msj/0797/win320797.aspx
 
+#include <stdlib.h>
+
+#include <vector>
+
 #include <windows.h>
 #include "Mutex.h"
 
@@ -19,8 +23,47 @@ private:
 	WinMutex() { ::InitializeCriticalSection(&cs); }
 	virtual ~WinMutex() { ::DeleteCriticalSection(&cs); }
 	friend class Mutex;
+	friend class WinCondition;
 };
 
 Mutex *Mutex::Create() {
    return new WinMutex();
 }
+
+// Condition variables are only in Windows Vista and later so each waiting thread waits on
+// its own event which Broadcast sets. Events are reused as the same threads wait often.
+class WinCondition : public Condition {
+private:
+	WinMutex *mutex;
+	std::vector<HANDLE> waiting;
+	std::vector<HANDLE> spare;
+	virtual void Wait() {
+		HANDLE event;
+		if (spare.empty()) {
+			event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+		} else {
+			event = spare.back();
+			spare.pop_back();
+		}
+		waiting.push_back(event);
+		mutex->Unlock();
+		::WaitForSingleObject(event, INFINITE);
+		mutex->Lock();
+		spare.push_back(event);
+	}
+	virtual void Broadcast() {
+		for (size_t i = 0; i < waiting.size(); i++)
+			::SetEvent(waiting[i]);
+		waiting.clear();
+	}
+	WinCondition(WinMutex *mutex_) : mutex(mutex_) {}
+	virtual ~WinCondition() {
+		for (size_t i = 0; i < spare.size(); i++)
+			::CloseHandle(spare[i]);
+	}
+	friend class Condition;
+};
+
+Condition *Condition::Create(Mutex *mutex) {
+   return new WinCondition(static_cast<WinMutex *>(mutex));
+}
@@ -54,6 +54,12 @@ FileWorker.o: ../src/FileWorker.cxx ../../scintilla/include/Scintilla.h \
  ../../scintilla/include/ILexer.h ../src/GUI.h ../src/SString.h \
  ../src/FilePath.h ../src/Cookie.h ../src/Worker.h ../src/FileWorker.h \
  ../src/Utf8_16.h
+GrepIndex.o: ../src/GrepIndex.cxx ../../scintilla/include/Scintilla.h \
+ ../src/GUI.h ../src/SString.h ../src/FilePath.h ../src/GrepIndex.h
+GrepWorker.o: ../src/GrepWorker.cxx ../../scintilla/include/Scintilla.h \
+ ../../scintilla/include/ILexer.h ../src/GUI.h ../src/SString.h \
+ ../src/FilePath.h ../src/Mutex.h ../src/Cookie.h ../src/Worker.h \
+ ../src/FileWorker.h ../../scintilla/src/LinearRegex.h ../src/GrepIndex.h ../src/GrepWorker.h
 IFaceTable.o: ../src/IFaceTable.cxx ../src/IFaceTable.h
 JobQueue.o: ../src/JobQueue.cxx ../../scintilla/include/Scintilla.h \
  ../src/GUI.h ../src/SString.h ../src/FilePath.h ../src/SciTE.h \
@@ -87,7 +93,9 @@ SciTEIO.o: ../src/SciTEIO.cxx ../../scintilla/include/Scintilla.h \
  ../src/StringList.h ../src/StringHelpers.h ../src/FilePath.h \
  ../src/PropSetFile.h ../src/StyleWriter.h ../src/Extender.h \
  ../src/SciTE.h ../src/Mutex.h ../src/JobQueue.h ../src/Cookie.h \
- ../src/Worker.h ../src/FileWorker.h ../src/SciTEBase.h ../src/Utf8_16.h
+ ../src/Worker.h ../src/FileWorker.h ../../scintilla/src/LinearRegex.h \
+ ../src/GrepIndex.h ../src/GrepWorker.h ../src/SciTEBase.h \
+ ../src/Utf8_16.h
 SciTEProps.o: ../src/SciTEProps.cxx ../../scintilla/include/Scintilla.h \
  ../../scintilla/include/SciLexer.h ../../scintilla/include/ILexer.h \
  ../src/GUI.h ../src/SString.h ../src/StringList.h ../src/StringHelpers.h \
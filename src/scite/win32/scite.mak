@@ -52,11 +52,13 @@ CXXFLAGS=$(CXXFLAGS) $(CXXNDEBUG)
 CCFLAGS=$(CCFLAGS) $(CXXNDEBUG)
 !ENDIF
 
-INCLUDEDIRS=-I../../scintilla/include -I../../scintilla/win32 -I../src
+INCLUDEDIRS=-I../../scintilla/include -I../../scintilla/src -I../../scintilla/win32 -I../src
 
 OBJS=\
 	SciTEBase.obj \
 	FileWorker.obj \
+	GrepIndex.obj \
+	GrepWorker.obj \
 	Cookie.obj \
 	Credits.obj \
 	FilePath.obj \
@@ -78,13 +80,16 @@ OBJS=\
 	StyleWriter.obj \
 	GUIWin.obj \
 	UniqueInstance.obj \
-	WinMutex.obj
+	WinMutex.obj \
+	..\..\scintilla\win32\LinearRegex.obj
 
 LEXLIB=..\..\scintilla\win32\Lexers.lib
 
 OBJSSTATIC=\
 	SciTEBase.obj \
 	FileWorker.obj \
+	GrepIndex.obj \
+	GrepWorker.obj \
 	Cookie.obj \
 	Credits.obj \
 	FilePath.obj \
@@ -125,6 +130,7 @@ OBJSSTATIC=\
 	..\..\scintilla\win32\LexerModule.obj \
 	..\..\scintilla\win32\LexerSimple.obj \
 	..\..\scintilla\win32\LineMarker.obj \
+	..\..\scintilla\win32\LinearRegex.obj \
 	..\..\scintilla\win32\PerLine.obj \
 	..\..\scintilla\win32\PlatWin.obj \
 	..\..\scintilla\win32\PositionCache.obj \
@@ -451,6 +457,25 @@ FileWorker.obj: \
 	../src/SString.h \
 	../src/Worker.h \
 	../src/FileWorker.h
+GrepIndex.obj: \
+	../src/GrepIndex.cxx \
+	../../scintilla/include/Scintilla.h \
+	../src/GUI.h \
+	../src/SString.h \
+	../src/FilePath.h \
+	../src/GrepIndex.h
+GrepWorker.obj: \
+	../src/GrepWorker.cxx \
+	../../scintilla/include/Scintilla.h \
+	../src/GUI.h \
+	../src/SString.h \
+	../src/FilePath.h \
+	../src/Mutex.h \
+	../src/Worker.h \
+	../src/FileWorker.h \
+	../../scintilla/src/LinearRegex.h \
+	../src/GrepIndex.h \
+	../src/GrepWorker.h
 Cookie.obj: \
 	../src/Cookie.cxx \
 	../../scintilla/include/Scintilla.h \
@@ -503,6 +528,9 @@ SciTEIO.obj: \
 	../src/SciTE.h \
 	../src/Mutex.h \
 	../src/JobQueue.h \
+	../../scintilla/src/LinearRegex.h \
+	../src/GrepIndex.h \
+	../src/GrepWorker.h \
 	../src/SciTEBase.h \
 	../src/Cookie.h \
 	../src/Utf8_16.h